@@ -0,0 +1,96 @@
+#include <benchmark/benchmark.h>
+#include <benchmarks/aot_model.hpp>
+#include <benchmarks/benchmark_utils.hpp>
+#include <src/comp_graph/graph.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "gladius_aot_mlp.hpp"
+#include "gladius_aot_mlp_mapped.hpp"
+
+namespace gladius::benchmarks {
+
+using gladius::comp_graph::NoGradGuard;
+
+static_assert(gladius_aot_mlp::INPUT_ROWS == AOT_ROWS &&
+              gladius_aot_mlp::INPUT_DIMENSION == AOT_INPUT_DIMENSION &&
+              gladius_aot_mlp::OUTPUT_DIMENSION == AOT_CLASSES);
+
+static inline constexpr uint64_t AOT_FLOPS =
+    2ULL * AOT_ROWS *
+    (AOT_HIDDEN_DIMENSION * AOT_INPUT_DIMENSION +
+     AOT_CLASSES * AOT_HIDDEN_DIMENSION);
+static inline constexpr uint64_t AOT_BYTES =
+    4ULL * (AOT_HIDDEN_DIMENSION * AOT_INPUT_DIMENSION +
+            AOT_CLASSES * AOT_HIDDEN_DIMENSION);
+
+/**
+ * The inference pass of the MLP of aot_model.hpp through the graph
+ * executor, after the same constant folding as aot_generator. The graph is
+ * rebuilt outside of the timed region. Compare with BM_AotInference.
+ */
+static void BM_InterpretedInference(benchmark::State& state) {
+  NoGradGuard no_grad;
+  std::mt19937 generator(SEED);
+  auto batch = randomVector(AOT_ROWS * AOT_INPUT_DIMENSION, generator);
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto inputs = batch;
+    auto graph = buildAotMLPGraph(inputs);
+    graph->foldConstants();
+    state.ResumeTiming();
+
+    auto& output = graph->launchInferencePass()->getOutput();
+    benchmark::DoNotOptimize(output.data());
+  }
+  setThroughputCounters(state, AOT_FLOPS, AOT_BYTES);
+}
+BENCHMARK(BM_InterpretedInference);
+
+/**
+ * The same inference pass through the code that aot_generator generated
+ * for the graph, with the weights compiled in
+ */
+static void BM_AotInference(benchmark::State& state) {
+  std::mt19937 generator(SEED);
+  auto batch = randomVector(AOT_ROWS * AOT_INPUT_DIMENSION, generator);
+  std::vector<float> output(AOT_ROWS * AOT_CLASSES);
+
+  for (auto _ : state) {
+    gladius_aot_mlp::run(batch.data(), output.data());
+    benchmark::DoNotOptimize(output.data());
+    benchmark::ClobberMemory();
+  }
+  setThroughputCounters(state, AOT_FLOPS, AOT_BYTES);
+}
+BENCHMARK(BM_AotInference);
+
+/**
+ * Mapping the weights file and the first inference pass, which pages the
+ * weights in from the page cache. Compare with the steady state of
+ * BM_AotInference.
+ */
+static void BM_AotColdStart(benchmark::State& state) {
+  std::mt19937 generator(SEED);
+  auto batch = randomVector(AOT_ROWS * AOT_INPUT_DIMENSION, generator);
+  std::vector<float> output(AOT_ROWS * AOT_CLASSES);
+
+  for (auto _ : state) {
+    if (!gladius_aot_mlp_mapped::loadWeights(GLADIUS_AOT_WEIGHTS_PATH)) {
+      state.SkipWithError("cannot map " GLADIUS_AOT_WEIGHTS_PATH);
+      break;
+    }
+    gladius_aot_mlp_mapped::run(batch.data(), output.data());
+    benchmark::DoNotOptimize(output.data());
+
+    state.PauseTiming();
+    gladius_aot_mlp_mapped::unloadWeights();
+    state.ResumeTiming();
+  }
+}
+BENCHMARK(BM_AotColdStart)->UseRealTime();
+
+}  // namespace gladius::benchmarks
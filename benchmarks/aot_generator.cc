@@ -0,0 +1,40 @@
+#include <benchmarks/aot_model.hpp>
+#include <src/aot/code_generator.hpp>
+#include <src/comp_graph/graph.hpp>
+#include <iostream>
+#include <vector>
+
+using gladius::aot::CodeGenerationOptions;
+using gladius::aot::generateCode;
+using gladius::aot::WeightStorage;
+using gladius::benchmarks::AOT_INPUT_DIMENSION;
+using gladius::benchmarks::AOT_ROWS;
+using gladius::benchmarks::buildAotMLPGraph;
+using gladius::comp_graph::NoGradGuard;
+
+/**
+ * Generates the sources that aot_benchmarks.cc compiles against:
+ * gladius_aot_mlp.{hpp,cc} with embedded weights and
+ * gladius_aot_mlp_mapped.{hpp,cc,weights} with mapped weights, both in the
+ * directory given as the only argument.
+ */
+int main(int argc, char** argv) {
+  if (argc != 2) {
+    std::cerr << "usage: " << argv[0] << " <output directory>\n";
+    return 1;
+  }
+  NoGradGuard no_grad;
+  for (auto storage : {WeightStorage::Embedded, WeightStorage::Mapped}) {
+    CodeGenerationOptions options;
+    options.name_space = storage == WeightStorage::Embedded
+                             ? "gladius_aot_mlp"
+                             : "gladius_aot_mlp_mapped";
+    options.file_stem = options.name_space;
+    options.weight_storage = storage;
+    std::vector<float> inputs(AOT_ROWS * AOT_INPUT_DIMENSION, 0.F);
+    auto graph = buildAotMLPGraph(inputs);
+    graph->foldConstants();
+    generateCode(*graph, options).write(argv[1]);
+  }
+  return 0;
+}
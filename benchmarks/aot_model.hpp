@@ -0,0 +1,57 @@
+#pragma once
+
+#include <benchmarks/random_utils.hpp>
+#include <src/comp_graph/graph.hpp>
+#include <src/comp_graph/vertices/activ_functions.hpp>
+#include <src/comp_graph/vertices/fully_connected.hpp>
+#include <src/comp_graph/vertices/input_vertex.hpp>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace gladius::benchmarks {
+
+using gladius::comp_graph::BiasGELUActivation;
+using gladius::comp_graph::FullyConnected;
+using gladius::comp_graph::Graph;
+using gladius::comp_graph::SequenceInputVertex;
+
+static inline constexpr uint32_t AOT_ROWS = 8;
+static inline constexpr uint32_t AOT_INPUT_DIMENSION = 784;
+static inline constexpr uint32_t AOT_HIDDEN_DIMENSION = 256;
+static inline constexpr uint32_t AOT_CLASSES = 10;
+
+/**
+ * The inference graph of a 2-layer MLP on a batch of AOT_ROWS MNIST-shaped
+ * inputs,
+ *        W_2 GELU(W_1 x + b_1 + b_2) + b_3
+ * with parameters drawn from a generator seeded with SEED, so that
+ * aot_generator (which compiles it ahead of time) and the benchmarks
+ * (which interpret it) see the same model.
+ */
+inline std::shared_ptr<Graph> buildAotMLPGraph(std::vector<float>& inputs) {
+  std::mt19937 generator(SEED);
+  auto input = std::make_shared<SequenceInputVertex>(
+      inputs, /* sequence_length = */ AOT_ROWS);
+  auto projection = std::make_shared<FullyConnected>(
+      input,
+      randomParameterVertex(AOT_HIDDEN_DIMENSION, AOT_INPUT_DIMENSION,
+                            generator),
+      randomParameterVertex(1, AOT_HIDDEN_DIMENSION, generator));
+  auto activation = std::make_shared<BiasGELUActivation>(
+      projection, randomParameterVertex(1, AOT_HIDDEN_DIMENSION, generator));
+  auto logits = std::make_shared<FullyConnected>(
+      activation,
+      randomParameterVertex(AOT_CLASSES, AOT_HIDDEN_DIMENSION, generator),
+      randomParameterVertex(1, AOT_CLASSES, generator));
+
+  auto graph = std::make_shared<Graph>();
+  graph->addVertex(input);
+  graph->addVertex(projection);
+  graph->addVertex(activation);
+  graph->addVertex(logits);
+  return graph;
+}
+
+}  // namespace gladius::benchmarks
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <benchmarks/random_utils.hpp>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace gladius::benchmarks {
+
+/**
+ * Reports the throughput of a benchmark that executes `flops` floating
+ * point operations and touches `bytes` bytes per iteration. The counters
+ * show up as FLOP/s and bytes_per_second in the console and JSON output.
+ * FLOP/s is omitted if `flops` is zero.
+ */
+inline void setThroughputCounters(benchmark::State& state, uint64_t flops,
+                                  uint64_t bytes) {
+  if (flops) {
+    state.counters["FLOP/s"] = benchmark::Counter(
+        static_cast<double>(flops),
+        benchmark::Counter::kIsIterationInvariantRate,
+        benchmark::Counter::kIs1000);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+}
+
+/**
+ * Runs the backward pass of `vertex` for the given upstream gradient once
+ * per iteration. The forward pass must have been launched before.
+ */
+template <typename VertexType>
+inline void runBackwardLoop(benchmark::State& state, VertexType& vertex,
+                            std::optional<std::vector<float>>& upstream_grad) {
+  for (auto _ : state) {
+    vertex.backward(upstream_grad);
+    benchmark::ClobberMemory();
+  }
+}
+
+}  // namespace gladius::benchmarks
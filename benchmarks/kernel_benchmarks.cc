@@ -0,0 +1,113 @@
+#include <benchmark/benchmark.h>
+#include <benchmarks/benchmark_utils.hpp>
+#include <src/params/element_types.hpp>
+#include <src/quantization/int8_kernels.hpp>
+#include <src/utils.hpp>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace gladius::benchmarks {
+
+using gladius::parameters::bfloat16;
+using gladius::parameters::float16;
+
+/**
+ * <x, y> for two fp32 vectors, as used by the dense InnerProduct forward pass
+ */
+static void BM_InnerProduct(benchmark::State& state) {
+  auto size = static_cast<uint32_t>(state.range(0));
+  std::mt19937 generator(SEED);
+  auto first = randomVector(size, generator);
+  auto second = randomVector(size, generator);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(gladius::utils::innerProduct(first, second));
+  }
+  setThroughputCounters(state, /* flops = */ 2ULL * size,
+                        /* bytes = */ 2ULL * size * sizeof(float));
+}
+BENCHMARK(BM_InnerProduct)->RangeMultiplier(4)->Range(64, 1 << 16);
+
+/**
+ * <x, M_{:, j}> for a vector x and the column j of a (size, size) matrix M,
+ * as used when multiplying an upstream gradient with a Jacobian. The column
+ * is strided, so this measures the cost of that memory access pattern.
+ */
+static void BM_InnerProductWithColumn(benchmark::State& state) {
+  auto size = static_cast<uint32_t>(state.range(0));
+  std::mt19937 generator(SEED);
+  auto vector = randomVector(size, generator);
+  auto matrix = randomMatrix(size, size, generator);
+
+  uint32_t column = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        gladius::utils::innerProduct(vector, matrix, column));
+    column = (column + 1) % size;
+  }
+  setThroughputCounters(state, /* flops = */ 2ULL * size,
+                        /* bytes = */ 2ULL * size * sizeof(float));
+}
+BENCHMARK(BM_InnerProductWithColumn)->RangeMultiplier(4)->Range(64, 4096);
+
+/**
+ * parameters::dotProduct of a weight row stored as T with an fp32 vector,
+ * i.e., the inner loop of FullyConnected for each storage type.
+ */
+template <typename T>
+static void BM_MixedPrecisionDotProduct(benchmark::State& state) {
+  auto size = static_cast<uint32_t>(state.range(0));
+  std::mt19937 generator(SEED);
+  auto values = randomVector(size, generator);
+  auto vector = randomVector(size, generator);
+
+  std::vector<T> row(size);
+  parameters::convertFromFloat(values.data(), row.data(), size);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        parameters::dotProduct(row.data(), vector.data(), size));
+  }
+  setThroughputCounters(state, /* flops = */ 2ULL * size,
+                        /* bytes = */ size * (sizeof(T) + sizeof(float)));
+}
+BENCHMARK_TEMPLATE(BM_MixedPrecisionDotProduct, float)
+    ->RangeMultiplier(4)
+    ->Range(64, 1 << 16);
+BENCHMARK_TEMPLATE(BM_MixedPrecisionDotProduct, bfloat16)
+    ->RangeMultiplier(4)
+    ->Range(64, 1 << 16);
+BENCHMARK_TEMPLATE(BM_MixedPrecisionDotProduct, float16)
+    ->RangeMultiplier(4)
+    ->Range(64, 1 << 16);
+
+/**
+ * quantization::dotProductU8S8, the inner loop of QuantizedFullyConnected
+ */
+static void BM_Int8DotProduct(benchmark::State& state) {
+  auto size = static_cast<uint32_t>(state.range(0));
+  std::mt19937 generator(SEED);
+  std::uniform_int_distribution<int32_t> activation_distribution(
+      0, quantization::MAX_QUANTIZED_ACTIVATION);
+  std::uniform_int_distribution<int32_t> weight_distribution(
+      -quantization::MAX_QUANTIZED_WEIGHT, quantization::MAX_QUANTIZED_WEIGHT);
+
+  std::vector<uint8_t> activations(size);
+  std::vector<int8_t> weights(size);
+  for (uint32_t index = 0; index < size; index++) {
+    activations[index] =
+        static_cast<uint8_t>(activation_distribution(generator));
+    weights[index] = static_cast<int8_t>(weight_distribution(generator));
+  }
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(quantization::dotProductU8S8(
+        activations.data(), weights.data(), size));
+  }
+  setThroughputCounters(state, /* flops = */ 2ULL * size,
+                        /* bytes = */ 2ULL * size);
+}
+BENCHMARK(BM_Int8DotProduct)->RangeMultiplier(4)->Range(64, 1 << 16);
+
+}  // namespace gladius::benchmarks
@@ -0,0 +1,68 @@
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+static inline const char* DEFAULT_OUTPUT_FILE = "gladius_benchmarks.json";
+
+/**
+ * Records the configuration that the numbers depend on next to the results
+ * so that runs from two builds can be compared safely.
+ */
+static void addBuildContext() {
+  std::string simd = "none";
+#if defined(__AVX512F__)
+  simd = "avx512";
+#elif defined(__AVX2__)
+  simd = "avx2";
+#endif
+  benchmark::AddCustomContext("gladius_simd", simd);
+#if defined(__F16C__)
+  benchmark::AddCustomContext("gladius_f16c", "true");
+#else
+  benchmark::AddCustomContext("gladius_f16c", "false");
+#endif
+#ifdef _OPENMP
+  benchmark::AddCustomContext("gladius_omp_max_threads",
+                              std::to_string(omp_get_max_threads()));
+#endif
+}
+
+/**
+ * Runs the benchmarks like BENCHMARK_MAIN(), except that the results are
+ * also written as JSON to gladius_benchmarks.json unless --benchmark_out is
+ * passed. The JSON output is what we keep to track regressions between
+ * releases, e.g., with tools/compare.py from the benchmark repository.
+ */
+int main(int argc, char** argv) {
+  std::vector<char*> arguments(argv, argv + argc);
+
+  bool has_output_file = false;
+  for (int index = 1; index < argc; index++) {
+    if (std::strncmp(argv[index], "--benchmark_out=", 16) == 0) {
+      has_output_file = true;
+    }
+  }
+  std::string output_file =
+      std::string("--benchmark_out=") + DEFAULT_OUTPUT_FILE;
+  std::string output_format = "--benchmark_out_format=json";
+  if (!has_output_file) {
+    arguments.push_back(output_file.data());
+    arguments.push_back(output_format.data());
+  }
+  int argument_count = static_cast<int>(arguments.size());
+
+  benchmark::Initialize(&argument_count, arguments.data());
+  if (benchmark::ReportUnrecognizedArguments(argument_count,
+                                             arguments.data())) {
+    return 1;
+  }
+  addBuildContext();
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
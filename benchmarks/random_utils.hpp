@@ -0,0 +1,49 @@
+#pragma once
+
+#include <src/comp_graph/vertices/param_vertex.hpp>
+#include <src/params/parameters.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+// Seeded random data, shared with aot_generator which does not link
+// Google Benchmark
+namespace gladius::benchmarks {
+
+using gladius::comp_graph::ParameterVertex;
+using gladius::parameters::Parameter;
+
+/**
+ * Every benchmark draws its inputs from a generator with a fixed seed so
+ * that two runs of the suite (e.g., on two releases) see the same data.
+ */
+static inline constexpr uint32_t SEED = 17;
+
+inline std::vector<float> randomVector(uint64_t size,
+                                       std::mt19937& generator) {
+  std::normal_distribution<float> distribution(0.F, 1.F);
+  std::vector<float> values(size);
+  std::generate(values.begin(), values.end(),
+                [&] { return distribution(generator); });
+  return values;
+}
+
+inline std::vector<std::vector<float>> randomMatrix(uint32_t rows,
+                                                    uint32_t columns,
+                                                    std::mt19937& generator) {
+  std::vector<std::vector<float>> matrix(rows);
+  for (auto& row : matrix) {
+    row = randomVector(columns, generator);
+  }
+  return matrix;
+}
+
+inline std::shared_ptr<ParameterVertex> randomParameterVertex(
+    uint32_t rows, uint32_t columns, std::mt19937& generator) {
+  return std::make_shared<ParameterVertex>(std::make_shared<Parameter>(
+      randomMatrix(rows, columns, generator)));
+}
+
+}  // namespace gladius::benchmarks
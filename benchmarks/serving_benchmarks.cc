@@ -0,0 +1,128 @@
+#include <benchmark/benchmark.h>
+#include <benchmarks/benchmark_utils.hpp>
+#include <src/comp_graph/graph.hpp>
+#include <src/comp_graph/vertices/activ_functions.hpp>
+#include <src/comp_graph/vertices/fully_connected.hpp>
+#include <src/comp_graph/vertices/input_vertex.hpp>
+#include <src/serving/inference_engine.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace gladius::benchmarks {
+
+using gladius::comp_graph::BiasGELUActivation;
+using gladius::comp_graph::FullyConnected;
+using gladius::comp_graph::Graph;
+using gladius::comp_graph::SequenceInputVertex;
+using gladius::comp_graph::VertexPointer;
+using gladius::serving::BatchGraphBuilder;
+using gladius::serving::BatchingPolicy;
+using gladius::serving::InferenceEngine;
+
+static inline constexpr uint32_t SERVING_INPUT_DIMENSION = 128;
+static inline constexpr uint32_t SERVING_HIDDEN_DIMENSION = 512;
+static inline constexpr uint32_t SERVING_CLASSES = 10;
+static inline constexpr uint32_t REQUESTS_PER_CLIENT = 64;
+
+/**
+ * Returns a builder for the MLP  W_2 GELU(W_1 x + b_1) + b_2  applied to
+ * every row of a batch
+ */
+static BatchGraphBuilder servingMLPBuilder() {
+  std::mt19937 generator(SEED);
+  auto parameter = [&](uint32_t rows, uint32_t columns) {
+    return std::make_shared<Parameter>(randomMatrix(rows, columns, generator));
+  };
+  std::vector<std::shared_ptr<Parameter>> parameters = {
+      parameter(SERVING_HIDDEN_DIMENSION, SERVING_INPUT_DIMENSION),
+      parameter(1, SERVING_HIDDEN_DIMENSION),
+      parameter(SERVING_CLASSES, SERVING_HIDDEN_DIMENSION),
+      parameter(1, SERVING_CLASSES)};
+
+  return [parameters](std::vector<float>& inputs, uint32_t batch_size) {
+    auto input = std::make_shared<SequenceInputVertex>(
+        inputs, /* sequence_length = */ batch_size);
+    auto hidden = std::make_shared<FullyConnected>(
+        input, std::make_shared<ParameterVertex>(parameters[0]));
+    auto activation = std::make_shared<BiasGELUActivation>(
+        hidden, std::make_shared<ParameterVertex>(parameters[1]));
+    auto logits = std::make_shared<FullyConnected>(
+        activation, std::make_shared<ParameterVertex>(parameters[2]),
+        std::make_shared<ParameterVertex>(parameters[3]));
+
+    auto graph = std::make_shared<Graph>();
+    for (const VertexPointer& vertex :
+         std::vector<VertexPointer>{input, hidden, activation, logits}) {
+      graph->addVertex(vertex);
+    }
+    return graph;
+  };
+}
+
+/**
+ * Closed-loop load on an InferenceEngine: every client submits a request,
+ * waits for its response and submits the next one, REQUESTS_PER_CLIENT
+ * times per iteration. Reports the requests served per second and the p50
+ * and p99 latencies in microseconds, along with the mean batch size that
+ * the dispatcher formed. A maximum batch size of 1 executes every request
+ * on its own.
+ * Arguments: clients, maximum batch size
+ */
+static void BM_ServingLoad(benchmark::State& state) {
+  auto clients = static_cast<uint32_t>(state.range(0));
+  auto max_batch_size = static_cast<uint32_t>(state.range(1));
+  BatchingPolicy policy = {
+      max_batch_size,
+      std::chrono::microseconds(max_batch_size == 1 ? 0 : 200)};
+  std::mt19937 generator(SEED);
+  auto input = randomVector(SERVING_INPUT_DIMENSION, generator);
+  std::vector<std::vector<double>> latencies(clients);
+
+  InferenceEngine engine(servingMLPBuilder(), SERVING_INPUT_DIMENSION, policy);
+  for (auto _ : state) {
+    std::vector<std::thread> threads;
+    for (uint32_t client = 0; client < clients; client++) {
+      threads.emplace_back([&, client] {
+        for (uint32_t request = 0; request < REQUESTS_PER_CLIENT; request++) {
+          auto submitted = std::chrono::steady_clock::now();
+          auto response = engine.submit(input).get();
+          benchmark::DoNotOptimize(response.data());
+          latencies[client].push_back(
+              std::chrono::duration<double, std::micro>(
+                  std::chrono::steady_clock::now() - submitted)
+                  .count());
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  std::vector<double> all_latencies;
+  for (auto& client_latencies : latencies) {
+    all_latencies.insert(all_latencies.end(), client_latencies.begin(),
+                         client_latencies.end());
+  }
+  std::sort(all_latencies.begin(), all_latencies.end());
+  auto percentile = [&](double fraction) {
+    return all_latencies[static_cast<uint64_t>(
+        fraction * static_cast<double>(all_latencies.size() - 1))];
+  };
+  state.counters["p50_us"] = percentile(0.5);
+  state.counters["p99_us"] = percentile(0.99);
+  state.counters["batch_size"] =
+      static_cast<double>(engine.getRequestCount()) /
+      static_cast<double>(std::max<uint64_t>(engine.getBatchCount(), 1));
+  state.SetItemsProcessed(state.iterations() * clients * REQUESTS_PER_CLIENT);
+}
+BENCHMARK(BM_ServingLoad)
+    ->ArgsProduct({{1, 4, 16}, {1, 32}})
+    ->UseRealTime();
+
+}  // namespace gladius::benchmarks
@@ -0,0 +1,389 @@
+#include <benchmark/benchmark.h>
+#include <benchmarks/benchmark_utils.hpp>
+#include <src/builders/builder_utils.hpp>
+#include <src/comp_graph/graph.hpp>
+#include <src/comp_graph/offloading.hpp>
+#include <src/comp_graph/vertices/activ_functions.hpp>
+#include <src/comp_graph/vertices/fully_connected.hpp>
+#include <src/comp_graph/vertices/input_vertex.hpp>
+#include <src/comp_graph/vertices/loss.hpp>
+#include <src/comp_graph/vertices/summation.hpp>
+#include <src/memory/numa.hpp>
+#include <src/model.hpp>
+#include <src/params/element_types.hpp>
+#include <src/parallel/parallel_for.hpp>
+#include <src/parallel/thread_pool.hpp>
+#include <src/params/parameters.hpp>
+#include <src/trainers/trainer.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace gladius::benchmarks {
+
+using gladius::builders::addModelParameter;
+using gladius::builders::addParameterVertex;
+using gladius::comp_graph::BiasGELUActivation;
+using gladius::comp_graph::CrossEntropyLoss;
+using gladius::comp_graph::FullyConnected;
+using gladius::comp_graph::Graph;
+using gladius::comp_graph::OffloadOptions;
+using gladius::comp_graph::ResidualAddition;
+using gladius::comp_graph::SequenceInputVertex;
+using gladius::comp_graph::VertexPointer;
+using gladius::parameters::ElementType;
+using gladius::trainers::GradientDescentTrainer;
+
+static inline constexpr uint32_t MLP_INPUT_DIMENSION = 784;
+static inline constexpr uint32_t MLP_CLASSES = 10;
+static inline constexpr uint32_t SYNTHETIC_SAMPLES = 64;
+static inline constexpr float LEARNING_RATE = 0.001;
+
+/**
+ * Model with the parameters of a 2-layer MLP on MNIST-shaped inputs:
+ *        CE(W_2 GELU(W_1 x + b_1) + b_2, label)
+ * in the order W_1, b_1, W_2, b_2.
+ */
+static std::shared_ptr<Model> buildMLPModel(uint32_t hidden_dimension) {
+  auto model = std::make_shared<Model>();
+  addModelParameter(model, {hidden_dimension, MLP_INPUT_DIMENSION});
+  addModelParameter(model, {hidden_dimension});
+  addModelParameter(model, {MLP_CLASSES, hidden_dimension});
+  addModelParameter(model, {MLP_CLASSES});
+  return model;
+}
+
+/**
+ * Builds the computation graph of the MLP for a single sample. The sample is
+ * copied since the input vertex takes ownership of its features.
+ */
+static std::unique_ptr<Graph> buildMLPGraph(
+    const std::shared_ptr<Model>& model, const std::vector<float>& sample,
+    uint32_t label) {
+  auto graph = std::make_unique<Graph>();
+  auto features = sample;
+  auto input = std::make_shared<SequenceInputVertex>(features,
+                                                     /* sequence_length = */ 1);
+  graph->addVertex(input);
+
+  auto hidden = std::make_shared<FullyConnected>(
+      input, addParameterVertex(model, *graph, /* param_id = */ 0));
+  graph->addVertex(hidden);
+  auto activation = std::make_shared<BiasGELUActivation>(
+      hidden, addParameterVertex(model, *graph, /* param_id = */ 1));
+  graph->addVertex(activation);
+
+  auto logits = std::make_shared<FullyConnected>(
+      activation, addParameterVertex(model, *graph, /* param_id = */ 2),
+      addParameterVertex(model, *graph, /* param_id = */ 3));
+  graph->addVertex(logits);
+  graph->addVertex(std::make_shared<CrossEntropyLoss>(logits, label));
+  return graph;
+}
+
+static std::vector<std::pair<std::vector<float>, uint32_t>>
+syntheticDataset(std::mt19937& generator) {
+  std::uniform_int_distribution<uint32_t> label_distribution(
+      0, MLP_CLASSES - 1);
+  std::vector<std::pair<std::vector<float>, uint32_t>> dataset;
+  for (uint32_t sample = 0; sample < SYNTHETIC_SAMPLES; sample++) {
+    dataset.emplace_back(randomVector(MLP_INPUT_DIMENSION, generator),
+                         label_distribution(generator));
+  }
+  return dataset;
+}
+
+/**
+ * Parameter::updateParameterValue after a dense gradient update, for fp32
+ * parameters and for parameters that also keep a bf16 copy, which is
+ * re-rounded after every update.
+ * Arguments: rows, columns, storage type (0 = fp32, 1 = bf16)
+ */
+static void BM_ParameterUpdate(benchmark::State& state) {
+  auto rows = static_cast<uint32_t>(state.range(0));
+  auto columns = static_cast<uint32_t>(state.range(1));
+  std::mt19937 generator(SEED);
+
+  Parameter parameter(randomMatrix(rows, columns, generator));
+  if (state.range(2)) {
+    parameter.setStorageType(ElementType::BFloat16);
+  }
+  auto gradient = randomVector(parameter.getParameterCount(), generator);
+  parameter.updateGradient(gradient);
+
+  for (auto _ : state) {
+    parameter.updateParameterValue(/* update_factor = */ -LEARNING_RATE);
+    benchmark::ClobberMemory();
+  }
+  uint64_t count = parameter.getParameterCount();
+  // One read of the gradient and a read and write of the value
+  setThroughputCounters(state, /* flops = */ 2 * count,
+                        /* bytes = */ 3 * count * sizeof(float));
+}
+BENCHMARK(BM_ParameterUpdate)
+    ->ArgsProduct({{256, 1024}, {784, 1024}, {0, 1}});
+
+/**
+ * GradientDescentTrainer::takeDescentStep over every parameter of the MLP
+ * Arguments: hidden dimension
+ */
+static void BM_GradientDescentStep(benchmark::State& state) {
+  auto model = buildMLPModel(static_cast<uint32_t>(state.range(0)));
+  std::mt19937 generator(SEED);
+  for (auto& parameter : model->getParameters()) {
+    auto gradient = randomVector(parameter->getParameterCount(), generator);
+    parameter->updateGradient(gradient);
+  }
+  GradientDescentTrainer trainer(model, LEARNING_RATE);
+
+  for (auto _ : state) {
+    trainer.takeDescentStep();
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_GradientDescentStep)->Arg(128)->Arg(512)->Arg(2048);
+
+/**
+ * Building the MLP graph of one sample, which happens before every training
+ * step since graphs are not reused across samples.
+ * Arguments: hidden dimension
+ */
+static void BM_GraphConstruction(benchmark::State& state) {
+  auto model = buildMLPModel(static_cast<uint32_t>(state.range(0)));
+  std::mt19937 generator(SEED);
+  auto sample = randomVector(MLP_INPUT_DIMENSION, generator);
+
+  for (auto _ : state) {
+    auto graph = buildMLPGraph(model, sample, /* label = */ 0);
+    benchmark::DoNotOptimize(graph.get());
+  }
+}
+BENCHMARK(BM_GraphConstruction)->Arg(128)->Arg(512)->Arg(2048);
+
+/**
+ * A full training step of the MLP on synthetic MNIST-shaped data: zeroing
+ * out the gradients, building the graph, the forward and backward passes
+ * and the descent step. Iterations cycle through a fixed set of samples.
+ * Arguments: hidden dimension
+ */
+static void BM_MLPTrainStep(benchmark::State& state) {
+  auto model = buildMLPModel(static_cast<uint32_t>(state.range(0)));
+  std::mt19937 generator(SEED);
+  auto dataset = syntheticDataset(generator);
+  GradientDescentTrainer trainer(model, LEARNING_RATE);
+
+  uint32_t sample = 0;
+  for (auto _ : state) {
+    auto& [features, label] = dataset[sample];
+    trainer.zeroOutGradients();
+    auto graph = buildMLPGraph(model, features, label);
+    auto [predicted_label, loss] = graph->launchForwardPass();
+    benchmark::DoNotOptimize(loss);
+
+    auto loss_vertex =
+        graph->getVertexAtIndex(graph->getVerticesCount() - 1);
+    std::optional<std::vector<float>> no_upstream_grad = std::nullopt;
+    loss_vertex->backward(no_upstream_grad);
+    trainer.takeDescentStep();
+
+    sample = (sample + 1) % SYNTHETIC_SAMPLES;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MLPTrainStep)->Arg(128)->Arg(512)->Arg(2048);
+
+/**
+ * The forward pass of a graph with independent branches,
+ *        CE(W_o (\sum_b GELU(W_b x + b_b)), label)
+ * which the graph executor runs concurrently. Compare the time per branch
+ * across branch counts (and OMP_NUM_THREADS) to see the inter-op speedup.
+ * The graph is rebuilt outside of the timed region.
+ * Arguments: branches, hidden dimension
+ */
+static void BM_WideForwardPass(benchmark::State& state) {
+  auto branches = static_cast<uint32_t>(state.range(0));
+  auto hidden_dimension = static_cast<uint32_t>(state.range(1));
+  std::mt19937 generator(SEED);
+  auto sample = randomVector(MLP_INPUT_DIMENSION, generator);
+  std::vector<std::pair<std::shared_ptr<ParameterVertex>,
+                        std::shared_ptr<ParameterVertex>>>
+      branch_parameters;
+  for (uint32_t branch = 0; branch < branches; branch++) {
+    branch_parameters.emplace_back(
+        randomParameterVertex(hidden_dimension, MLP_INPUT_DIMENSION,
+                              generator),
+        randomParameterVertex(1, hidden_dimension, generator));
+  }
+  auto output_weights =
+      randomParameterVertex(MLP_CLASSES, hidden_dimension, generator);
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    Graph graph;
+    auto features = sample;
+    auto input = std::make_shared<SequenceInputVertex>(
+        features, /* sequence_length = */ 1);
+    graph.addVertex(input);
+    VertexPointer sum;
+    for (const auto& [weights, bias] : branch_parameters) {
+      auto projection = std::make_shared<FullyConnected>(input, weights);
+      auto activation = std::make_shared<BiasGELUActivation>(projection, bias);
+      graph.addVertex(projection);
+      graph.addVertex(activation);
+      if (sum) {
+        sum = std::make_shared<ResidualAddition>(sum, activation);
+        graph.addVertex(sum);
+      } else {
+        sum = activation;
+      }
+    }
+    auto logits = std::make_shared<FullyConnected>(sum, output_weights);
+    graph.addVertex(logits);
+    graph.addVertex(std::make_shared<CrossEntropyLoss>(logits, 0));
+    state.ResumeTiming();
+
+    auto [predicted_label, loss] = graph.launchForwardPass();
+    benchmark::DoNotOptimize(loss);
+  }
+  setThroughputCounters(
+      state,
+      /* flops = */ 2ULL * branches * hidden_dimension * MLP_INPUT_DIMENSION,
+      /* bytes = */ 4ULL * branches * hidden_dimension * MLP_INPUT_DIMENSION);
+}
+BENCHMARK(BM_WideForwardPass)
+    ->ArgsProduct({{1, 2, 4, 8}, {512, 2048}})
+    ->UseRealTime();
+
+/**
+ * Reads every row of a 256 MiB weight matrix, built by a single thread like
+ * Model::addParameter, from a pinned pool whose workers are spread over the
+ * NUMA nodes. With first-touch placement all the pages sit on the node of
+ * the building thread, so the bandwidth stops scaling once the pool spans a
+ * second socket. The `nodes` counter gives the nodes the pool runs on.
+ * Arguments: threads, placement (0 = first touch, 1 = interleave)
+ */
+static void BM_NumaWeightScan(benchmark::State& state) {
+  constexpr uint32_t ROWS = 16384;
+  constexpr uint32_t COLUMNS = 4096;
+  auto threads = static_cast<uint32_t>(state.range(0));
+  if (state.range(1)) {
+    memory::NumaPolicy::enable(memory::NumaPlacement::Interleave);
+  }
+  Parameter parameter(std::vector<std::vector<float>>(
+      ROWS, std::vector<float>(COLUMNS, 1.F)));
+  memory::NumaPolicy::disable();
+
+  parallel::ThreadPool pool(threads, /* pin_threads = */ true);
+  std::vector<float> row_sums(ROWS);
+  auto& value = parameter.getValue();
+  for (auto _ : state) {
+    parallel::parallelFor(
+        0, ROWS,
+        [&](uint64_t begin, uint64_t end) {
+          for (uint64_t row = begin; row < end; row++) {
+            float sum = 0.F;
+            for (float weight : value[row]) {
+              sum += weight;
+            }
+            row_sums[row] = sum;
+          }
+        },
+        parallel::grainSize(COLUMNS), pool);
+    benchmark::DoNotOptimize(row_sums.data());
+  }
+
+  // Pinned workers take a CPU of every node in turn
+  state.counters["nodes"] =
+      std::min(threads, memory::NumaTopology::get().getNumNodes());
+  setThroughputCounters(state, /* flops = */ uint64_t(ROWS) * COLUMNS,
+                        /* bytes = */ uint64_t(ROWS) * COLUMNS * sizeof(float));
+}
+BENCHMARK(BM_NumaWeightScan)
+    ->Apply([](benchmark::internal::Benchmark* benchmark) {
+      uint32_t cores = std::max(std::thread::hardware_concurrency(), 1U);
+      for (uint32_t threads = 1; threads < cores; threads *= 2) {
+        benchmark->Args({threads, 0})->Args({threads, 1});
+      }
+      benchmark->Args({cores, 0})->Args({cores, 1});
+    })
+    ->UseRealTime();
+
+/**
+ * A training step (forward and backward passes) of a chain of `depth`
+ * blocks GELU(W_i h_i + b_i) of width 2048, with the activations in memory
+ * or offloaded to a spill file. The counters give the share of spilled
+ * outputs that were read back before the backward pass needed them, the
+ * time it waited for the others and the bytes spilled per step. The graph
+ * is rebuilt outside of the timed region.
+ * Arguments: depth, offloading (0 = off, 1 = on)
+ */
+static void BM_OffloadedTrainStep(benchmark::State& state) {
+  constexpr uint32_t WIDTH = 2048;
+  auto depth = static_cast<uint32_t>(state.range(0));
+  std::mt19937 generator(SEED);
+  auto sample = randomVector(WIDTH, generator);
+  std::vector<std::pair<std::shared_ptr<ParameterVertex>,
+                        std::shared_ptr<ParameterVertex>>>
+      block_parameters;
+  for (uint32_t block = 0; block < depth; block++) {
+    block_parameters.emplace_back(
+        randomParameterVertex(WIDTH, WIDTH, generator),
+        randomParameterVertex(1, WIDTH, generator));
+  }
+  auto output_weights = randomParameterVertex(MLP_CLASSES, WIDTH, generator);
+  OffloadOptions options;
+  options.min_bytes = 0;
+
+  double hit_rate = 0.0;
+  double stall_nanoseconds = 0.0;
+  double spilled_bytes = 0.0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    Graph graph;
+    if (state.range(1)) {
+      graph.enableOffloading(options);
+    }
+    auto features = sample;
+    VertexPointer hidden = std::make_shared<SequenceInputVertex>(
+        features, /* sequence_length = */ 1);
+    graph.addVertex(hidden);
+    for (const auto& [weights, bias] : block_parameters) {
+      auto projection = std::make_shared<FullyConnected>(hidden, weights);
+      hidden = std::make_shared<BiasGELUActivation>(projection, bias);
+      graph.addVertex(projection);
+      graph.addVertex(hidden);
+    }
+    auto logits = std::make_shared<FullyConnected>(hidden, output_weights);
+    auto loss = std::make_shared<CrossEntropyLoss>(logits, 0);
+    graph.addVertex(logits);
+    graph.addVertex(loss);
+    state.ResumeTiming();
+
+    graph.launchForwardPass();
+    std::optional<std::vector<float>> no_upstream_grad = std::nullopt;
+    loss->backward(no_upstream_grad);
+
+    if (auto* offloader = graph.getOffloader()) {
+      auto statistics = offloader->getStatistics();
+      hit_rate += statistics.getPrefetchHitRate();
+      stall_nanoseconds += statistics.stall_nanoseconds;
+      spilled_bytes += statistics.spilled_bytes;
+    }
+  }
+  state.counters["hit_rate"] =
+      benchmark::Counter(hit_rate, benchmark::Counter::kAvgIterations);
+  state.counters["stall_ms"] = benchmark::Counter(
+      stall_nanoseconds / 1e6, benchmark::Counter::kAvgIterations);
+  state.counters["spilled_bytes"] =
+      benchmark::Counter(spilled_bytes, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_OffloadedTrainStep)
+    ->ArgsProduct({{8, 32}, {0, 1}})
+    ->UseRealTime();
+
+}  // namespace gladius::benchmarks
@@ -0,0 +1,312 @@
+#include <benchmark/benchmark.h>
+#include <benchmarks/benchmark_utils.hpp>
+#include <src/comp_graph/vertices/activ_functions.hpp>
+#include <src/comp_graph/vertices/fully_connected.hpp>
+#include <src/comp_graph/vertices/inner_product.hpp>
+#include <src/comp_graph/vertices/input_vertex.hpp>
+#include <src/comp_graph/vertices/layer_norm.hpp>
+#include <src/comp_graph/vertices/loss.hpp>
+#include <src/comp_graph/vertices/lsh_sparse_dense.hpp>
+#include <src/comp_graph/vertices/param_vertex.hpp>
+#include <src/comp_graph/vertices/recurrent.hpp>
+#include <src/comp_graph/vertices/sampled_softmax.hpp>
+#include <src/comp_graph/vertices/self_attention.hpp>
+#include <src/comp_graph/vertices/summation.hpp>
+#include <src/comp_graph/vertices/vertex.hpp>
+#include <src/params/element_types.hpp>
+#include <src/sampling/candidate_sampler.hpp>
+#include <src/sampling/lsh_tables.hpp>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <random>
+#include <vector>
+
+namespace gladius::benchmarks {
+
+using gladius::comp_graph::BiasGELUActivation;
+using gladius::comp_graph::CrossEntropyLoss;
+using gladius::comp_graph::FullyConnected;
+using gladius::comp_graph::GRULayer;
+using gladius::comp_graph::InnerProduct;
+using gladius::comp_graph::LayerNorm;
+using gladius::comp_graph::LSHSparseDense;
+using gladius::comp_graph::LSTMLayer;
+using gladius::comp_graph::ReLUActivation;
+using gladius::comp_graph::ResidualAddition;
+using gladius::comp_graph::SampledSoftmaxLoss;
+using gladius::comp_graph::SelfAttention;
+using gladius::comp_graph::SequenceInputVertex;
+using gladius::comp_graph::SoftMaxActivation;
+using gladius::comp_graph::TanHActivation;
+using gladius::comp_graph::VertexPointer;
+using gladius::parameters::ElementType;
+using gladius::sampling::CandidateSampler;
+using gladius::sampling::HashFunction;
+using gladius::sampling::LSHTables;
+
+/**
+ * Builds the vertex under test, with random inputs and parameters, for the
+ * shape given by the arguments of the benchmark. The vertex holds on to its
+ * inputs, so they live as long as it does.
+ */
+using VertexBuilder = VertexPointer (*)(const benchmark::State& state,
+                                        std::mt19937& generator);
+
+static std::shared_ptr<SequenceInputVertex> randomInput(
+    uint32_t rows, uint32_t columns, std::mt19937& generator) {
+  auto features = randomVector(static_cast<uint64_t>(rows) * columns,
+                               generator);
+  return std::make_shared<SequenceInputVertex>(features, rows);
+}
+
+/**
+ * Losses start the backward pass and take no upstream gradient, and can only
+ * be evaluated once, so a new loss is built (outside of the timed region)
+ * before every forward pass. SoftMax, ReLU and TanH assert that their output
+ * is empty before a forward pass, so their output is released (and then
+ * reallocated) in the timed loop.
+ */
+enum class VertexKind { Operation, Activation, Loss };
+
+static void BM_VertexForward(benchmark::State& state, VertexBuilder build,
+                             VertexKind kind) {
+  std::mt19937 generator(SEED);
+  VertexPointer vertex = build(state, generator);
+
+  for (auto _ : state) {
+    if (kind == VertexKind::Loss) {
+      state.PauseTiming();
+      vertex = build(state, generator);
+      state.ResumeTiming();
+    } else if (kind == VertexKind::Activation) {
+      vertex->releaseOutput();
+    }
+    vertex->forward();
+    benchmark::ClobberMemory();
+  }
+  setThroughputCounters(state, /* flops = */ vertex->estimateFlops(),
+                        /* bytes = */ vertex->getBufferBytes());
+}
+
+/**
+ * Times the backward pass of the vertex, which includes the (cheap) backward
+ * passes of its input and parameter vertices. As in the profiler, the
+ * backward pass is assumed to cost twice the FLOPs of the forward pass.
+ */
+static void BM_VertexBackward(benchmark::State& state, VertexBuilder build,
+                              VertexKind kind) {
+  std::mt19937 generator(SEED);
+  VertexPointer vertex = build(state, generator);
+  vertex->forward();
+
+  std::optional<std::vector<float>> upstream_grad = std::nullopt;
+  if (kind != VertexKind::Loss) {
+    auto [rows, columns] = vertex->getOutputShape();
+    upstream_grad =
+        randomVector(static_cast<uint64_t>(rows) * columns, generator);
+  }
+  runBackwardLoop(state, *vertex, upstream_grad);
+  // Losses compute (part of) their gradient with the loss, so the FLOPs of
+  // their backward pass are not reported
+  uint64_t flops = kind == VertexKind::Loss ? 0 : 2 * vertex->estimateFlops();
+  setThroughputCounters(state, flops, /* bytes = */ vertex->getBufferBytes());
+}
+
+// Arguments: rows, input dimension, output dimension
+static VertexPointer buildFullyConnected(const benchmark::State& state,
+                                         std::mt19937& generator) {
+  auto rows = static_cast<uint32_t>(state.range(0));
+  auto input_dimension = static_cast<uint32_t>(state.range(1));
+  auto output_dimension = static_cast<uint32_t>(state.range(2));
+  return std::make_shared<FullyConnected>(
+      randomInput(rows, input_dimension, generator),
+      randomParameterVertex(output_dimension, input_dimension, generator),
+      randomParameterVertex(1, output_dimension, generator));
+}
+
+// Same as above with the weights stored as STORAGE_TYPE, so that the forward
+// and backward passes read them through the mixed-precision kernels
+template <ElementType STORAGE_TYPE>
+static VertexPointer buildCompactFullyConnected(const benchmark::State& state,
+                                                std::mt19937& generator) {
+  auto rows = static_cast<uint32_t>(state.range(0));
+  auto input_dimension = static_cast<uint32_t>(state.range(1));
+  auto output_dimension = static_cast<uint32_t>(state.range(2));
+  auto weights =
+      randomParameterVertex(output_dimension, input_dimension, generator);
+  weights->getParameter()->setStorageType(STORAGE_TYPE);
+  return std::make_shared<FullyConnected>(
+      randomInput(rows, input_dimension, generator), weights,
+      randomParameterVertex(1, output_dimension, generator));
+}
+
+// Arguments: output dimension, input dimension
+static VertexPointer buildInnerProduct(const benchmark::State& state,
+                                       std::mt19937& generator) {
+  auto output_dimension = static_cast<uint32_t>(state.range(0));
+  auto input_dimension = static_cast<uint32_t>(state.range(1));
+  return std::make_shared<InnerProduct>(
+      randomParameterVertex(output_dimension, input_dimension, generator),
+      randomInput(1, input_dimension, generator));
+}
+
+// Arguments: rows, dimension
+static VertexPointer buildBiasGELU(const benchmark::State& state,
+                                   std::mt19937& generator) {
+  auto rows = static_cast<uint32_t>(state.range(0));
+  auto dimension = static_cast<uint32_t>(state.range(1));
+  return std::make_shared<BiasGELUActivation>(
+      randomInput(rows, dimension, generator),
+      randomParameterVertex(1, dimension, generator));
+}
+
+// Arguments: rows, dimension
+static VertexPointer buildLayerNorm(const benchmark::State& state,
+                                    std::mt19937& generator) {
+  auto rows = static_cast<uint32_t>(state.range(0));
+  auto dimension = static_cast<uint32_t>(state.range(1));
+  return std::make_shared<LayerNorm>(
+      randomInput(rows, dimension, generator),
+      randomParameterVertex(1, dimension, generator),
+      randomParameterVertex(1, dimension, generator));
+}
+
+// Arguments: rows, dimension
+static VertexPointer buildResidualAddition(const benchmark::State& state,
+                                           std::mt19937& generator) {
+  auto rows = static_cast<uint32_t>(state.range(0));
+  auto dimension = static_cast<uint32_t>(state.range(1));
+  return std::make_shared<ResidualAddition>(
+      randomInput(rows, dimension, generator),
+      randomInput(rows, dimension, generator));
+}
+
+// Arguments: dimension
+template <typename Activation>
+static VertexPointer buildActivation(const benchmark::State& state,
+                                     std::mt19937& generator) {
+  auto dimension = static_cast<uint32_t>(state.range(0));
+  return std::make_shared<Activation>(std::vector<VertexPointer>{
+      randomInput(/* rows = */ 1, dimension, generator)});
+}
+
+// Arguments: number of classes
+static VertexPointer buildCrossEntropyLoss(const benchmark::State& state,
+                                           std::mt19937& generator) {
+  auto num_classes = static_cast<uint32_t>(state.range(0));
+  return std::make_shared<CrossEntropyLoss>(
+      randomInput(/* rows = */ 1, num_classes, generator),
+      /* label = */ num_classes / 2);
+}
+
+// Arguments: number of classes, hidden dimension, number of sampled classes
+static VertexPointer buildSampledSoftmax(const benchmark::State& state,
+                                         std::mt19937& generator) {
+  auto num_classes = static_cast<uint32_t>(state.range(0));
+  auto dimension = static_cast<uint32_t>(state.range(1));
+  auto num_sampled = static_cast<uint32_t>(state.range(2));
+  auto sampler = std::make_shared<CandidateSampler>(
+      CandidateSampler::logUniform(num_classes, /* seed = */ SEED));
+  return std::make_shared<SampledSoftmaxLoss>(
+      randomInput(/* rows = */ 1, dimension, generator),
+      randomParameterVertex(num_classes, dimension, generator),
+      /* label = */ num_classes / 2, sampler, num_sampled);
+}
+
+// Arguments: output dimension, input dimension
+static VertexPointer buildLSHSparseDense(const benchmark::State& state,
+                                         std::mt19937& generator) {
+  auto output_dimension = static_cast<uint32_t>(state.range(0));
+  auto input_dimension = static_cast<uint32_t>(state.range(1));
+  auto weights =
+      randomParameterVertex(output_dimension, input_dimension, generator);
+  auto hash_tables = std::make_shared<LSHTables>(
+      HashFunction::SimHash, input_dimension, /* num_tables = */ 8,
+      /* hashes_per_table = */ 8);
+  hash_tables->build(weights->getParameter()->getValue());
+
+  return std::make_shared<LSHSparseDense>(
+      randomInput(/* rows = */ 1, input_dimension, generator), weights,
+      randomParameterVertex(1, output_dimension, generator), hash_tables);
+}
+
+// Arguments: sequence length, model dimension, number of heads
+static VertexPointer buildSelfAttention(const benchmark::State& state,
+                                        std::mt19937& generator) {
+  auto sequence_length = static_cast<uint32_t>(state.range(0));
+  auto model_dimension = static_cast<uint32_t>(state.range(1));
+  auto num_heads = static_cast<uint32_t>(state.range(2));
+  return std::make_shared<SelfAttention>(
+      randomInput(sequence_length, 3 * model_dimension, generator), num_heads,
+      /* causal = */ true);
+}
+
+// Arguments: timesteps, hidden dimension
+static VertexPointer buildLSTM(const benchmark::State& state,
+                               std::mt19937& generator) {
+  auto timesteps = static_cast<uint32_t>(state.range(0));
+  auto hidden_dimension = static_cast<uint32_t>(state.range(1));
+  return std::make_shared<LSTMLayer>(
+      randomInput(timesteps, 4 * hidden_dimension, generator),
+      randomParameterVertex(4 * hidden_dimension, hidden_dimension,
+                            generator));
+}
+
+// Arguments: timesteps, hidden dimension
+static VertexPointer buildGRU(const benchmark::State& state,
+                              std::mt19937& generator) {
+  auto timesteps = static_cast<uint32_t>(state.range(0));
+  auto hidden_dimension = static_cast<uint32_t>(state.range(1));
+  return std::make_shared<GRULayer>(
+      randomInput(timesteps, 3 * hidden_dimension, generator),
+      randomParameterVertex(3 * hidden_dimension, hidden_dimension,
+                            generator),
+      randomParameterVertex(1, 3 * hidden_dimension, generator));
+}
+
+/**
+ * Registers the forward and backward benchmarks of a vertex for the product
+ * of the given argument lists (see the builders above for the meaning of
+ * each argument).
+ */
+#define GLADIUS_VERTEX_BENCHMARK(name, builder, kind, ...)                  \
+  BENCHMARK_CAPTURE(BM_VertexForward, name, builder, VertexKind::kind)      \
+      ->ArgsProduct({__VA_ARGS__});                                         \
+  BENCHMARK_CAPTURE(BM_VertexBackward, name, builder, VertexKind::kind)     \
+      ->ArgsProduct({__VA_ARGS__})
+
+GLADIUS_VERTEX_BENCHMARK(FullyConnected, buildFullyConnected, Operation,
+                         {1, 32, 128}, {128, 512}, {128, 512});
+GLADIUS_VERTEX_BENCHMARK(FullyConnectedBF16,
+                         buildCompactFullyConnected<ElementType::BFloat16>,
+                         Operation, {1, 32, 128}, {128, 512}, {128, 512});
+GLADIUS_VERTEX_BENCHMARK(FullyConnectedFP16,
+                         buildCompactFullyConnected<ElementType::Float16>,
+                         Operation, {1, 32, 128}, {128, 512}, {128, 512});
+GLADIUS_VERTEX_BENCHMARK(InnerProduct, buildInnerProduct, Operation, {10, 256},
+                         {256, 784});
+GLADIUS_VERTEX_BENCHMARK(BiasGELU, buildBiasGELU, Operation, {1, 32, 128},
+                         {256, 1024});
+GLADIUS_VERTEX_BENCHMARK(LayerNorm, buildLayerNorm, Operation, {1, 32, 128},
+                         {256, 1024});
+GLADIUS_VERTEX_BENCHMARK(ResidualAddition, buildResidualAddition, Operation,
+                         {1, 32, 128}, {256, 1024});
+GLADIUS_VERTEX_BENCHMARK(ReLU, buildActivation<ReLUActivation>, Activation,
+                         {64, 256, 1024});
+GLADIUS_VERTEX_BENCHMARK(TanH, buildActivation<TanHActivation>, Activation,
+                         {64, 256, 1024});
+GLADIUS_VERTEX_BENCHMARK(SoftMax, buildActivation<SoftMaxActivation>,
+                         Activation, {64, 256, 1024});
+GLADIUS_VERTEX_BENCHMARK(CrossEntropyLoss, buildCrossEntropyLoss, Loss,
+                         {10, 1000, 10000});
+GLADIUS_VERTEX_BENCHMARK(SampledSoftmaxLoss, buildSampledSoftmax, Loss,
+                         {10000, 100000}, {128}, {16, 64});
+GLADIUS_VERTEX_BENCHMARK(LSHSparseDense, buildLSHSparseDense, Operation,
+                         {1024, 8192}, {128});
+GLADIUS_VERTEX_BENCHMARK(SelfAttention, buildSelfAttention, Operation,
+                         {16, 64, 256}, {64, 256}, {4});
+GLADIUS_VERTEX_BENCHMARK(LSTM, buildLSTM, Operation, {16, 64}, {64, 256});
+GLADIUS_VERTEX_BENCHMARK(GRU, buildGRU, Operation, {16, 64}, {64, 256});
+
+}  // namespace gladius::benchmarks
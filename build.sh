@@ -3,10 +3,14 @@
 mkdir -p build 
 
 TESTING=OFF
+BENCHMARKING=OFF
 
-if [ $1 = "tests" ]
+if [ "$1" = "tests" ]
 then 
     TESTING=ON
+elif [ "$1" = "benchmarks" ]
+then
+    BENCHMARKING=ON
 fi
 
 
@@ -15,6 +19,6 @@ fi
 ## DCMAKE_CXX_COMPILER:FILEPATH sets the compiler path 
 ## DCMAKE_EXPORT_COMPILE_COMMANDS=OFF since clangd seems to consume so much 
 ## memory and cpu time 
-cd build && cmake -DBUILD_TESTS=${TESTING} -DCMAKE_EXPORT_COMPILE_COMMANDS=ON -DCMAKE_CXX_COMPILER:FILEPATH=/usr/local/opt/llvm/bin/clang++ ..
+cd build && cmake -DBUILD_TESTS=${TESTING} -DBUILD_BENCHMARKS=${BENCHMARKING} -DCMAKE_EXPORT_COMPILE_COMMANDS=ON -DCMAKE_CXX_COMPILER:FILEPATH=/usr/local/opt/llvm/bin/clang++ ..
 make -j 8
 cd ..
\ No newline at end of file
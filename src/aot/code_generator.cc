@@ -0,0 +1,584 @@
+#include <src/aot/code_generator.hpp>
+#include <src/comp_graph/constant_folding.hpp>
+#include <src/comp_graph/vertices/activ_functions.hpp>
+#include <src/comp_graph/vertices/fully_connected.hpp>
+#include <src/comp_graph/vertices/inner_product.hpp>
+#include <src/comp_graph/vertices/input_vertex.hpp>
+#include <src/comp_graph/vertices/layer_norm.hpp>
+#include <src/comp_graph/vertices/loss.hpp>
+#include <src/comp_graph/vertices/param_vertex.hpp>
+#include <src/comp_graph/vertices/summation.hpp>
+#include <src/comp_graph/vertices/vertex.hpp>
+#include <src/params/parameters.hpp>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace gladius::aot {
+
+using gladius::comp_graph::BiasGELUActivation;
+using gladius::comp_graph::CrossEntropyLoss;
+using gladius::comp_graph::FullyConnected;
+using gladius::comp_graph::InnerProduct;
+using gladius::comp_graph::LayerNorm;
+using gladius::comp_graph::ParameterVertex;
+using gladius::comp_graph::ReLUActivation;
+using gladius::comp_graph::ResidualAddition;
+using gladius::comp_graph::SequenceInputVertex;
+using gladius::comp_graph::SoftMaxActivation;
+using gladius::comp_graph::TanHActivation;
+using gladius::comp_graph::Vertex;
+using gladius::comp_graph::VertexPointer;
+using gladius::parameters::Parameter;
+
+// Buffers and parameters start on a 64-byte boundary
+static inline constexpr uint64_t ALIGNMENT = 64 / sizeof(float);
+
+static inline uint64_t alignUp(uint64_t floats) {
+  return (floats + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+/**
+ * Kernels of the generated code by name, with the same arithmetic as the
+ * forward pass of the corresponding vertices. Only the ones that the graph
+ * uses are emitted.
+ */
+static const std::map<std::string, std::string>& kernels() {
+  static const std::map<std::string, std::string> kernels = {
+      {"add", R"(template <uint64_t SIZE>
+inline void add(const float* __restrict left, const float* __restrict right,
+                float* __restrict output) {
+#pragma omp simd
+  for (uint64_t index = 0; index < SIZE; index++) {
+    output[index] = left[index] + right[index];
+  }
+}
+)"},
+      {"biasGELU", R"(template <uint32_t ROWS, uint32_t DIMENSION>
+inline void biasGELU(const float* __restrict input,
+                     const float* __restrict bias, float* __restrict output) {
+  for (uint32_t row = 0; row < ROWS; row++) {
+    uint64_t offset = static_cast<uint64_t>(row) * DIMENSION;
+#pragma omp simd
+    for (uint32_t col = 0; col < DIMENSION; col++) {
+      float z = input[offset + col] + bias[col];
+      float tanh_u = std::tanh(0.7978845608F * (z + 0.044715F * z * z * z));
+      output[offset + col] = 0.5F * z * (1.F + tanh_u);
+    }
+  }
+}
+)"},
+      {"fullyConnected", R"(template <uint32_t ROWS, uint32_t INPUTS,
+          uint32_t OUTPUTS, bool BIASED>
+inline void fullyConnected(const float* __restrict input,
+                           const float* __restrict weights,
+                           const float* __restrict bias,
+                           float* __restrict output) {
+  for (uint32_t row = 0; row < ROWS; row++) {
+    const float* input_row = input + static_cast<uint64_t>(row) * INPUTS;
+    for (uint32_t neuron = 0; neuron < OUTPUTS; neuron++) {
+      const float* weight_row =
+          weights + static_cast<uint64_t>(neuron) * INPUTS;
+      float activation = 0.F;
+#pragma omp simd reduction(+ : activation)
+      for (uint32_t col = 0; col < INPUTS; col++) {
+        activation += weight_row[col] * input_row[col];
+      }
+      if constexpr (BIASED) {
+        activation += bias[neuron];
+      }
+      output[static_cast<uint64_t>(row) * OUTPUTS + neuron] = activation;
+    }
+  }
+}
+)"},
+      {"hyperbolicTangent", R"(template <uint64_t SIZE>
+inline void hyperbolicTangent(const float* __restrict input,
+                              float* __restrict output) {
+  for (uint64_t index = 0; index < SIZE; index++) {
+    float exponential_term = std::exp(-2 * input[index]);
+    output[index] = (1 - exponential_term) / (1 + exponential_term);
+  }
+}
+)"},
+      {"layerNorm", R"(template <uint32_t ROWS, uint32_t DIMENSION>
+inline void layerNorm(const float* __restrict input,
+                      const float* __restrict gain,
+                      const float* __restrict bias, float epsilon,
+                      float* __restrict output) {
+  for (uint32_t row = 0; row < ROWS; row++) {
+    const float* input_row = input + static_cast<uint64_t>(row) * DIMENSION;
+    float* output_row = output + static_cast<uint64_t>(row) * DIMENSION;
+    float sum = 0.F;
+#pragma omp simd reduction(+ : sum)
+    for (uint32_t col = 0; col < DIMENSION; col++) {
+      sum += input_row[col];
+    }
+    float mean = sum / DIMENSION;
+    float sum_squares = 0.F;
+#pragma omp simd reduction(+ : sum_squares)
+    for (uint32_t col = 0; col < DIMENSION; col++) {
+      float deviation = input_row[col] - mean;
+      sum_squares += deviation * deviation;
+    }
+    float inverse_std = 1.F / std::sqrt(sum_squares / DIMENSION + epsilon);
+#pragma omp simd
+    for (uint32_t col = 0; col < DIMENSION; col++) {
+      output_row[col] =
+          gain[col] * (input_row[col] - mean) * inverse_std + bias[col];
+    }
+  }
+}
+)"},
+      {"matrixVector", R"(template <uint32_t ROWS, uint32_t COLUMNS>
+inline void matrixVector(const float* __restrict weights,
+                         const float* __restrict input,
+                         float* __restrict output) {
+  for (uint32_t row = 0; row < ROWS; row++) {
+    const float* weight_row = weights + static_cast<uint64_t>(row) * COLUMNS;
+    float activation = 0.F;
+#pragma omp simd reduction(+ : activation)
+    for (uint32_t col = 0; col < COLUMNS; col++) {
+      activation += weight_row[col] * input[col];
+    }
+    output[row] = activation;
+  }
+}
+)"},
+      {"relu", R"(template <uint64_t SIZE>
+inline void relu(const float* __restrict input, float* __restrict output) {
+#pragma omp simd
+  for (uint64_t index = 0; index < SIZE; index++) {
+    output[index] = input[index] > 0 ? input[index] : 0;
+  }
+}
+)"},
+      {"softmax", R"(template <uint64_t SIZE>
+inline void softmax(const float* __restrict input, float* __restrict output) {
+  float max_element = *std::max_element(input, input + SIZE);
+  float sum_exps = 0.F;
+  for (uint64_t index = 0; index < SIZE; index++) {
+    sum_exps += std::exp(input[index] - max_element);
+  }
+  for (uint64_t index = 0; index < SIZE; index++) {
+    output[index] = std::exp(input[index] - max_element) / sum_exps;
+  }
+}
+)"},
+  };
+  return kernels;
+}
+
+/**
+ * Returns `value` as an exact (hexadecimal) float literal
+ */
+static std::string floatLiteral(float value) {
+  if (!std::isfinite(value)) {
+    throw std::invalid_argument(
+        "Cannot generate code for a graph with non-finite parameters.");
+  }
+  std::ostringstream stream;
+  stream << std::hexfloat << value << "F";
+  return stream.str();
+}
+
+/**
+ * Offsets of the outputs of the vertices in the workspace. A block released
+ * after the last consumer of its vertex has run is reused by the vertices
+ * that come after it.
+ */
+class WorkspaceLayout {
+ public:
+  uint64_t allocate(uint64_t size) {
+    size = alignUp(size);
+    // First fit
+    for (auto block = _free_blocks.begin(); block != _free_blocks.end();
+         block++) {
+      auto [offset, block_size] = *block;
+      if (block_size < size) {
+        continue;
+      }
+      _free_blocks.erase(block);
+      if (block_size > size) {
+        _free_blocks.emplace(offset + size, block_size - size);
+      }
+      return offset;
+    }
+    auto offset = _size;
+    _size += size;
+    return offset;
+  }
+
+  void release(uint64_t offset, uint64_t size) {
+    size = alignUp(size);
+    auto next = _free_blocks.lower_bound(offset);
+    // Merges the block with its free neighbours
+    if (next != _free_blocks.end() && offset + size == next->first) {
+      size += next->second;
+      next = _free_blocks.erase(next);
+    }
+    if (next != _free_blocks.begin()) {
+      auto previous = std::prev(next);
+      if (previous->first + previous->second == offset) {
+        previous->second += size;
+        return;
+      }
+    }
+    _free_blocks.emplace(offset, size);
+  }
+
+  inline uint64_t getSize() const { return _size; }
+
+ private:
+  // Size of the free blocks by offset
+  std::map<uint64_t, uint64_t> _free_blocks;
+  uint64_t _size = 0;
+};
+
+static inline uint64_t outputSize(const Vertex& vertex) {
+  auto [rows, columns] = vertex.getOutputShape();
+  return static_cast<uint64_t>(rows) * columns;
+}
+
+GeneratedCode generateCode(Graph& graph,
+                           const CodeGenerationOptions& options) {
+  std::vector<VertexPointer> vertices;
+  for (uint32_t index = 0; index < graph.getVerticesCount(); index++) {
+    vertices.push_back(graph.getVertexAtIndex(index));
+  }
+  // The loss is skipped, as in Graph::launchInferencePass()
+  if (!vertices.empty() &&
+      std::dynamic_pointer_cast<CrossEntropyLoss>(vertices.back())) {
+    vertices.pop_back();
+  }
+  if (vertices.empty() || vertices.back()->getInputs().empty()) {
+    throw std::invalid_argument(
+        "Cannot generate code for a graph that computes nothing.");
+  }
+  const Vertex* output_vertex = vertices.back().get();
+
+  std::unordered_map<const Vertex*, uint32_t> last_use;
+  for (uint32_t index = 0; index < vertices.size(); index++) {
+    for (const auto& input : vertices[index]->getInputs()) {
+      last_use[input.get()] = index;
+    }
+  }
+
+  // Parameters in order of first use, and where they start in the weights
+  std::vector<Parameter*> parameters;
+  std::vector<uint64_t> parameter_offsets;
+  std::unordered_map<const Parameter*, std::string> parameter_names;
+  uint64_t weights_size = 0;
+  auto parameterName = [&](const std::shared_ptr<ParameterVertex>& vertex) {
+    Parameter* parameter = vertex->getParameter().get();
+    auto [entry, inserted] = parameter_names.emplace(
+        parameter, "PARAMETER_" + std::to_string(parameters.size()));
+    if (inserted) {
+      parameters.push_back(parameter);
+      parameter_offsets.push_back(weights_size);
+      weights_size += alignUp(parameter->getParameterCount());
+    }
+    return entry->second;
+  };
+
+  // Expressions for the outputs of the vertices computed so far
+  std::unordered_map<const Vertex*, std::string> buffers;
+  std::unordered_map<const Vertex*, uint64_t> offsets;
+  auto bufferOf = [&](const VertexPointer& vertex) -> std::string {
+    if (auto parameter = std::dynamic_pointer_cast<ParameterVertex>(vertex)) {
+      return parameterName(parameter);
+    }
+    auto buffer = buffers.find(vertex.get());
+    if (buffer == buffers.end()) {
+      throw std::invalid_argument("Cannot generate code for a graph that "
+                                  "reads a " +
+                                  vertex->getName() +
+                                  " vertex that is not in the graph.");
+    }
+    return buffer->second;
+  };
+
+  WorkspaceLayout workspace;
+  std::set<std::string> used_kernels;
+  std::ostringstream body;
+  std::pair<uint32_t, uint32_t> input_shape;
+  bool has_input = false;
+  uint32_t operations = 0;
+
+  for (uint32_t index = 0; index < vertices.size(); index++) {
+    const auto& vertex = vertices[index];
+    if (std::dynamic_pointer_cast<ParameterVertex>(vertex)) {
+      continue;
+    }
+    if (std::dynamic_pointer_cast<SequenceInputVertex>(vertex)) {
+      if (has_input) {
+        throw std::invalid_argument(
+            "Cannot generate code for a graph with several inputs.");
+      }
+      has_input = true;
+      input_shape = vertex->getOutputShape();
+      buffers[vertex.get()] = "input";
+      continue;
+    }
+
+    std::string output = "output";
+    if (vertex.get() != output_vertex) {
+      offsets[vertex.get()] = workspace.allocate(outputSize(*vertex));
+      output = "workspace + " + std::to_string(offsets[vertex.get()]);
+    }
+    std::string kernel;
+    std::ostringstream call;
+    if (auto layer = std::dynamic_pointer_cast<FullyConnected>(vertex)) {
+      kernel = "fullyConnected";
+      auto [rows, input_dimension] = layer->getInput()->getOutputShape();
+      call << "<" << rows << ", " << input_dimension << ", "
+           << layer->getOutputShape().second << ", "
+           << (layer->getBias() ? "true" : "false") << ">("
+           << bufferOf(layer->getInput()) << ", "
+           << parameterName(layer->getWeights()) << ", "
+           << (layer->getBias() ? parameterName(layer->getBias()) : "nullptr")
+           << ", " << output << ");";
+    } else if (auto product = std::dynamic_pointer_cast<InnerProduct>(vertex)) {
+      auto weights =
+          std::dynamic_pointer_cast<ParameterVertex>(product->getLeftInput());
+      if (!weights || !comp_graph::isMatrixVectorProduct(*product) ||
+          product->getRightInput()->getOutputShape().first != 1 ||
+          std::dynamic_pointer_cast<comp_graph::SparseInputVertex>(
+              product->getRightInput())) {
+        throw std::invalid_argument(
+            "Code can only be generated for InnerProduct vertices that "
+            "multiply a weight parameter by a dense vector.");
+      }
+      kernel = "matrixVector";
+      auto [rows, columns] = weights->getOutputShape();
+      call << "<" << rows << ", " << columns << ">(" << parameterName(weights)
+           << ", " << bufferOf(product->getRightInput()) << ", " << output
+           << ");";
+    } else if (auto activation =
+                   std::dynamic_pointer_cast<BiasGELUActivation>(vertex)) {
+      kernel = "biasGELU";
+      auto [rows, dimension] = activation->getOutputShape();
+      call << "<" << rows << ", " << dimension << ">("
+           << bufferOf(activation->getInput()) << ", "
+           << parameterName(activation->getBias()) << ", " << output << ");";
+    } else if (auto norm = std::dynamic_pointer_cast<LayerNorm>(vertex)) {
+      kernel = "layerNorm";
+      auto [rows, dimension] = norm->getOutputShape();
+      call << "<" << rows << ", " << dimension << ">("
+           << bufferOf(norm->getInput()) << ", "
+           << parameterName(norm->getGain()) << ", "
+           << parameterName(norm->getBias()) << ", "
+           << floatLiteral(norm->getEpsilon()) << ", " << output << ");";
+    } else if (std::dynamic_pointer_cast<ResidualAddition>(vertex)) {
+      kernel = "add";
+      auto inputs = vertex->getInputs();
+      call << "<" << outputSize(*vertex) << ">(" << bufferOf(inputs[0])
+           << ", " << bufferOf(inputs[1]) << ", " << output << ");";
+    } else if (std::dynamic_pointer_cast<ReLUActivation>(vertex) ||
+               std::dynamic_pointer_cast<TanHActivation>(vertex) ||
+               std::dynamic_pointer_cast<SoftMaxActivation>(vertex)) {
+      kernel = std::dynamic_pointer_cast<ReLUActivation>(vertex) ? "relu"
+               : std::dynamic_pointer_cast<TanHActivation>(vertex)
+                   ? "hyperbolicTangent"
+                   : "softmax";
+      call << "<" << outputSize(*vertex) << ">("
+           << bufferOf(vertex->getInputs().at(0)) << ", " << output << ");";
+    } else {
+      throw std::invalid_argument("Cannot generate code for a " +
+                                  vertex->getName() + " vertex.");
+    }
+    used_kernels.insert(kernel);
+    body << "  " << kernel << call.str() << "\n";
+    buffers[vertex.get()] = std::move(output);
+    operations++;
+
+    for (const auto& input : vertex->getInputs()) {
+      auto offset = offsets.find(input.get());
+      if (offset != offsets.end() && last_use.at(input.get()) == index) {
+        workspace.release(offset->second, outputSize(*input));
+        offsets.erase(offset);
+      }
+    }
+    // Outputs that nothing reads
+    if (!last_use.count(vertex.get()) && offsets.count(vertex.get())) {
+      workspace.release(offsets[vertex.get()], outputSize(*vertex));
+      offsets.erase(vertex.get());
+    }
+  }
+  if (!has_input) {
+    throw std::invalid_argument(
+        "Cannot generate code for a graph without a SequenceInputVertex.");
+  }
+
+  bool mapped = options.weight_storage == WeightStorage::Mapped;
+  auto [output_rows, output_dimension] = output_vertex->getOutputShape();
+  GeneratedCode code;
+  code.file_stem = options.file_stem;
+
+  std::ostringstream header;
+  header << "// Generated by gladius::aot::generateCode(). Do not edit.\n"
+         << "#pragma once\n\n"
+         << "#include <cstdint>\n\n"
+         << "namespace " << options.name_space << " {\n\n"
+         << "inline constexpr uint32_t INPUT_ROWS = " << input_shape.first
+         << ";\n"
+         << "inline constexpr uint32_t INPUT_DIMENSION = " << input_shape.second
+         << ";\n"
+         << "inline constexpr uint32_t OUTPUT_ROWS = " << output_rows << ";\n"
+         << "inline constexpr uint32_t OUTPUT_DIMENSION = " << output_dimension
+         << ";\n"
+         << "// Floats of scratch memory used by run()\n"
+         << "inline constexpr uint64_t WORKSPACE_SIZE = " << workspace.getSize()
+         << ";\n";
+  if (mapped) {
+    header << "// Floats in the weights file\n"
+           << "inline constexpr uint64_t WEIGHTS_SIZE = " << weights_size
+           << ";\n\n"
+           << "// Maps the weights file into memory, which must succeed "
+              "before run()\n"
+           << "// is called. Returns false if the file cannot be mapped or "
+              "has the\n"
+           << "// wrong size.\n"
+           << "bool loadWeights(const char* path);\n"
+           << "void unloadWeights();\n";
+  }
+  header << "\n"
+         << "// Computes the (OUTPUT_ROWS, OUTPUT_DIMENSION) output for a\n"
+         << "// (INPUT_ROWS, INPUT_DIMENSION) input, both row by row. The\n"
+         << "// workspace holds WORKSPACE_SIZE floats.\n"
+         << "void run(const float* input, float* output, float* workspace);\n"
+         << "// Same, with a thread-local workspace\n"
+         << "void run(const float* input, float* output);\n\n"
+         << "}  // namespace " << options.name_space << "\n";
+  code.header = header.str();
+
+  std::ostringstream source;
+  source << "// Generated by gladius::aot::generateCode() from a graph of "
+         << graph.getVerticesCount() << " vertices: " << operations
+         << " operations\n// and " << parameters.size()
+         << " parameters. Do not edit.\n"
+         << "#include \"" << options.file_stem << ".hpp\"\n"
+         << "#include <algorithm>\n#include <cmath>\n#include <cstdint>\n";
+  if (mapped) {
+    source << "#include <fcntl.h>\n#include <sys/mman.h>\n"
+           << "#include <sys/stat.h>\n#include <unistd.h>\n";
+  }
+  source << "\nnamespace " << options.name_space << " {\n"
+         << "namespace {\n\n";
+  for (const auto& [name, kernel] : kernels()) {
+    if (used_kernels.count(name)) {
+      source << kernel << "\n";
+    }
+  }
+
+  if (mapped) {
+    code.weights.assign(weights_size, 0.F);
+  }
+  for (uint32_t index = 0; index < parameters.size(); index++) {
+    auto& value = parameters[index]->getValue();
+    const auto& name = parameter_names.at(parameters[index]);
+    if (mapped) {
+      source << "const float* " << name << " = nullptr;\n";
+      uint64_t offset = parameter_offsets[index];
+      for (const auto& row : value) {
+        std::copy(row.begin(), row.end(), code.weights.begin() + offset);
+        offset += row.size();
+      }
+      continue;
+    }
+    source << "alignas(64) const float " << name << "["
+           << parameters[index]->getParameterCount() << "] = {";
+    uint64_t count = 0;
+    for (const auto& row : value) {
+      for (float element : row) {
+        source << (count++ % 4 == 0 ? "\n    " : " ") << floatLiteral(element)
+               << ",";
+      }
+    }
+    source << "\n};\n\n";
+  }
+
+  if (mapped) {
+    source << "void* mapped_weights = nullptr;\n\n"
+           << "}  // namespace\n\n"
+           << "void unloadWeights() {\n"
+           << "  if (mapped_weights) {\n"
+           << "    munmap(mapped_weights, WEIGHTS_SIZE * sizeof(float));\n"
+           << "    mapped_weights = nullptr;\n"
+           << "  }\n"
+           << "}\n\n"
+           << "bool loadWeights(const char* path) {\n"
+           << "  int descriptor = open(path, O_RDONLY);\n"
+           << "  if (descriptor < 0) {\n"
+           << "    return false;\n"
+           << "  }\n"
+           << "  struct stat status;\n"
+           << "  if (fstat(descriptor, &status) != 0 ||\n"
+           << "      static_cast<uint64_t>(status.st_size) !=\n"
+           << "          WEIGHTS_SIZE * sizeof(float)) {\n"
+           << "    close(descriptor);\n"
+           << "    return false;\n"
+           << "  }\n"
+           << "  void* mapping = mmap(nullptr, WEIGHTS_SIZE * sizeof(float), "
+              "PROT_READ,\n"
+           << "                       MAP_PRIVATE, descriptor, 0);\n"
+           << "  close(descriptor);\n"
+           << "  if (mapping == MAP_FAILED) {\n"
+           << "    return false;\n"
+           << "  }\n"
+           << "  unloadWeights();\n"
+           << "  mapped_weights = mapping;\n"
+           << "  const auto* weights = static_cast<const float*>(mapping);\n";
+    for (uint32_t index = 0; index < parameters.size(); index++) {
+      source << "  " << parameter_names.at(parameters[index])
+             << " = weights + " << parameter_offsets[index] << ";\n";
+    }
+    source << "  return true;\n"
+           << "}\n\n";
+  } else {
+    source << "}  // namespace\n\n";
+  }
+
+  source << "void run(const float* input, float* output, float* workspace) "
+            "{\n"
+         << "  (void)workspace;\n"
+         << body.str() << "}\n\n"
+         << "void run(const float* input, float* output) {\n"
+         << "  alignas(64) static thread_local float\n"
+         << "      workspace[WORKSPACE_SIZE > 0 ? WORKSPACE_SIZE : 1];\n"
+         << "  run(input, output, workspace);\n"
+         << "}\n\n"
+         << "}  // namespace " << options.name_space << "\n";
+  code.source = source.str();
+  return code;
+}
+
+void GeneratedCode::write(const std::string& directory) const {
+  auto writeFile = [&](const std::string& extension, const char* data,
+                       uint64_t size, std::ios::openmode mode) {
+    auto path = directory + "/" + file_stem + extension;
+    std::ofstream file(path, mode | std::ios::trunc);
+    file.write(data, static_cast<std::streamsize>(size));
+    if (!file) {
+      throw std::runtime_error("Unable to write " + path + ".");
+    }
+  };
+  writeFile(".hpp", header.data(), header.size(), std::ios::out);
+  writeFile(".cc", source.data(), source.size(), std::ios::out);
+  if (!weights.empty()) {
+    writeFile(".weights", reinterpret_cast<const char*>(weights.data()),
+              weights.size() * sizeof(float),
+              std::ios::out | std::ios::binary);
+  }
+}
+
+}  // namespace gladius::aot
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <src/comp_graph/graph.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gladius::aot {
+
+using gladius::comp_graph::Graph;
+
+/**
+ * Where the generated code reads the parameters from
+ */
+enum class WeightStorage {
+  // Compiled into the translation unit as constant arrays
+  Embedded,
+  // Read from a separate file that loadWeights() maps into memory, which
+  // keeps the translation unit (and its compile time) small for large models
+  Mapped
+};
+
+struct CodeGenerationOptions {
+  // Namespace of the generated constants and functions
+  std::string name_space = "gladius_aot";
+  // Name of the generated files, without extension. The source includes the
+  // header as "<file_stem>.hpp".
+  std::string file_stem = "gladius_aot_model";
+  WeightStorage weight_storage = WeightStorage::Embedded;
+};
+
+/**
+ * The files generated for a graph by generateCode()
+ */
+struct GeneratedCode {
+  // See CodeGenerationOptions
+  std::string file_stem;
+  std::string header;
+  std::string source;
+  // With WeightStorage::Mapped, the contents of the weights file: every
+  // parameter, row by row, starting on a 64-byte boundary
+  std::vector<float> weights;
+
+  /**
+   * Writes <directory>/<file_stem>.hpp, <file_stem>.cc and, with
+   * WeightStorage::Mapped, <file_stem>.weights
+   */
+  void write(const std::string& directory) const;
+};
+
+/**
+ * Compiles an inference graph ahead of time into a standalone C++
+ * translation unit, to be built with the local toolchain into fixed
+ * production models.
+ *
+ * The generated header declares the shapes of the input and output as
+ * constexpr and
+ *
+ *      void run(const float* input, float* output, float* workspace);
+ *      void run(const float* input, float* output);
+ *
+ * which compute the output of the graph for a (INPUT_ROWS, INPUT_DIMENSION)
+ * input, row by row. Every vertex becomes a call to a kernel whose shapes
+ * are template arguments, so the compiler fully specializes its loops, and
+ * the outputs of the vertices live at fixed offsets of a workspace of
+ * WORKSPACE_SIZE floats, reused once their consumers have run. The second
+ * overload uses a thread-local workspace. Nothing is dispatched or
+ * allocated at run time.
+ *
+ * The graph must have a single SequenceInputVertex and is read as is, so
+ * run Graph::eliminateRedundantVertices() and Graph::foldConstants() on it
+ * first. A trailing CrossEntropyLoss is skipped, as in
+ * Graph::launchInferencePass(). FullyConnected, InnerProduct (dense
+ * matrix-vector), BiasGELU, LayerNorm, ResidualAddition, ReLU, TanH and
+ * SoftMax vertices are supported. The fp32 values of the parameters are
+ * used whatever their storage type.
+ *
+ * Throws std::invalid_argument for the graphs that cannot be compiled.
+ */
+GeneratedCode generateCode(Graph& graph,
+                           const CodeGenerationOptions& options = {});
+
+}  // namespace gladius::aot
@@ -0,0 +1,136 @@
+#include <src/attention.hpp>
+#include <src/utils.hpp>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace gladius::transformer {
+
+MultiHeadAttention::MultiHeadAttention(
+    uint32_t num_heads, std::shared_ptr<Parameter> query_weights,
+    std::shared_ptr<Parameter> key_weights,
+    std::shared_ptr<Parameter> value_weights,
+    std::shared_ptr<Parameter> output_weights)
+    : _num_heads(num_heads),
+      _query_weights(std::move(query_weights)),
+      _key_weights(std::move(key_weights)),
+      _value_weights(std::move(value_weights)),
+      _output_weights(std::move(output_weights)) {
+  _model_dimension = _query_weights->getParameterShape().second;
+
+  for (const auto& weights :
+       {_query_weights, _key_weights, _value_weights, _output_weights}) {
+    auto shape = weights->getParameterShape();
+    if (shape.first != _model_dimension || shape.second != _model_dimension) {
+      throw std::invalid_argument(
+          "MultiHeadAttention expects square projection matrices of shape (" +
+          std::to_string(_model_dimension) + ", " +
+          std::to_string(_model_dimension) + "). Got instead (" +
+          std::to_string(shape.first) + ", " + std::to_string(shape.second) +
+          ").");
+    }
+  }
+  if (!_num_heads || _model_dimension % _num_heads != 0) {
+    throw std::invalid_argument(
+        "The model dimension (" + std::to_string(_model_dimension) +
+        ") must be divisible by the number of attention heads (" +
+        std::to_string(_num_heads) + ").");
+  }
+  _head_dimension = _model_dimension / _num_heads;
+
+  _query = std::vector<float>(_model_dimension, 0.F);
+  _key = std::vector<float>(_model_dimension, 0.F);
+  _value = std::vector<float>(_model_dimension, 0.F);
+  _context = std::vector<float>(_model_dimension, 0.F);
+}
+
+std::vector<float> MultiHeadAttention::decodeStep(
+    const std::vector<float>& token_embedding, KVCache& cache,
+    uint32_t layer) {
+  if (token_embedding.size() != _model_dimension) {
+    throw std::invalid_argument(
+        "Expected a token embedding of size " +
+        std::to_string(_model_dimension) + ". Got instead a vector of size " +
+        std::to_string(token_embedding.size()) + ".");
+  }
+  if (cache.getNumHeads() != _num_heads ||
+      cache.getHeadDimension() != _head_dimension) {
+    throw std::invalid_argument(
+        "The KVCache head configuration does not match the attention layer.");
+  }
+
+  project(*_query_weights, token_embedding, _query);
+  project(*_key_weights, token_embedding, _key);
+  project(*_value_weights, token_embedding, _value);
+
+  cache.append(layer, _key, _value);
+
+  for (uint32_t head = 0; head < _num_heads; head++) {
+    uint64_t offset = static_cast<uint64_t>(head) * _head_dimension;
+    attendToCache(cache, layer, head, _query.data() + offset,
+                  _context.data() + offset);
+  }
+
+  std::vector<float> output(_model_dimension, 0.F);
+  project(*_output_weights, _context, output);
+  return output;
+}
+
+void MultiHeadAttention::project(Parameter& weights,
+                                 const std::vector<float>& input,
+                                 std::vector<float>& output) {
+  auto& rows = weights.getValue();
+  auto total_rows = rows.size();
+  assert(output.size() == total_rows);
+
+  for (uint32_t row_index = 0; row_index < total_rows; row_index++) {
+    output[row_index] = gladius::utils::innerProduct(
+        /* first = */ rows[row_index], /* second = */ input);
+  }
+}
+
+void MultiHeadAttention::attendToCache(const KVCache& cache, uint32_t layer,
+                                       uint32_t head, const float* query,
+                                       float* context) {
+  uint32_t cached_tokens = cache.getCachedTokenCount(layer);
+  const float* keys = cache.getKeys(layer, head);
+  const float* values = cache.getValues(layer, head);
+
+  if (_scores.size() < cached_tokens) {
+    _scores.resize(cache.getMaxSequenceLength());
+  }
+  float scale = 1.F / std::sqrt(static_cast<float>(_head_dimension));
+
+  // The order of the slots in the ring does not matter here since the softmax
+  // and the weighted sum over values are both invariant to permutations of
+  // the cached tokens.
+  float max_score = -INFINITY;
+  for (uint32_t token = 0; token < cached_tokens; token++) {
+    const float* key = keys + static_cast<uint64_t>(token) * _head_dimension;
+    float score = 0.F;
+    for (uint32_t index = 0; index < _head_dimension; index++) {
+      score += query[index] * key[index];
+    }
+    _scores[token] = score * scale;
+    max_score = std::max(max_score, _scores[token]);
+  }
+
+  float sum_exps = 0.F;
+  for (uint32_t token = 0; token < cached_tokens; token++) {
+    _scores[token] = std::exp(_scores[token] - max_score);
+    sum_exps += _scores[token];
+  }
+
+  std::fill_n(context, _head_dimension, 0.F);
+  for (uint32_t token = 0; token < cached_tokens; token++) {
+    const float* value =
+        values + static_cast<uint64_t>(token) * _head_dimension;
+    float weight = _scores[token] / sum_exps;
+    for (uint32_t index = 0; index < _head_dimension; index++) {
+      context[index] += weight * value[index];
+    }
+  }
+}
+
+}  // namespace gladius::transformer
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <src/kv_cache.hpp>
+#include <src/params/parameters.hpp>
 #include <cstdint>
+#include <memory>
+#include <vector>
 
 /**
 This class implements the scaled dot-product attention layer as
@@ -10,8 +14,69 @@ https://arxiv.org/pdf/1706.03762.pdf
 
 namespace gladius::transformer {
 
+using gladius::parameters::Parameter;
+
 class MultiHeadAttention {
-  explicit MultiHeadAttention(uint32_t attention_blocks);
+ public:
+  /**
+   * Each projection parameter is a (model_dimension x model_dimension) weight
+   * matrix. The model dimension must be divisible by the number of heads so
+   * that every head attends over a slice of size model_dimension / num_heads.
+   */
+  MultiHeadAttention(uint32_t num_heads,
+                     std::shared_ptr<Parameter> query_weights,
+                     std::shared_ptr<Parameter> key_weights,
+                     std::shared_ptr<Parameter> value_weights,
+                     std::shared_ptr<Parameter> output_weights);
+
+  MultiHeadAttention(const MultiHeadAttention&) = delete;
+  MultiHeadAttention& operator=(const MultiHeadAttention&) = delete;
+
+  /**
+   * Runs a single autoregressive decoding step for the given layer. The new
+   * token is projected into its query, key and value vectors, the key and
+   * value are appended to the cache and the query attends over every cached
+   * token (including itself). Only the new token is projected, so the cost of
+   * a step is linear in the number of cached tokens instead of quadratic in
+   * the length of the prefix.
+   */
+  std::vector<float> decodeStep(const std::vector<float>& token_embedding,
+                                KVCache& cache, uint32_t layer);
+
+  uint32_t getNumHeads() const { return _num_heads; }
+  uint32_t getModelDimension() const { return _model_dimension; }
+  uint32_t getHeadDimension() const { return _head_dimension; }
+
+ private:
+  /**
+   * Computes output = W * input for a (m x n) weight parameter W.
+   */
+  static void project(Parameter& weights, const std::vector<float>& input,
+                      std::vector<float>& output);
+
+  /**
+   * Computes softmax(q K^T / sqrt(d)) V for a single head over the tokens
+   * currently held in the cache and writes the result to `context`.
+   */
+  void attendToCache(const KVCache& cache, uint32_t layer, uint32_t head,
+                     const float* query, float* context);
+
+  uint32_t _num_heads;
+  uint32_t _model_dimension;
+  uint32_t _head_dimension;
+
+  std::shared_ptr<Parameter> _query_weights;
+  std::shared_ptr<Parameter> _key_weights;
+  std::shared_ptr<Parameter> _value_weights;
+  std::shared_ptr<Parameter> _output_weights;
+
+  // Scratch buffers reused across decoding steps so that a step performs no
+  // allocations once the buffers have reached their final size.
+  std::vector<float> _query;
+  std::vector<float> _key;
+  std::vector<float> _value;
+  std::vector<float> _context;
+  std::vector<float> _scores;
 };
 
-}  // namespace gladius::transformer
\ No newline at end of file
+}  // namespace gladius::transformer
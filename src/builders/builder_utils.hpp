@@ -0,0 +1,48 @@
+#pragma once
+
+#include <src/comp_graph/graph.hpp>
+#include <src/comp_graph/vertices/param_vertex.hpp>
+#include <src/model.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace gladius::builders {
+
+using gladius::comp_graph::Graph;
+using gladius::comp_graph::ParameterVertex;
+
+/**
+ * Adds a parameter to the model and returns its ID. If provided, every
+ * entry of the parameter is set to `fill_value` instead of the model's
+ * default initialization (LayerNorm gains, for instance, start at one).
+ */
+inline uint32_t addModelParameter(
+    const std::shared_ptr<Model>& model, std::vector<uint32_t>&& dimensions,
+    std::optional<float> fill_value = std::nullopt) {
+  uint32_t param_id = model->getParameterCount();
+  model->addParameter(std::move(dimensions));
+
+  if (fill_value.has_value()) {
+    for (auto& row : model->getParameterByID(param_id)->getValue()) {
+      std::fill(row.begin(), row.end(), fill_value.value());
+    }
+  }
+  return param_id;
+}
+
+/**
+ * Wraps the model parameter with the given ID in a parameter vertex and adds
+ * it to the graph.
+ */
+inline std::shared_ptr<ParameterVertex> addParameterVertex(
+    const std::shared_ptr<Model>& model, Graph& graph, uint32_t param_id) {
+  auto parameter_vertex =
+      std::make_shared<ParameterVertex>(model->getParameterByID(param_id));
+  graph.addVertex(parameter_vertex);
+  return parameter_vertex;
+}
+
+}  // namespace gladius::builders
@@ -0,0 +1,118 @@
+#include <src/builders/rnn_builder.hpp>
+#include <src/comp_graph/vertices/fully_connected.hpp>
+#include <src/comp_graph/vertices/recurrent.hpp>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace gladius::builders {
+
+using gladius::comp_graph::FullyConnected;
+using gladius::comp_graph::GRULayer;
+using gladius::comp_graph::LSTMLayer;
+
+static void checkInputDimension(const VertexPointer& input,
+                                uint32_t expected_dimension) {
+  auto dimension = input->getOutputShape().second;
+  if (dimension != expected_dimension) {
+    throw std::invalid_argument(
+        "The input to the recurrent network must have rows of dimension " +
+        std::to_string(expected_dimension) + ". Got instead " +
+        std::to_string(dimension) + ".");
+  }
+}
+
+LSTMBuilder::LSTMBuilder(std::shared_ptr<Model> model,
+                         uint32_t input_dimension, uint32_t hidden_dimension,
+                         uint32_t num_layers)
+    : _model(std::move(model)),
+      _input_dimension(input_dimension),
+      _hidden_dimension(hidden_dimension) {
+  uint32_t h = hidden_dimension;
+  uint32_t layer_input_dimension = input_dimension;
+
+  for (uint32_t layer = 0; layer < num_layers; layer++) {
+    LayerParameterIDs ids{};
+    ids.input_weights =
+        addModelParameter(_model, {4 * h, layer_input_dimension});
+    ids.input_bias = addModelParameter(_model, {4 * h});
+    ids.recurrent_weights = addModelParameter(_model, {4 * h, h});
+
+    // Initializing the forget gate bias to one keeps the cell state flowing
+    // through time early in training.
+    auto& input_bias = _model->getParameterByID(ids.input_bias)->getValue();
+    std::fill_n(input_bias.at(0).begin() + h, h, 1.F);
+
+    _layers.push_back(ids);
+    layer_input_dimension = h;
+  }
+}
+
+VertexPointer LSTMBuilder::build(Graph& graph, VertexPointer input) const {
+  checkInputDimension(input, _input_dimension);
+
+  VertexPointer current = std::move(input);
+  for (const auto& ids : _layers) {
+    auto input_projections = std::make_shared<FullyConnected>(
+        /* input = */ current,
+        /* weights = */ addParameterVertex(_model, graph, ids.input_weights),
+        /* bias = */ addParameterVertex(_model, graph, ids.input_bias));
+    graph.addVertex(input_projections);
+
+    auto lstm = std::make_shared<LSTMLayer>(
+        /* input_projections = */ input_projections,
+        /* recurrent_weights = */
+        addParameterVertex(_model, graph, ids.recurrent_weights));
+    graph.addVertex(lstm);
+
+    current = lstm;
+  }
+  return current;
+}
+
+GRUBuilder::GRUBuilder(std::shared_ptr<Model> model, uint32_t input_dimension,
+                       uint32_t hidden_dimension, uint32_t num_layers)
+    : _model(std::move(model)),
+      _input_dimension(input_dimension),
+      _hidden_dimension(hidden_dimension) {
+  uint32_t h = hidden_dimension;
+  uint32_t layer_input_dimension = input_dimension;
+
+  for (uint32_t layer = 0; layer < num_layers; layer++) {
+    LayerParameterIDs ids{};
+    ids.input_weights =
+        addModelParameter(_model, {3 * h, layer_input_dimension});
+    ids.input_bias = addModelParameter(_model, {3 * h});
+    ids.recurrent_weights = addModelParameter(_model, {3 * h, h});
+    ids.recurrent_bias = addModelParameter(_model, {3 * h});
+
+    _layers.push_back(ids);
+    layer_input_dimension = h;
+  }
+}
+
+VertexPointer GRUBuilder::build(Graph& graph, VertexPointer input) const {
+  checkInputDimension(input, _input_dimension);
+
+  VertexPointer current = std::move(input);
+  for (const auto& ids : _layers) {
+    auto input_projections = std::make_shared<FullyConnected>(
+        /* input = */ current,
+        /* weights = */ addParameterVertex(_model, graph, ids.input_weights),
+        /* bias = */ addParameterVertex(_model, graph, ids.input_bias));
+    graph.addVertex(input_projections);
+
+    auto gru = std::make_shared<GRULayer>(
+        /* input_projections = */ input_projections,
+        /* recurrent_weights = */
+        addParameterVertex(_model, graph, ids.recurrent_weights),
+        /* recurrent_bias = */
+        addParameterVertex(_model, graph, ids.recurrent_bias));
+    graph.addVertex(gru);
+
+    current = gru;
+  }
+  return current;
+}
+
+}  // namespace gladius::builders
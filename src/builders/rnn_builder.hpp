@@ -0,0 +1,85 @@
+#pragma once
+
+#include <src/builders/builder_utils.hpp>
+#include <src/comp_graph/graph.hpp>
+#include <src/comp_graph/vertices/vertex.hpp>
+#include <src/model.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace gladius::builders {
+
+using gladius::comp_graph::Graph;
+using gladius::comp_graph::VertexPointer;
+
+/**
+ * Builds a stack of LSTM layers. Every layer adds exactly two compute
+ * vertices to the graph regardless of the sequence length: a FullyConnected
+ * vertex computing the input projections of all four gates for every
+ * timestep with one matrix product, and an LSTMLayer vertex running the
+ * recurrence with one matrix-vector product per timestep followed by a fused
+ * gate kernel. Usage:
+ *
+ *        LSTMBuilder lstm(model, 128, 256, 2);
+ *        auto hidden_states = lstm.build(graph, sequence_input_vertex);
+ */
+class LSTMBuilder {
+ public:
+  LSTMBuilder(std::shared_ptr<Model> model, uint32_t input_dimension,
+              uint32_t hidden_dimension, uint32_t num_layers);
+
+  /**
+   * Adds the vertices of every layer to the graph on top of the given input
+   * vertex, whose output must have shape (T, input_dimension). Returns the
+   * vertex computing the (T, hidden_dimension) hidden states of the last
+   * layer.
+   */
+  VertexPointer build(Graph& graph, VertexPointer input) const;
+
+  uint32_t getNumLayers() const { return _layers.size(); }
+
+ private:
+  struct LayerParameterIDs {
+    uint32_t input_weights;
+    uint32_t input_bias;
+    uint32_t recurrent_weights;
+  };
+
+  std::shared_ptr<Model> _model;
+  uint32_t _input_dimension;
+  uint32_t _hidden_dimension;
+
+  std::vector<LayerParameterIDs> _layers;
+};
+
+/**
+ * Builds a stack of GRU layers with the same structure as LSTMBuilder: one
+ * FullyConnected vertex for the input projections of the three gates over
+ * the whole sequence, followed by one GRULayer vertex per layer.
+ */
+class GRUBuilder {
+ public:
+  GRUBuilder(std::shared_ptr<Model> model, uint32_t input_dimension,
+             uint32_t hidden_dimension, uint32_t num_layers);
+
+  VertexPointer build(Graph& graph, VertexPointer input) const;
+
+  uint32_t getNumLayers() const { return _layers.size(); }
+
+ private:
+  struct LayerParameterIDs {
+    uint32_t input_weights;
+    uint32_t input_bias;
+    uint32_t recurrent_weights;
+    uint32_t recurrent_bias;
+  };
+
+  std::shared_ptr<Model> _model;
+  uint32_t _input_dimension;
+  uint32_t _hidden_dimension;
+
+  std::vector<LayerParameterIDs> _layers;
+};
+
+}  // namespace gladius::builders
@@ -0,0 +1,140 @@
+#include <src/builders/transformer_builder.hpp>
+#include <src/comp_graph/vertices/activ_functions.hpp>
+#include <src/comp_graph/vertices/fully_connected.hpp>
+#include <src/comp_graph/vertices/layer_norm.hpp>
+#include <src/comp_graph/vertices/self_attention.hpp>
+#include <src/comp_graph/vertices/summation.hpp>
+#include <stdexcept>
+#include <string>
+
+namespace gladius::builders {
+
+using gladius::comp_graph::BiasGELUActivation;
+using gladius::comp_graph::FullyConnected;
+using gladius::comp_graph::LayerNorm;
+using gladius::comp_graph::ResidualAddition;
+using gladius::comp_graph::SelfAttention;
+
+TransformerBlockBuilder::TransformerBlockBuilder(
+    std::shared_ptr<Model> model, uint32_t model_dimension,
+    uint32_t num_heads, uint32_t feed_forward_dimension, uint32_t num_layers,
+    bool causal)
+    : _model(std::move(model)),
+      _model_dimension(model_dimension),
+      _num_heads(num_heads),
+      _feed_forward_dimension(feed_forward_dimension),
+      _causal(causal) {
+  if (!num_heads || model_dimension % num_heads != 0) {
+    throw std::invalid_argument(
+        "The model dimension (" + std::to_string(model_dimension) +
+        ") must be divisible by the number of attention heads (" +
+        std::to_string(num_heads) + ").");
+  }
+  uint32_t d = model_dimension;
+  uint32_t f = feed_forward_dimension;
+
+  auto parameter = [&](std::vector<uint32_t>&& dimensions,
+                       std::optional<float> fill_value = std::nullopt) {
+    return addModelParameter(_model, std::move(dimensions), fill_value);
+  };
+
+  for (uint32_t layer = 0; layer < num_layers; layer++) {
+    BlockParameterIDs block{};
+    block.attention_norm_gain = parameter({d}, /* fill_value = */ 1.F);
+    block.attention_norm_bias = parameter({d});
+    block.query_key_value_weights = parameter({3 * d, d});
+    block.query_key_value_bias = parameter({3 * d});
+    block.attention_output_weights = parameter({d, d});
+    block.attention_output_bias = parameter({d});
+    block.feed_forward_norm_gain = parameter({d}, /* fill_value = */ 1.F);
+    block.feed_forward_norm_bias = parameter({d});
+    block.hidden_weights = parameter({f, d});
+    block.hidden_bias = parameter({f});
+    block.projection_weights = parameter({d, f});
+    block.projection_bias = parameter({d});
+    _blocks.push_back(block);
+  }
+}
+
+VertexPointer TransformerBlockBuilder::build(Graph& graph,
+                                             VertexPointer input) const {
+  auto [sequence_length, dimension] = input->getOutputShape();
+  if (dimension != _model_dimension) {
+    throw std::invalid_argument(
+        "The input to the transformer encoder must have rows of dimension " +
+        std::to_string(_model_dimension) + ". Got instead " +
+        std::to_string(dimension) + ".");
+  }
+  VertexPointer current = std::move(input);
+  for (const auto& block : _blocks) {
+    current = buildBlock(graph, current, block);
+  }
+  return current;
+}
+
+VertexPointer TransformerBlockBuilder::buildBlock(
+    Graph& graph, VertexPointer input, const BlockParameterIDs& block) const {
+  auto parameter = [&](uint32_t param_id) {
+    return addParameterVertex(_model, graph, param_id);
+  };
+
+  // Attention sub-layer
+  auto attention_norm = std::make_shared<LayerNorm>(
+      /* input = */ input,
+      /* gain = */ parameter(block.attention_norm_gain),
+      /* bias = */ parameter(block.attention_norm_bias));
+  graph.addVertex(attention_norm);
+
+  auto query_key_value = std::make_shared<FullyConnected>(
+      /* input = */ attention_norm,
+      /* weights = */ parameter(block.query_key_value_weights),
+      /* bias = */ parameter(block.query_key_value_bias));
+  graph.addVertex(query_key_value);
+
+  auto attention = std::make_shared<SelfAttention>(
+      /* query_key_value = */ query_key_value, /* num_heads = */ _num_heads,
+      /* causal = */ _causal);
+  graph.addVertex(attention);
+
+  auto attention_output = std::make_shared<FullyConnected>(
+      /* input = */ attention,
+      /* weights = */ parameter(block.attention_output_weights),
+      /* bias = */ parameter(block.attention_output_bias));
+  graph.addVertex(attention_output);
+
+  auto attention_residual = std::make_shared<ResidualAddition>(
+      /* shortcut_input = */ input, /* residual_input = */ attention_output);
+  graph.addVertex(attention_residual);
+
+  // Feed-forward sub-layer
+  auto feed_forward_norm = std::make_shared<LayerNorm>(
+      /* input = */ attention_residual,
+      /* gain = */ parameter(block.feed_forward_norm_gain),
+      /* bias = */ parameter(block.feed_forward_norm_bias));
+  graph.addVertex(feed_forward_norm);
+
+  auto hidden = std::make_shared<FullyConnected>(
+      /* input = */ feed_forward_norm,
+      /* weights = */ parameter(block.hidden_weights));
+  graph.addVertex(hidden);
+
+  auto hidden_activation = std::make_shared<BiasGELUActivation>(
+      /* input = */ hidden,
+      /* bias = */ parameter(block.hidden_bias));
+  graph.addVertex(hidden_activation);
+
+  auto projection = std::make_shared<FullyConnected>(
+      /* input = */ hidden_activation,
+      /* weights = */ parameter(block.projection_weights),
+      /* bias = */ parameter(block.projection_bias));
+  graph.addVertex(projection);
+
+  auto feed_forward_residual = std::make_shared<ResidualAddition>(
+      /* shortcut_input = */ attention_residual,
+      /* residual_input = */ projection);
+  graph.addVertex(feed_forward_residual);
+
+  return feed_forward_residual;
+}
+
+}  // namespace gladius::builders
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <src/builders/builder_utils.hpp>
+#include <src/comp_graph/graph.hpp>
+#include <src/comp_graph/vertices/vertex.hpp>
+#include <src/model.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace gladius::builders {
+
+using gladius::comp_graph::Graph;
+using gladius::comp_graph::VertexPointer;
+
+/**
+ * Builds a stack of pre-LayerNorm transformer encoder blocks. Each block maps
+ * an (L, d) sequence x to
+ *        h = x + W_o SelfAttention(W_qkv LayerNorm(x) + b_qkv) + b_o
+ *        y = h + W_2 GELU(W_1 LayerNorm(h) + b_1) + b_2
+ * The parameters of every block are registered with the model when the
+ * builder is constructed, so the same builder can be used to build the graph
+ * for every training example:
+ *
+ *        TransformerBlockBuilder encoder(model, 512, 8, 2048, 6);
+ *        auto encoded = encoder.build(graph, input_vertex);
+ *
+ * The block is composed of fused vertices: the query, key and value
+ * projections share one FullyConnected vertex, LayerNorm computes its
+ * statistics and affine transform together, and the first feed-forward bias
+ * is fused into the GELU activation.
+ */
+class TransformerBlockBuilder {
+ public:
+  TransformerBlockBuilder(std::shared_ptr<Model> model,
+                          uint32_t model_dimension, uint32_t num_heads,
+                          uint32_t feed_forward_dimension, uint32_t num_layers,
+                          bool causal = false);
+
+  /**
+   * Adds the vertices of every block to the graph on top of the given input
+   * vertex, whose output must have shape (L, model_dimension). Returns the
+   * vertex computing the output of the last block.
+   */
+  VertexPointer build(Graph& graph, VertexPointer input) const;
+
+  uint32_t getNumLayers() const { return _blocks.size(); }
+
+ private:
+  struct BlockParameterIDs {
+    uint32_t attention_norm_gain;
+    uint32_t attention_norm_bias;
+    uint32_t query_key_value_weights;
+    uint32_t query_key_value_bias;
+    uint32_t attention_output_weights;
+    uint32_t attention_output_bias;
+    uint32_t feed_forward_norm_gain;
+    uint32_t feed_forward_norm_bias;
+    uint32_t hidden_weights;
+    uint32_t hidden_bias;
+    uint32_t projection_weights;
+    uint32_t projection_bias;
+  };
+
+  VertexPointer buildBlock(Graph& graph, VertexPointer input,
+                           const BlockParameterIDs& block) const;
+
+  std::shared_ptr<Model> _model;
+  uint32_t _model_dimension;
+  uint32_t _num_heads;
+  uint32_t _feed_forward_dimension;
+  bool _causal;
+
+  std::vector<BlockParameterIDs> _blocks;
+};
+
+}  // namespace gladius::builders
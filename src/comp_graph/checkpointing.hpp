@@ -0,0 +1,237 @@
+#pragma once
+
+#include <src/comp_graph/vertices/vertex.hpp>
+#include <src/profiling/profiler.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace gladius::comp_graph {
+
+/**
+ * Gradient checkpointing (activation recomputation, [1]) for the vertices of
+ * a graph. The vertices, in topological order, are split into segments of
+ * consecutive vertices, ceil(sqrt(N)) of them by default. Once the forward
+ * pass of a segment is done, the outputs that no later segment reads are
+ * dropped. The other outputs (the checkpoints) are kept: the last vertex of
+ * every segment, the vertices read by a later segment, the leaves and the
+ * softmax and loss vertices. The last segment, which the backward pass
+ * starts with, keeps all of its outputs.
+ *
+ * When the backward pass reaches a vertex of a segment whose outputs were
+ * dropped, the segment runs its forward pass again from the checkpoints.
+ * Before that, the recomputed segments that are done with their backward
+ * pass are dropped again, so that at most a few segments are alive at any
+ * time. With N vertices of similar size, the peak activation memory goes
+ * from O(N) to O(sqrt(N)) at the cost of about one extra forward pass.
+ *
+ * Recomputation assumes that the forward pass of a vertex only depends on
+ * its inputs and parameters, which holds for every vertex except the
+ * sampled softmax loss, always in the last segment.
+ *
+ * [1] T. Chen et al. Training deep nets with sublinear memory cost. 2016.
+ */
+class Checkpointer final : public BackwardObserver {
+ public:
+  /**
+   * `vertices` must be in topological order. A `segment_length` of 0 picks
+   * ceil(sqrt(N)).
+   */
+  Checkpointer(const std::vector<VertexPointer>& vertices,
+               uint32_t segment_length = 0)
+      : _vertex_segments(vertices.size()) {
+    uint32_t num_vertices = vertices.size();
+    _segment_length =
+        segment_length != 0
+            ? segment_length
+            : std::max<uint32_t>(1, std::ceil(std::sqrt(num_vertices)));
+    uint32_t num_segments =
+        (num_vertices + _segment_length - 1) / _segment_length;
+    _segments = std::vector<Segment>(num_segments);
+
+    std::unordered_map<Vertex*, uint32_t> indices;
+    for (uint32_t index = 0; index < num_vertices; index++) {
+      indices[vertices[index].get()] = index;
+      _vertex_segments[index] = index / _segment_length;
+    }
+    // The vertices whose output is read by a later segment
+    std::vector<bool> read_later(num_vertices, false);
+    for (uint32_t index = 0; index < num_vertices; index++) {
+      for (const auto& input : vertices[index]->getInputs()) {
+        auto input_index = indices.find(input.get());
+        if (input_index != indices.end() &&
+            _vertex_segments[input_index->second] < _vertex_segments[index]) {
+          read_later[input_index->second] = true;
+        }
+      }
+    }
+
+    for (uint32_t index = 0; index < num_vertices; index++) {
+      auto& vertex = vertices[index];
+      uint32_t segment_index = _vertex_segments[index];
+      auto& segment = _segments[segment_index];
+      if (vertex->getInputs().empty()) {
+        segment.leaves++;
+        continue;
+      }
+      _positions[vertex.get()] = {
+          segment_index, static_cast<uint32_t>(segment.members.size())};
+      segment.members.push_back(vertex.get());
+      vertex->setBackwardObserver(this);
+
+      bool last_of_segment = index + 1 == num_vertices ||
+                             _vertex_segments[index + 1] != segment_index;
+      auto name = vertex->getName();
+      if (segment_index + 1 < num_segments && !last_of_segment &&
+          !read_later[index] && name != "SoftMax" &&
+          name != "CrossEntropyLoss") {
+        segment.dropped.push_back(vertex.get());
+      }
+    }
+    for (auto& segment : _segments) {
+      segment.visited.assign(segment.members.size(), false);
+    }
+  }
+
+  ~Checkpointer() {
+    for (auto& segment : _segments) {
+      for (auto* member : segment.members) {
+        member->setBackwardObserver(nullptr);
+      }
+    }
+  }
+
+  Checkpointer(const Checkpointer&) = delete;
+  Checkpointer& operator=(const Checkpointer&) = delete;
+
+  inline uint32_t getSegmentLength() const { return _segment_length; }
+
+  inline uint32_t getSegmentsCount() const { return _segments.size(); }
+
+  /**
+   * The number of vertices whose output is dropped after the forward pass
+   */
+  uint32_t getDroppedCount() const {
+    uint32_t dropped = 0;
+    for (const auto& segment : _segments) {
+      dropped += segment.dropped.size();
+    }
+    return dropped;
+  }
+
+  /**
+   * The number of forward passes of vertices run again in backward passes
+   */
+  inline uint64_t getRecomputedCount() const { return _recomputed; }
+
+  /**
+   * Resets the state of the segments. Must be called before every forward
+   * pass.
+   */
+  void beginForward() {
+    for (auto& segment : _segments) {
+      segment.remaining_forward.store(
+          segment.members.size() + segment.leaves, std::memory_order_relaxed);
+      segment.released = false;
+      std::fill(segment.visited.begin(), segment.visited.end(), false);
+      segment.visited_count = 0;
+    }
+    _recomputed_segments.clear();
+    _recomputed = 0;
+  }
+
+  /**
+   * Called once the forward pass of the vertex with the given index is done,
+   * possibly concurrently with other vertices. The thread that finishes the
+   * last vertex of a segment drops its outputs.
+   */
+  void afterForward(uint32_t vertex_index) {
+    auto& segment = _segments[_vertex_segments[vertex_index]];
+    if (segment.remaining_forward.fetch_sub(1, std::memory_order_acq_rel) ==
+        1) {
+      release(segment);
+    }
+  }
+
+  void beforeBackward(Vertex& vertex) final {
+    auto position = _positions.find(&vertex);
+    if (position == _positions.end()) {
+      return;
+    }
+    auto& segment = _segments[position->second.first];
+    if (!segment.visited[position->second.second]) {
+      segment.visited[position->second.second] = true;
+      segment.visited_count++;
+    }
+    if (!segment.released) {
+      return;
+    }
+    // Only a few segments are alive at once: those that no vertex needs
+    // anymore go before this one comes back
+    std::erase_if(_recomputed_segments, [&](Segment* recomputed) {
+      if (!isBackwardDone(*recomputed)) {
+        return false;
+      }
+      release(*recomputed);
+      return true;
+    });
+    for (auto* dropped : segment.dropped) {
+      profiling::ProfileScope profile_scope(*dropped,
+                                            profiling::Pass::Forward);
+      dropped->forward();
+      _recomputed++;
+    }
+    segment.released = false;
+    _recomputed_segments.push_back(&segment);
+  }
+
+ private:
+  struct Segment {
+    // The vertices of the segment that are not leaves
+    std::vector<Vertex*> members;
+    // The members whose output is dropped, in topological order
+    std::vector<Vertex*> dropped;
+    // Leaves of the segment, which run in its forward pass as well
+    uint32_t leaves = 0;
+    std::atomic<uint32_t> remaining_forward = 0;
+    bool released = false;
+    // The members whose backward pass started
+    std::vector<bool> visited;
+    uint32_t visited_count = 0;
+  };
+
+  void release(Segment& segment) {
+    for (auto* dropped : segment.dropped) {
+      dropped->releaseOutput();
+    }
+    segment.released = !segment.dropped.empty();
+  }
+
+  /**
+   * Returns true if the backward pass of every member started and none of
+   * them waits for the gradient of another consumer, so no vertex reads the
+   * outputs of the segment anymore
+   */
+  static bool isBackwardDone(const Segment& segment) {
+    if (segment.visited_count != segment.members.size()) {
+      return false;
+    }
+    return std::none_of(
+        segment.members.begin(), segment.members.end(),
+        [](const Vertex* member) { return member->hasPendingGradients(); });
+  }
+
+  uint32_t _segment_length;
+  std::vector<Segment> _segments;
+  std::vector<uint32_t> _vertex_segments;
+  // Segment and index among its members of every member
+  std::unordered_map<Vertex*, std::pair<uint32_t, uint32_t>> _positions;
+  std::vector<Segment*> _recomputed_segments;
+  uint64_t _recomputed = 0;
+};
+
+}  // namespace gladius::comp_graph
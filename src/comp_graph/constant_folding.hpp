@@ -0,0 +1,449 @@
+#pragma once
+
+#include <src/comp_graph/vertices/activ_functions.hpp>
+#include <src/comp_graph/vertices/fully_connected.hpp>
+#include <src/comp_graph/vertices/inner_product.hpp>
+#include <src/comp_graph/vertices/input_vertex.hpp>
+#include <src/comp_graph/vertices/param_vertex.hpp>
+#include <src/comp_graph/vertices/vertex.hpp>
+#include <src/parallel/parallel_for.hpp>
+#include <src/params/parameters.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace gladius::comp_graph {
+
+using gladius::parameters::Parameter;
+
+/**
+ * The parameters computed by foldConstantVertices(), keyed by the rule that
+ * computed them and the parameters they were computed from. Graphs rebuilt
+ * for every batch from the same frozen parameters (see
+ * serving::InferenceEngine) share a cache to fold them only once.
+ *
+ * The cache keeps the source parameters alive, so their addresses are never
+ * reused, but it does not see their values change: clear it after updating
+ * them. Thread-safe.
+ */
+class FoldedConstantCache {
+ public:
+  using Compute = std::function<std::shared_ptr<Parameter>()>;
+
+  /**
+   * Returns the constant computed by `rule` from `sources`, calling
+   * `compute` if it is not cached yet
+   */
+  std::shared_ptr<Parameter> getOrCompute(
+      const std::string& rule,
+      const std::vector<std::shared_ptr<Parameter>>& sources,
+      const Compute& compute) {
+    Key key{rule, {}};
+    for (const auto& source : sources) {
+      key.sources.push_back(source.get());
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto entry = _constants.find(key);
+    if (entry != _constants.end()) {
+      return entry->second.constant;
+    }
+    auto constant = compute();
+    _constants.emplace(std::move(key), Entry{sources, constant});
+    return constant;
+  }
+
+  inline uint64_t size() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _constants.size();
+  }
+
+  inline void clear() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _constants.clear();
+  }
+
+ private:
+  struct Key {
+    std::string rule;
+    // nullptr for a missing (optional) source, e.g., a bias
+    std::vector<const Parameter*> sources;
+
+    bool operator==(const Key& other) const = default;
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const {
+      size_t hash = std::hash<std::string>()(key.rule);
+      for (const auto* source : key.sources) {
+        hash ^= std::hash<const Parameter*>()(source) + 0x9e3779b97f4a7c15ULL +
+                (hash << 6) + (hash >> 2);
+      }
+      return hash;
+    }
+  };
+
+  struct Entry {
+    std::vector<std::shared_ptr<Parameter>> sources;
+    std::shared_ptr<Parameter> constant;
+  };
+
+  mutable std::mutex _mutex;
+  std::unordered_map<Key, Entry, KeyHash> _constants;
+};
+
+/**
+ * Returns the (m, n) product AB of a (m, k) matrix A and a (k, n) matrix B
+ */
+inline std::vector<std::vector<float>> multiplyMatrices(
+    const std::vector<std::vector<float>>& left,
+    const std::vector<std::vector<float>>& right) {
+  uint32_t columns = right.empty() ? 0 : right.front().size();
+  std::vector<std::vector<float>> product(left.size(),
+                                          std::vector<float>(columns, 0.F));
+  parallel::parallelFor(
+      0, left.size(),
+      [&](uint64_t begin, uint64_t end) {
+        for (uint64_t row = begin; row < end; row++) {
+          float* product_row = product[row].data();
+          for (uint32_t inner = 0; inner < right.size(); inner++) {
+            float scale = left[row][inner];
+            const float* right_row = right[inner].data();
+#pragma omp simd
+            for (uint32_t col = 0; col < columns; col++) {
+              product_row[col] += scale * right_row[col];
+            }
+          }
+        }
+      },
+      parallel::grainSize(
+          /* work_per_iteration = */ uint64_t{columns} * right.size()));
+  return product;
+}
+
+/**
+ * Returns the (1, m) row vector (W b^T)^T + c for a (m, k) matrix W, a
+ * (1, k) row vector b (if any) and a (1, m) row vector c (if any)
+ */
+inline std::vector<std::vector<float>> transformBias(
+    const std::vector<std::vector<float>>& weights,
+    const std::vector<std::vector<float>>* bias,
+    const std::vector<std::vector<float>>* offset) {
+  std::vector<float> result(weights.size(), 0.F);
+  for (uint32_t row = 0; row < weights.size(); row++) {
+    if (bias) {
+      for (uint32_t col = 0; col < weights[row].size(); col++) {
+        result[row] += weights[row][col] * bias->front()[col];
+      }
+    }
+    if (offset) {
+      result[row] += offset->front()[row];
+    }
+  }
+  return {std::move(result)};
+}
+
+/**
+ * Returns the value of `parameter` row by row
+ */
+inline std::vector<float> flattenParameter(Parameter& parameter) {
+  std::vector<float> value;
+  value.reserve(parameter.getParameterCount());
+  for (const auto& row : parameter.getValue()) {
+    value.insert(value.end(), row.begin(), row.end());
+  }
+  return value;
+}
+
+/**
+ * Whether the InnerProduct computes matrix-vector products Wx, rather than
+ * the inner product of two vectors (see InnerProduct)
+ */
+inline bool isMatrixVectorProduct(const InnerProduct& product) {
+  if (std::dynamic_pointer_cast<SparseInputVertex>(product.getRightInput())) {
+    return true;
+  }
+  return product.getLeftInput()->getOutputShape().first !=
+         product.getRightInput()->getOutputShape().first;
+}
+
+/**
+ * Computes the output of `vertex`, whose inputs are all ParameterVertex
+ * objects, and returns it as a matrix of the output shape
+ */
+inline std::vector<std::vector<float>> evaluateConstant(Vertex& vertex) {
+  auto inputs = vertex.getInputs();
+  std::vector<float> output;
+  if (auto* product = dynamic_cast<InnerProduct*>(&vertex)) {
+    // Computed as in InnerProduct::forward(), from the values of the
+    // parameters
+    auto& left = std::static_pointer_cast<ParameterVertex>(inputs[0])
+                     ->getParameter()
+                     ->getValue();
+    auto& right = std::static_pointer_cast<ParameterVertex>(inputs[1])
+                      ->getParameter()
+                      ->getValue();
+    output = std::vector<float>(product->getOutputShape().second, 0.F);
+    for (uint32_t row = 0; row < left.size(); row++) {
+      for (uint32_t col = 0; col < left[row].size(); col++) {
+        output[row] += left[row][col] * right.front()[col];
+      }
+    }
+  } else {
+    // The vertex reads the flattened values of the parameters as the
+    // outputs of its inputs
+    std::vector<VertexPointer> restored;
+    for (const auto& input : inputs) {
+      if (input->isOutputReleased()) {
+        input->restoreOutput(flattenParameter(
+            *std::static_pointer_cast<ParameterVertex>(input)->getParameter()));
+        restored.push_back(input);
+      }
+    }
+    vertex.forward();
+    output = vertex.getOutput();
+    for (const auto& input : restored) {
+      input->releaseOutput();
+    }
+  }
+
+  auto [rows, columns] = vertex.getOutputShape();
+  if (static_cast<uint64_t>(rows) * columns != output.size()) {
+    throw std::logic_error("The output of a " + vertex.getName() +
+                           " vertex does not match its output shape.");
+  }
+  std::vector<std::vector<float>> matrix(rows);
+  for (uint32_t row = 0; row < rows; row++) {
+    auto begin = output.begin() + static_cast<uint64_t>(row) * columns;
+    matrix[row].assign(begin, begin + columns);
+  }
+  return matrix;
+}
+
+/**
+ * Constant folding over the vertices of an inference graph, in topological
+ * order. Whatever only depends on (frozen) parameters is computed once,
+ * here, instead of in every forward pass:
+ *  - a vertex whose inputs are all ParameterVertex objects becomes a
+ *    ParameterVertex holding its output,
+ *  - FC(FC(x, W_1, b_1), W_2, b_2) becomes FC(x, W_2 W_1, W_2 b_1 + b_2)
+ *    and InnerProduct(W_2, InnerProduct(W_1, x)) becomes
+ *    InnerProduct(W_2 W_1, x), if nothing else reads the inner vertex and
+ *    the product takes fewer FLOPs than the two layers,
+ *  - BiasGELU(FC(x, W, b_1), b_2) adds the bias b_1 + b_2 once instead of
+ *    b_1 and b_2, if nothing else reads the FC vertex.
+ * Rules apply to the vertices they create, so chains of linear layers fold
+ * into one. The parameters they compute are looked up in (and added to)
+ * `cache`, if given. The last vertex, the output of the graph, is never
+ * replaced by a constant. Inputs of the folded vertices that are in the
+ * graph are left for pruneDeadVertices().
+ *
+ * Returns the number of vertices folded away. Throws if some vertex was not
+ * built under a NoGradGuard, since the parameters would no longer receive
+ * their gradients.
+ */
+inline uint32_t foldConstantVertices(std::vector<VertexPointer>& vertices,
+                                     FoldedConstantCache* cache = nullptr) {
+  for (const auto& vertex : vertices) {
+    if (vertex->requiresGrad()) {
+      throw std::logic_error(
+          "Constants can only be folded in graphs built under a "
+          "NoGradGuard.");
+    }
+  }
+  NoGradGuard no_grad;
+  FoldedConstantCache local_cache;
+  auto& constants = cache ? *cache : local_cache;
+
+  std::unordered_map<const Vertex*, uint32_t> consumers;
+  for (const auto& vertex : vertices) {
+    for (const auto& input : vertex->getInputs()) {
+      consumers[input.get()]++;
+    }
+  }
+  const Vertex* output = vertices.empty() ? nullptr : vertices.back().get();
+  // Whether only the vertex being folded reads `input`
+  auto foldable = [&](const VertexPointer& input) {
+    return input && input.get() != output && consumers[input.get()] == 1;
+  };
+  auto parameterOf = [](const std::shared_ptr<ParameterVertex>& vertex) {
+    return vertex ? vertex->getParameter() : nullptr;
+  };
+  auto wrap = [](std::shared_ptr<Parameter> parameter) {
+    return std::make_shared<ParameterVertex>(std::move(parameter));
+  };
+  auto storeLike = [](const std::shared_ptr<Parameter>& parameter,
+                      const std::shared_ptr<Parameter>& reference) {
+    if (reference->getStorageType() != parameter->getStorageType()) {
+      parameter->setStorageType(reference->getStorageType());
+    }
+    return parameter;
+  };
+
+  std::unordered_map<const Vertex*, VertexPointer> replacements;
+  std::unordered_set<const Vertex*> folded_inputs;
+  std::vector<VertexPointer> kept;
+  uint32_t folded = 0;
+
+  // Removes `vertex` in favor of `replacement`, for its consumers
+  auto replace = [&](const VertexPointer& vertex,
+                     const VertexPointer& replacement) {
+    replacements[vertex.get()] = replacement;
+    consumers[replacement.get()] = consumers[vertex.get()];
+    vertex->unregisterFromInputs();
+    folded++;
+  };
+
+  for (uint32_t index = 0; index < vertices.size(); index++) {
+    auto vertex = vertices[index];
+    for (const auto& input : vertex->getInputs()) {
+      auto replacement = replacements.find(input.get());
+      if (replacement != replacements.end()) {
+        vertex->replaceInput(*input, replacement->second);
+      }
+    }
+    auto inputs = vertex->getInputs();
+    auto attributes = vertex->getAttributes();
+
+    bool constant = !inputs.empty() && attributes.has_value();
+    std::vector<std::shared_ptr<Parameter>> sources;
+    for (const auto& input : inputs) {
+      auto parameter = std::dynamic_pointer_cast<ParameterVertex>(input);
+      constant = constant && parameter;
+      sources.push_back(parameterOf(parameter));
+    }
+    if (constant && vertex.get() != output) {
+      auto value = constants.getOrCompute(
+          vertex->getName() + "/" + std::to_string(*attributes), sources,
+          [&] {
+            return std::make_shared<Parameter>(evaluateConstant(*vertex));
+          });
+      auto folded_vertex = wrap(value);
+      // Consumers may read it as an output rather than as a parameter
+      folded_vertex->restoreOutput(flattenParameter(*value));
+      replace(vertex, folded_vertex);
+      continue;
+    }
+
+    if (auto outer = std::dynamic_pointer_cast<FullyConnected>(vertex)) {
+      auto inner = std::dynamic_pointer_cast<FullyConnected>(outer->getInput());
+      if (inner && foldable(inner)) {
+        auto input_dimension = inner->getInput()->getOutputShape().second;
+        auto hidden_dimension = inner->getOutputShape().second;
+        auto output_dimension = outer->getOutputShape().second;
+        if (static_cast<uint64_t>(output_dimension) * input_dimension <=
+            static_cast<uint64_t>(hidden_dimension) *
+                (input_dimension + output_dimension)) {
+          auto inner_weights = parameterOf(inner->getWeights());
+          auto outer_weights = parameterOf(outer->getWeights());
+          auto inner_bias = parameterOf(inner->getBias());
+          auto outer_bias = parameterOf(outer->getBias());
+          auto weights = constants.getOrCompute(
+              "FullyConnected/weights", {outer_weights, inner_weights}, [&] {
+                return storeLike(std::make_shared<Parameter>(multiplyMatrices(
+                                     outer_weights->getValue(),
+                                     inner_weights->getValue())),
+                                 outer_weights);
+              });
+          std::shared_ptr<ParameterVertex> bias = outer->getBias();
+          if (inner_bias) {
+            bias = wrap(constants.getOrCompute(
+                "FullyConnected/bias", {outer_weights, inner_bias, outer_bias},
+                [&] {
+                  return std::make_shared<Parameter>(transformBias(
+                      outer_weights->getValue(), &inner_bias->getValue(),
+                      outer_bias ? &outer_bias->getValue() : nullptr));
+                }));
+          }
+          auto composed = std::make_shared<FullyConnected>(
+              inner->getInput(), wrap(std::move(weights)), std::move(bias));
+          inner->unregisterFromInputs();
+          folded_inputs.insert(inner.get());
+          replace(vertex, composed);
+          kept.push_back(std::move(composed));
+          continue;
+        }
+      }
+    }
+
+    if (auto outer = std::dynamic_pointer_cast<InnerProduct>(vertex)) {
+      auto inner =
+          std::dynamic_pointer_cast<InnerProduct>(outer->getRightInput());
+      auto outer_weights =
+          std::dynamic_pointer_cast<ParameterVertex>(outer->getLeftInput());
+      auto inner_weights = inner ? std::dynamic_pointer_cast<ParameterVertex>(
+                                       inner->getLeftInput())
+                                 : nullptr;
+      if (inner_weights && outer_weights && foldable(inner) &&
+          isMatrixVectorProduct(*inner) && isMatrixVectorProduct(*outer)) {
+        auto [hidden_dimension, input_dimension] =
+            inner_weights->getOutputShape();
+        auto output_dimension = outer_weights->getOutputShape().first;
+        if (static_cast<uint64_t>(output_dimension) * input_dimension <=
+            static_cast<uint64_t>(hidden_dimension) *
+                (input_dimension + output_dimension)) {
+          auto weights = constants.getOrCompute(
+              "InnerProduct/weights",
+              {outer_weights->getParameter(), inner_weights->getParameter()},
+              [&] {
+                return storeLike(
+                    std::make_shared<Parameter>(multiplyMatrices(
+                        outer_weights->getParameter()->getValue(),
+                        inner_weights->getParameter()->getValue())),
+                    outer_weights->getParameter());
+              });
+          auto composed = std::make_shared<InnerProduct>(
+              wrap(std::move(weights)), inner->getRightInput());
+          inner->unregisterFromInputs();
+          folded_inputs.insert(inner.get());
+          replace(vertex, composed);
+          kept.push_back(std::move(composed));
+          continue;
+        }
+      }
+    }
+
+    if (auto activation =
+            std::dynamic_pointer_cast<BiasGELUActivation>(vertex)) {
+      auto projection =
+          std::dynamic_pointer_cast<FullyConnected>(activation->getInput());
+      if (projection && projection->getBias() && foldable(projection)) {
+        auto projection_bias = parameterOf(projection->getBias());
+        auto activation_bias = parameterOf(activation->getBias());
+        auto bias = constants.getOrCompute(
+            "BiasGELU/bias", {projection_bias, activation_bias},
+            [&] {
+              auto sum = projection_bias->getValue();
+              for (uint32_t col = 0; col < sum.front().size(); col++) {
+                sum.front()[col] += activation_bias->getValue().front()[col];
+              }
+              return std::make_shared<Parameter>(std::move(sum));
+            });
+        auto unbiased = std::make_shared<FullyConnected>(
+            projection->getInput(), projection->getWeights());
+        activation->replaceInput(*projection, unbiased);
+        activation->replaceInput(*activation->getBias(), wrap(bias));
+        consumers[unbiased.get()] = 1;
+        projection->unregisterFromInputs();
+        folded_inputs.insert(projection.get());
+        kept.push_back(std::move(unbiased));
+      }
+    }
+    kept.push_back(std::move(vertex));
+  }
+
+  // Vertices merged into their consumer
+  std::erase_if(kept, [&](const VertexPointer& vertex) {
+    return folded_inputs.count(vertex.get()) != 0;
+  });
+  vertices = std::move(kept);
+  return folded;
+}
+
+}  // namespace gladius::comp_graph
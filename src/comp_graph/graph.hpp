@@ -1,12 +1,25 @@
 #pragma once
 
+#include <src/comp_graph/checkpointing.hpp>
+#include <src/comp_graph/constant_folding.hpp>
+#include <src/comp_graph/graph_executor.hpp>
+#include <src/comp_graph/graph_passes.hpp>
+#include <src/comp_graph/offloading.hpp>
 #include <src/comp_graph/vertices/activ_functions.hpp>
+#include <src/comp_graph/vertices/loss.hpp>
 #include <src/comp_graph/vertices/vertex.hpp>
+#include <src/memory/memory_tracker.hpp>
+#include <src/profiling/profiler.hpp>
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <iterator>
+#include <memory>
 #include <omp.h>
 #include <optional>
 #include <set>
 #include <stdexcept>
+#include <unordered_map>
 #include <vector>
 
 namespace gladius::comp_graph {
@@ -20,12 +33,16 @@ class Graph {
   Graph& operator=(Graph&&) = delete;
 
   inline void clearComputationGraph() {
+    // Detaches from the vertices while they are alive
+    _checkpointer.reset();
+    _offloader.reset();
     if (!_topologically_sorted_vertices.empty()) {
       // for (auto& vertex : _topologically_sorted_vertices) {
       //   vertex->zeroOutGradients();
       // }
       _topologically_sorted_vertices.clear();
     }
+    _executor.reset();
     if (_loss_value) {
       _loss_value = std::nullopt;
     }
@@ -44,6 +61,115 @@ class Graph {
 
   void addVertex(VertexPointer vertex) {
     _topologically_sorted_vertices.push_back(std::move(vertex));
+    _executor.reset();
+    _checkpointer.reset();
+    _offloader.reset();
+  }
+
+  /**
+   * Runs the passes that remove redundant vertices before the graph is
+   * executed: duplicates are merged (see eliminateCommonSubexpressions()),
+   * then the vertices that do not reach the output, the last vertex, are
+   * pruned (see pruneDeadVertices()). Print the returned report to log
+   * what was removed.
+   */
+  GraphPassReport eliminateRedundantVertices() {
+    // Detaches from the vertices before the removed ones are released
+    _executor.reset();
+    _checkpointer.reset();
+    _offloader.reset();
+    GraphPassReport report;
+    report.vertices_before = getVerticesCount();
+    report.merged_vertices =
+        eliminateCommonSubexpressions(_topologically_sorted_vertices);
+    report.pruned_vertices = pruneDeadVertices(_topologically_sorted_vertices);
+    return report;
+  }
+
+  /**
+   * Computes once what only depends on parameters in a graph built under a
+   * NoGradGuard (see foldConstantVertices()), then prunes the vertices that
+   * no longer reach the output. Graphs rebuilt from the same frozen
+   * parameters can share `cache` to fold them only once.
+   */
+  GraphPassReport foldConstants(FoldedConstantCache* cache = nullptr) {
+    _executor.reset();
+    _checkpointer.reset();
+    _offloader.reset();
+    GraphPassReport report;
+    report.vertices_before = getVerticesCount();
+    report.folded_vertices =
+        foldConstantVertices(_topologically_sorted_vertices, cache);
+    report.pruned_vertices = pruneDeadVertices(_topologically_sorted_vertices);
+    return report;
+  }
+
+  /**
+   * Enables gradient checkpointing for the training passes of the graph
+   * (see Checkpointer): launchForwardPass() drops the outputs of most
+   * vertices, and the backward pass recomputes them segment by segment. The
+   * segments hold `segment_length` vertices, ceil(sqrt(N)) if not given.
+   */
+  void enableCheckpointing(std::optional<uint32_t> segment_length =
+                               std::nullopt) {
+    if (isOffloadingEnabled()) {
+      throw std::logic_error(
+          "Gradient checkpointing and activation offloading cannot both be "
+          "enabled on a graph.");
+    }
+    _checkpoint_segment_length = segment_length.value_or(0);
+    _checkpointer.reset();
+  }
+
+  void disableCheckpointing() {
+    _checkpoint_segment_length = std::nullopt;
+    _checkpointer.reset();
+  }
+
+  inline bool isCheckpointingEnabled() const {
+    return _checkpoint_segment_length.has_value();
+  }
+
+  /**
+   * The checkpointer of the last forward pass, or nullptr if checkpointing
+   * is disabled
+   */
+  inline const Checkpointer* getCheckpointer() const {
+    return _checkpointer.get();
+  }
+
+  /**
+   * Enables activation offloading for the training passes of the graph (see
+   * ActivationOffloader): launchForwardPass() writes the outputs that only
+   * the backward pass needs to a spill file, and the backward pass reads
+   * them back ahead of its sweep.
+   */
+  void enableOffloading(OffloadOptions options = {}) {
+    if (isCheckpointingEnabled()) {
+      throw std::logic_error(
+          "Gradient checkpointing and activation offloading cannot both be "
+          "enabled on a graph.");
+    }
+    _offload_options = std::move(options);
+    _offloader.reset();
+  }
+
+  void disableOffloading() {
+    _offload_options = std::nullopt;
+    _offloader.reset();
+  }
+
+  inline bool isOffloadingEnabled() const {
+    return _offload_options.has_value();
+  }
+
+  /**
+   * The offloader of the last forward pass, or nullptr if offloading is
+   * disabled. Its statistics report the prefetch hit rate and the time the
+   * backward pass waited for the spill file.
+   */
+  inline ActivationOffloader* getOffloader() {
+    return _offloader.get();
   }
 
   /**
@@ -56,10 +182,32 @@ class Graph {
     assert(_topologically_sorted_vertices[graph_size - 1]->getName() ==
            "CrossEntropyLoss");
 
-    uint32_t prediction;
-    for (uint32_t vertex_index = 0; vertex_index < graph_size; vertex_index++) {
-      auto vertex = _topologically_sorted_vertices[vertex_index];
-      vertex->forward();
+    Checkpointer* checkpointer = buildCheckpointer();
+    if (checkpointer) {
+      checkpointer->beginForward();
+    }
+    ActivationOffloader* offloader = buildOffloader();
+    if (offloader) {
+      offloader->beginForward();
+    }
+    getExecutor().run([&](uint32_t vertex_index) {
+      auto& vertex = _topologically_sorted_vertices[vertex_index];
+      {
+        profiling::ProfileScope profile_scope(*vertex,
+                                              profiling::Pass::Forward);
+        vertex->forward();
+      }
+      if (checkpointer) {
+        checkpointer->afterForward(vertex_index);
+      }
+      if (offloader) {
+        offloader->afterForward(vertex_index);
+      }
+      memory::MemoryTracker::checkBudget();
+    });
+
+    std::optional<uint32_t> prediction = std::nullopt;
+    for (const auto& vertex : _topologically_sorted_vertices) {
       if (vertex->getName() == "SoftMax") {
         prediction =
             dynamic_cast<gladius::comp_graph::SoftMaxActivation*>(vertex.get())
@@ -69,8 +217,95 @@ class Graph {
     auto loss_vertex = _topologically_sorted_vertices[graph_size - 1];
     assert(loss_vertex->getName() == "CrossEntropyLoss");
 
-    _loss_value = loss_vertex->getOutput().at(0).at(0);
-    return {prediction, _loss_value.value()};
+    // Without an explicit softmax vertex, the loss knows the argmax of the
+    // logits it consumed.
+    if (!prediction.has_value()) {
+      prediction = dynamic_cast<CrossEntropyLoss*>(loss_vertex.get())
+                       ->getPredictedLabel();
+    }
+
+    _loss_value = loss_vertex->getOutput().at(0);
+    return {prediction.value(), _loss_value.value()};
+  }
+
+  /**
+   * Runs the forward pass without computing the loss and returns the vertex
+   * whose output holds the logits (or probabilities, for a softmax graph).
+   * Meant for graphs built under a NoGradGuard: the trailing loss vertex (if
+   * any) is skipped, and the output of every intermediate vertex is released
+   * as soon as its last consumer has run, so at any point only the
+   * activations that are still needed are alive.
+   */
+  VertexPointer launchInferencePass() {
+    auto graph_size = _topologically_sorted_vertices.size();
+    if (graph_size != 0 &&
+        _topologically_sorted_vertices[graph_size - 1]->getName() ==
+            "CrossEntropyLoss") {
+      graph_size--;
+    }
+    if (graph_size == 0) {
+      throw std::runtime_error("Cannot run inference on an empty graph.");
+    }
+    auto logits = _topologically_sorted_vertices[graph_size - 1];
+
+    // Consumers of every vertex that have not run yet, decremented
+    // concurrently when independent branches run in parallel
+    std::unordered_map<Vertex*, uint32_t> consumer_slots;
+    for (uint32_t vertex_index = 0; vertex_index < graph_size; vertex_index++) {
+      for (auto& input :
+           _topologically_sorted_vertices[vertex_index]->getInputs()) {
+        consumer_slots.emplace(input.get(), consumer_slots.size());
+      }
+    }
+    auto remaining_consumers =
+        std::make_unique<std::atomic<uint32_t>[]>(consumer_slots.size());
+    for (uint32_t vertex_index = 0; vertex_index < graph_size; vertex_index++) {
+      for (auto& input :
+           _topologically_sorted_vertices[vertex_index]->getInputs()) {
+        remaining_consumers[consumer_slots.at(input.get())].fetch_add(
+            1, std::memory_order_relaxed);
+      }
+    }
+
+    getExecutor().run([&](uint32_t vertex_index) {
+      if (vertex_index >= graph_size) {
+        // The skipped loss vertex
+        return;
+      }
+      auto& vertex = _topologically_sorted_vertices[vertex_index];
+      {
+        profiling::ProfileScope profile_scope(*vertex,
+                                              profiling::Pass::Forward);
+        vertex->forward();
+      }
+      memory::MemoryTracker::checkBudget();
+
+      for (auto& input : vertex->getInputs()) {
+        // Leaves own their values (e.g., parameters), so they are never
+        // released
+        if (remaining_consumers[consumer_slots.at(input.get())].fetch_sub(
+                1, std::memory_order_acq_rel) == 1 &&
+            !input->getInputs().empty() && input != logits) {
+          input->releaseOutput();
+        }
+      }
+    });
+    return logits;
+  }
+
+  /**
+   * Returns the predicted label of a single sample, i.e., the argmax of the
+   * output of launchInferencePass().
+   */
+  uint32_t predict() {
+    auto logits = launchInferencePass();
+    if (logits->getName() == "SoftMax") {
+      return dynamic_cast<SoftMaxActivation*>(logits.get())
+          ->getPredictedLabel();
+    }
+    auto& output = logits->getOutput();
+    auto max_iterator = std::max_element(output.begin(), output.end());
+    return static_cast<uint32_t>(std::distance(output.begin(), max_iterator));
   }
 
   // void launchBackwardPass() {
@@ -88,8 +323,42 @@ class Graph {
   // }
 
  private:
+  GraphExecutor& getExecutor() {
+    if (!_executor) {
+      _executor =
+          std::make_unique<GraphExecutor>(_topologically_sorted_vertices);
+    }
+    return *_executor;
+  }
+
+  Checkpointer* buildCheckpointer() {
+    if (_checkpoint_segment_length && !_checkpointer) {
+      _checkpointer = std::make_unique<Checkpointer>(
+          _topologically_sorted_vertices, *_checkpoint_segment_length);
+    }
+    return _checkpointer.get();
+  }
+
+  ActivationOffloader* buildOffloader() {
+    if (_offload_options && !_offloader) {
+      _offloader = std::make_unique<ActivationOffloader>(
+          _topologically_sorted_vertices, *_offload_options);
+    }
+    return _offloader.get();
+  }
+
   std::vector<VertexPointer> _topologically_sorted_vertices;
   std::optional<float> _loss_value;
+  // Built on the first pass after the vertices change
+  std::unique_ptr<GraphExecutor> _executor;
+  // 0 for the default segment length, nullopt if checkpointing is disabled
+  std::optional<uint32_t> _checkpoint_segment_length;
+  // nullopt if offloading is disabled
+  std::optional<OffloadOptions> _offload_options;
+  // Built on the first forward pass after the vertices change. Declared
+  // after the vertices, so they detach from them before they are released.
+  std::unique_ptr<Checkpointer> _checkpointer;
+  std::unique_ptr<ActivationOffloader> _offloader;
 };
 
 }  // namespace gladius::comp_graph
\ No newline at end of file
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <src/comp_graph/vertices/vertex.hpp>
+#include <src/parallel/thread_pool.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <omp.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace gladius::comp_graph {
+
+/**
+ * Runs a function on every vertex of a graph such that each vertex runs
+ * after all of its inputs, executing independent branches (e.g., the Q/K/V
+ * projections of an attention block or the towers of a multi-input model)
+ * concurrently on a parallel::ThreadPool.
+ *
+ * The dependency DAG is built once from the inputs of the vertices. Inputs
+ * that are not vertices of the graph, e.g., parameters, are treated as
+ * already computed. A vertex becomes ready once its last input finishes and
+ * is scheduled on the thread that finished that input.
+ *
+ * Inter-op and intra-op (OpenMP) parallelism share the core budget of the
+ * pool: a vertex that starts while k vertices are running uses
+ * max(1, budget / k) OpenMP threads, so a chain still gets every core while
+ * wide sections split them between their branches.
+ *
+ * Graphs whose DAG is a chain, pools with a single thread and graphs run
+ * while the pool is busy with another graph run the vertices sequentially
+ * in insertion order, without any synchronization.
+ */
+class GraphExecutor {
+ public:
+  /**
+   * `vertices` must be in topological order
+   */
+  explicit GraphExecutor(const std::vector<VertexPointer>& vertices)
+      : _successors(vertices.size()), _num_inputs(vertices.size(), 0) {
+    std::unordered_map<Vertex*, uint32_t> indices;
+    for (uint32_t index = 0; index < vertices.size(); index++) {
+      indices[vertices[index].get()] = index;
+    }
+    // Length of the longest path from a source, which groups the vertices
+    // into levels of mutually independent vertices
+    std::vector<uint32_t> levels(vertices.size(), 0);
+    for (uint32_t index = 0; index < vertices.size(); index++) {
+      for (const auto& input : vertices[index]->getInputs()) {
+        auto input_index = indices.find(input.get());
+        if (input_index == indices.end()) {
+          continue;
+        }
+        _successors[input_index->second].push_back(index);
+        _num_inputs[index]++;
+        levels[index] =
+            std::max(levels[index], levels[input_index->second] + 1);
+      }
+      if (_num_inputs[index] == 0) {
+        _sources.push_back(index);
+      }
+    }
+    std::vector<uint32_t> level_widths(vertices.size(), 0);
+    for (uint32_t level : levels) {
+      _max_width = std::max(_max_width, ++level_widths[level]);
+    }
+  }
+
+  /**
+   * The size of the largest level, a lower bound on the number of vertices
+   * that can run concurrently
+   */
+  inline uint32_t getMaxWidth() const { return _max_width; }
+
+  inline uint32_t getVerticesCount() const {
+    return static_cast<uint32_t>(_successors.size());
+  }
+
+  /**
+   * Calls `function(vertex_index)` for every vertex and returns once all of
+   * them are done. If a call throws, the vertices that have not started are
+   * skipped and the exception is rethrown.
+   */
+  template <typename Function>
+  void run(Function&& function,
+           parallel::ThreadPool& pool = parallel::ThreadPool::global()) {
+    if (_max_width > 1 && pool.getNumThreads() > 1 &&
+        !parallel::ThreadPool::isInsideTask()) {
+      VertexJob<Function&> job(*this, function, pool);
+      if (pool.tryRun(job, _sources)) {
+        return;
+      }
+      // The pool is busy with the graph of another thread
+    }
+    for (uint32_t index = 0; index < getVerticesCount(); index++) {
+      function(index);
+    }
+  }
+
+ private:
+  template <typename Function>
+  class VertexJob final : public parallel::Job {
+   public:
+    VertexJob(const GraphExecutor& executor, Function&& function,
+              parallel::ThreadPool& pool)
+        : _executor(executor),
+          _function(std::forward<Function>(function)),
+          _pool(pool),
+          _remaining_inputs(std::make_unique<std::atomic<uint32_t>[]>(
+              executor.getVerticesCount())) {
+      for (uint32_t index = 0; index < executor.getVerticesCount(); index++) {
+        _remaining_inputs[index].store(executor._num_inputs[index],
+                                       std::memory_order_relaxed);
+      }
+    }
+
+    void execute(uint32_t vertex_index) final {
+      int previous_threads = omp_get_max_threads();
+      int intra_op_threads = std::max<int>(
+          1, _pool.getNumThreads() / std::max<uint32_t>(
+                                         _pool.getRunningTasks(), 1));
+      omp_set_num_threads(intra_op_threads);
+      try {
+        _function(vertex_index);
+      } catch (...) {
+        omp_set_num_threads(previous_threads);
+        throw;
+      }
+      omp_set_num_threads(previous_threads);
+
+      for (uint32_t successor : _executor._successors[vertex_index]) {
+        if (_remaining_inputs[successor].fetch_sub(
+                1, std::memory_order_acq_rel) == 1) {
+          _pool.schedule(successor);
+        }
+      }
+    }
+
+   private:
+    const GraphExecutor& _executor;
+    Function _function;
+    parallel::ThreadPool& _pool;
+    std::unique_ptr<std::atomic<uint32_t>[]> _remaining_inputs;
+  };
+
+  std::vector<std::vector<uint32_t>> _successors;
+  std::vector<uint32_t> _num_inputs;
+  std::vector<uint32_t> _sources;
+  uint32_t _max_width = 0;
+};
+
+}  // namespace gladius::comp_graph
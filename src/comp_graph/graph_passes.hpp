@@ -0,0 +1,172 @@
+#pragma once
+
+#include <src/comp_graph/vertices/vertex.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace gladius::comp_graph {
+
+/**
+ * What the passes over the vertices of a graph removed
+ */
+struct GraphPassReport {
+  uint32_t vertices_before = 0;
+  // Duplicates merged into an equivalent vertex
+  uint32_t merged_vertices = 0;
+  // Vertices whose output does not reach the output of the graph
+  uint32_t pruned_vertices = 0;
+  // Vertices computed ahead of time from parameters (see
+  // foldConstantVertices())
+  uint32_t folded_vertices = 0;
+
+  inline uint32_t getRemovedCount() const {
+    return merged_vertices + pruned_vertices + folded_vertices;
+  }
+
+  void print(std::ostream& stream) const {
+    stream << "Removed " << getRemovedCount() << " of " << vertices_before
+           << " vertices: " << merged_vertices << " duplicates merged, "
+           << pruned_vertices << " dead vertices pruned, " << folded_vertices
+           << " vertices folded into constants\n";
+  }
+};
+
+/**
+ * Identifies the output of a vertex: its name, attributes and (already
+ * merged) inputs
+ */
+struct VertexKey {
+  std::string name;
+  uint64_t attributes;
+  std::vector<const Vertex*> inputs;
+
+  bool operator==(const VertexKey& other) const = default;
+};
+
+struct VertexKeyHash {
+  size_t operator()(const VertexKey& key) const {
+    size_t hash = std::hash<std::string>()(key.name);
+    auto combine = [&hash](size_t value) {
+      hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    };
+    combine(std::hash<uint64_t>()(key.attributes));
+    for (const auto* input : key.inputs) {
+      combine(std::hash<const Vertex*>()(input));
+    }
+    return hash;
+  }
+};
+
+/**
+ * Common subexpression elimination over `vertices`, in topological order.
+ * Vertices with the same name, attributes (see Vertex::getAttributes()) and
+ * inputs compute the same output, so every such vertex but the first is
+ * removed and its consumers read the first one instead. This includes the
+ * leaves that are not in the graph, e.g., several ParameterVertex objects
+ * wrapping the same parameter, which would otherwise each overwrite the
+ * gradient of the parameter with the contribution of their own consumers.
+ * The merged vertex sums the gradients of all of them instead. The last
+ * vertex, the output of the graph, is kept.
+ *
+ * Returns the number of merged vertices.
+ */
+inline uint32_t eliminateCommonSubexpressions(
+    std::vector<VertexPointer>& vertices) {
+  std::unordered_set<const Vertex*> members;
+  for (const auto& vertex : vertices) {
+    members.insert(vertex.get());
+  }
+  std::unordered_map<VertexKey, VertexPointer, VertexKeyHash> canonical;
+  std::unordered_map<const Vertex*, VertexPointer> replacements;
+
+  // The vertex equivalent to `vertex` that was seen first, or `vertex`
+  auto merge = [&](const VertexPointer& vertex) -> VertexPointer {
+    auto attributes = vertex->getAttributes();
+    if (!attributes) {
+      return vertex;
+    }
+    VertexKey key{vertex->getName(), *attributes, {}};
+    for (const auto& input : vertex->getInputs()) {
+      key.inputs.push_back(input.get());
+    }
+    auto [entry, inserted] = canonical.emplace(std::move(key), vertex);
+    if (!inserted) {
+      replacements[vertex.get()] = entry->second;
+    }
+    return entry->second;
+  };
+
+  std::vector<VertexPointer> kept;
+  uint32_t merged = 0;
+  for (uint32_t index = 0; index < vertices.size(); index++) {
+    auto& vertex = vertices[index];
+    for (const auto& input : vertex->getInputs()) {
+      auto replacement = replacements.find(input.get());
+      VertexPointer merged_input;
+      if (replacement != replacements.end()) {
+        merged_input = replacement->second;
+      } else if (!members.count(input.get()) && input->getInputs().empty()) {
+        // Leaves outside of the graph are merged when first read
+        merged_input = merge(input);
+      }
+      if (merged_input && merged_input != input) {
+        vertex->replaceInput(*input, merged_input);
+      }
+    }
+    if (index + 1 == vertices.size() || merge(vertex) == vertex) {
+      kept.push_back(std::move(vertex));
+      continue;
+    }
+    vertex->unregisterFromInputs();
+    merged++;
+  }
+  vertices = std::move(kept);
+  return merged;
+}
+
+/**
+ * Removes the vertices of `vertices`, in topological order, whose output
+ * does not reach the last vertex, the output of the graph. They would run
+ * for nothing, and the inputs they registered with as a consumer would wait
+ * forever for their gradient in the backward pass.
+ *
+ * Returns the number of pruned vertices.
+ */
+inline uint32_t pruneDeadVertices(std::vector<VertexPointer>& vertices) {
+  if (vertices.empty()) {
+    return 0;
+  }
+  std::unordered_set<const Vertex*> live = {vertices.back().get()};
+  std::vector<bool> keep(vertices.size(), false);
+  for (uint32_t index = vertices.size(); index-- > 0;) {
+    auto& vertex = vertices[index];
+    if (!live.count(vertex.get())) {
+      continue;
+    }
+    keep[index] = true;
+    for (const auto& input : vertex->getInputs()) {
+      live.insert(input.get());
+    }
+  }
+
+  std::vector<VertexPointer> kept;
+  for (uint32_t index = 0; index < vertices.size(); index++) {
+    if (keep[index]) {
+      kept.push_back(std::move(vertices[index]));
+    } else {
+      vertices[index]->unregisterFromInputs();
+    }
+  }
+  uint32_t pruned = vertices.size() - kept.size();
+  vertices = std::move(kept);
+  return pruned;
+}
+
+}  // namespace gladius::comp_graph
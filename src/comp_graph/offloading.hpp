@@ -0,0 +1,435 @@
+#pragma once
+
+#include <src/comp_graph/vertices/vertex.hpp>
+#include <src/memory/spill_file.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace gladius::comp_graph {
+
+struct OffloadOptions {
+  // Where the spill file is created
+  std::string directory = "/tmp";
+  // Smaller outputs stay in memory
+  uint64_t min_bytes = 64 * 1024;
+  // How many vertices ahead of the backward sweep the spilled outputs are
+  // read back
+  uint32_t prefetch_depth = 4;
+};
+
+struct OffloadStatistics {
+  // Outputs written to the spill file and released in the forward pass
+  uint64_t spilled_outputs = 0;
+  uint64_t spilled_bytes = 0;
+  uint64_t read_bytes = 0;
+  // Reads issued ahead of the backward sweep
+  uint64_t prefetches = 0;
+  // Spilled outputs needed by the backward pass that were in memory by then
+  uint64_t hits = 0;
+  // Spilled outputs the backward pass had to wait for
+  uint64_t stalls = 0;
+  uint64_t stall_nanoseconds = 0;
+
+  /**
+   * The share of the spilled outputs needed by the backward pass that did
+   * not stall it
+   */
+  inline double getPrefetchHitRate() const {
+    uint64_t needed = hits + stalls;
+    return needed == 0 ? 1.0 : static_cast<double>(hits) / needed;
+  }
+
+  void print(std::ostream& stream) const {
+    stream << "Spilled " << spilled_outputs << " outputs ("
+           << spilled_bytes / 1024 << " KiB), read back "
+           << read_bytes / 1024 << " KiB with " << prefetches
+           << " prefetches\n"
+           << "Prefetch hit rate " << std::fixed << std::setprecision(1)
+           << 100.0 * getPrefetchHitRate() << "% (" << hits << " hits, "
+           << stalls << " stalls, " << std::setprecision(3)
+           << stall_nanoseconds / 1e6 << " ms stalled)\n";
+  }
+};
+
+/**
+ * Activation offloading for the vertices of a graph, for the activations
+ * that do not fit in memory even with gradient checkpointing. Once the last
+ * consumer of an output has run its forward pass, the output is only needed
+ * by the backward pass. From then on, a background I/O thread writes it to
+ * a memory::SpillFile and releases it, while the forward pass goes on.
+ *
+ * The backward pass visits the vertices in about the reverse topological
+ * order. When it reaches the vertex with index i, the spilled outputs of
+ * the `prefetch_depth` vertices before i are read back in reverse order, so
+ * that they are in memory by the time the sweep gets to them. The vertex
+ * waits (a stall) if its output or one of its inputs is still on disk. An
+ * output read back is released again once the vertex and its consumers are
+ * done with their backward pass, and a pending write is cancelled if the
+ * backward pass needs the output first.
+ *
+ * Leaves, the softmax and loss vertices and outputs below `min_bytes` stay
+ * in memory. Vertices whose backward pass reads outputs other than their
+ * own and those of their inputs are not supported.
+ */
+class ActivationOffloader final : public BackwardObserver {
+ public:
+  /**
+   * `vertices` must be in topological order
+   */
+  explicit ActivationOffloader(const std::vector<VertexPointer>& vertices,
+                               OffloadOptions options = {})
+      : _options(std::move(options)),
+        _spill_file(_options.directory),
+        _outputs(vertices.size()),
+        _remaining_consumers(vertices.size()) {
+    for (uint32_t index = 0; index < vertices.size(); index++) {
+      _indices[vertices[index].get()] = index;
+    }
+    for (uint32_t index = 0; index < vertices.size(); index++) {
+      auto& output = _outputs[index];
+      output.vertex = vertices[index].get();
+      for (const auto& input : vertices[index]->getInputs()) {
+        auto input_index = _indices.find(input.get());
+        if (input_index != _indices.end()) {
+          output.inputs.push_back(input_index->second);
+          _outputs[input_index->second].consumers.push_back(index);
+        }
+      }
+      output.vertex->setBackwardObserver(this);
+    }
+    for (auto& output : _outputs) {
+      auto name = output.vertex->getName();
+      output.spillable = !output.inputs.empty() && !output.consumers.empty() &&
+                         name != "SoftMax" && name != "CrossEntropyLoss";
+    }
+    _io_thread = std::thread([this] { runIO(); });
+  }
+
+  ~ActivationOffloader() {
+    {
+      std::unique_lock lock(_mutex);
+      _stopping = true;
+      // The outputs of the pending writes are still in memory
+      for (auto index : _requests) {
+        if (_outputs[index].state == State::Writing) {
+          _outputs[index].state = State::InMemory;
+        }
+      }
+      _requests.clear();
+    }
+    _requested.notify_all();
+    _io_thread.join();
+    for (auto& output : _outputs) {
+      output.vertex->setBackwardObserver(nullptr);
+    }
+  }
+
+  ActivationOffloader(const ActivationOffloader&) = delete;
+  ActivationOffloader& operator=(const ActivationOffloader&) = delete;
+
+  /**
+   * Waits for the I/O of the previous pass and resets the state of the
+   * outputs. Must be called before every forward pass.
+   */
+  void beginForward() {
+    std::unique_lock lock(_mutex);
+    waitForIO(lock);
+    rethrowIOError();
+    for (uint32_t index = 0; index < _outputs.size(); index++) {
+      auto& output = _outputs[index];
+      output.state = State::InMemory;
+      output.written = false;
+      output.wanted = false;
+      output.needed = false;
+      output.finished = false;
+      _remaining_consumers[index].store(output.consumers.size(),
+                                        std::memory_order_relaxed);
+    }
+    _restored.clear();
+    _spill_file.reset();
+    _statistics = OffloadStatistics();
+  }
+
+  /**
+   * Called once the forward pass of the vertex with the given index is done,
+   * possibly concurrently with other vertices. Spills the inputs of the
+   * vertex that it was the last consumer of.
+   */
+  void afterForward(uint32_t vertex_index) {
+    for (auto input : _outputs[vertex_index].inputs) {
+      if (_remaining_consumers[input].fetch_sub(
+              1, std::memory_order_acq_rel) == 1 &&
+          _outputs[input].spillable) {
+        spill(input);
+      }
+    }
+  }
+
+  /**
+   * Waits until the pending writes and reads are done
+   */
+  void flush() {
+    std::unique_lock lock(_mutex);
+    waitForIO(lock);
+    rethrowIOError();
+  }
+
+  void beforeBackward(Vertex& vertex) final {
+    auto position = _indices.find(&vertex);
+    if (position == _indices.end()) {
+      return;
+    }
+    uint32_t index = position->second;
+    std::unique_lock lock(_mutex);
+    rethrowIOError();
+    auto& output = _outputs[index];
+    // What the vertex reads goes first in the queue, then the outputs the
+    // next vertices of the sweep will read
+    request(index);
+    for (auto input : output.inputs) {
+      request(input);
+    }
+    uint32_t first = index > _options.prefetch_depth
+                         ? index - _options.prefetch_depth
+                         : 0;
+    for (uint32_t ahead = index; ahead-- > first;) {
+      if (_outputs[ahead].state == State::OnDisk) {
+        request(ahead);
+        _statistics.prefetches++;
+      }
+    }
+    acquire(index, lock);
+    for (auto input : output.inputs) {
+      acquire(input, lock);
+    }
+  }
+
+  void afterBackward(Vertex& vertex) final {
+    auto position = _indices.find(&vertex);
+    if (position == _indices.end() || vertex.hasPendingGradients()) {
+      return;
+    }
+    std::unique_lock lock(_mutex);
+    _outputs[position->second].finished = true;
+    // The outputs read back that no vertex reads anymore go back to disk
+    std::erase_if(_restored, [&](uint32_t restored) {
+      auto& output = _outputs[restored];
+      bool done = output.finished &&
+                  std::all_of(output.consumers.begin(), output.consumers.end(),
+                              [&](uint32_t consumer) {
+                                return _outputs[consumer].finished;
+                              });
+      if (!done) {
+        return false;
+      }
+      if (output.written) {
+        output.vertex->releaseOutput();
+        output.state = State::OnDisk;
+      }
+      return true;
+    });
+  }
+
+  /**
+   * The statistics of the last pass
+   */
+  OffloadStatistics getStatistics() const {
+    std::unique_lock lock(_mutex);
+    return _statistics;
+  }
+
+  inline const memory::SpillFile& getSpillFile() const { return _spill_file; }
+
+ private:
+  enum class State : uint8_t {
+    // The output is in memory and no I/O is pending for it
+    InMemory,
+    Writing,
+    // The output was released after its write
+    OnDisk,
+    Reading
+  };
+
+  struct Output {
+    Vertex* vertex;
+    std::vector<uint32_t> inputs;
+    std::vector<uint32_t> consumers;
+    bool spillable = false;
+    State state = State::InMemory;
+    // The spill file holds the output
+    bool written = false;
+    // The backward pass waits for the output, so a pending write is
+    // cancelled and a finished one does not release the output
+    bool wanted = false;
+    // The output was needed by the backward pass after it was spilled
+    bool needed = false;
+    // The last call to backward() of the vertex returned
+    bool finished = false;
+    uint64_t offset = 0;
+    uint64_t bytes = 0;
+  };
+
+  void spill(uint32_t index) {
+    auto& output = _outputs[index];
+    uint64_t bytes = output.vertex->getOutput().size() * sizeof(float);
+    if (bytes < _options.min_bytes || bytes == 0) {
+      return;
+    }
+    {
+      std::unique_lock lock(_mutex);
+      if (_stopping) {
+        return;
+      }
+      output.bytes = bytes;
+      output.offset = _spill_file.allocate(bytes);
+      output.state = State::Writing;
+      _requests.push_back(index);
+    }
+    _requested.notify_one();
+  }
+
+  // Queues the read of a spilled output. Requires the lock.
+  void request(uint32_t index) {
+    auto& output = _outputs[index];
+    if (output.state == State::OnDisk) {
+      output.state = State::Reading;
+      _requests.push_back(index);
+      _requested.notify_one();
+    } else if (output.state == State::Writing) {
+      output.wanted = true;
+    }
+  }
+
+  // Waits until a requested output is in memory
+  void acquire(uint32_t index, std::unique_lock<std::mutex>& lock) {
+    auto& output = _outputs[index];
+    bool spilled = output.state != State::InMemory || output.written;
+    if (spilled && !output.needed) {
+      output.needed = true;
+      if (output.state == State::InMemory) {
+        _statistics.hits++;
+      } else {
+        _statistics.stalls++;
+      }
+    }
+    if (output.state == State::InMemory) {
+      return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    _completed.wait(lock, [&] {
+      return output.state == State::InMemory || _io_error;
+    });
+    _statistics.stall_nanoseconds +=
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start)
+            .count();
+    rethrowIOError();
+  }
+
+  void waitForIO(std::unique_lock<std::mutex>& lock) {
+    _completed.wait(lock, [&] { return _requests.empty() && !_busy; });
+  }
+
+  void rethrowIOError() {
+    if (_io_error) {
+      std::rethrow_exception(std::exchange(_io_error, nullptr));
+    }
+  }
+
+  void runIO() {
+    std::unique_lock lock(_mutex);
+    while (true) {
+      _requested.wait(lock, [&] { return _stopping || !_requests.empty(); });
+      if (_stopping) {
+        return;
+      }
+      uint32_t index = _requests.front();
+      _requests.pop_front();
+      auto& output = _outputs[index];
+      if (output.state == State::Writing && output.wanted) {
+        // Needed before it was written
+        output.state = State::InMemory;
+        _completed.notify_all();
+        continue;
+      }
+      _busy = true;
+      lock.unlock();
+      std::vector<float> buffer;
+      std::exception_ptr error;
+      try {
+        if (output.state == State::Writing) {
+          // No other thread touches the output until the write is done
+          _spill_file.write(output.offset, output.vertex->getOutput().data(),
+                            output.bytes);
+        } else {
+          buffer.resize(output.bytes / sizeof(float));
+          _spill_file.read(output.offset, buffer.data(), output.bytes);
+        }
+      } catch (...) {
+        error = std::current_exception();
+      }
+      lock.lock();
+      _busy = false;
+      if (error) {
+        // The output stays in memory if it was being written
+        _io_error = error;
+        if (output.state == State::Writing) {
+          output.state = State::InMemory;
+        }
+      } else if (output.state == State::Writing) {
+        output.written = true;
+        _statistics.spilled_outputs++;
+        _statistics.spilled_bytes += output.bytes;
+        if (!output.wanted) {
+          output.vertex->releaseOutput();
+          output.state = State::OnDisk;
+        } else {
+          output.state = State::InMemory;
+          _restored.push_back(index);
+        }
+      } else {
+        output.vertex->restoreOutput(std::move(buffer));
+        output.state = State::InMemory;
+        _statistics.read_bytes += output.bytes;
+        _restored.push_back(index);
+      }
+      _completed.notify_all();
+    }
+  }
+
+  OffloadOptions _options;
+  memory::SpillFile _spill_file;
+  std::unordered_map<Vertex*, uint32_t> _indices;
+  std::vector<Output> _outputs;
+  // Consumers of every output whose forward pass did not run yet
+  std::vector<std::atomic<uint32_t>> _remaining_consumers;
+  // Outputs back in memory in the backward pass, released again once done
+  std::vector<uint32_t> _restored;
+
+  mutable std::mutex _mutex;
+  std::condition_variable _requested;
+  std::condition_variable _completed;
+  std::deque<uint32_t> _requests;
+  bool _busy = false;
+  bool _stopping = false;
+  std::exception_ptr _io_error;
+  OffloadStatistics _statistics;
+  // Started last, once every other member is constructed
+  std::thread _io_thread;
+};
+
+}  // namespace gladius::comp_graph
@@ -6,14 +6,14 @@
 #include <cereal/types/optional.hpp>
 #include <cereal/types/polymorphic.hpp>
 #include <cereal/types/vector.hpp>
-#include <_types/_uint32_t.h>
-#include <_types/_uint8_t.h>
+#include <src/comp_graph/vertices/param_vertex.hpp>
 #include <src/comp_graph/vertices/vertex.hpp>
 #include <src/utils.hpp>
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <cstddef>
-#include <format>
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <stdexcept>
@@ -34,8 +34,10 @@ class SoftMaxActivation final
           "input. Received " +
           std::to_string(incoming_edges.size()) + " vectors.");
     }
-    auto output_shape = getOutputShape();
-    _local_gradient = std::vector<float>(output_shape.second, 0.F);
+    if (requiresGrad()) {
+      auto output_shape = getOutputShape();
+      _local_gradient = std::vector<float>(output_shape.second, 0.F);
+    }
   }
   SoftMaxActivation(const SoftMaxActivation&) = delete;
   SoftMaxActivation& operator=(const SoftMaxActivation&) = delete;
@@ -43,7 +45,7 @@ class SoftMaxActivation final
 
   void forward() final {
     assert(_output.empty());
-    _logits = _incoming_edges.at(0)->getOutput().at(0);
+    _logits = _incoming_edges.at(0)->getOutput();
     applyOperation();
   }
 
@@ -74,7 +76,9 @@ class SoftMaxActivation final
    * then use the chain rule to compute the partials of the loss function w.r.t
    * the logits
    */
-  void backward(std::optional<std::vector<float>>& upstream_grad) final {
+  void backwardImpl(std::optional<std::vector<float>>& upstream_grad) final {
+    profiling::ProfileScope profile_scope(*this, profiling::Pass::Backward);
+    checkRequiresGrad();
     if (!upstream_grad.has_value()) {
       throw std::runtime_error(
           "Cannot propagate the gradient backward without "
@@ -129,6 +133,27 @@ class SoftMaxActivation final
 
   std::string getName() final { return "SoftMax"; }
 
+  std::vector<VertexPointer> getInputs() const final {
+    return _incoming_edges;
+  }
+
+  void replaceInput(const Vertex& input,
+                    const VertexPointer& replacement) final {
+    for (auto& edge : _incoming_edges) {
+      replaceInputMember(edge, input, replacement);
+    }
+  }
+
+  std::optional<uint64_t> getAttributes() const final {
+    return 0;
+  }
+
+  VertexMemoryUsage getMemoryUsage() const final {
+    auto usage = Vertex::getMemoryUsage();
+    usage.activations += memory::bytesOf(_logits);
+    return usage;
+  }
+
  private:
   /**
    * Computes the softmax operation for the input logits. To prevent
@@ -189,8 +214,10 @@ class ReLUActivation final
           "input. Received " +
           std::to_string(_incoming_edges.size()) + " vectors.");
     }
-    auto output_shape = getOutputShape();
-    _local_gradient = std::vector<float>(output_shape.second, 0.F);
+    if (requiresGrad()) {
+      auto output_shape = getOutputShape();
+      _local_gradient = std::vector<float>(output_shape.second, 0.F);
+    }
   }
 
   ReLUActivation(const ReLUActivation&) = delete;
@@ -209,7 +236,9 @@ class ReLUActivation final
    * TODO: Computing the Jacobian matrix is completely unnecessary.
    *       Remove it.
    */
-  void backward(std::optional<std::vector<float>>& upstream_grad) final {
+  void backwardImpl(std::optional<std::vector<float>>& upstream_grad) final {
+    profiling::ProfileScope profile_scope(*this, profiling::Pass::Backward);
+    checkRequiresGrad();
     if (!upstream_grad.has_value()) {
       throw std::runtime_error(
           "Cannot propagate the gradient backward without "
@@ -224,10 +253,9 @@ class ReLUActivation final
       _jacobian = std::vector<std::vector<float>>(
           dimensions, std::vector<float>(dimensions, 0.F));
 
-      auto input_vector = _incoming_edges.at(0)->getOutput();
+      auto& input_vector = _incoming_edges.at(0)->getOutput();
       for (uint32_t index = 0; index < dimensions; index++) {
-        (*_jacobian)[index][index] =
-            input_vector.at(0).at(index) > 0.F ? 1.0 : 0.F;
+        (*_jacobian)[index][index] = input_vector.at(index) > 0.F ? 1.0 : 0.F;
       }
     }
 
@@ -248,14 +276,35 @@ class ReLUActivation final
 
   inline std::string getName() final { return "ReLU"; }
 
+  std::vector<VertexPointer> getInputs() const final {
+    return _incoming_edges;
+  }
+
+  void replaceInput(const Vertex& input,
+                    const VertexPointer& replacement) final {
+    for (auto& edge : _incoming_edges) {
+      replaceInputMember(edge, input, replacement);
+    }
+  }
+
+  std::optional<uint64_t> getAttributes() const final {
+    return 0;
+  }
+
   std::pair<uint32_t, uint32_t> getOutputShape() const final {
     return _incoming_edges.at(0)->getOutputShape();
   }
 
+  VertexMemoryUsage getMemoryUsage() const final {
+    auto usage = Vertex::getMemoryUsage();
+    usage.jacobians += memory::bytesOf(_jacobian);
+    return usage;
+  }
+
  private:
   std::shared_ptr<Vertex> applyOperation() final {
     auto incoming_edge = _incoming_edges.at(0);
-    auto input_vector = incoming_edge->getOutput().at(0);
+    auto& input_vector = incoming_edge->getOutput();
     auto size = input_vector.size();
 
     for (uint32_t neuron_index = 0; neuron_index < size; neuron_index++) {
@@ -298,8 +347,10 @@ class TanHActivation final
           "input. Received " +
           std::to_string(_incoming_edges.size()) + " vectors.");
     }
-    auto output_shape = getOutputShape();
-    _local_gradient = std::vector<float>(output_shape.second, 0.F);
+    if (requiresGrad()) {
+      auto output_shape = getOutputShape();
+      _local_gradient = std::vector<float>(output_shape.second, 0.F);
+    }
   }
 
   TanHActivation(const TanHActivation&) = delete;
@@ -319,7 +370,9 @@ class TanHActivation final
    * simplifying, we get that d(tanh(x))/dx = 1 - [tanh(x)^2]
    *
    */
-  void backward(std::optional<std::vector<float>>& upstream_grad) final {
+  void backwardImpl(std::optional<std::vector<float>>& upstream_grad) final {
+    profiling::ProfileScope profile_scope(*this, profiling::Pass::Backward);
+    checkRequiresGrad();
     if (!upstream_grad.has_value()) {
       throw std::runtime_error(
           "Cannot propagate the gradient backward without "
@@ -353,14 +406,35 @@ class TanHActivation final
 
   inline std::string getName() final { return "TanH"; }
 
+  std::vector<VertexPointer> getInputs() const final {
+    return _incoming_edges;
+  }
+
+  void replaceInput(const Vertex& input,
+                    const VertexPointer& replacement) final {
+    for (auto& edge : _incoming_edges) {
+      replaceInputMember(edge, input, replacement);
+    }
+  }
+
+  std::optional<uint64_t> getAttributes() const final {
+    return 0;
+  }
+
   std::pair<uint32_t, uint32_t> getOutputShape() const final {
     return _incoming_edges.at(0)->getOutputShape();
   }
 
+  VertexMemoryUsage getMemoryUsage() const final {
+    auto usage = Vertex::getMemoryUsage();
+    usage.jacobians += memory::bytesOf(_jacobian);
+    return usage;
+  }
+
  private:
   std::shared_ptr<Vertex> applyOperation() final {
     auto incoming_edge = _incoming_edges.at(0);
-    auto input_vector = incoming_edge->getOutput().at(0);
+    auto& input_vector = incoming_edge->getOutput();
     auto size = input_vector.size();
 
     for (uint32_t neuron_index = 0; neuron_index < size; neuron_index++) {
@@ -384,6 +458,168 @@ class TanHActivation final
   }
 };
 
+/**
+ * Computes GELU(x + b) for a (rows, d) input x and a (1, d) bias parameter b
+ * that is broadcast over the rows. GELU is evaluated with the tanh
+ * approximation from https://arxiv.org/pdf/1606.08415.pdf
+ *        GELU(z) = 0.5 z (1 + TanH(\sqrt{2 / \pi} (z + 0.044715 z^3)))
+ *
+ * Fusing the bias addition into the activation means the pre-activation
+ * z = x + b never has to be written out: it is recomputed from the input
+ * during the backward pass, and each pass touches every element once.
+ */
+class BiasGELUActivation final
+    : public Vertex,
+      public std::enable_shared_from_this<BiasGELUActivation> {
+ public:
+  BiasGELUActivation(VertexPointer input,
+                     std::shared_ptr<ParameterVertex> bias)
+      : _input(std::move(input)), _bias(std::move(bias)) {
+    auto [rows, dimension] = _input->getOutputShape();
+    if (_bias->getOutputShape() !=
+        std::pair<uint32_t, uint32_t>(1, dimension)) {
+      throw std::invalid_argument(
+          "The bias of a BiasGELU activation must have shape (1, " +
+          std::to_string(dimension) + ").");
+    }
+    _rows = rows;
+    _dimension = dimension;
+
+    registerInput(*_input);
+    registerInput(*_bias);
+  }
+
+  BiasGELUActivation(const BiasGELUActivation&) = delete;
+  BiasGELUActivation& operator=(const BiasGELUActivation&) = delete;
+
+  void forward() final { applyOperation(); }
+
+  /**
+   * With u = \sqrt{2 / \pi} (z + 0.044715 z^3) and t = TanH(u), the
+   * derivative of the activation is
+   *        GELU'(z) = 0.5 (1 + t) + 0.5 z (1 - t^2) \sqrt{2 / \pi}
+   *                   (1 + 3 * 0.044715 z^2)
+   * The gradient w.r.t the input is the upstream gradient scaled by
+   * GELU'(z), and the gradient w.r.t the bias sums it over the rows.
+   */
+  void backwardImpl(std::optional<std::vector<float>>& upstream_grad) final {
+    profiling::ProfileScope profile_scope(*this, profiling::Pass::Backward);
+    checkRequiresGrad();
+    if (!upstream_grad.has_value()) {
+      throw std::runtime_error(
+          "Cannot propagate the gradient backward without "
+          "setting the upstream gradient first.");
+    }
+    assert(!_output.empty());
+    assert(upstream_grad.value().size() == _output.size());
+
+    if (!accumulateUpstreamGradient(upstream_grad.value())) {
+      return;
+    }
+    auto& input = _input->getOutput();
+    const float* bias = _bias->getParameter()->getValue().at(0).data();
+
+    resetGradient(_local_gradient, _rows * _dimension);
+    resetGradient(_bias_gradient, _dimension);
+
+    for (uint32_t row = 0; row < _rows; row++) {
+      uint64_t offset = static_cast<uint64_t>(row) * _dimension;
+#pragma omp simd
+      for (uint32_t col = 0; col < _dimension; col++) {
+        float z = input[offset + col] + bias[col];
+        float tanh_u =
+            std::tanh(SQRT_2_OVER_PI * (z + GELU_COEFFICIENT * z * z * z));
+        float derivative =
+            0.5F * (1.F + tanh_u) +
+            0.5F * z * (1.F - tanh_u * tanh_u) * SQRT_2_OVER_PI *
+                (1.F + 3.F * GELU_COEFFICIENT * z * z);
+        float grad = _upstream_gradient[offset + col] * derivative;
+
+        (*_local_gradient)[offset + col] = grad;
+        (*_bias_gradient)[col] += grad;
+      }
+    }
+    _bias->backward(/* upstream_grad = */ _bias_gradient);
+    _input->backward(/* upstream_grad = */ _local_gradient);
+  }
+
+  inline std::string getName() final { return "BiasGELU"; }
+
+  std::vector<VertexPointer> getInputs() const final {
+    return {_input, _bias};
+  }
+
+  void replaceInput(const Vertex& input,
+                    const VertexPointer& replacement) final {
+    replaceInputMember(_input, input, replacement);
+    replaceInputMember(_bias, input, replacement);
+  }
+
+  std::optional<uint64_t> getAttributes() const final {
+    return 0;
+  }
+
+  uint64_t estimateFlops() const final {
+    // Bias addition and the tanh approximation of GELU
+    return 10ULL * _rows * _dimension;
+  }
+
+  std::pair<uint32_t, uint32_t> getOutputShape() const final {
+    return std::make_pair(_rows, _dimension);
+  }
+
+  inline const VertexPointer& getInput() const { return _input; }
+  inline const std::shared_ptr<ParameterVertex>& getBias() const {
+    return _bias;
+  }
+
+  VertexMemoryUsage getMemoryUsage() const final {
+    auto usage = Vertex::getMemoryUsage();
+    usage.gradients += memory::bytesOf(_bias_gradient);
+    return usage;
+  }
+
+ private:
+  static constexpr float SQRT_2_OVER_PI = 0.7978845608F;
+  static constexpr float GELU_COEFFICIENT = 0.044715F;
+
+  std::shared_ptr<Vertex> applyOperation() final {
+    auto& input = _input->getOutput();
+    const float* bias = _bias->getParameter()->getValue().at(0).data();
+
+    // Every entry is overwritten, so the output is only allocated once
+    _output.resize(_rows * _dimension);
+
+    for (uint32_t row = 0; row < _rows; row++) {
+      uint64_t offset = static_cast<uint64_t>(row) * _dimension;
+#pragma omp simd
+      for (uint32_t col = 0; col < _dimension; col++) {
+        float z = input[offset + col] + bias[col];
+        float tanh_u =
+            std::tanh(SQRT_2_OVER_PI * (z + GELU_COEFFICIENT * z * z * z));
+        _output[offset + col] = 0.5F * z * (1.F + tanh_u);
+      }
+    }
+    return shared_from_this();
+  }
+
+  VertexPointer _input;
+  std::shared_ptr<ParameterVertex> _bias;
+  std::optional<std::vector<float>> _bias_gradient;
+
+  uint32_t _rows;
+  uint32_t _dimension;
+
+  BiasGELUActivation() = default;
+
+  friend class cereal::access;
+  template <typename Archive>
+  void serialize(Archive& archive) {
+    archive(cereal::base_class<Vertex>(this), _input, _bias, _output, _rows,
+            _dimension);
+  }
+};
+
 }  // namespace gladius::comp_graph
 
 #include <cereal/archives/binary.hpp>
@@ -391,3 +627,4 @@ class TanHActivation final
 CEREAL_REGISTER_TYPE(gladius::comp_graph::TanHActivation)
 CEREAL_REGISTER_TYPE(gladius::comp_graph::ReLUActivation)
 CEREAL_REGISTER_TYPE(gladius::comp_graph::SoftMaxActivation)
+CEREAL_REGISTER_TYPE(gladius::comp_graph::BiasGELUActivation)
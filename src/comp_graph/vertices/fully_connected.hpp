@@ -0,0 +1,293 @@
+#pragma once
+
+#include <cereal/access.hpp>
+#include <cereal/types/base_class.hpp>
+#include <cereal/types/memory.hpp>
+#include <cereal/types/optional.hpp>
+#include <cereal/types/polymorphic.hpp>
+#include <cereal/types/vector.hpp>
+#include <src/comp_graph/vertices/param_vertex.hpp>
+#include <src/comp_graph/vertices/vertex.hpp>
+#include <src/params/element_types.hpp>
+#include <src/parallel/parallel_for.hpp>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace gladius::comp_graph {
+
+using gladius::comp_graph::ParameterVertex;
+using gladius::comp_graph::Vertex;
+using gladius::comp_graph::VertexPointer;
+using gladius::parameters::bfloat16;
+using gladius::parameters::ElementType;
+using gladius::parameters::float16;
+
+/**
+ * Computes Y = XW^T + b for a batch (or sequence) of row vectors X of shape
+ * (rows, n), a weight parameter W of shape (m, n) and an optional bias b of
+ * shape (1, m). The output has shape (rows, m).
+ *
+ * Unlike InnerProduct, this vertex never materializes a Jacobian. The
+ * gradients w.r.t X, W and b are computed directly as
+ *        dX = G W,   dW = G^T X,   db = \sum_{rows} G
+ * where G is the (rows, m) upstream gradient.
+ *
+ * If the weight parameter keeps a bf16 or fp16 copy of its value (see
+ * Parameter::setStorageType), Y and dX read the weights from that copy and
+ * convert them on load, accumulating in fp32. dW is always computed in fp32
+ * for the fp32 master weights.
+ */
+class FullyConnected final
+    : public Vertex,
+      public std::enable_shared_from_this<FullyConnected> {
+ public:
+  FullyConnected(VertexPointer input, std::shared_ptr<ParameterVertex> weights,
+                 std::shared_ptr<ParameterVertex> bias = nullptr)
+      : _input(std::move(input)),
+        _weights(std::move(weights)),
+        _bias(std::move(bias)) {
+    auto [rows, input_dimension] = _input->getOutputShape();
+    auto [output_dimension, weight_columns] = _weights->getOutputShape();
+
+    if (weight_columns != input_dimension) {
+      throw std::invalid_argument(
+          "Dimension mismatch for the inputs to FullyConnected vertex. The "
+          "weight matrix has " +
+          std::to_string(weight_columns) +
+          " columns while the input rows have dimension " +
+          std::to_string(input_dimension) + ".");
+    }
+    if (_bias && _bias->getOutputShape() !=
+                     std::pair<uint32_t, uint32_t>(1, output_dimension)) {
+      throw std::invalid_argument(
+          "The bias of a FullyConnected vertex must have shape (1, " +
+          std::to_string(output_dimension) + ").");
+    }
+    _rows = rows;
+    _input_dimension = input_dimension;
+    _output_dimension = output_dimension;
+
+    registerInput(*_input);
+    registerInput(*_weights);
+    if (_bias) {
+      registerInput(*_bias);
+    }
+  }
+
+  FullyConnected(const FullyConnected&) = delete;
+  FullyConnected& operator=(const FullyConnected&) = delete;
+
+  void forward() final { applyOperation(); }
+
+  void backwardImpl(std::optional<std::vector<float>>& upstream_grad) final {
+    profiling::ProfileScope profile_scope(*this, profiling::Pass::Backward);
+    if (!upstream_grad.has_value()) {
+      throw std::runtime_error(
+          "Cannot propagate the gradient backward without "
+          "setting the upstream gradient first.");
+    }
+    assert(!_output.empty());
+    assert(upstream_grad.value().size() == _output.size());
+
+    if (!accumulateUpstreamGradient(upstream_grad.value())) {
+      return;
+    }
+    auto& input = _input->getOutput();
+
+    _local_gradient = std::vector<float>(_rows * _input_dimension, 0.F);
+    _weight_gradient =
+        std::vector<float>(_output_dimension * _input_dimension, 0.F);
+
+    switch (_weights->getParameter()->getStorageType()) {
+      case ElementType::BFloat16:
+        backwardInputImpl<bfloat16>();
+        break;
+      case ElementType::Float16:
+        backwardInputImpl<float16>();
+        break;
+      case ElementType::Float32:
+        backwardInputImpl<float>();
+        break;
+    }
+
+    parallel::parallelFor(
+        0, _output_dimension,
+        [&](uint64_t begin, uint64_t end) {
+          for (uint64_t neuron = begin; neuron < end; neuron++) {
+            float* weight_gradient =
+                _weight_gradient->data() + neuron * _input_dimension;
+            for (uint32_t row = 0; row < _rows; row++) {
+              float grad =
+                  _upstream_gradient[row * _output_dimension + neuron];
+              const float* input_row = input.data() + row * _input_dimension;
+#pragma omp simd
+              for (uint32_t col = 0; col < _input_dimension; col++) {
+                weight_gradient[col] += grad * input_row[col];
+              }
+            }
+          }
+        },
+        parallel::grainSize(
+            /* work_per_iteration = */ uint64_t{_rows} * _input_dimension));
+    _weights->backward(/* upstream_grad = */ _weight_gradient);
+
+    if (_bias) {
+      _bias_gradient = std::vector<float>(_output_dimension, 0.F);
+      for (uint32_t row = 0; row < _rows; row++) {
+        for (uint32_t neuron = 0; neuron < _output_dimension; neuron++) {
+          (*_bias_gradient)[neuron] +=
+              _upstream_gradient[row * _output_dimension + neuron];
+        }
+      }
+      _bias->backward(/* upstream_grad = */ _bias_gradient);
+    }
+
+    _input->backward(/* upstream_grad = */ _local_gradient);
+  }
+
+  inline std::string getName() final { return "FullyConnected"; }
+
+  std::vector<VertexPointer> getInputs() const final {
+    if (_bias) {
+      return {_input, _weights, _bias};
+    }
+    return {_input, _weights};
+  }
+
+  void replaceInput(const Vertex& input,
+                    const VertexPointer& replacement) final {
+    replaceInputMember(_input, input, replacement);
+    replaceInputMember(_weights, input, replacement);
+    replaceInputMember(_bias, input, replacement);
+  }
+
+  std::optional<uint64_t> getAttributes() const final {
+    return 0;
+  }
+
+  uint64_t estimateFlops() const final {
+    return 2ULL * _rows * _input_dimension * _output_dimension;
+  }
+
+  std::pair<uint32_t, uint32_t> getOutputShape() const final {
+    return std::make_pair(_rows, _output_dimension);
+  }
+
+  inline const VertexPointer& getInput() const { return _input; }
+  inline const std::shared_ptr<ParameterVertex>& getWeights() const {
+    return _weights;
+  }
+  inline const std::shared_ptr<ParameterVertex>& getBias() const {
+    return _bias;
+  }
+
+  VertexMemoryUsage getMemoryUsage() const final {
+    auto usage = Vertex::getMemoryUsage();
+    usage.gradients += memory::bytesOf(_weight_gradient) +
+                       memory::bytesOf(_bias_gradient);
+    return usage;
+  }
+
+ private:
+  template <typename T>
+  inline const T* weightRow(uint32_t neuron) const {
+    if constexpr (std::is_same_v<T, float>) {
+      return _weights->getParameter()->getValue()[neuron].data();
+    } else {
+      return _weights->getParameter()->template getCompactRow<T>(neuron);
+    }
+  }
+
+  template <typename T>
+  void backwardInputImpl() {
+    parallel::parallelFor(
+        0, _rows,
+        [&](uint64_t begin, uint64_t end) {
+          for (uint64_t row = begin; row < end; row++) {
+            float* input_gradient =
+                _local_gradient->data() + row * _input_dimension;
+            for (uint32_t neuron = 0; neuron < _output_dimension; neuron++) {
+              float grad = _upstream_gradient[row * _output_dimension + neuron];
+              parameters::addScaled(grad, weightRow<T>(neuron),
+                                    input_gradient, _input_dimension);
+            }
+          }
+        },
+        parallel::grainSize(
+            /* work_per_iteration = */ uint64_t{_output_dimension} *
+            _input_dimension));
+  }
+
+  template <typename T>
+  void forwardImpl() {
+    auto& input = _input->getOutput();
+    const float* bias =
+        _bias ? _bias->getParameter()->getValue().at(0).data() : nullptr;
+
+    parallel::parallelFor(
+        0, _rows,
+        [&](uint64_t begin, uint64_t end) {
+          for (uint64_t row = begin; row < end; row++) {
+            const float* input_row = input.data() + row * _input_dimension;
+            for (uint32_t neuron = 0; neuron < _output_dimension; neuron++) {
+              float activation = parameters::dotProduct(
+                  weightRow<T>(neuron), input_row, _input_dimension);
+              _output[row * _output_dimension + neuron] =
+                  activation + (bias ? bias[neuron] : 0.F);
+            }
+          }
+        },
+        parallel::grainSize(
+            /* work_per_iteration = */ uint64_t{_output_dimension} *
+            _input_dimension));
+  }
+
+  std::shared_ptr<Vertex> applyOperation() final {
+    _output = std::vector<float>(_rows * _output_dimension, 0.F);
+
+    profiling::ProfileScope kernel_scope(
+        "FullyConnected::gemm", profiling::Pass::Kernel, estimateFlops());
+
+    switch (_weights->getParameter()->getStorageType()) {
+      case ElementType::BFloat16:
+        forwardImpl<bfloat16>();
+        break;
+      case ElementType::Float16:
+        forwardImpl<float16>();
+        break;
+      case ElementType::Float32:
+        forwardImpl<float>();
+        break;
+    }
+    return shared_from_this();
+  }
+
+  VertexPointer _input;
+  std::shared_ptr<ParameterVertex> _weights;
+  std::shared_ptr<ParameterVertex> _bias;
+
+  std::optional<std::vector<float>> _weight_gradient;
+  std::optional<std::vector<float>> _bias_gradient;
+
+  uint32_t _rows;
+  uint32_t _input_dimension;
+  uint32_t _output_dimension;
+
+  FullyConnected() = default;
+  friend class cereal::access;
+
+  template <typename Archive>
+  void serialize(Archive& archive) {
+    archive(cereal::base_class<Vertex>(this), _input, _weights, _bias, _output,
+            _rows, _input_dimension, _output_dimension);
+  }
+};
+
+}  // namespace gladius::comp_graph
+
+CEREAL_REGISTER_TYPE(gladius::comp_graph::FullyConnected)
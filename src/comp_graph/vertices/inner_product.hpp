@@ -6,9 +6,13 @@
 #include <cereal/types/optional.hpp>
 #include <cereal/types/polymorphic.hpp>
 #include <cereal/types/vector.hpp>
-#include <_types/_uint32_t.h>
+#include <src/comp_graph/vertices/input_vertex.hpp>
+#include <src/comp_graph/vertices/param_vertex.hpp>
 #include <src/comp_graph/vertices/vertex.hpp>
+#include <src/parallel/parallel_for.hpp>
 #include <src/utils.hpp>
+#include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <stdexcept>
 #include <utility>
@@ -16,9 +20,19 @@
 
 namespace gladius::comp_graph {
 
+using gladius::comp_graph::ParameterVertex;
+using gladius::comp_graph::SparseInputVertex;
 using gladius::comp_graph::Vertex;
 using gladius::comp_graph::VertexPointer;
 
+/**
+ * If the right input is a SparseInputVertex holding a batch of B sparse rows
+ * and the left input is a (m, n) weight parameter W, the output is the
+ * (B, m) matrix whose row b is W x_b. Only the non-zero entries of x_b are
+ * read, so the cost is O(m nnz) instead of O(m n B), and the backward pass
+ * only writes the columns of the weight gradient that are non-zero in the
+ * batch.
+ */
 class InnerProduct final : public Vertex,
                            public std::enable_shared_from_this<InnerProduct> {
  public:
@@ -36,6 +50,20 @@ class InnerProduct final : public Vertex,
           "Dimension mismatch for the inputs to InnerProduct vertex. Make sure "
           "that the two inputs have the same dimensions.");
     }
+
+    _sparse_input = std::dynamic_pointer_cast<SparseInputVertex>(_right_input);
+    if (_sparse_input) {
+      _weights = std::dynamic_pointer_cast<ParameterVertex>(_left_input);
+      if (!_weights) {
+        throw std::invalid_argument(
+            "InnerProduct with a sparse right input expects the left input "
+            "to be a weight parameter.");
+      }
+      _output_length = left_input_shape.first;
+      _batch_size = _sparse_input->getBatchSize();
+      _output = std::vector<float>(_batch_size * _output_length, 0.F);
+      return;
+    }
     // We treat the operation as representing Matrix-vector multiplication if
     // the first dimension mismatch. Otherwise, the operation represents the
     // inner product of two vectors.
@@ -50,6 +78,9 @@ class InnerProduct final : public Vertex,
 
     _output = std::vector<float>(_output_length, 0.F);
 
+    if (!requiresGrad()) {
+      return;
+    }
     _local_left_gradient = std::vector<float>(
         left_input_shape.first * left_input_shape.second, 0.F);
 
@@ -59,7 +90,9 @@ class InnerProduct final : public Vertex,
 
   void forward() final { applyOperation(); }
 
-  void backward(std::optional<std::vector<float>>& upstream_grad) final {
+  void backwardImpl(std::optional<std::vector<float>>& upstream_grad) final {
+    profiling::ProfileScope profile_scope(*this, profiling::Pass::Backward);
+    checkRequiresGrad();
     if (!upstream_grad.has_value()) {
       throw std::runtime_error(
           "Cannot propagate the gradient backward without "
@@ -67,6 +100,11 @@ class InnerProduct final : public Vertex,
     }
     assert(!_output.empty());
 
+    if (_sparse_input) {
+      backwardSparseImpl(/* upstream_grad = */ upstream_grad.value());
+      return;
+    }
+
     // Memory for the gradients ought to have been allocated during the forward
     // pass
     assert(_local_left_gradient.has_value());
@@ -79,11 +117,121 @@ class InnerProduct final : public Vertex,
 
   inline std::string getName() final { return "InnerProduct"; }
 
+  std::vector<VertexPointer> getInputs() const final {
+    return {_left_input, _right_input};
+  }
+
+  void replaceInput(const Vertex& input,
+                    const VertexPointer& replacement) final {
+    replaceInputMember(_left_input, input, replacement);
+    replaceInputMember(_right_input, input, replacement);
+    replaceInputMember(_sparse_input, input, replacement);
+    replaceInputMember(_weights, input, replacement);
+  }
+
+  std::optional<uint64_t> getAttributes() const final {
+    return 0;
+  }
+
+  uint64_t estimateFlops() const final {
+    if (_sparse_input) {
+      return 2ULL * _sparse_input->getIndices().size() * _output_length;
+    }
+    auto [rows, columns] = _left_input->getOutputShape();
+    return 2ULL * rows * columns;
+  }
+
   std::pair<uint32_t, uint32_t> getOutputShape() const final {
-    return std::make_pair(1, _output_length);
+    return std::make_pair(_batch_size, _output_length);
+  }
+
+  inline const VertexPointer& getLeftInput() const { return _left_input; }
+  inline const VertexPointer& getRightInput() const { return _right_input; }
+
+  VertexMemoryUsage getMemoryUsage() const final {
+    auto usage = Vertex::getMemoryUsage();
+    usage.gradients += memory::bytesOf(_local_left_gradient) +
+                       memory::bytesOf(_local_right_gradient);
+    usage.jacobians += memory::bytesOf(_left_input_jacobian);
+    return usage;
   }
 
  private:
+  /**
+   * With G the (B, m) upstream gradient, the gradient w.r.t W is G^T X. Its
+   * column c is zero unless c is a non-zero index of some row of X, so it is
+   * only computed (and later applied by the optimizer) for those columns.
+   * The sparse input has no gradient.
+   */
+  void backwardSparseImpl(std::vector<float>& upstream_grad) {
+    assert(upstream_grad.size() == _batch_size * _output_length);
+    const auto& row_offsets = _sparse_input->getRowOffsets();
+    const auto& indices = _sparse_input->getIndices();
+    const auto& values = _sparse_input->getValues();
+
+    std::vector<uint32_t> columns = indices;
+    std::sort(columns.begin(), columns.end());
+    columns.erase(std::unique(columns.begin(), columns.end()), columns.end());
+
+    // Position of every non-zero entry in the list of touched columns
+    std::vector<uint32_t> positions(indices.size());
+    for (uint64_t k = 0; k < indices.size(); k++) {
+      positions[k] =
+          std::lower_bound(columns.begin(), columns.end(), indices[k]) -
+          columns.begin();
+    }
+
+    uint64_t num_columns = columns.size();
+    std::vector<float> columns_gradient(_output_length * num_columns, 0.F);
+
+    parallel::parallelFor(
+        0, _output_length,
+        [&](uint64_t begin, uint64_t end) {
+          for (uint64_t neuron = begin; neuron < end; neuron++) {
+            float* gradient_row =
+                columns_gradient.data() + neuron * num_columns;
+            for (uint32_t row = 0; row < _batch_size; row++) {
+              float grad = upstream_grad[row * _output_length + neuron];
+              for (uint32_t k = row_offsets[row]; k < row_offsets[row + 1];
+                   k++) {
+                gradient_row[positions[k]] += grad * values[k];
+              }
+            }
+          }
+        },
+        parallel::grainSize(/* work_per_iteration = */ indices.size()));
+    _weights->getParameter()->accumulateColumnGradient(columns,
+                                                       columns_gradient);
+  }
+
+  std::shared_ptr<Vertex> applySparseOperation() {
+    profiling::ProfileScope kernel_scope("InnerProduct::spmm",
+                                         profiling::Pass::Kernel,
+                                         estimateFlops());
+    auto& weights = _weights->getParameter()->getValue();
+    const auto& row_offsets = _sparse_input->getRowOffsets();
+    const auto& indices = _sparse_input->getIndices();
+    const auto& values = _sparse_input->getValues();
+
+    parallel::parallelFor(
+        0, _output_length,
+        [&](uint64_t begin, uint64_t end) {
+          for (uint64_t neuron = begin; neuron < end; neuron++) {
+            const float* weight_row = weights[neuron].data();
+            for (uint32_t row = 0; row < _batch_size; row++) {
+              float activation = 0.F;
+              for (uint32_t k = row_offsets[row]; k < row_offsets[row + 1];
+                   k++) {
+                activation += weight_row[indices[k]] * values[k];
+              }
+              _output[row * _output_length + neuron] = activation;
+            }
+          }
+        },
+        parallel::grainSize(/* work_per_iteration = */ indices.size()));
+    return shared_from_this();
+  }
+
   /**
    * Note: For now we are assuming that the right input represents
    * some vector (for example, a computation result from ReLU).
@@ -99,12 +247,16 @@ class InnerProduct final : public Vertex,
 
     // std::cout << "\t[inner-prod-local-grad-update(right)]" << std::endl;
 
-    for (uint32_t col_index = 0; col_index < num_columns; col_index++) {
-      (*_local_right_gradient)[col_index] +=  // NOLINT
-          gladius::utils::innerProduct(        // NOLINT
-              /* vector = */ upstream_grad,   // NOLINT
-              /* matrix = */ _left_input->getOutput(),
-              /* col_index = */ col_index);
+    // The left input is a (rows, num_columns) matrix stored row by row
+    auto& left_output = _left_input->getOutput();
+    for (uint32_t row_index = 0; row_index < left_input_shape.first;
+         row_index++) {
+      const float* left_row =
+          left_output.data() + static_cast<uint64_t>(row_index) * num_columns;
+      for (uint32_t col_index = 0; col_index < num_columns; col_index++) {
+        (*_local_right_gradient)[col_index] +=
+            upstream_grad[row_index] * left_row[col_index];
+      }
     }
     // std::cout << "[inner-prod-backward-right-input]" << std::endl;
 
@@ -133,24 +285,28 @@ class InnerProduct final : public Vertex,
           left_input_shape.first,
           std::vector<float>(total_jacobian_columns, 0.F));
 
-#pragma omp parallel for default(none)                                     \
-    shared(left_input_shape, total_jacobian_columns, _left_input_jacobian, \
-           _right_input)
-      for (uint32_t row_index = 0; row_index < left_input_shape.first;
-           row_index++) {
-        for (uint32_t col_index = 0; col_index < total_jacobian_columns;
-             col_index++) {
-          uint32_t weight_matrix_col_index =
-              col_index % left_input_shape.second;
-          uint32_t weight_matrix_row_index =
-              (col_index - weight_matrix_col_index) / left_input_shape.second;
-
-          if (row_index == weight_matrix_row_index) {
-            (*_left_input_jacobian)[row_index][col_index] =
-                _right_input->getOutput().at(0).at(weight_matrix_col_index);
-          }
-        }
-      }
+      auto& right_output = _right_input->getOutput();
+      parallel::parallelFor(
+          0, left_input_shape.first,
+          [&](uint64_t begin, uint64_t end) {
+            for (uint64_t row_index = begin; row_index < end; row_index++) {
+              for (uint32_t col_index = 0; col_index < total_jacobian_columns;
+                   col_index++) {
+                uint32_t weight_matrix_col_index =
+                    col_index % left_input_shape.second;
+                uint32_t weight_matrix_row_index =
+                    (col_index - weight_matrix_col_index) /
+                    left_input_shape.second;
+
+                if (row_index == weight_matrix_row_index) {
+                  (*_left_input_jacobian)[row_index][col_index] =
+                      right_output.at(weight_matrix_col_index);
+                }
+              }
+            }
+          },
+          parallel::grainSize(
+              /* work_per_iteration = */ total_jacobian_columns));
     }
     // std::cout << "\t[inner-prod-local-grad-update(left)]" << std::endl;
 
@@ -169,14 +325,23 @@ class InnerProduct final : public Vertex,
   }
 
   std::shared_ptr<Vertex> applyOperation() final {
-    auto right_output_vector = _right_input->getOutput().at(0);
-    auto size = _left_input->getOutputShape().first;
+    if (_sparse_input) {
+      return applySparseOperation();
+    }
+    profiling::ProfileScope kernel_scope(
+        "InnerProduct::gemv", profiling::Pass::Kernel, estimateFlops());
+    auto& right_output = _right_input->getOutput();
+    auto& left_output = _left_input->getOutput();
+    auto [size, columns] = _left_input->getOutputShape();
 
     for (uint32_t row_index = 0; row_index < size; row_index++) {
-      auto current_row = _left_input->getOutput().at(row_index);
-      auto inner_product = gladius::utils::innerProduct(
-          /*first = */ current_row, /* second = */ right_output_vector);
-
+      const float* left_row =
+          left_output.data() + static_cast<uint64_t>(row_index) * columns;
+      float inner_product = 0.F;
+#pragma omp simd reduction(+ : inner_product)
+      for (uint32_t col_index = 0; col_index < columns; col_index++) {
+        inner_product += left_row[col_index] * right_output[col_index];
+      }
       _output[row_index] = inner_product;
     }
     return shared_from_this();
@@ -189,6 +354,11 @@ class InnerProduct final : public Vertex,
   std::optional<std::vector<std::vector<float>>> _left_input_jacobian;
 
   uint32_t _output_length;
+  uint32_t _batch_size = 1;
+
+  // Only set when the right input is sparse
+  std::shared_ptr<SparseInputVertex> _sparse_input;
+  std::shared_ptr<ParameterVertex> _weights;
 
   InnerProduct() = default;
   friend class cereal::access;
@@ -197,7 +367,8 @@ class InnerProduct final : public Vertex,
   void serialize(Archive& archive) {
     archive(cereal::base_class<Vertex>(this), _left_input, _right_input,
             _output, _local_left_gradient, _local_right_gradient,
-            _left_input_jacobian, _output_length);
+            _left_input_jacobian, _output_length, _batch_size, _sparse_input,
+            _weights);
   }
 };
 
@@ -6,7 +6,10 @@
 #include <cereal/types/polymorphic.hpp>
 #include <cereal/types/vector.hpp>
 #include <src/comp_graph/vertices/vertex.hpp>
+#include <algorithm>
 #include <memory>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 namespace gladius::comp_graph {
@@ -23,16 +26,14 @@ class InputVertex final : public Vertex,
   InputVertex& operator=(const InputVertex&) = delete;
 
   void forward() override {}
-  void backward(std::optional<std::vector<float>>& upstream_grad) override {
+  void backwardImpl(std::optional<std::vector<float>>& upstream_grad) override {
     (void)upstream_grad;
     // std::cout << "[input-vertex-backward]" << std::endl;
   }
 
   inline std::string getName() final { return "Input"; }
 
-  inline std::vector<std::vector<float>> getOutput() const override {
-    return {*_output};
-  }
+  inline std::vector<float>& getOutput() override { return *_output; }
 
   std::pair<uint32_t, uint32_t> getOutputShape() const final {
     assert(!_output->empty());
@@ -52,6 +53,154 @@ class InputVertex final : public Vertex,
   }
 };
 
+/**
+ * Input vertex holding a sequence of row vectors of the same dimension stored
+ * contiguously, for instance the token embeddings fed to a transformer
+ * encoder. The output has shape (sequence_length, dimension).
+ */
+class SequenceInputVertex final
+    : public Vertex,
+      public std::enable_shared_from_this<SequenceInputVertex> {
+ public:
+  SequenceInputVertex(std::vector<float>& input, uint32_t sequence_length)
+      : _sequence_length(sequence_length) {
+    if (!sequence_length || input.empty() ||
+        input.size() % sequence_length != 0) {
+      throw std::invalid_argument(
+          "The input to a sequence input vertex must consist of " +
+          std::to_string(sequence_length) +
+          " rows of the same dimension. Got a vector of size " +
+          std::to_string(input.size()) + ".");
+    }
+    _output = std::move(input);
+  }
+
+  SequenceInputVertex(const SequenceInputVertex&) = delete;
+  SequenceInputVertex& operator=(const SequenceInputVertex&) = delete;
+
+  void forward() final {}
+  void backwardImpl(std::optional<std::vector<float>>& upstream_grad) final {
+    (void)upstream_grad;
+  }
+
+  inline std::string getName() final { return "SequenceInput"; }
+
+  std::pair<uint32_t, uint32_t> getOutputShape() const final {
+    return std::make_pair(_sequence_length,
+                          _output.size() / _sequence_length);
+  }
+
+ private:
+  std::shared_ptr<Vertex> applyOperation() final { return shared_from_this(); }
+  uint32_t _sequence_length;
+
+  SequenceInputVertex() = default;
+  friend class cereal::access;
+
+  template <class Archive>
+  void serialize(Archive& archive) {
+    archive(cereal::base_class<Vertex>(this), _output, _sequence_length);
+  }
+};
+
+/**
+ * Input vertex holding a batch of sparse row vectors of dimension n in
+ * compressed sparse row (CSR) format: the non-zero entries of row b are
+ *        (indices[k], values[k])  for row_offsets[b] <= k < row_offsets[b + 1]
+ * The output has shape (batch_size, n). Vertices with a sparse path (for
+ * instance, InnerProduct) read the CSR arrays directly. Any other consumer
+ * calling getOutput() gets a dense copy, which is only materialized then.
+ */
+class SparseInputVertex final
+    : public Vertex,
+      public std::enable_shared_from_this<SparseInputVertex> {
+ public:
+  SparseInputVertex(std::vector<uint32_t>& row_offsets,
+                    std::vector<uint32_t>& indices, std::vector<float>& values,
+                    uint32_t dimension)
+      : _row_offsets(std::move(row_offsets)),
+        _indices(std::move(indices)),
+        _values(std::move(values)),
+        _dimension(dimension) {
+    if (_row_offsets.size() < 2 || _row_offsets.front() != 0 ||
+        _row_offsets.back() != _indices.size() ||
+        _indices.size() != _values.size() ||
+        !std::is_sorted(_row_offsets.begin(), _row_offsets.end())) {
+      throw std::invalid_argument(
+          "Invalid CSR input. The row offsets must be non-decreasing, start "
+          "at 0 and end at the number of non-zeros, which must be the same "
+          "for the indices and values.");
+    }
+    for (uint32_t index : _indices) {
+      if (index >= _dimension) {
+        throw std::invalid_argument(
+            "Sparse input index " + std::to_string(index) +
+            " is out of range for dimension " + std::to_string(_dimension) +
+            ".");
+      }
+    }
+  }
+
+  SparseInputVertex(const SparseInputVertex&) = delete;
+  SparseInputVertex& operator=(const SparseInputVertex&) = delete;
+
+  void forward() final {}
+  void backwardImpl(std::optional<std::vector<float>>& upstream_grad) final {
+    (void)upstream_grad;
+  }
+
+  inline std::string getName() final { return "SparseInput"; }
+
+  std::vector<float>& getOutput() final {
+    if (_output.empty()) {
+      _output = std::vector<float>(getBatchSize() * _dimension, 0.F);
+      for (uint32_t row = 0; row < getBatchSize(); row++) {
+        for (uint32_t k = _row_offsets[row]; k < _row_offsets[row + 1]; k++) {
+          _output[row * _dimension + _indices[k]] += _values[k];
+        }
+      }
+    }
+    return _output;
+  }
+
+  std::pair<uint32_t, uint32_t> getOutputShape() const final {
+    return std::make_pair(getBatchSize(), _dimension);
+  }
+
+  inline uint32_t getBatchSize() const { return _row_offsets.size() - 1; }
+  inline const std::vector<uint32_t>& getRowOffsets() const {
+    return _row_offsets;
+  }
+  inline const std::vector<uint32_t>& getIndices() const { return _indices; }
+  inline const std::vector<float>& getValues() const { return _values; }
+
+  VertexMemoryUsage getMemoryUsage() const final {
+    auto usage = Vertex::getMemoryUsage();
+    usage.activations += memory::bytesOf(_row_offsets) +
+                         memory::bytesOf(_indices) + memory::bytesOf(_values);
+    return usage;
+  }
+
+ private:
+  std::shared_ptr<Vertex> applyOperation() final { return shared_from_this(); }
+
+  std::vector<uint32_t> _row_offsets;
+  std::vector<uint32_t> _indices;
+  std::vector<float> _values;
+  uint32_t _dimension;
+
+  SparseInputVertex() = default;
+  friend class cereal::access;
+
+  template <class Archive>
+  void serialize(Archive& archive) {
+    archive(cereal::base_class<Vertex>(this), _row_offsets, _indices, _values,
+            _dimension);
+  }
+};
+
 }  // namespace gladius::comp_graph
 
-CEREAL_REGISTER_TYPE(gladius::comp_graph::InputVertex)
\ No newline at end of file
+CEREAL_REGISTER_TYPE(gladius::comp_graph::InputVertex)
+CEREAL_REGISTER_TYPE(gladius::comp_graph::SequenceInputVertex)
+CEREAL_REGISTER_TYPE(gladius::comp_graph::SparseInputVertex)
\ No newline at end of file
@@ -0,0 +1,248 @@
+#pragma once
+
+#include <cereal/access.hpp>
+#include <cereal/types/base_class.hpp>
+#include <cereal/types/memory.hpp>
+#include <cereal/types/optional.hpp>
+#include <cereal/types/polymorphic.hpp>
+#include <cereal/types/vector.hpp>
+#include <src/comp_graph/vertices/param_vertex.hpp>
+#include <src/comp_graph/vertices/vertex.hpp>
+#include <bit>
+#include <cmath>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace gladius::comp_graph {
+
+using gladius::comp_graph::ParameterVertex;
+using gladius::comp_graph::Vertex;
+using gladius::comp_graph::VertexPointer;
+
+/**
+ * Layer normalization as described in https://arxiv.org/pdf/1607.06450.pdf
+ * For every row x of the (rows, d) input, this vertex computes
+ *        y = \gamma * (x - \mu) / \sqrt{\sigma^2 + \epsilon} + \beta
+ * where \mu and \sigma^2 are the mean and variance of x, and \gamma, \beta
+ * are learned (1, d) gain and bias parameters.
+ *
+ * The statistics, normalization, scale and shift are fused: a row is read
+ * once for its mean, once for the sum of squared deviations from the mean
+ * and once more to write the scaled and shifted output. Unlike
+ * E[x^2] - E[x]^2, the two-pass variance does not cancel catastrophically
+ * when the mean is large compared to the spread of the row. Only the per-row
+ * mean and inverse standard deviation are kept for the backward pass; the
+ * normalized input is recomputed from them instead of being stored.
+ */
+class LayerNorm final : public Vertex,
+                        public std::enable_shared_from_this<LayerNorm> {
+ public:
+  LayerNorm(VertexPointer input, std::shared_ptr<ParameterVertex> gain,
+            std::shared_ptr<ParameterVertex> bias, float epsilon = 1e-5)
+      : _input(std::move(input)),
+        _gain(std::move(gain)),
+        _bias(std::move(bias)),
+        _epsilon(epsilon) {
+    auto [rows, dimension] = _input->getOutputShape();
+    auto expected_shape = std::pair<uint32_t, uint32_t>(1, dimension);
+
+    if (_gain->getOutputShape() != expected_shape ||
+        _bias->getOutputShape() != expected_shape) {
+      throw std::invalid_argument(
+          "The gain and bias parameters of LayerNorm must have shape (1, " +
+          std::to_string(dimension) + ").");
+    }
+    _rows = rows;
+    _dimension = dimension;
+
+    registerInput(*_input);
+    registerInput(*_gain);
+    registerInput(*_bias);
+  }
+
+  LayerNorm(const LayerNorm&) = delete;
+  LayerNorm& operator=(const LayerNorm&) = delete;
+
+  void forward() final { applyOperation(); }
+
+  /**
+   * Let \hat{x} = (x - \mu) r with r = 1 / \sqrt{\sigma^2 + \epsilon} and let
+   * g be the upstream gradient of a row. With \hat{g} = g * \gamma, the
+   * gradient w.r.t the row is
+   *        dx = r (\hat{g} - mean(\hat{g}) - \hat{x} mean(\hat{g} \hat{x}))
+   * while d\gamma and d\beta accumulate g \hat{x} and g over all rows.
+   * Both means are computed in a single pass over the row, and a second pass
+   * writes dx and the parameter gradients.
+   */
+  void backwardImpl(std::optional<std::vector<float>>& upstream_grad) final {
+    profiling::ProfileScope profile_scope(*this, profiling::Pass::Backward);
+    if (!upstream_grad.has_value()) {
+      throw std::runtime_error(
+          "Cannot propagate the gradient backward without "
+          "setting the upstream gradient first.");
+    }
+    assert(!_output.empty());
+    assert(upstream_grad.value().size() == _output.size());
+
+    if (!accumulateUpstreamGradient(upstream_grad.value())) {
+      return;
+    }
+    auto& input = _input->getOutput();
+    const float* gain = _gain->getParameter()->getValue().at(0).data();
+
+    resetGradient(_local_gradient, _rows * _dimension);
+    resetGradient(_gain_gradient, _dimension);
+    resetGradient(_bias_gradient, _dimension);
+
+    for (uint32_t row = 0; row < _rows; row++) {
+      const float* input_row = input.data() + row * _dimension;
+      const float* grad_row = _upstream_gradient.data() + row * _dimension;
+      float* input_gradient = _local_gradient->data() + row * _dimension;
+      float mean = _means[row];
+      float inverse_std = _inverse_stds[row];
+
+      float sum_scaled_grad = 0.F;
+      float sum_scaled_grad_normalized = 0.F;
+#pragma omp simd reduction(+ : sum_scaled_grad, sum_scaled_grad_normalized)
+      for (uint32_t col = 0; col < _dimension; col++) {
+        float normalized = (input_row[col] - mean) * inverse_std;
+        float scaled_grad = grad_row[col] * gain[col];
+        sum_scaled_grad += scaled_grad;
+        sum_scaled_grad_normalized += scaled_grad * normalized;
+      }
+      float mean_scaled_grad = sum_scaled_grad / _dimension;
+      float mean_scaled_grad_normalized =
+          sum_scaled_grad_normalized / _dimension;
+
+#pragma omp simd
+      for (uint32_t col = 0; col < _dimension; col++) {
+        float normalized = (input_row[col] - mean) * inverse_std;
+        float scaled_grad = grad_row[col] * gain[col];
+        input_gradient[col] =
+            inverse_std * (scaled_grad - mean_scaled_grad -
+                           normalized * mean_scaled_grad_normalized);
+        (*_gain_gradient)[col] += grad_row[col] * normalized;
+        (*_bias_gradient)[col] += grad_row[col];
+      }
+    }
+    _gain->backward(/* upstream_grad = */ _gain_gradient);
+    _bias->backward(/* upstream_grad = */ _bias_gradient);
+    _input->backward(/* upstream_grad = */ _local_gradient);
+  }
+
+  inline std::string getName() final { return "LayerNorm"; }
+
+  std::vector<VertexPointer> getInputs() const final {
+    return {_input, _gain, _bias};
+  }
+
+  void replaceInput(const Vertex& input,
+                    const VertexPointer& replacement) final {
+    replaceInputMember(_input, input, replacement);
+    replaceInputMember(_gain, input, replacement);
+    replaceInputMember(_bias, input, replacement);
+  }
+
+  std::optional<uint64_t> getAttributes() const final {
+    return std::bit_cast<uint32_t>(_epsilon);
+  }
+
+  uint64_t estimateFlops() const final {
+    // Mean, variance, normalization, gain and bias
+    return 8ULL * _rows * _dimension;
+  }
+
+  std::pair<uint32_t, uint32_t> getOutputShape() const final {
+    return std::make_pair(_rows, _dimension);
+  }
+
+  inline const VertexPointer& getInput() const { return _input; }
+  inline const std::shared_ptr<ParameterVertex>& getGain() const {
+    return _gain;
+  }
+  inline const std::shared_ptr<ParameterVertex>& getBias() const {
+    return _bias;
+  }
+  inline float getEpsilon() const { return _epsilon; }
+
+  VertexMemoryUsage getMemoryUsage() const final {
+    auto usage = Vertex::getMemoryUsage();
+    usage.activations +=
+        memory::bytesOf(_means) + memory::bytesOf(_inverse_stds);
+    usage.gradients +=
+        memory::bytesOf(_gain_gradient) + memory::bytesOf(_bias_gradient);
+    return usage;
+  }
+
+ private:
+  std::shared_ptr<Vertex> applyOperation() final {
+    auto& input = _input->getOutput();
+    const float* gain = _gain->getParameter()->getValue().at(0).data();
+    const float* bias = _bias->getParameter()->getValue().at(0).data();
+
+    // Every entry is overwritten below, so the buffers are only allocated
+    // by the first pass
+    _output.resize(_rows * _dimension);
+    _means.resize(_rows);
+    _inverse_stds.resize(_rows);
+
+    for (uint32_t row = 0; row < _rows; row++) {
+      const float* input_row = input.data() + row * _dimension;
+      float* output_row = _output.data() + row * _dimension;
+
+      float sum = 0.F;
+#pragma omp simd reduction(+ : sum)
+      for (uint32_t col = 0; col < _dimension; col++) {
+        sum += input_row[col];
+      }
+      float mean = sum / _dimension;
+
+      float sum_squares = 0.F;
+#pragma omp simd reduction(+ : sum_squares)
+      for (uint32_t col = 0; col < _dimension; col++) {
+        float deviation = input_row[col] - mean;
+        sum_squares += deviation * deviation;
+      }
+      float inverse_std = 1.F / std::sqrt(sum_squares / _dimension + _epsilon);
+
+#pragma omp simd
+      for (uint32_t col = 0; col < _dimension; col++) {
+        output_row[col] =
+            gain[col] * (input_row[col] - mean) * inverse_std + bias[col];
+      }
+      _means[row] = mean;
+      _inverse_stds[row] = inverse_std;
+    }
+    return shared_from_this();
+  }
+
+  VertexPointer _input;
+  std::shared_ptr<ParameterVertex> _gain;
+  std::shared_ptr<ParameterVertex> _bias;
+  float _epsilon;
+
+  std::vector<float> _means;
+  std::vector<float> _inverse_stds;
+  std::optional<std::vector<float>> _gain_gradient;
+  std::optional<std::vector<float>> _bias_gradient;
+
+  uint32_t _rows;
+  uint32_t _dimension;
+
+  LayerNorm() = default;
+  friend class cereal::access;
+
+  template <typename Archive>
+  void serialize(Archive& archive) {
+    archive(cereal::base_class<Vertex>(this), _input, _gain, _bias, _epsilon,
+            _output, _means, _inverse_stds, _rows, _dimension);
+  }
+};
+
+}  // namespace gladius::comp_graph
+
+CEREAL_REGISTER_TYPE(gladius::comp_graph::LayerNorm)
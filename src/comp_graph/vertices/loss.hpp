@@ -6,12 +6,14 @@
 #include <cereal/types/optional.hpp>
 #include <cereal/types/polymorphic.hpp>
 #include <cereal/types/vector.hpp>
-#include <_types/_uint32_t.h>
 #include <src/comp_graph/vertices/vertex.hpp>
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <stdexcept>
+#include <string>
 #include <vector>
 
 namespace gladius::comp_graph {
@@ -31,13 +33,12 @@ class CrossEntropyLoss final
       public std::enable_shared_from_this<CrossEntropyLoss> {
  public:
   /*
-   * The constructor expects input vertex to have an output with
-   * the same dimension as the label. The output vector computed
-   * by the input vertex consists of logits prior to a softmax
-   * operation.
+   * The constructor expects the input vertex to compute a (1, C) vector of
+   * logits prior to a softmax operation, and the label to be the index of the
+   * true class in [0, C).
    */
-  CrossEntropyLoss(VertexPointer input_vertex, std::vector<uint32_t>& label)
-      : _input(std::move(input_vertex)), _label(std::move(label)) {
+  CrossEntropyLoss(VertexPointer input_vertex, uint32_t label)
+      : _input(std::move(input_vertex)), _label(label) {
     auto logits_shape = _input->getOutputShape();
 
     if (logits_shape.first != 1) {
@@ -49,53 +50,54 @@ class CrossEntropyLoss final
           std::to_string(logits_shape.second) + ").");
     }
 
-    if (logits_shape.second != _label.size()) {
+    if (_label >= logits_shape.second) {
+      throw std::invalid_argument(
+          "The label must be the index of one of the " +
+          std::to_string(logits_shape.second) + " classes. Got instead " +
+          std::to_string(_label) + ".");
+    }
+    _num_classes = logits_shape.second;
+    if (requiresGrad()) {
+      _local_gradient = std::vector<float>(_num_classes, 0.F);
+    }
+  }
+
+  /*
+   * Same as above for a one-hot encoded label vector with the same dimension
+   * as the logits. Only the index of the positive entry is kept.
+   */
+  CrossEntropyLoss(VertexPointer input_vertex,
+                   const std::vector<uint32_t>& label)
+      : CrossEntropyLoss(std::move(input_vertex),
+                         findIndexWithPositiveLabel(label)) {
+    if (_num_classes != label.size()) {
       throw std::invalid_argument(
           "The size of the probability vector must be equal to the size of the "
           "label vector. The Probabilities vector has size " +
-          std::to_string(logits_shape.second) +
-          " while the label vector has size " + std::to_string(_label.size()));
+          std::to_string(_num_classes) +
+          " while the label vector has size " + std::to_string(label.size()));
     }
-
-    _local_gradient =
-        std::vector<float>(logits_shape.second, 0.F);
-    _softmax = std::vector<float>(logits_shape.second, 0.F);
   }
 
   void forward() final {
-    assert(!_label.empty());
     assert(!_loss.has_value());
 
     applyOperation();
   }
 
   /**
-   * Suppose P \in \mathbb{R}^k is the output probability vector computed
-   * by the softmax function, and let CE(Y, P) be the cross entropy loss
-   * computed by this vertex. Treating CE as a function of P (with Y constant),
-   * i.e., CE(Y, P) = CE(P) = -log(P_j) where Y_j = 1.0,
-   * we observe that the gradient is a 1 x n matrix given by
-   * DCE = [0, 0, ..., (-1/P_j), ..., 0]
-   *
+   * Let P be the softmax of the logits z and let j be the index of the true
+   * class. The gradient of CE = -log(P_j) w.r.t the logits is
+   *        DCE = P - e_j
+   * where e_j is the one-hot vector of the label. This gradient is written
+   * during the forward pass, so all that is left here is to propagate it.
    */
-  void backward(std::optional<std::vector<float>>& upstream_grad) final {
+  void backwardImpl(std::optional<std::vector<float>>& upstream_grad) final {
+    profiling::ProfileScope profile_scope(*this, profiling::Pass::Backward);
+    checkRequiresGrad();
     assert(!upstream_grad.has_value());
     assert(_local_gradient.has_value());
-
-    // auto probabilities = _input->getOutput().at(0);
-
-    for (uint32_t i = 0; i < _softmax.size(); i++) {
-      (*_local_gradient)[i] = _softmax[i] - _label[i];
-    }
-
-    // uint32_t index_with_positive_label = findIndexWithPositiveLabel(_label);
-
-    // // derivative of -log(P_j) where j is the index
-
-    // auto derivative_at_index =
-    //     -(1.F / (probabilities.at(index_with_positive_label)));
-
-    // (*_local_gradient)[index_with_positive_label] = derivative_at_index;
+    assert(_loss.has_value());
 
     // std::cout << "[loss-backward]" << std::endl;
     _input->backward(/* upstream_grad = */ _local_gradient);
@@ -103,13 +105,30 @@ class CrossEntropyLoss final
 
   inline std::string getName() final { return "CrossEntropyLoss"; }
 
-  inline std::vector<std::vector<float>> getOutput() const override {
-    assert(_loss.has_value());
-    return {{_loss.value()}};
+  std::vector<VertexPointer> getInputs() const final {
+    return {_input};
+  }
+
+  void replaceInput(const Vertex& input,
+                    const VertexPointer& replacement) final {
+    replaceInputMember(_input, input, replacement);
+  }
+
+  uint64_t estimateFlops() const final {
+    return 4ULL * _num_classes;
   }
 
   std::pair<uint32_t, uint32_t> getOutputShape() const final { return {1, 1}; }
 
+  /**
+   * Returns the index of the largest logit, which is also the class with the
+   * largest softmax probability. It is found while computing the loss.
+   */
+  uint32_t getPredictedLabel() const {
+    assert(_loss.has_value());
+    return _predicted_label;
+  }
+
  private:
   /**
    * Assuming a one-hot encoded vector as an input, this function returns
@@ -128,52 +147,80 @@ class CrossEntropyLoss final
    * probabilities by the neural network respectively. Assuming that they
    * are supported on a space of n possible values, the cross entropy is
    * given by
-   *        CE(Y, P) = \sum_{k=1}^{n}y_k \log(p_k)
-   * The function below computes exactly the expression above.
+   *        CE(Y, P) = -\sum_{k=1}^{n}y_k \log(p_k)
+   * For a one-hot Y with y_j = 1, this is the log-sum-exp of the logits
+   * minus the logit of the true class
+   *        CE = \log(\sum_k \exp(z_k - m)) - (z_j - m),   m = \max_k z_k
+   * which we compute without ever forming log(softmax). The logits are read
+   * once to find m (and the predicted label), and once to compute each
+   * exponential exactly once, storing it in the gradient buffer. Scaling that
+   * buffer by the normalizer and subtracting one at the label turns it into
+   * the gradient P - e_j in place, so no separate softmax copy is kept.
+   * Without gradient bookkeeping only the normalizer is computed.
    * For more on cross-entropy, check out
    * https://eli.thegreenplace.net/2016/the-softmax-function-and-its-derivative/
    */
   std::shared_ptr<Vertex> applyOperation() final {
-    _loss = 0.F;
-    auto output_size = _label.size();
-    auto logits = _input->getOutput().at(0);
+    auto& logits = _input->getOutput();
+    uint64_t size = _num_classes;
+    assert(logits.size() == size);
+
+    const float* logit_values = logits.data();
+
+    float max_logit = logit_values[0];
+    uint32_t max_index = 0;
+    for (uint64_t i = 1; i < size; i++) {
+      if (logit_values[i] > max_logit) {
+        max_logit = logit_values[i];
+        max_index = i;
+      }
+    }
 
     float sum_exps = 0.F;
-    auto max_element = std::max_element(logits.begin(), logits.end());
-    std::for_each(logits.begin(), logits.end(),
-                  [&sum_exps, &max_element](float logit) {
-                    sum_exps += exp(logit - *max_element);
-                  });
-    assert(logits.size() == _label.size());
-
-    for (uint32_t i = 0; i < logits.size(); i++) {
-      float softmax = exp(logits[i] - *max_element) / sum_exps;
-      _softmax[i] = softmax;
-
-      if (_label[i]) {
-        (*_loss) -= log(softmax);
-        // This is when we use log-softmax as opposed to softmax
-        // *_loss -= probabilities[prob_index];
+    if (requiresGrad()) {
+      float* gradient_values = _local_gradient->data();
+#pragma omp simd reduction(+ : sum_exps)
+      for (uint64_t i = 0; i < size; i++) {
+        gradient_values[i] = std::exp(logit_values[i] - max_logit);
+        sum_exps += gradient_values[i];
+      }
 
+      float inverse_sum_exps = 1.F / sum_exps;
+#pragma omp simd
+      for (uint64_t i = 0; i < size; i++) {
+        gradient_values[i] *= inverse_sum_exps;
+      }
+      gradient_values[_label] -= 1.F;
+    } else {
+#pragma omp simd reduction(+ : sum_exps)
+      for (uint64_t i = 0; i < size; i++) {
+        sum_exps += std::exp(logit_values[i] - max_logit);
       }
     }
+
+    _loss = std::log(sum_exps) - (logit_values[_label] - max_logit);
+    _predicted_label = max_index;
+    _output = {_loss.value()};
+
     // std::cout << "[computed loss]: " << _loss.value() << std::endl;
     return shared_from_this();
   }
 
   VertexPointer _input;
 
-  // One-hot encoded vector representing the label
-  std::vector<uint32_t> _label;
+  // Index of the true class
+  uint32_t _label;
+  uint32_t _num_classes;
   std::optional<float> _loss;
-  std::vector<float> _softmax;
+  uint32_t _predicted_label;
 
   CrossEntropyLoss() = default;
 
+  friend class cereal::access;
   template <typename Archive>
   void serialize(Archive& archive) {
-    archive(cereal::base_class<Vertex>(this), _input, _label, _loss,
-            _local_gradient, _softmax);
+    archive(cereal::base_class<Vertex>(this), _input, _label, _num_classes,
+            _loss, _local_gradient);
   }
 };
 
@@ -0,0 +1,270 @@
+#pragma once
+
+#include <cereal/access.hpp>
+#include <cereal/types/base_class.hpp>
+#include <cereal/types/memory.hpp>
+#include <cereal/types/optional.hpp>
+#include <cereal/types/polymorphic.hpp>
+#include <cereal/types/vector.hpp>
+#include <src/comp_graph/vertices/param_vertex.hpp>
+#include <src/comp_graph/vertices/vertex.hpp>
+#include <src/parallel/parallel_for.hpp>
+#include <src/sampling/lsh_tables.hpp>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace gladius::comp_graph {
+
+using gladius::comp_graph::ParameterVertex;
+using gladius::comp_graph::Vertex;
+using gladius::comp_graph::VertexPointer;
+using gladius::sampling::LSHTables;
+
+/**
+ * Adaptive sparse fully connected layer as in SLIDE
+ * (https://arxiv.org/pdf/1903.03129.pdf). For a (1, n) input x, a (m, n)
+ * weight parameter W and an optional (1, m) bias b, only the neurons
+ * retrieved by querying the hash tables with x (plus a set of always active
+ * neurons, typically the labels of the sample in an output layer) are
+ * computed:
+ *        y_a = <W_a, x> + b_a    for every active neuron a,
+ * and every other entry of the (1, m) output is zero. The gradient only
+ * flows through the active neurons, so both passes cost O(|active| n)
+ * instead of O(m n), and only the active rows of W and entries of b are
+ * written. The (1, m) output is reused across forward passes, which only
+ * reset the entries of the previously active neurons.
+ *
+ * The hash tables are shared by every graph that uses the same weights.
+ * Rows that receive a gradient are re-hashed according to the rebuild
+ * schedule of the tables, which is advanced by every forward pass.
+ */
+class LSHSparseDense final
+    : public Vertex,
+      public std::enable_shared_from_this<LSHSparseDense> {
+ public:
+  LSHSparseDense(VertexPointer input, std::shared_ptr<ParameterVertex> weights,
+                 std::shared_ptr<ParameterVertex> bias,
+                 std::shared_ptr<LSHTables> hash_tables,
+                 std::vector<uint32_t> always_active = {})
+      : _input(std::move(input)),
+        _weights(std::move(weights)),
+        _bias(std::move(bias)),
+        _hash_tables(std::move(hash_tables)),
+        _always_active(std::move(always_active)) {
+    auto [rows, input_dimension] = _input->getOutputShape();
+    auto [output_dimension, weight_columns] = _weights->getOutputShape();
+
+    if (rows != 1 || weight_columns != input_dimension) {
+      throw std::invalid_argument(
+          "LSHSparseDense expects a (1, n) input and a (m, n) weight "
+          "parameter. Got an input of shape (" +
+          std::to_string(rows) + ", " + std::to_string(input_dimension) +
+          ") and weights with " + std::to_string(weight_columns) +
+          " columns.");
+    }
+    if (_bias && _bias->getOutputShape() !=
+                     std::pair<uint32_t, uint32_t>(1, output_dimension)) {
+      throw std::invalid_argument(
+          "The bias of a LSHSparseDense vertex must have shape (1, " +
+          std::to_string(output_dimension) + ").");
+    }
+    if (!_hash_tables || _hash_tables->getDimension() != input_dimension ||
+        _hash_tables->getNumRows() != output_dimension) {
+      throw std::invalid_argument(
+          "The hash tables of a LSHSparseDense vertex must be built over "
+          "the " +
+          std::to_string(output_dimension) + " rows of its weights.");
+    }
+    for (uint32_t neuron : _always_active) {
+      if (neuron >= output_dimension) {
+        throw std::invalid_argument("Invalid active neuron " +
+                                    std::to_string(neuron) + ".");
+      }
+    }
+    _input_dimension = input_dimension;
+    _output_dimension = output_dimension;
+
+    // Like the weights, the bias receives its gradient directly from this
+    // vertex, so that it stays sparse
+    registerInput(*_input);
+  }
+
+  LSHSparseDense(const LSHSparseDense&) = delete;
+  LSHSparseDense& operator=(const LSHSparseDense&) = delete;
+
+  void forward() final { applyOperation(); }
+
+  void backwardImpl(std::optional<std::vector<float>>& upstream_grad) final {
+    profiling::ProfileScope profile_scope(*this, profiling::Pass::Backward);
+    if (!upstream_grad.has_value()) {
+      throw std::runtime_error(
+          "Cannot propagate the gradient backward without "
+          "setting the upstream gradient first.");
+    }
+    assert(!_output.empty());
+    assert(upstream_grad.value().size() == _output.size());
+
+    if (!accumulateUpstreamGradient(upstream_grad.value())) {
+      return;
+    }
+    auto parameter = _weights->getParameter();
+    auto& weights = parameter->getValue();
+    auto& input = _input->getOutput();
+
+    _local_gradient = std::vector<float>(_input_dimension, 0.F);
+    std::vector<float> row_gradient(_input_dimension);
+    float* input_gradient = _local_gradient->data();
+
+    for (uint32_t neuron : _active_neurons) {
+      float grad = _upstream_gradient[neuron];
+      if (grad == 0.F) {
+        continue;
+      }
+      const float* weight_row = weights[neuron].data();
+#pragma omp simd
+      for (uint32_t col = 0; col < _input_dimension; col++) {
+        input_gradient[col] += grad * weight_row[col];
+        row_gradient[col] = grad * input[col];
+      }
+      parameter->accumulateRowGradient(neuron, row_gradient.data());
+      _hash_tables->markForRehash(neuron);
+    }
+
+    if (_bias) {
+      _bias_gradient.resize(_active_neurons.size());
+      for (uint32_t index = 0; index < _active_neurons.size(); index++) {
+        _bias_gradient[index] = _upstream_gradient[_active_neurons[index]];
+      }
+      _bias->getParameter()->accumulateColumnGradient(_active_neurons,
+                                                      _bias_gradient);
+    }
+    _input->backward(/* upstream_grad = */ _local_gradient);
+  }
+
+  inline std::string getName() final { return "LSHSparseDense"; }
+
+  std::vector<VertexPointer> getInputs() const final {
+    if (_bias) {
+      return {_input, _weights, _bias};
+    }
+    return {_input, _weights};
+  }
+
+  void replaceInput(const Vertex& input,
+                    const VertexPointer& replacement) final {
+    replaceInputMember(_input, input, replacement);
+    replaceInputMember(_weights, input, replacement);
+    replaceInputMember(_bias, input, replacement);
+  }
+
+  uint64_t estimateFlops() const final {
+    return 2ULL * _active_neurons.size() * _input_dimension;
+  }
+
+  std::pair<uint32_t, uint32_t> getOutputShape() const final {
+    return std::make_pair(1, _output_dimension);
+  }
+
+  /**
+   * Neurons computed in the last forward pass
+   */
+  const std::vector<uint32_t>& getActiveNeurons() const {
+    return _active_neurons;
+  }
+
+  VertexMemoryUsage getMemoryUsage() const final {
+    auto usage = Vertex::getMemoryUsage();
+    usage.gradients += memory::bytesOf(_bias_gradient);
+    usage.workspace +=
+        memory::bytesOf(_active_neurons) + memory::bytesOf(_candidates);
+    return usage;
+  }
+
+ private:
+  std::shared_ptr<Vertex> applyOperation() final {
+    auto& weights = _weights->getParameter()->getValue();
+    auto& input = _input->getOutput();
+    const float* bias =
+        _bias ? _bias->getParameter()->getValue().at(0).data() : nullptr;
+
+    _hash_tables->step(weights);
+
+    _candidates = _always_active;
+    _hash_tables->query(input.data(), _candidates);
+
+    // Only the previously active neurons can have a non-zero output
+    if (_output.size() == _output_dimension) {
+      for (uint32_t neuron : _active_neurons) {
+        _output[neuron] = 0.F;
+      }
+    } else {
+      _output.assign(_output_dimension, 0.F);
+    }
+
+    // The same neuron is usually retrieved from several tables. The flags
+    // are all false between forward passes.
+    _is_active.resize(_output_dimension, false);
+    _active_neurons.clear();
+    for (uint32_t neuron : _candidates) {
+      if (!_is_active[neuron]) {
+        _is_active[neuron] = true;
+        _active_neurons.push_back(neuron);
+      }
+    }
+    for (uint32_t neuron : _active_neurons) {
+      _is_active[neuron] = false;
+    }
+
+    parallel::parallelFor(
+        0, _active_neurons.size(),
+        [&](uint64_t begin, uint64_t end) {
+          for (uint64_t index = begin; index < end; index++) {
+            uint32_t neuron = _active_neurons[index];
+            const float* weight_row = weights[neuron].data();
+            float activation = bias ? bias[neuron] : 0.F;
+#pragma omp simd reduction(+ : activation)
+            for (uint32_t col = 0; col < _input_dimension; col++) {
+              activation += weight_row[col] * input[col];
+            }
+            _output[neuron] = activation;
+          }
+        },
+        parallel::grainSize(/* work_per_iteration = */ _input_dimension));
+    return shared_from_this();
+  }
+
+  VertexPointer _input;
+  std::shared_ptr<ParameterVertex> _weights;
+  std::shared_ptr<ParameterVertex> _bias;
+  std::shared_ptr<LSHTables> _hash_tables;
+  std::vector<uint32_t> _always_active;
+
+  std::vector<uint32_t> _active_neurons;
+  std::vector<float> _bias_gradient;
+
+  // Buffers reused across passes
+  std::vector<uint32_t> _candidates;
+  std::vector<bool> _is_active;
+
+  uint32_t _input_dimension;
+  uint32_t _output_dimension;
+
+  LSHSparseDense() = default;
+
+  // The hash tables are not serialized. They can be rebuilt from the weights.
+  friend class cereal::access;
+  template <typename Archive>
+  void serialize(Archive& archive) {
+    archive(cereal::base_class<Vertex>(this), _input, _weights, _bias,
+            _always_active, _active_neurons, _output, _input_dimension,
+            _output_dimension);
+  }
+};
+
+}  // namespace gladius::comp_graph
+
+CEREAL_REGISTER_TYPE(gladius::comp_graph::LSHSparseDense)
@@ -22,7 +22,8 @@ class ParameterVertex final
       : _parameter(std::move(parameter)) {}
 
   void forward() final {}
-  void backward(std::optional<std::vector<float>>& upstream_grad) final {
+  void backwardImpl(std::optional<std::vector<float>>& upstream_grad) final {
+    profiling::ProfileScope profile_scope(*this, profiling::Pass::Backward);
     /**
      * At the time the gradient reaches this parameter, there is no further
      * backpropagation needed. This is the actual gradient update for the
@@ -48,10 +49,25 @@ class ParameterVertex final
 
     // std::cout << "[param-vertex-backward]" << std::endl;
 
-    _parameter->updateGradient(upstream_grad.value());
+    // A parameter shared by several consumers (for instance, a recurrent
+    // weight matrix used at every timestep) receives the sum of their
+    // gradients.
+    if (!accumulateUpstreamGradient(upstream_grad.value())) {
+      return;
+    }
+    _parameter->updateGradient(_upstream_gradient);
   }
-  inline std::vector<float> getOutput() const final {
-    return _parameter->getValue();
+  /**
+   * Returns the value of the parameter flattened row by row. The copy is
+   * refreshed on every call since optimizers update the value in place.
+   */
+  std::vector<float>& getOutput() final {
+    _output.clear();
+    _output.reserve(_parameter->getParameterCount());
+    for (const auto& row : _parameter->getValue()) {
+      _output.insert(_output.end(), row.begin(), row.end());
+    }
+    return _output;
   }
 
   std::pair<uint32_t, uint32_t> getOutputShape() const final {
@@ -59,6 +75,15 @@ class ParameterVertex final
   }
   inline std::string getName() final { return "Parameter"; }
 
+  std::shared_ptr<Parameter> getParameter() const { return _parameter; }
+
+  /**
+   * Vertices that wrap the same parameter are interchangeable
+   */
+  std::optional<uint64_t> getAttributes() const final {
+    return reinterpret_cast<uintptr_t>(_parameter.get());
+  }
+
  private:
   std::shared_ptr<Vertex> applyOperation() final { return shared_from_this(); }
   std::shared_ptr<Parameter> _parameter;
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <src/comp_graph/vertices/param_vertex.hpp>
+#include <src/comp_graph/vertices/vertex.hpp>
+#include <src/parallel/parallel_for.hpp>
+#include <src/quantization/int8_kernels.hpp>
+#include <src/quantization/quantizer.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace gladius::comp_graph {
+
+using gladius::comp_graph::ParameterVertex;
+using gladius::comp_graph::Vertex;
+using gladius::comp_graph::VertexPointer;
+using gladius::quantization::QuantizedLinear;
+
+/**
+ * Int8 counterpart of FullyConnected for inference. Every input row x is
+ * quantized once with the calibrated activation parameters (s_x, z_x) into
+ * q_x, and each output is computed from an integer dot product with the
+ * quantized weight row q_r of scale s_r:
+ *        y_r = s_x s_r (<q_x, q_r> - z_x \sum_i q_{r,i}) + b_r
+ * The zero point correction, rescaling and bias are fused in the epilogue,
+ * so the output is written once in fp32 and can feed any fp32 vertex.
+ *
+ * This vertex has no backward pass.
+ */
+class QuantizedFullyConnected final
+    : public Vertex,
+      public std::enable_shared_from_this<QuantizedFullyConnected> {
+ public:
+  QuantizedFullyConnected(VertexPointer input,
+                          std::shared_ptr<const QuantizedLinear> weights,
+                          std::shared_ptr<ParameterVertex> bias = nullptr)
+      : _input(std::move(input)),
+        _weights(std::move(weights)),
+        _bias(std::move(bias)) {
+    auto [rows, input_dimension] = _input->getOutputShape();
+    if (input_dimension != _weights->columns) {
+      throw std::invalid_argument(
+          "Dimension mismatch for the inputs to QuantizedFullyConnected "
+          "vertex. The weight matrix has " +
+          std::to_string(_weights->columns) +
+          " columns while the input rows have dimension " +
+          std::to_string(input_dimension) + ".");
+    }
+    if (_bias && _bias->getOutputShape() !=
+                     std::pair<uint32_t, uint32_t>(1, _weights->rows)) {
+      throw std::invalid_argument(
+          "The bias of a QuantizedFullyConnected vertex must have shape (1, " +
+          std::to_string(_weights->rows) + ").");
+    }
+    _rows = rows;
+  }
+
+  QuantizedFullyConnected(const QuantizedFullyConnected&) = delete;
+  QuantizedFullyConnected& operator=(const QuantizedFullyConnected&) = delete;
+
+  void forward() final { applyOperation(); }
+
+  void backwardImpl(std::optional<std::vector<float>>& upstream_grad) final {
+    (void)upstream_grad;
+    throw std::runtime_error(
+        "QuantizedFullyConnected only supports inference. Train the fp32 "
+        "model and quantize it afterwards.");
+  }
+
+  inline std::string getName() final { return "QuantizedFullyConnected"; }
+
+  std::vector<VertexPointer> getInputs() const final {
+    if (_bias) {
+      return {_input, _bias};
+    }
+    return {_input};
+  }
+
+  void replaceInput(const Vertex& input,
+                    const VertexPointer& replacement) final {
+    replaceInputMember(_input, input, replacement);
+    replaceInputMember(_bias, input, replacement);
+  }
+
+  std::optional<uint64_t> getAttributes() const final {
+    return reinterpret_cast<uintptr_t>(_weights.get());
+  }
+
+  uint64_t estimateFlops() const final {
+    // Integer multiply-adds
+    return 2ULL * _rows * _weights->rows * _weights->columns;
+  }
+
+  std::pair<uint32_t, uint32_t> getOutputShape() const final {
+    return std::make_pair(_rows, _weights->rows);
+  }
+
+  VertexMemoryUsage getMemoryUsage() const final {
+    auto usage = Vertex::getMemoryUsage();
+    usage.workspace += memory::bytesOf(_quantized_input);
+    return usage;
+  }
+
+ private:
+  std::shared_ptr<Vertex> applyOperation() final {
+    auto& input = _input->getOutput();
+    const float* bias =
+        _bias ? _bias->getParameter()->getValue().at(0).data() : nullptr;
+    uint32_t columns = _weights->columns;
+    uint32_t output_dimension = _weights->rows;
+    float inverse_input_scale = 1.F / _weights->input.scale;
+    int32_t input_zero_point = _weights->input.zero_point;
+
+    _quantized_input.resize(static_cast<uint64_t>(_rows) * columns);
+    for (uint64_t index = 0; index < _quantized_input.size(); index++) {
+      auto value = static_cast<int32_t>(
+          std::lround(input[index] * inverse_input_scale)) +
+          input_zero_point;
+      _quantized_input[index] = static_cast<uint8_t>(std::clamp<int32_t>(
+          value, 0, quantization::MAX_QUANTIZED_ACTIVATION));
+    }
+
+    _output = std::vector<float>(_rows * output_dimension, 0.F);
+
+    parallel::parallelFor(
+        0, output_dimension,
+        [&](uint64_t begin, uint64_t end) {
+          for (uint64_t neuron = begin; neuron < end; neuron++) {
+            const int8_t* weight_row =
+                _weights->weights.data() + neuron * columns;
+            float scale =
+                _weights->input.scale * _weights->weight_scales[neuron];
+            int32_t zero_point_correction =
+                input_zero_point * _weights->weight_row_sums[neuron];
+
+            for (uint32_t row = 0; row < _rows; row++) {
+              int32_t accumulator = quantization::dotProductU8S8(
+                  _quantized_input.data() +
+                      static_cast<uint64_t>(row) * columns,
+                  weight_row, columns);
+              _output[row * output_dimension + neuron] =
+                  scale * static_cast<float>(accumulator -
+                                             zero_point_correction) +
+                  (bias ? bias[neuron] : 0.F);
+            }
+          }
+        },
+        parallel::grainSize(
+            /* work_per_iteration = */ static_cast<uint64_t>(_rows) * columns));
+    return shared_from_this();
+  }
+
+  VertexPointer _input;
+  std::shared_ptr<const QuantizedLinear> _weights;
+  std::shared_ptr<ParameterVertex> _bias;
+  uint32_t _rows;
+
+  std::vector<uint8_t> _quantized_input;
+};
+
+}  // namespace gladius::comp_graph
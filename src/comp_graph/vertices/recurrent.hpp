@@ -0,0 +1,489 @@
+#pragma once
+
+#include <cereal/access.hpp>
+#include <cereal/types/base_class.hpp>
+#include <cereal/types/memory.hpp>
+#include <cereal/types/optional.hpp>
+#include <cereal/types/polymorphic.hpp>
+#include <cereal/types/vector.hpp>
+#include <src/comp_graph/vertices/param_vertex.hpp>
+#include <src/comp_graph/vertices/vertex.hpp>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace gladius::comp_graph {
+
+using gladius::comp_graph::ParameterVertex;
+using gladius::comp_graph::Vertex;
+using gladius::comp_graph::VertexPointer;
+
+inline float sigmoid(float value) { return 1.F / (1.F + std::exp(-value)); }
+
+/**
+ * Computes output += W v for a (m x n) weight matrix W stored as m rows.
+ */
+inline void accumulateMatrixVector(const std::vector<std::vector<float>>& W,
+                                   const float* vector, float* output) {
+  auto rows = W.size();
+  for (uint64_t row = 0; row < rows; row++) {
+    const float* weight_row = W[row].data();
+    auto columns = W[row].size();
+    float sum = 0.F;
+#pragma omp simd reduction(+ : sum)
+    for (uint64_t col = 0; col < columns; col++) {
+      sum += weight_row[col] * vector[col];
+    }
+    output[row] += sum;
+  }
+}
+
+/**
+ * Runs an LSTM over a whole sequence as a single vertex.
+ *
+ * The input is the (T, 4h) matrix of input projections W_x x_t + b for all
+ * timesteps, which is computed ahead of the recurrence by one FullyConnected
+ * vertex, i.e., one large matrix product instead of T small ones. Every
+ * timestep then only multiplies the previous hidden state by the (4h, h)
+ * recurrent weights of all four gates at once and applies a fused
+ * elementwise kernel for the gates
+ *        i = \sigma(a_i),  f = \sigma(a_f),  g = TanH(a_g),  o = \sigma(a_o)
+ *        c_t = f c_{t-1} + i g,   h_t = o TanH(c_t)
+ * The gate pre-activations a are ordered [i | f | g | o]. The output is the
+ * (T, h) sequence of hidden states, and the initial state is zero.
+ */
+class LSTMLayer final : public Vertex,
+                        public std::enable_shared_from_this<LSTMLayer> {
+ public:
+  LSTMLayer(VertexPointer input_projections,
+            std::shared_ptr<ParameterVertex> recurrent_weights)
+      : _input(std::move(input_projections)),
+        _recurrent_weights(std::move(recurrent_weights)) {
+    auto [timesteps, projection_dimension] = _input->getOutputShape();
+    auto [weight_rows, hidden_dimension] =
+        _recurrent_weights->getOutputShape();
+
+    if (weight_rows != 4 * hidden_dimension ||
+        projection_dimension != 4 * hidden_dimension) {
+      throw std::invalid_argument(
+          "LSTMLayer expects recurrent weights of shape (4h, h) and input "
+          "projections of shape (T, 4h). Got recurrent weights of shape (" +
+          std::to_string(weight_rows) + ", " +
+          std::to_string(hidden_dimension) +
+          ") and input projections with " +
+          std::to_string(projection_dimension) + " columns.");
+    }
+    _timesteps = timesteps;
+    _hidden_dimension = hidden_dimension;
+
+    registerInput(*_input);
+    registerInput(*_recurrent_weights);
+  }
+
+  LSTMLayer(const LSTMLayer&) = delete;
+  LSTMLayer& operator=(const LSTMLayer&) = delete;
+
+  void forward() final { applyOperation(); }
+
+  /**
+   * Back-propagation through time. Walking the sequence backwards, the
+   * gradient of the hidden state h_t is the upstream gradient of row t plus
+   * W^T da_{t+1} from the next timestep, and the gradient of the cell state
+   * is carried over through the forget gate.
+   */
+  void backwardImpl(std::optional<std::vector<float>>& upstream_grad) final {
+    profiling::ProfileScope profile_scope(*this, profiling::Pass::Backward);
+    if (!upstream_grad.has_value()) {
+      throw std::runtime_error(
+          "Cannot propagate the gradient backward without "
+          "setting the upstream gradient first.");
+    }
+    assert(!_output.empty());
+    assert(upstream_grad.value().size() == _output.size());
+
+    if (!accumulateUpstreamGradient(upstream_grad.value())) {
+      return;
+    }
+    auto& weights = _recurrent_weights->getParameter()->getValue();
+    uint32_t h = _hidden_dimension;
+
+    _local_gradient = std::vector<float>(_timesteps * 4 * h, 0.F);
+    _recurrent_weights_gradient = std::vector<float>(4 * h * h, 0.F);
+
+    std::vector<float> next_hidden_grad(h, 0.F);
+    std::vector<float> next_cell_grad(h, 0.F);
+
+    for (int64_t t = _timesteps - 1; t >= 0; t--) {
+      const float* gates = _gates.data() + t * 4 * h;
+      const float* cell = _cells.data() + t * h;
+      const float* previous_cell = t > 0 ? cell - h : nullptr;
+      const float* previous_hidden = t > 0 ? _output.data() + (t - 1) * h
+                                           : nullptr;
+      float* gate_grad = _local_gradient->data() + t * 4 * h;
+
+      for (uint32_t unit = 0; unit < h; unit++) {
+        float input_gate = gates[unit];
+        float forget_gate = gates[h + unit];
+        float candidate = gates[2 * h + unit];
+        float output_gate = gates[3 * h + unit];
+        float cell_tanh = std::tanh(cell[unit]);
+        float previous_cell_value = previous_cell ? previous_cell[unit] : 0.F;
+
+        float dh = _upstream_gradient[t * h + unit] + next_hidden_grad[unit];
+        float dc = next_cell_grad[unit] +
+                   dh * output_gate * (1.F - cell_tanh * cell_tanh);
+
+        gate_grad[unit] = dc * candidate * input_gate * (1.F - input_gate);
+        gate_grad[h + unit] =
+            dc * previous_cell_value * forget_gate * (1.F - forget_gate);
+        gate_grad[2 * h + unit] =
+            dc * input_gate * (1.F - candidate * candidate);
+        gate_grad[3 * h + unit] =
+            dh * cell_tanh * output_gate * (1.F - output_gate);
+
+        next_cell_grad[unit] = dc * forget_gate;
+      }
+
+      std::fill(next_hidden_grad.begin(), next_hidden_grad.end(), 0.F);
+      if (previous_hidden) {
+        for (uint32_t row = 0; row < 4 * h; row++) {
+          float grad = gate_grad[row];
+          const float* weight_row = weights[row].data();
+          float* weight_grad = _recurrent_weights_gradient->data() + row * h;
+#pragma omp simd
+          for (uint32_t col = 0; col < h; col++) {
+            next_hidden_grad[col] += grad * weight_row[col];
+            weight_grad[col] += grad * previous_hidden[col];
+          }
+        }
+      }
+    }
+    _recurrent_weights->backward(
+        /* upstream_grad = */ _recurrent_weights_gradient);
+    _input->backward(/* upstream_grad = */ _local_gradient);
+  }
+
+  inline std::string getName() final { return "LSTM"; }
+
+  std::vector<VertexPointer> getInputs() const final {
+    return {_input, _recurrent_weights};
+  }
+
+  void replaceInput(const Vertex& input,
+                    const VertexPointer& replacement) final {
+    replaceInputMember(_input, input, replacement);
+    replaceInputMember(_recurrent_weights, input, replacement);
+  }
+
+  std::optional<uint64_t> getAttributes() const final {
+    return 0;
+  }
+
+  uint64_t estimateFlops() const final {
+    // The recurrent matrix products dominate
+    return 2ULL * _timesteps * 4 * _hidden_dimension * _hidden_dimension;
+  }
+
+  std::pair<uint32_t, uint32_t> getOutputShape() const final {
+    return std::make_pair(_timesteps, _hidden_dimension);
+  }
+
+  VertexMemoryUsage getMemoryUsage() const final {
+    auto usage = Vertex::getMemoryUsage();
+    usage.activations += memory::bytesOf(_gates) + memory::bytesOf(_cells);
+    usage.gradients += memory::bytesOf(_recurrent_weights_gradient);
+    return usage;
+  }
+
+ private:
+  std::shared_ptr<Vertex> applyOperation() final {
+    auto& projections = _input->getOutput();
+    auto& weights = _recurrent_weights->getParameter()->getValue();
+    uint32_t h = _hidden_dimension;
+
+    _output = std::vector<float>(_timesteps * h, 0.F);
+    _cells = std::vector<float>(_timesteps * h, 0.F);
+    _gates = std::vector<float>(_timesteps * 4 * h, 0.F);
+
+    for (uint32_t t = 0; t < _timesteps; t++) {
+      float* gates = _gates.data() + t * 4 * h;
+      std::copy_n(projections.begin() + t * 4 * h, 4 * h, gates);
+      if (t > 0) {
+        accumulateMatrixVector(weights, _output.data() + (t - 1) * h, gates);
+      }
+
+      float* cell = _cells.data() + t * h;
+      float* hidden = _output.data() + t * h;
+      for (uint32_t unit = 0; unit < h; unit++) {
+        float input_gate = sigmoid(gates[unit]);
+        float forget_gate = sigmoid(gates[h + unit]);
+        float candidate = std::tanh(gates[2 * h + unit]);
+        float output_gate = sigmoid(gates[3 * h + unit]);
+        float previous_cell = t > 0 ? (cell - h)[unit] : 0.F;
+
+        cell[unit] = forget_gate * previous_cell + input_gate * candidate;
+        hidden[unit] = output_gate * std::tanh(cell[unit]);
+
+        gates[unit] = input_gate;
+        gates[h + unit] = forget_gate;
+        gates[2 * h + unit] = candidate;
+        gates[3 * h + unit] = output_gate;
+      }
+    }
+    return shared_from_this();
+  }
+
+  VertexPointer _input;
+  std::shared_ptr<ParameterVertex> _recurrent_weights;
+  std::optional<std::vector<float>> _recurrent_weights_gradient;
+
+  // Gate activations and cell states of every timestep, kept for BPTT
+  std::vector<float> _gates;
+  std::vector<float> _cells;
+
+  uint32_t _timesteps;
+  uint32_t _hidden_dimension;
+
+  LSTMLayer() = default;
+  friend class cereal::access;
+
+  template <typename Archive>
+  void serialize(Archive& archive) {
+    archive(cereal::base_class<Vertex>(this), _input, _recurrent_weights,
+            _output, _gates, _cells, _timesteps, _hidden_dimension);
+  }
+};
+
+/**
+ * Runs a GRU over a whole sequence as a single vertex. As for LSTMLayer, the
+ * (T, 3h) input projections W_x x_t + b_x are computed ahead of the
+ * recurrence. Every timestep computes the recurrent projections of all three
+ * gates with one product r = W_h h_{t-1} + b_h and applies the fused kernel
+ *        r = \sigma(x_r + r_r),   z = \sigma(x_z + r_z)
+ *        n = TanH(x_n + r * r_n),  h_t = (1 - z) n + z h_{t-1}
+ * with pre-activations ordered [r | z | n] as in
+ * https://arxiv.org/pdf/1406.1078.pdf
+ */
+class GRULayer final : public Vertex,
+                       public std::enable_shared_from_this<GRULayer> {
+ public:
+  GRULayer(VertexPointer input_projections,
+           std::shared_ptr<ParameterVertex> recurrent_weights,
+           std::shared_ptr<ParameterVertex> recurrent_bias)
+      : _input(std::move(input_projections)),
+        _recurrent_weights(std::move(recurrent_weights)),
+        _recurrent_bias(std::move(recurrent_bias)) {
+    auto [timesteps, projection_dimension] = _input->getOutputShape();
+    auto [weight_rows, hidden_dimension] =
+        _recurrent_weights->getOutputShape();
+
+    if (weight_rows != 3 * hidden_dimension ||
+        projection_dimension != 3 * hidden_dimension ||
+        _recurrent_bias->getOutputShape() !=
+            std::pair<uint32_t, uint32_t>(1, 3 * hidden_dimension)) {
+      throw std::invalid_argument(
+          "GRULayer expects recurrent weights of shape (3h, h), a recurrent "
+          "bias of shape (1, 3h) and input projections of shape (T, 3h). Got "
+          "recurrent weights of shape (" +
+          std::to_string(weight_rows) + ", " +
+          std::to_string(hidden_dimension) +
+          ") and input projections with " +
+          std::to_string(projection_dimension) + " columns.");
+    }
+    _timesteps = timesteps;
+    _hidden_dimension = hidden_dimension;
+
+    registerInput(*_input);
+    registerInput(*_recurrent_weights);
+    registerInput(*_recurrent_bias);
+  }
+
+  GRULayer(const GRULayer&) = delete;
+  GRULayer& operator=(const GRULayer&) = delete;
+
+  void forward() final { applyOperation(); }
+
+  void backwardImpl(std::optional<std::vector<float>>& upstream_grad) final {
+    profiling::ProfileScope profile_scope(*this, profiling::Pass::Backward);
+    if (!upstream_grad.has_value()) {
+      throw std::runtime_error(
+          "Cannot propagate the gradient backward without "
+          "setting the upstream gradient first.");
+    }
+    assert(!_output.empty());
+    assert(upstream_grad.value().size() == _output.size());
+
+    if (!accumulateUpstreamGradient(upstream_grad.value())) {
+      return;
+    }
+    auto& weights = _recurrent_weights->getParameter()->getValue();
+    uint32_t h = _hidden_dimension;
+
+    _local_gradient = std::vector<float>(_timesteps * 3 * h, 0.F);
+    _recurrent_weights_gradient = std::vector<float>(3 * h * h, 0.F);
+    _recurrent_bias_gradient = std::vector<float>(3 * h, 0.F);
+
+    std::vector<float> next_hidden_grad(h, 0.F);
+    std::vector<float> recurrent_grad(3 * h, 0.F);
+
+    for (int64_t t = _timesteps - 1; t >= 0; t--) {
+      const float* gates = _gates.data() + t * 3 * h;
+      const float* recurrent = _recurrent_projections.data() + t * 3 * h;
+      const float* previous_hidden =
+          t > 0 ? _output.data() + (t - 1) * h : nullptr;
+      float* input_grad = _local_gradient->data() + t * 3 * h;
+
+      for (uint32_t unit = 0; unit < h; unit++) {
+        float reset_gate = gates[unit];
+        float update_gate = gates[h + unit];
+        float candidate = gates[2 * h + unit];
+        float previous = previous_hidden ? previous_hidden[unit] : 0.F;
+
+        float dh = _upstream_gradient[t * h + unit] + next_hidden_grad[unit];
+        float dn = dh * (1.F - update_gate) * (1.F - candidate * candidate);
+        float dz = dh * (previous - candidate) * update_gate *
+                   (1.F - update_gate);
+        float dr = dn * recurrent[2 * h + unit] * reset_gate *
+                   (1.F - reset_gate);
+
+        input_grad[unit] = dr;
+        input_grad[h + unit] = dz;
+        input_grad[2 * h + unit] = dn;
+
+        recurrent_grad[unit] = dr;
+        recurrent_grad[h + unit] = dz;
+        recurrent_grad[2 * h + unit] = dn * reset_gate;
+
+        next_hidden_grad[unit] = dh * update_gate;
+      }
+
+      for (uint32_t row = 0; row < 3 * h; row++) {
+        (*_recurrent_bias_gradient)[row] += recurrent_grad[row];
+      }
+      if (previous_hidden) {
+        for (uint32_t row = 0; row < 3 * h; row++) {
+          float grad = recurrent_grad[row];
+          const float* weight_row = weights[row].data();
+          float* weight_grad = _recurrent_weights_gradient->data() + row * h;
+#pragma omp simd
+          for (uint32_t col = 0; col < h; col++) {
+            next_hidden_grad[col] += grad * weight_row[col];
+            weight_grad[col] += grad * previous_hidden[col];
+          }
+        }
+      }
+    }
+    _recurrent_weights->backward(
+        /* upstream_grad = */ _recurrent_weights_gradient);
+    _recurrent_bias->backward(/* upstream_grad = */ _recurrent_bias_gradient);
+    _input->backward(/* upstream_grad = */ _local_gradient);
+  }
+
+  inline std::string getName() final { return "GRU"; }
+
+  std::vector<VertexPointer> getInputs() const final {
+    return {_input, _recurrent_weights, _recurrent_bias};
+  }
+
+  void replaceInput(const Vertex& input,
+                    const VertexPointer& replacement) final {
+    replaceInputMember(_input, input, replacement);
+    replaceInputMember(_recurrent_weights, input, replacement);
+    replaceInputMember(_recurrent_bias, input, replacement);
+  }
+
+  std::optional<uint64_t> getAttributes() const final {
+    return 0;
+  }
+
+  uint64_t estimateFlops() const final {
+    return 2ULL * _timesteps * 3 * _hidden_dimension * _hidden_dimension;
+  }
+
+  std::pair<uint32_t, uint32_t> getOutputShape() const final {
+    return std::make_pair(_timesteps, _hidden_dimension);
+  }
+
+  VertexMemoryUsage getMemoryUsage() const final {
+    auto usage = Vertex::getMemoryUsage();
+    usage.activations +=
+        memory::bytesOf(_gates) + memory::bytesOf(_recurrent_projections);
+    usage.gradients += memory::bytesOf(_recurrent_weights_gradient) +
+                       memory::bytesOf(_recurrent_bias_gradient);
+    return usage;
+  }
+
+ private:
+  std::shared_ptr<Vertex> applyOperation() final {
+    auto& projections = _input->getOutput();
+    auto& weights = _recurrent_weights->getParameter()->getValue();
+    auto& bias = _recurrent_bias->getParameter()->getValue().at(0);
+    uint32_t h = _hidden_dimension;
+
+    _output = std::vector<float>(_timesteps * h, 0.F);
+    _gates = std::vector<float>(_timesteps * 3 * h, 0.F);
+    _recurrent_projections = std::vector<float>(_timesteps * 3 * h, 0.F);
+
+    for (uint32_t t = 0; t < _timesteps; t++) {
+      const float* input_projection = projections.data() + t * 3 * h;
+      float* recurrent = _recurrent_projections.data() + t * 3 * h;
+      float* gates = _gates.data() + t * 3 * h;
+      float* hidden = _output.data() + t * h;
+
+      std::copy(bias.begin(), bias.end(), recurrent);
+      if (t > 0) {
+        accumulateMatrixVector(weights, hidden - h, recurrent);
+      }
+
+      for (uint32_t unit = 0; unit < h; unit++) {
+        float reset_gate = sigmoid(input_projection[unit] + recurrent[unit]);
+        float update_gate =
+            sigmoid(input_projection[h + unit] + recurrent[h + unit]);
+        float candidate = std::tanh(input_projection[2 * h + unit] +
+                                    reset_gate * recurrent[2 * h + unit]);
+        float previous = t > 0 ? (hidden - h)[unit] : 0.F;
+
+        hidden[unit] = (1.F - update_gate) * candidate + update_gate * previous;
+
+        gates[unit] = reset_gate;
+        gates[h + unit] = update_gate;
+        gates[2 * h + unit] = candidate;
+      }
+    }
+    return shared_from_this();
+  }
+
+  VertexPointer _input;
+  std::shared_ptr<ParameterVertex> _recurrent_weights;
+  std::shared_ptr<ParameterVertex> _recurrent_bias;
+  std::optional<std::vector<float>> _recurrent_weights_gradient;
+  std::optional<std::vector<float>> _recurrent_bias_gradient;
+
+  // Gate activations and recurrent projections of every timestep, kept for
+  // BPTT
+  std::vector<float> _gates;
+  std::vector<float> _recurrent_projections;
+
+  uint32_t _timesteps;
+  uint32_t _hidden_dimension;
+
+  GRULayer() = default;
+  friend class cereal::access;
+
+  template <typename Archive>
+  void serialize(Archive& archive) {
+    archive(cereal::base_class<Vertex>(this), _input, _recurrent_weights,
+            _recurrent_bias, _output, _gates, _recurrent_projections,
+            _timesteps, _hidden_dimension);
+  }
+};
+
+}  // namespace gladius::comp_graph
+
+CEREAL_REGISTER_TYPE(gladius::comp_graph::LSTMLayer)
+CEREAL_REGISTER_TYPE(gladius::comp_graph::GRULayer)
@@ -0,0 +1,244 @@
+#pragma once
+
+#include <cereal/access.hpp>
+#include <cereal/types/base_class.hpp>
+#include <cereal/types/memory.hpp>
+#include <cereal/types/optional.hpp>
+#include <cereal/types/polymorphic.hpp>
+#include <cereal/types/vector.hpp>
+#include <src/comp_graph/vertices/param_vertex.hpp>
+#include <src/comp_graph/vertices/vertex.hpp>
+#include <src/sampling/candidate_sampler.hpp>
+#include <cmath>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace gladius::comp_graph {
+
+using gladius::comp_graph::ParameterVertex;
+using gladius::comp_graph::Vertex;
+using gladius::comp_graph::VertexPointer;
+using gladius::sampling::CandidateSampler;
+
+/**
+ * Sampled softmax loss as described in https://arxiv.org/pdf/1412.2007.pdf
+ * This replaces a FullyConnected output layer followed by CrossEntropyLoss
+ * when the number of classes V is too large to compute every logit.
+ *
+ * The input is a (1, d) hidden vector h and the output layer is a (V, d)
+ * weight parameter W. Every forward pass draws K negative classes s_1..s_K
+ * from the proposal distribution Q of the sampler, and computes the logits
+ *        z_j = <W_{c_j}, h> - \log(K Q(c_j))
+ * only for c_0 = label and c_j = s_j. Subtracting log(K Q) is the log-Q
+ * correction, which makes the softmax over the candidates an estimate of the
+ * full softmax. Sampled negatives that coincide with the label are removed.
+ * The loss is the cross-entropy over the K + 1 candidates with target c_0.
+ *
+ * Only the K + 1 sampled rows of W are read, and the backward pass only
+ * writes those rows of its gradient, so the cost of the output layer is
+ * O(K d) instead of O(V d).
+ */
+class SampledSoftmaxLoss final
+    : public Vertex,
+      public std::enable_shared_from_this<SampledSoftmaxLoss> {
+ public:
+  SampledSoftmaxLoss(VertexPointer input,
+                     std::shared_ptr<ParameterVertex> weights, uint32_t label,
+                     std::shared_ptr<CandidateSampler> sampler,
+                     uint32_t num_sampled)
+      : _input(std::move(input)),
+        _weights(std::move(weights)),
+        _label(label),
+        _sampler(std::move(sampler)),
+        _num_sampled(num_sampled) {
+    auto [rows, dimension] = _input->getOutputShape();
+    auto [num_classes, weight_columns] = _weights->getOutputShape();
+
+    if (rows != 1 || weight_columns != dimension) {
+      throw std::invalid_argument(
+          "SampledSoftmaxLoss expects a (1, d) input and a (V, d) weight "
+          "parameter. Got an input of shape (" +
+          std::to_string(rows) + ", " + std::to_string(dimension) +
+          ") and weights with " + std::to_string(weight_columns) +
+          " columns.");
+    }
+    if (_label >= num_classes) {
+      throw std::invalid_argument(
+          "The label must be the index of one of the " +
+          std::to_string(num_classes) + " classes. Got instead " +
+          std::to_string(_label) + ".");
+    }
+    if (!_sampler || _sampler->getNumClasses() != num_classes) {
+      throw std::invalid_argument(
+          "The candidate sampler must draw from the " +
+          std::to_string(num_classes) + " classes of the weight parameter.");
+    }
+    if (!_num_sampled) {
+      throw std::invalid_argument(
+          "SampledSoftmaxLoss requires at least one sampled class.");
+    }
+    _dimension = dimension;
+    _candidates = std::vector<uint32_t>(_num_sampled + 1);
+    _candidate_gradients = std::vector<float>(_num_sampled + 1);
+    _row_gradient = std::vector<float>(_dimension);
+
+    registerInput(*_input);
+  }
+
+  SampledSoftmaxLoss(const SampledSoftmaxLoss&) = delete;
+  SampledSoftmaxLoss& operator=(const SampledSoftmaxLoss&) = delete;
+
+  void forward() final {
+    assert(!_loss.has_value());
+
+    applyOperation();
+  }
+
+  /**
+   * With P the softmax over the candidate logits, the gradient w.r.t z is
+   * g = P - e_0. Hence
+   *        dh = \sum_j g_j W_{c_j},     dW_{c_j} = g_j h
+   * and the weight gradient is accumulated row by row into the parameter,
+   * which only keeps track of (and later updates) the rows written here.
+   */
+  void backwardImpl(std::optional<std::vector<float>>& upstream_grad) final {
+    profiling::ProfileScope profile_scope(*this, profiling::Pass::Backward);
+    assert(!upstream_grad.has_value());
+    assert(_loss.has_value());
+
+    auto& weights = _weights->getParameter()->getValue();
+    auto& hidden = _input->getOutput();
+    auto parameter = _weights->getParameter();
+
+    _local_gradient = std::vector<float>(_dimension, 0.F);
+    float* input_gradient = _local_gradient->data();
+
+    for (uint32_t index = 0; index <= _num_sampled; index++) {
+      float grad = _candidate_gradients[index];
+      if (grad == 0.F) {
+        continue;
+      }
+      const float* weight_row = weights[_candidates[index]].data();
+#pragma omp simd
+      for (uint32_t col = 0; col < _dimension; col++) {
+        input_gradient[col] += grad * weight_row[col];
+        _row_gradient[col] = grad * hidden[col];
+      }
+      parameter->accumulateRowGradient(_candidates[index],
+                                       _row_gradient.data());
+    }
+    _input->backward(/* upstream_grad = */ _local_gradient);
+  }
+
+  inline std::string getName() final { return "SampledSoftmaxLoss"; }
+
+  std::vector<VertexPointer> getInputs() const final {
+    return {_input, _weights};
+  }
+
+  void replaceInput(const Vertex& input,
+                    const VertexPointer& replacement) final {
+    replaceInputMember(_input, input, replacement);
+    replaceInputMember(_weights, input, replacement);
+  }
+
+  uint64_t estimateFlops() const final {
+    return 2ULL * (_num_sampled + 1) * _dimension;
+  }
+
+  std::pair<uint32_t, uint32_t> getOutputShape() const final { return {1, 1}; }
+
+  /**
+   * The true class followed by the classes sampled in the last forward pass
+   */
+  const std::vector<uint32_t>& getCandidates() const { return _candidates; }
+
+  VertexMemoryUsage getMemoryUsage() const final {
+    auto usage = Vertex::getMemoryUsage();
+    usage.gradients += memory::bytesOf(_row_gradient);
+    usage.workspace +=
+        memory::bytesOf(_candidates) + memory::bytesOf(_candidate_gradients);
+    return usage;
+  }
+
+ private:
+  std::shared_ptr<Vertex> applyOperation() final {
+    auto& weights = _weights->getParameter()->getValue();
+    auto& hidden = _input->getOutput();
+    float log_num_sampled = std::log(static_cast<float>(_num_sampled));
+
+    _candidates[0] = _label;
+    for (uint32_t index = 1; index <= _num_sampled; index++) {
+      _candidates[index] = _sampler->sample();
+    }
+
+    float* logits = _candidate_gradients.data();
+    float max_logit = -INFINITY;
+    for (uint32_t index = 0; index <= _num_sampled; index++) {
+      uint32_t candidate = _candidates[index];
+      if (index && candidate == _label) {
+        logits[index] = -INFINITY;
+        continue;
+      }
+      const float* weight_row = weights[candidate].data();
+      float logit = 0.F;
+#pragma omp simd reduction(+ : logit)
+      for (uint32_t col = 0; col < _dimension; col++) {
+        logit += weight_row[col] * hidden[col];
+      }
+      logits[index] = logit - log_num_sampled -
+                      std::log(_sampler->probability(candidate));
+      max_logit = std::max(max_logit, logits[index]);
+    }
+
+    // Same fused log-sum-exp as in CrossEntropyLoss: the exponentials are
+    // written in place and scaled into the gradient P - e_0.
+    float true_logit = logits[0];
+    float sum_exps = 0.F;
+    for (uint32_t index = 0; index <= _num_sampled; index++) {
+      logits[index] = std::exp(logits[index] - max_logit);
+      sum_exps += logits[index];
+    }
+    for (uint32_t index = 0; index <= _num_sampled; index++) {
+      logits[index] /= sum_exps;
+    }
+    logits[0] -= 1.F;
+
+    _loss = std::log(sum_exps) - (true_logit - max_logit);
+    _output = {_loss.value()};
+    return shared_from_this();
+  }
+
+  VertexPointer _input;
+  std::shared_ptr<ParameterVertex> _weights;
+  uint32_t _label;
+  std::shared_ptr<CandidateSampler> _sampler;
+  uint32_t _num_sampled;
+  uint32_t _dimension;
+
+  std::optional<float> _loss;
+  std::vector<uint32_t> _candidates;
+  // Holds the candidate logits during the forward pass, and P - e_0 after it
+  std::vector<float> _candidate_gradients;
+  std::vector<float> _row_gradient;
+
+  SampledSoftmaxLoss() = default;
+
+  // The sampler is not serialized. It holds the state of a random number
+  // generator and must be provided again to train a deserialized graph.
+  friend class cereal::access;
+  template <typename Archive>
+  void serialize(Archive& archive) {
+    archive(cereal::base_class<Vertex>(this), _input, _weights, _label,
+            _num_sampled, _dimension, _loss, _candidates,
+            _candidate_gradients);
+  }
+};
+
+}  // namespace gladius::comp_graph
+
+CEREAL_REGISTER_TYPE(gladius::comp_graph::SampledSoftmaxLoss)
@@ -0,0 +1,288 @@
+#pragma once
+
+#include <cereal/access.hpp>
+#include <cereal/types/base_class.hpp>
+#include <cereal/types/memory.hpp>
+#include <cereal/types/optional.hpp>
+#include <cereal/types/polymorphic.hpp>
+#include <cereal/types/vector.hpp>
+#include <src/comp_graph/vertices/vertex.hpp>
+#include <src/parallel/parallel_for.hpp>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace gladius::comp_graph {
+
+using gladius::comp_graph::Vertex;
+using gladius::comp_graph::VertexPointer;
+
+/**
+ * Multi-head scaled dot-product self-attention over a sequence of length L
+ * as described in https://arxiv.org/pdf/1706.03762.pdf
+ *
+ * The input is the (L, 3d) output of a single fused projection whose rows
+ * are the concatenation [q | k | v] of the query, key and value vectors of a
+ * token. Computing all three projections with one FullyConnected vertex reads
+ * the input sequence once instead of three times. For every head h, which
+ * owns a slice of size d / num_heads of q, k and v, this vertex computes
+ *        O_h = softmax(Q_h K_h^T / \sqrt{d / num_heads}) V_h
+ * and the heads are concatenated into an (L, d) output. With a causal mask,
+ * token i only attends to tokens j <= i.
+ */
+class SelfAttention final : public Vertex,
+                            public std::enable_shared_from_this<SelfAttention> {
+ public:
+  SelfAttention(VertexPointer query_key_value, uint32_t num_heads,
+                bool causal = false)
+      : _input(std::move(query_key_value)),
+        _num_heads(num_heads),
+        _causal(causal) {
+    auto [sequence_length, projection_dimension] = _input->getOutputShape();
+    if (projection_dimension % 3 != 0 || !num_heads ||
+        (projection_dimension / 3) % num_heads != 0) {
+      throw std::invalid_argument(
+          "SelfAttention expects the concatenated query, key and value "
+          "projections of dimension 3d with d divisible by the number of "
+          "heads. Got dimension " +
+          std::to_string(projection_dimension) + " and " +
+          std::to_string(num_heads) + " heads.");
+    }
+    _sequence_length = sequence_length;
+    _model_dimension = projection_dimension / 3;
+    _head_dimension = _model_dimension / num_heads;
+
+    registerInput(*_input);
+  }
+
+  SelfAttention(const SelfAttention&) = delete;
+  SelfAttention& operator=(const SelfAttention&) = delete;
+
+  void forward() final { applyOperation(); }
+
+  /**
+   * Let P be the attention probabilities of a head and dO the upstream
+   * gradient of its output. Then
+   *        dV = P^T dO,  dP = dO V^T,
+   *        dS_ij = P_ij (dP_ij - \sum_k P_ik dP_ik),
+   *        dQ = dS K / \sqrt{d_h},  dK = dS^T Q / \sqrt{d_h}
+   * where S are the scaled scores. Heads write to disjoint slices of the
+   * gradient, so they are processed in parallel.
+   */
+  void backwardImpl(std::optional<std::vector<float>>& upstream_grad) final {
+    profiling::ProfileScope profile_scope(*this, profiling::Pass::Backward);
+    if (!upstream_grad.has_value()) {
+      throw std::runtime_error(
+          "Cannot propagate the gradient backward without "
+          "setting the upstream gradient first.");
+    }
+    assert(!_output.empty());
+    assert(upstream_grad.value().size() == _output.size());
+
+    if (!accumulateUpstreamGradient(upstream_grad.value())) {
+      return;
+    }
+    auto& input = _input->getOutput();
+    uint32_t row_stride = 3 * _model_dimension;
+    float scale = 1.F / std::sqrt(static_cast<float>(_head_dimension));
+
+    _local_gradient =
+        std::vector<float>(_sequence_length * row_stride, 0.F);
+    std::vector<float> probability_gradients(_num_heads * _sequence_length,
+                                             0.F);
+
+    parallel::parallelFor(
+        0, _num_heads,
+        [&](uint64_t begin, uint64_t end) {
+          for (uint64_t head = begin; head < end; head++) {
+            backwardHead(head, input, scale,
+                         probability_gradients.data() +
+                             head * _sequence_length);
+          }
+        },
+        parallel::grainSize(/* work_per_iteration = */ headWork()));
+    _input->backward(/* upstream_grad = */ _local_gradient);
+  }
+
+  inline std::string getName() final { return "SelfAttention"; }
+
+  std::vector<VertexPointer> getInputs() const final {
+    return {_input};
+  }
+
+  void replaceInput(const Vertex& input,
+                    const VertexPointer& replacement) final {
+    replaceInputMember(_input, input, replacement);
+  }
+
+  std::optional<uint64_t> getAttributes() const final {
+    return (static_cast<uint64_t>(_num_heads) << 1) | _causal;
+  }
+
+  uint64_t estimateFlops() const final {
+    // QK^T and the weighted sum of the values over every head
+    return 4ULL * _sequence_length * _sequence_length * _model_dimension;
+  }
+
+  std::pair<uint32_t, uint32_t> getOutputShape() const final {
+    return std::make_pair(_sequence_length, _model_dimension);
+  }
+
+  VertexMemoryUsage getMemoryUsage() const final {
+    auto usage = Vertex::getMemoryUsage();
+    usage.activations += memory::bytesOf(_probabilities);
+    return usage;
+  }
+
+ private:
+  inline float* probabilityRow(uint32_t head, uint32_t query) {
+    return _probabilities.data() +
+           (static_cast<uint64_t>(head) * _sequence_length + query) *
+               _sequence_length;
+  }
+
+  // Scalar operations per head of a pass, which is the grain of its loop
+  inline uint64_t headWork() const {
+    return 4ULL * _sequence_length * _sequence_length * _head_dimension;
+  }
+
+  void forwardHead(uint32_t head, const std::vector<float>& input,
+                   float scale) {
+    uint32_t row_stride = 3 * _model_dimension;
+    uint32_t query_offset = head * _head_dimension;
+    uint32_t key_offset = _model_dimension + query_offset;
+    uint32_t value_offset = 2 * _model_dimension + query_offset;
+
+    for (uint32_t query = 0; query < _sequence_length; query++) {
+      float* probabilities = probabilityRow(head, query);
+      const float* query_row =
+          input.data() + query * row_stride + query_offset;
+      uint32_t attended = _causal ? query + 1 : _sequence_length;
+
+      float max_score = -INFINITY;
+      for (uint32_t key = 0; key < attended; key++) {
+        const float* key_row = input.data() + key * row_stride + key_offset;
+        float score = 0.F;
+        for (uint32_t index = 0; index < _head_dimension; index++) {
+          score += query_row[index] * key_row[index];
+        }
+        probabilities[key] = score * scale;
+        max_score = std::max(max_score, probabilities[key]);
+      }
+      float sum_exps = 0.F;
+      for (uint32_t key = 0; key < attended; key++) {
+        probabilities[key] = std::exp(probabilities[key] - max_score);
+        sum_exps += probabilities[key];
+      }
+
+      float* output_row =
+          _output.data() + query * _model_dimension + query_offset;
+      for (uint32_t key = 0; key < attended; key++) {
+        probabilities[key] /= sum_exps;
+        const float* value =
+            input.data() + key * row_stride + value_offset;
+        for (uint32_t index = 0; index < _head_dimension; index++) {
+          output_row[index] += probabilities[key] * value[index];
+        }
+      }
+    }
+  }
+
+  /**
+   * Accumulates the gradients of the queries, keys and values of `head`.
+   * `grad_scores` is a scratch row of length L that only this head uses.
+   */
+  void backwardHead(uint32_t head, const std::vector<float>& input,
+                    float scale, float* grad_scores) {
+    uint32_t row_stride = 3 * _model_dimension;
+    uint32_t query_offset = head * _head_dimension;
+    uint32_t key_offset = _model_dimension + query_offset;
+    uint32_t value_offset = 2 * _model_dimension + query_offset;
+    float* input_gradient = _local_gradient->data();
+
+    for (uint32_t query = 0; query < _sequence_length; query++) {
+      const float* probabilities = probabilityRow(head, query);
+      const float* output_grad = _upstream_gradient.data() +
+                                 query * _model_dimension + query_offset;
+      uint32_t attended = _causal ? query + 1 : _sequence_length;
+
+      float weighted_sum = 0.F;
+      for (uint32_t key = 0; key < attended; key++) {
+        const float* value = input.data() + key * row_stride + value_offset;
+        float* value_grad = input_gradient + key * row_stride + value_offset;
+        float grad_probability = 0.F;
+        for (uint32_t index = 0; index < _head_dimension; index++) {
+          grad_probability += output_grad[index] * value[index];
+          value_grad[index] += probabilities[key] * output_grad[index];
+        }
+        grad_scores[key] = grad_probability;
+        weighted_sum += probabilities[key] * grad_probability;
+      }
+
+      const float* query_row =
+          input.data() + query * row_stride + query_offset;
+      float* query_grad = input_gradient + query * row_stride + query_offset;
+      for (uint32_t key = 0; key < attended; key++) {
+        float grad_score =
+            scale * probabilities[key] * (grad_scores[key] - weighted_sum);
+        const float* key_row = input.data() + key * row_stride + key_offset;
+        float* key_grad = input_gradient + key * row_stride + key_offset;
+        for (uint32_t index = 0; index < _head_dimension; index++) {
+          query_grad[index] += grad_score * key_row[index];
+          key_grad[index] += grad_score * query_row[index];
+        }
+      }
+    }
+  }
+
+  std::shared_ptr<Vertex> applyOperation() final {
+    auto& input = _input->getOutput();
+    float scale = 1.F / std::sqrt(static_cast<float>(_head_dimension));
+
+    _output = std::vector<float>(_sequence_length * _model_dimension, 0.F);
+    _probabilities = std::vector<float>(
+        static_cast<uint64_t>(_num_heads) * _sequence_length *
+            _sequence_length,
+        0.F);
+
+    parallel::parallelFor(
+        0, _num_heads,
+        [&](uint64_t begin, uint64_t end) {
+          for (uint64_t head = begin; head < end; head++) {
+            forwardHead(head, input, scale);
+          }
+        },
+        parallel::grainSize(/* work_per_iteration = */ headWork()));
+    return shared_from_this();
+  }
+
+  VertexPointer _input;
+  uint32_t _num_heads;
+  bool _causal;
+
+  uint32_t _sequence_length;
+  uint32_t _model_dimension;
+  uint32_t _head_dimension;
+
+  // Attention probabilities laid out as [head][query][key]
+  std::vector<float> _probabilities;
+
+  SelfAttention() = default;
+  friend class cereal::access;
+
+  template <typename Archive>
+  void serialize(Archive& archive) {
+    archive(cereal::base_class<Vertex>(this), _input, _num_heads, _causal,
+            _sequence_length, _model_dimension, _head_dimension, _output,
+            _probabilities);
+  }
+};
+
+}  // namespace gladius::comp_graph
+
+CEREAL_REGISTER_TYPE(gladius::comp_graph::SelfAttention)
@@ -5,10 +5,13 @@
 #include <cereal/types/memory.hpp>
 #include <cereal/types/optional.hpp>
 #include <cereal/types/polymorphic.hpp>
+#include <cereal/types/utility.hpp>
 #include <cereal/types/vector.hpp>
 #include <src/comp_graph/vertices/vertex.hpp>
 #include <memory>
+#include <optional>
 #include <stdexcept>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -56,7 +59,8 @@ class Summation final : public Vertex,
    * is passed backward to both input vertices for downstream gradient
    * computations.
    */
-  void backward(std::optional<std::vector<float>>& upstream_grad) final {
+  void backwardImpl(std::optional<std::vector<float>>& upstream_grad) final {
+    profiling::ProfileScope profile_scope(*this, profiling::Pass::Backward);
     if (!upstream_grad.has_value()) {
       throw std::runtime_error(
           "Cannot propagate the gradient backward without "
@@ -73,10 +77,30 @@ class Summation final : public Vertex,
 
   inline std::string getName() final { return "Summation"; }
 
+  std::vector<VertexPointer> getInputs() const final {
+    return {_left_input, _right_input};
+  }
+
+  void replaceInput(const Vertex& input,
+                    const VertexPointer& replacement) final {
+    replaceInputMember(_left_input, input, replacement);
+    replaceInputMember(_right_input, input, replacement);
+  }
+
+  std::optional<uint64_t> getAttributes() const final {
+    return 0;
+  }
+
   std::pair<uint32_t, uint32_t> getOutputShape() const final {
     return std::make_pair(1, _output_length);
   }
 
+  VertexMemoryUsage getMemoryUsage() const final {
+    auto usage = Vertex::getMemoryUsage();
+    usage.gradients += memory::bytesOf(_gradient);
+    return usage;
+  }
+
  private:
   std::shared_ptr<Vertex> applyOperation() final {
     auto left_output_vector = _left_input->getOutput();
@@ -106,6 +130,106 @@ class Summation final : public Vertex,
   }
 };
 
+/**
+ * Computes the elementwise sum of two inputs of the same (rows, d) shape, as
+ * used by residual connections, i.e., y = x + f(x). Unlike Summation, this
+ * vertex supports multi-row inputs and registers itself as a consumer of both
+ * inputs so that the shortcut input x, which is also consumed by f, only
+ * propagates backwards once both of its gradients have been summed.
+ */
+class ResidualAddition final
+    : public Vertex,
+      public std::enable_shared_from_this<ResidualAddition> {
+ public:
+  ResidualAddition(VertexPointer shortcut_input, VertexPointer residual_input)
+      : _shortcut_input(std::move(shortcut_input)),
+        _residual_input(std::move(residual_input)) {
+    _output_shape = _shortcut_input->getOutputShape();
+    if (_output_shape != _residual_input->getOutputShape()) {
+      throw std::invalid_argument(
+          "Dimension mismatch for the inputs to residual addition vertex. Make "
+          "sure that the two inputs have the same dimensions.");
+    }
+    registerInput(*_shortcut_input);
+    registerInput(*_residual_input);
+  }
+
+  void forward() final { applyOperation(); }
+
+  void backwardImpl(std::optional<std::vector<float>>& upstream_grad) final {
+    profiling::ProfileScope profile_scope(*this, profiling::Pass::Backward);
+    if (!upstream_grad.has_value()) {
+      throw std::runtime_error(
+          "Cannot propagate the gradient backward without "
+          "setting the upstream gradient first.");
+    }
+    assert(upstream_grad.value().size() == _output.size());
+
+    if (!accumulateUpstreamGradient(upstream_grad.value())) {
+      return;
+    }
+    // The gradient passes through unchanged. Swapping, rather than moving,
+    // hands the previous buffer back to _upstream_gradient so that the next
+    // pass copies into it instead of allocating.
+    if (!_local_gradient.has_value()) {
+      _local_gradient.emplace();
+    }
+    _local_gradient->swap(_upstream_gradient);
+
+    _residual_input->backward(/* upstream_grad = */ _local_gradient);
+    _shortcut_input->backward(/* upstream_grad = */ _local_gradient);
+  }
+
+  inline std::string getName() final { return "ResidualAddition"; }
+
+  std::vector<VertexPointer> getInputs() const final {
+    return {_shortcut_input, _residual_input};
+  }
+
+  void replaceInput(const Vertex& input,
+                    const VertexPointer& replacement) final {
+    replaceInputMember(_shortcut_input, input, replacement);
+    replaceInputMember(_residual_input, input, replacement);
+  }
+
+  std::optional<uint64_t> getAttributes() const final {
+    return 0;
+  }
+
+  std::pair<uint32_t, uint32_t> getOutputShape() const final {
+    return _output_shape;
+  }
+
+ private:
+  std::shared_ptr<Vertex> applyOperation() final {
+    auto& shortcut = _shortcut_input->getOutput();
+    auto& residual = _residual_input->getOutput();
+    auto size = shortcut.size();
+
+    _output.resize(size);
+#pragma omp simd
+    for (uint64_t index = 0; index < size; index++) {
+      _output[index] = shortcut[index] + residual[index];
+    }
+    return shared_from_this();
+  }
+
+  VertexPointer _shortcut_input;
+  VertexPointer _residual_input;
+  std::pair<uint32_t, uint32_t> _output_shape;
+
+  ResidualAddition() = default;
+
+  friend class cereal::access;
+
+  template <typename Archive>
+  void serialize(Archive& archive) {
+    archive(cereal::base_class<Vertex>(this), _shortcut_input, _residual_input,
+            _output, _output_shape);
+  }
+};
+
 }  // namespace gladius::comp_graph
 
-CEREAL_REGISTER_TYPE(gladius::comp_graph::Summation)
\ No newline at end of file
+CEREAL_REGISTER_TYPE(gladius::comp_graph::Summation)
+CEREAL_REGISTER_TYPE(gladius::comp_graph::ResidualAddition)
\ No newline at end of file
@@ -3,7 +3,12 @@
 #include <cereal/access.hpp>
 #include <cereal/types/optional.hpp>
 #include <cereal/types/vector.hpp>
+#include <src/memory/memory_tracker.hpp>
+#include <src/profiling/profiler.hpp>
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <stdexcept>
@@ -29,13 +34,88 @@ namespace gladius::comp_graph {
 //   }
 // };
 
+/**
+ * Thread-local switch that tells vertices whether they will take part in a
+ * backward pass. It is read once, when a vertex is constructed, so the graph
+ * built for a sample keeps the mode it was built under.
+ */
+class GradMode {
+ public:
+  static inline bool isEnabled() { return _enabled; }
+  static inline void setEnabled(bool enabled) { _enabled = enabled; }
+
+ private:
+  static inline thread_local bool _enabled = true;
+};
+
+/**
+ * Disables gradient bookkeeping for the vertices constructed in its scope,
+ * e.g., the graphs built to evaluate a trained model:
+ *
+ *      {
+ *        NoGradGuard no_grad;
+ *        auto graph = buildComputationGraph(model, input, label);
+ *        auto predicted_label = graph->predict();
+ *      }
+ *
+ * Such vertices allocate no gradient buffers and cannot be backpropagated
+ * through. The previous mode is restored when the guard goes out of scope.
+ */
+class NoGradGuard {
+ public:
+  NoGradGuard() : _previous(GradMode::isEnabled()) {
+    GradMode::setEnabled(false);
+  }
+  ~NoGradGuard() { GradMode::setEnabled(_previous); }
+
+  NoGradGuard(const NoGradGuard&) = delete;
+  NoGradGuard& operator=(const NoGradGuard&) = delete;
+
+ private:
+  bool _previous;
+};
+
+/**
+ * Bytes held by the buffers of a vertex, by memory category (see
+ * memory::MemoryCategory)
+ */
+struct VertexMemoryUsage {
+  uint64_t activations = 0;
+  uint64_t gradients = 0;
+  uint64_t jacobians = 0;
+  uint64_t workspace = 0;
+
+  inline uint64_t total() const {
+    return activations + gradients + jacobians + workspace;
+  }
+};
+
+class Vertex;
+
+/**
+ * Told when the backward pass of a vertex starts, before the vertex reads
+ * any output, e.g., to recompute the outputs that gradient checkpointing
+ * dropped (see Checkpointer), and when the call to backward() returns
+ */
+class BackwardObserver {
+ public:
+  virtual ~BackwardObserver() = default;
+
+  virtual void beforeBackward(Vertex& vertex) = 0;
+
+  virtual void afterBackward(Vertex& vertex) { (void)vertex; }
+};
+
 class Vertex {
  public:
   Vertex() = default;
   /* Move constructor */
   Vertex(Vertex&& other) noexcept
       : _local_gradient(std::move(other._local_gradient)),
-        _output(std::move(other._output)) {}
+        _output(std::move(other._output)),
+        _requires_grad(other._requires_grad),
+        _registered_inputs(std::move(other._registered_inputs)),
+        _tracked_memory(std::move(other._tracked_memory)) {}
 
   /* Move assignment operator */
 
@@ -54,8 +134,16 @@ class Vertex {
    * gradients at a specific vertex and updating the gradient
    * of the loss function with respect to the given parameter
    * via the chain rule.
+   *
+   * Every step of the backward pass, including the recursive calls on the
+   * inputs, goes through here, so the backward observer of the vertex (see
+   * setBackwardObserver()) is told about it whatever backwardImpl() does.
    */
-  virtual void backward(std::optional<std::vector<float>>& upstream_grad) = 0;
+  void backward(std::optional<std::vector<float>>& upstream_grad) {
+    prepareBackward();
+    backwardImpl(upstream_grad);
+    finishBackward();
+  }
 
   /**
    * While this method is indeed part of the mechanics of the backward
@@ -97,6 +185,123 @@ class Vertex {
   //   _upstream_gradient = gradient;
   // }
 
+  /**
+   * Registers one more vertex that consumes the output of this vertex.
+   * The backward computation is recursive, so a vertex whose output feeds
+   * several consumers (for instance, the input of a residual connection)
+   * would otherwise propagate backwards once per consumer, which visits
+   * every path in the graph and grows exponentially with depth. Vertices
+   * that register themselves here let their inputs wait until the gradient
+   * from every consumer has been summed before propagating it further.
+   */
+  inline void registerConsumer() { _consumer_count++; }
+
+  inline void unregisterConsumer() {
+    assert(_consumer_count > 0);
+    _consumer_count--;
+  }
+
+  /**
+   * Undoes the registrations of the vertex as a consumer of its inputs (see
+   * registerInput()). Graph passes call it on the vertices they remove, so
+   * that the inputs do not wait for a gradient that never comes.
+   */
+  void unregisterFromInputs() {
+    for (auto* input : _registered_inputs) {
+      input->unregisterConsumer();
+    }
+    _registered_inputs.clear();
+  }
+
+  /**
+   * Makes every input of the vertex that is `input` point to `replacement`,
+   * which computes the same output, e.g., when a graph pass merges duplicate
+   * vertices. The registration as a consumer moves along.
+   */
+  virtual void replaceInput(const Vertex& input,
+                            const std::shared_ptr<Vertex>& replacement) {
+    (void)input;
+    (void)replacement;
+    if (!getInputs().empty()) {
+      throw std::logic_error("The inputs of a " + getName() +
+                             " vertex cannot be replaced.");
+    }
+  }
+
+  /**
+   * What the output of the vertex depends on besides its name and inputs,
+   * e.g., the parameter of a ParameterVertex. Two vertices with the same
+   * name, inputs and attributes compute the same output, so graph passes may
+   * merge them. Vertices that are never merged, such as those holding data
+   * or sampling at random, return nullopt.
+   */
+  virtual std::optional<uint64_t> getAttributes() const {
+    return std::nullopt;
+  }
+
+  /**
+   * Returns the vertices whose outputs this vertex reads in forward().
+   * Leaves (inputs and parameters) have none.
+   */
+  virtual std::vector<std::shared_ptr<Vertex>> getInputs() const {
+    return {};
+  }
+
+  /**
+   * Returns false if the vertex was constructed under a NoGradGuard, in
+   * which case it holds no gradient state.
+   */
+  inline bool requiresGrad() const { return _requires_grad; }
+
+  /**
+   * Frees the output of the forward pass. Used in inference once every
+   * consumer of the output has run.
+   */
+  inline void releaseOutput() {
+    std::vector<float>().swap(_output);
+    trackMemory();
+  }
+
+  inline bool isOutputReleased() const { return _output.empty(); }
+
+  /**
+   * Gives back an output freed by releaseOutput(), e.g., one read back from
+   * a memory::SpillFile
+   */
+  inline void restoreOutput(std::vector<float>&& output) {
+    _output = std::move(output);
+    trackMemory();
+  }
+
+  inline void setBackwardObserver(BackwardObserver* observer) {
+    _backward_observer = observer;
+  }
+
+  /**
+   * Runs at the start of every call to backward()
+   */
+  inline void prepareBackward() {
+    if (_backward_observer) {
+      _backward_observer->beforeBackward(*this);
+    }
+  }
+
+  /**
+   * Runs when a call to backward() returns, including the calls that only
+   * accumulate the gradient of one consumer
+   */
+  inline void finishBackward() {
+    if (_backward_observer) {
+      _backward_observer->afterBackward(*this);
+    }
+  }
+
+  /**
+   * Returns true if some, but not all, of the consumers of the vertex have
+   * propagated their gradient to it
+   */
+  inline bool hasPendingGradients() const { return _received_gradients != 0; }
+
   inline void zeroOutGradients() {
     if (_local_gradient.has_value()) {
       _local_gradient = std::nullopt;
@@ -131,7 +336,60 @@ class Vertex {
    */
   virtual std::pair<uint32_t, uint32_t> getOutputShape() const = 0;
 
+  /**
+   * Returns an estimate of the floating point operations of the forward
+   * pass, used by the profiler. The default counts one operation per output
+   * entry, which suits element-wise operations.
+   */
+  virtual uint64_t estimateFlops() const {
+    auto [rows, columns] = getOutputShape();
+    return static_cast<uint64_t>(rows) * columns;
+  }
+
+  /**
+   * Returns the bytes held by the buffers of the vertex. The default counts
+   * the output and the gradients held by every vertex. Vertices with more
+   * buffers (e.g., values kept for the backward pass, gradients w.r.t their
+   * parameters or Jacobians) add them to the usage of the base class.
+   */
+  virtual VertexMemoryUsage getMemoryUsage() const {
+    VertexMemoryUsage usage;
+    usage.activations = memory::bytesOf(_output);
+    usage.gradients =
+        memory::bytesOf(_upstream_gradient) + memory::bytesOf(_local_gradient);
+    return usage;
+  }
+
+  uint64_t getBufferBytes() const { return getMemoryUsage().total(); }
+
+  /**
+   * Reports the current size of the buffers of the vertex to the memory
+   * tracker, if it is enabled. This happens after every forward and backward
+   * pass of the vertex (see profiling::ProfileScope).
+   */
+  void trackMemory() {
+    if (!memory::MemoryTracker::isEnabled()) {
+      return;
+    }
+    auto usage = getMemoryUsage();
+    auto name = getName();
+    _tracked_memory[0].set(name, memory::MemoryCategory::Activations,
+                           usage.activations);
+    _tracked_memory[1].set(name, memory::MemoryCategory::Gradients,
+                           usage.gradients);
+    _tracked_memory[2].set(name, memory::MemoryCategory::Jacobians,
+                           usage.jacobians);
+    _tracked_memory[3].set(name, memory::MemoryCategory::Workspace,
+                           usage.workspace);
+  }
+
  protected:
+  /**
+   * The backward pass of the vertex itself (see backward())
+   */
+  virtual void backwardImpl(
+      std::optional<std::vector<float>>& upstream_grad) = 0;
+
   /**
    * Applies the main operation implemented by the vertex.
    * For instance, if the vertex computes the expression
@@ -140,10 +398,103 @@ class Vertex {
    */
   virtual std::shared_ptr<Vertex> applyOperation() = 0;
 
+  /**
+   * Adds the given upstream gradient to _upstream_gradient and returns true
+   * once every registered consumer has contributed its gradient, i.e., when
+   * the vertex is ready to propagate backwards. Vertices with no registered
+   * consumers are always ready, which preserves the behavior of vertices that
+   * do not take part in consumer registration.
+   */
+  bool accumulateUpstreamGradient(const std::vector<float>& upstream_grad) {
+    if (_received_gradients == 0) {
+      _upstream_gradient = upstream_grad;
+    } else {
+      assert(_upstream_gradient.size() == upstream_grad.size());
+      auto size = upstream_grad.size();
+      for (uint64_t index = 0; index < size; index++) {
+        _upstream_gradient[index] += upstream_grad[index];
+      }
+    }
+    _received_gradients++;
+
+    if (_received_gradients < std::max<uint32_t>(_consumer_count, 1)) {
+      return false;
+    }
+    _received_gradients = 0;
+    return true;
+  }
+
+  /**
+   * Sets `gradient` to `size` zeros. The vector is only allocated by the
+   * first backward pass and its memory is reused by the following ones.
+   */
+  static void resetGradient(std::optional<std::vector<float>>& gradient,
+                            uint64_t size) {
+    if (!gradient.has_value()) {
+      gradient.emplace();
+    }
+    gradient->assign(size, 0.F);
+  }
+
+  /**
+   * Registers the vertex as one more consumer of `input` and remembers it,
+   * so that graph passes can move or undo the registration
+   */
+  void registerInput(Vertex& input) {
+    input.registerConsumer();
+    _registered_inputs.push_back(&input);
+  }
+
+  /**
+   * Points `member` to `replacement` if it holds `input`. For the overrides
+   * of replaceInput().
+   */
+  template <typename T>
+  void replaceInputMember(std::shared_ptr<T>& member, const Vertex& input,
+                          const std::shared_ptr<Vertex>& replacement) {
+    if (!member || static_cast<const Vertex*>(member.get()) != &input) {
+      return;
+    }
+    auto typed_replacement = std::dynamic_pointer_cast<T>(replacement);
+    if (!typed_replacement) {
+      throw std::invalid_argument("Cannot replace an input of a " +
+                                  getName() + " vertex with a " +
+                                  replacement->getName() + " vertex.");
+    }
+    auto registration = std::find(_registered_inputs.begin(),
+                                  _registered_inputs.end(), member.get());
+    if (registration != _registered_inputs.end()) {
+      member->unregisterConsumer();
+      replacement->registerConsumer();
+      *registration = replacement.get();
+    }
+    member = std::move(typed_replacement);
+  }
+
+  inline void checkRequiresGrad() const {
+    if (!_requires_grad) {
+      throw std::runtime_error(
+          "Cannot propagate the gradient backward through a vertex that was "
+          "constructed under a NoGradGuard.");
+    }
+  }
+
   std::optional<std::vector<float>> _local_gradient;
   std::vector<float> _output;
 
+  std::vector<float> _upstream_gradient;
+  uint32_t _consumer_count = 0;
+  uint32_t _received_gradients = 0;
+  bool _requires_grad = GradMode::isEnabled();
+  // The inputs the vertex registered with as a consumer
+  std::vector<Vertex*> _registered_inputs;
+
  private:
+  // Activations, gradients, Jacobians and workspace reported to the memory
+  // tracker
+  std::array<memory::TrackedBytes, 4> _tracked_memory;
+  BackwardObserver* _backward_observer = nullptr;
+
   friend class cereal::access;
   template <typename Archive>
   void serialize(Archive& archive) {
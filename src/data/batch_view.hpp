@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+namespace gladius::data {
+
+/**
+ * Non-owning view of a batch of samples. The inputs are stored row by row,
+ * one row of input_dimension values per sample, and labels[i] is the class
+ * index of the i-th sample.
+ */
+struct BatchView {
+  const float* inputs;
+  const uint32_t* labels;
+  uint32_t size;
+  uint32_t input_dimension;
+};
+
+}  // namespace gladius::data
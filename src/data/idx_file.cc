@@ -0,0 +1,52 @@
+#include <src/data/idx_file.hpp>
+#include <stdexcept>
+#include <string>
+
+namespace gladius::data {
+
+static constexpr uint8_t IDX_UNSIGNED_BYTE = 0x08;
+
+static uint32_t readBigEndian(const uint8_t* bytes) {
+  return (static_cast<uint32_t>(bytes[0]) << 24) |
+         (static_cast<uint32_t>(bytes[1]) << 16) |
+         (static_cast<uint32_t>(bytes[2]) << 8) |
+         static_cast<uint32_t>(bytes[3]);
+}
+
+IdxFile::IdxFile(const std::string& filename) : _file(filename) {
+  const uint8_t* header = _file.data();
+  auto fail = [&](const std::string& message) {
+    throw std::invalid_argument(filename + ": " + message);
+  };
+
+  if (_file.size() < 4 || header[0] != 0 || header[1] != 0) {
+    fail("invalid IDX magic number.");
+  }
+  if (header[2] != IDX_UNSIGNED_BYTE) {
+    fail("only IDX files of unsigned bytes are supported.");
+  }
+  uint32_t dimensions = header[3];
+  uint64_t header_size = 4 + 4 * static_cast<uint64_t>(dimensions);
+  if (dimensions == 0 || _file.size() < header_size) {
+    fail("truncated IDX header.");
+  }
+
+  _item_size = 1;
+  for (uint32_t index = 0; index < dimensions; index++) {
+    _dimensions.push_back(readBigEndian(header + 4 + 4 * index));
+    if (index > 0) {
+      _item_size *= _dimensions.back();
+    }
+  }
+  if (_file.size() - header_size < _item_size * _dimensions[0]) {
+    fail("the file holds fewer items than its header declares.");
+  }
+  _data = header + header_size;
+}
+
+void IdxFile::prefetch(uint32_t first, uint32_t count) const {
+  _file.prefetch(static_cast<uint64_t>(getItem(first) - _file.data()),
+                 count * _item_size);
+}
+
+}  // namespace gladius::data
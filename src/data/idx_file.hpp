@@ -0,0 +1,60 @@
+#pragma once
+
+#include <src/data/mapped_file.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gladius::data {
+
+/**
+ * Read-only memory mapping of a file in the IDX format used by MNIST:
+ *    - 2 zero bytes, a type byte (0x08 for unsigned bytes) and the number of
+ *      dimensions d,
+ *    - d big-endian 32-bit sizes,
+ *    - the items, stored contiguously in row-major order.
+ * The first dimension indexes the items, e.g., an image file has
+ * dimensions (N, 28, 28) and a label file has dimensions (N).
+ *
+ * Only unsigned byte files are supported. Pages are loaded lazily by the
+ * kernel as items are read, so opening a file is cheap regardless of its
+ * size.
+ */
+class IdxFile {
+ public:
+  explicit IdxFile(const std::string& filename);
+
+  IdxFile(const IdxFile&) = delete;
+  IdxFile& operator=(const IdxFile&) = delete;
+
+  inline const std::vector<uint32_t>& getDimensions() const {
+    return _dimensions;
+  }
+
+  inline uint32_t getItemCount() const { return _dimensions.at(0); }
+
+  /**
+   * Number of bytes in a single item, i.e., the product of every dimension
+   * but the first one.
+   */
+  inline uint64_t getItemSize() const { return _item_size; }
+
+  inline const uint8_t* getItem(uint32_t index) const {
+    return _data + static_cast<uint64_t>(index) * _item_size;
+  }
+
+  /**
+   * Hints the kernel that the items in [first, first + count) will be read
+   * soon.
+   */
+  void prefetch(uint32_t first, uint32_t count) const;
+
+ private:
+  MappedFile _file;
+
+  std::vector<uint32_t> _dimensions;
+  uint64_t _item_size;
+  const uint8_t* _data;
+};
+
+}  // namespace gladius::data
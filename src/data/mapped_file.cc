@@ -0,0 +1,50 @@
+#include <src/data/mapped_file.hpp>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace gladius::data {
+
+MappedFile::MappedFile(const std::string& filename) {
+  int descriptor = open(filename.c_str(), O_RDONLY);
+  if (descriptor < 0) {
+    throw std::runtime_error("Unable to open " + filename + ".");
+  }
+  struct stat file_status;
+  if (fstat(descriptor, &file_status) != 0) {
+    close(descriptor);
+    throw std::runtime_error("Unable to read the size of " + filename + ".");
+  }
+  _size = static_cast<uint64_t>(file_status.st_size);
+  if (_size == 0) {
+    close(descriptor);
+    throw std::invalid_argument(filename + " is empty.");
+  }
+
+  void* mapping = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+  // The mapping keeps its own reference to the file
+  close(descriptor);
+  if (mapping == MAP_FAILED) {
+    throw std::runtime_error("Unable to memory-map " + filename + ".");
+  }
+  _data = static_cast<const uint8_t*>(mapping);
+  madvise(mapping, _size, MADV_SEQUENTIAL);
+}
+
+MappedFile::~MappedFile() {
+  munmap(const_cast<uint8_t*>(_data), _size);
+}
+
+void MappedFile::prefetch(uint64_t offset, uint64_t length) const {
+  // madvise expects a page-aligned address
+  auto page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  auto begin = reinterpret_cast<uintptr_t>(_data + offset);
+  auto end = begin + length;
+  begin -= begin % page_size;
+  madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+}
+
+}  // namespace gladius::data
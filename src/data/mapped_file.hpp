@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace gladius::data {
+
+/**
+ * Read-only memory mapping of a whole file. Pages are loaded lazily by the
+ * kernel as they are read and, since they are backed by the file, they can
+ * be evicted under memory pressure without being written to swap.
+ */
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& filename);
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  ~MappedFile();
+
+  inline const uint8_t* data() const { return _data; }
+  inline uint64_t size() const { return _size; }
+
+  /**
+   * Hints the kernel that the bytes in [offset, offset + length) will be
+   * read soon.
+   */
+  void prefetch(uint64_t offset, uint64_t length) const;
+
+ private:
+  const uint8_t* _data = nullptr;
+  uint64_t _size = 0;
+};
+
+}  // namespace gladius::data
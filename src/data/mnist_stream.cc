@@ -0,0 +1,202 @@
+#include <src/data/mnist_stream.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace gladius::data {
+
+static constexpr uint64_t BUFFER_ALIGNMENT = 64;
+
+void normalizePixels(const uint8_t* pixels, float* destination,
+                     uint64_t size) {
+  constexpr float SCALE = 1.F / 255.F;
+  uint64_t index = 0;
+#if defined(__AVX2__)
+  const __m256 scale = _mm256_set1_ps(SCALE);
+  for (; index + 32 <= size; index += 32) {
+    __m256i bytes =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels + index));
+    __m128i low = _mm256_castsi256_si128(bytes);
+    __m128i high = _mm256_extracti128_si256(bytes, 1);
+    __m128i quarters[4] = {low, _mm_srli_si128(low, 8), high,
+                           _mm_srli_si128(high, 8)};
+    for (uint32_t quarter = 0; quarter < 4; quarter++) {
+      __m256 values =
+          _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(quarters[quarter]));
+      _mm256_storeu_ps(destination + index + 8 * quarter,
+                       _mm256_mul_ps(values, scale));
+    }
+  }
+#endif
+  for (; index < size; index++) {
+    destination[index] = static_cast<float>(pixels[index]) * SCALE;
+  }
+}
+
+MNISTStream::MNISTStream(const std::string& images_filename,
+                         const std::string& labels_filename,
+                         uint32_t batch_size)
+    : _images(images_filename),
+      _labels(labels_filename),
+      _batch_size(batch_size) {
+  if (_batch_size == 0) {
+    throw std::invalid_argument("The batch size must be positive.");
+  }
+  if (_images.getItemCount() != _labels.getItemCount() ||
+      _labels.getItemSize() != 1) {
+    throw std::invalid_argument(
+        "The label file must hold exactly one label per image. Got " +
+        std::to_string(_labels.getItemCount()) + " labels for " +
+        std::to_string(_images.getItemCount()) + " images.");
+  }
+  _input_dimension = static_cast<uint32_t>(_images.getItemSize());
+  _batch_count = (_images.getItemCount() + _batch_size - 1) / _batch_size;
+
+  for (auto& buffer : _buffers) {
+    allocate(buffer);
+  }
+  _prefetcher = std::thread([this] { prefetchLoop(); });
+}
+
+MNISTStream::~MNISTStream() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopping = true;
+  }
+  _condition.notify_all();
+  _prefetcher.join();
+
+  for (auto& buffer : _buffers) {
+    release(buffer);
+  }
+}
+
+void MNISTStream::allocate(BatchBuffer& buffer) const {
+  auto round_up = [](uint64_t bytes) {
+    return (bytes + BUFFER_ALIGNMENT - 1) / BUFFER_ALIGNMENT *
+           BUFFER_ALIGNMENT;
+  };
+  uint64_t input_bytes = round_up(static_cast<uint64_t>(_batch_size) *
+                                  _input_dimension * sizeof(float));
+  uint64_t label_bytes = round_up(_batch_size * sizeof(uint32_t));
+
+  buffer.inputs = static_cast<float*>(
+      std::aligned_alloc(BUFFER_ALIGNMENT, input_bytes));
+  buffer.labels = static_cast<uint32_t*>(
+      std::aligned_alloc(BUFFER_ALIGNMENT, label_bytes));
+  if (buffer.inputs == nullptr || buffer.labels == nullptr) {
+    std::free(buffer.inputs);
+    std::free(buffer.labels);
+    throw std::bad_alloc();
+  }
+  // Locking fails without the privilege or above RLIMIT_MEMLOCK, in which
+  // case the buffers are simply pageable
+  mlock(buffer.inputs, input_bytes);
+  mlock(buffer.labels, label_bytes);
+}
+
+void MNISTStream::release(BatchBuffer& buffer) const {
+  // munlock is harmless on memory that was never locked
+  munlock(buffer.inputs, static_cast<uint64_t>(_batch_size) *
+                             _input_dimension * sizeof(float));
+  munlock(buffer.labels, _batch_size * sizeof(uint32_t));
+  std::free(buffer.inputs);
+  std::free(buffer.labels);
+}
+
+void MNISTStream::prefetchLoop() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (true) {
+    _condition.wait(lock, [this] {
+      if (_stopping) {
+        return true;
+      }
+      const auto& buffer = _buffers[_fill_index % 2];
+      return _fill_index < _batch_count && !buffer.ready && !buffer.in_use;
+    });
+    if (_stopping) {
+      return;
+    }
+
+    uint32_t batch_index = _fill_index;
+    uint64_t epoch = _epoch;
+    auto& buffer = _buffers[batch_index % 2];
+    lock.unlock();
+    fill(buffer, batch_index);
+    lock.lock();
+
+    if (epoch == _epoch) {
+      buffer.ready = true;
+      _fill_index++;
+      _condition.notify_all();
+    }
+  }
+}
+
+void MNISTStream::fill(BatchBuffer& buffer, uint32_t batch_index) {
+  uint32_t first = batch_index * _batch_size;
+  uint32_t size = std::min(_batch_size, _images.getItemCount() - first);
+
+  // Ask the kernel to start reading the batch after this one
+  uint32_t next_first = first + size;
+  if (next_first < _images.getItemCount()) {
+    uint32_t next_size =
+        std::min(_batch_size, _images.getItemCount() - next_first);
+    _images.prefetch(next_first, next_size);
+  }
+
+  // Consecutive images are contiguous in the file
+  normalizePixels(_images.getItem(first), buffer.inputs,
+                  static_cast<uint64_t>(size) * _input_dimension);
+  const uint8_t* labels = _labels.getItem(first);
+  for (uint32_t index = 0; index < size; index++) {
+    buffer.labels[index] = labels[index];
+  }
+  buffer.size = size;
+}
+
+bool MNISTStream::next(BatchView& batch) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  // The previous batch is no longer needed
+  if (_consume_index > 0) {
+    auto& previous = _buffers[(_consume_index - 1) % 2];
+    if (previous.in_use) {
+      previous.in_use = false;
+      previous.ready = false;
+      _condition.notify_all();
+    }
+  }
+  if (_consume_index == _batch_count) {
+    return false;
+  }
+
+  auto& buffer = _buffers[_consume_index % 2];
+  _condition.wait(lock, [&buffer] { return buffer.ready; });
+  buffer.in_use = true;
+  _consume_index++;
+
+  batch = {buffer.inputs, buffer.labels, buffer.size, _input_dimension};
+  return true;
+}
+
+void MNISTStream::reset() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _epoch++;
+    _fill_index = 0;
+    _consume_index = 0;
+    for (auto& buffer : _buffers) {
+      buffer.ready = false;
+      buffer.in_use = false;
+    }
+  }
+  _condition.notify_all();
+}
+
+}  // namespace gladius::data
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <src/data/batch_view.hpp>
+#include <src/data/idx_file.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace gladius::data {
+
+/**
+ * Converts `size` pixels into floats in [0, 1]. Uses AVX2 when available.
+ */
+void normalizePixels(const uint8_t* pixels, float* destination, uint64_t size);
+
+/**
+ * Streams batches out of an IDX image file and the matching IDX label file
+ * (e.g., the MNIST training set) without materializing the dataset.
+ *
+ * Both files are memory-mapped. A background thread converts the pixels of
+ * the next batch while the current one is in use, alternating between two
+ * page-locked buffers, so the consumer only waits if it is faster than the
+ * conversion itself. Every batch but the last holds batch_size samples.
+ *
+ *      MNISTStream stream(images, labels, 64);
+ *      BatchView batch;
+ *      while (stream.next(batch)) {
+ *        ...
+ *      }
+ *      stream.reset();  // next epoch
+ */
+class MNISTStream {
+ public:
+  MNISTStream(const std::string& images_filename,
+              const std::string& labels_filename, uint32_t batch_size);
+
+  MNISTStream(const MNISTStream&) = delete;
+  MNISTStream& operator=(const MNISTStream&) = delete;
+
+  ~MNISTStream();
+
+  /**
+   * Returns false once every batch of the epoch has been returned. The view
+   * stays valid until the next call to next() or reset().
+   */
+  bool next(BatchView& batch);
+
+  /**
+   * Starts a new epoch from the first sample
+   */
+  void reset();
+
+  inline uint32_t getSampleCount() const { return _images.getItemCount(); }
+  inline uint32_t getBatchCount() const { return _batch_count; }
+  inline uint32_t getInputDimension() const { return _input_dimension; }
+
+ private:
+  /**
+   * 64-byte aligned storage for one batch. The memory is locked (pinned) on
+   * a best-effort basis, so that it is never paged out between batches.
+   */
+  struct BatchBuffer {
+    float* inputs = nullptr;
+    uint32_t* labels = nullptr;
+    uint32_t size = 0;
+    bool ready = false;
+    bool in_use = false;
+  };
+
+  void allocate(BatchBuffer& buffer) const;
+  void release(BatchBuffer& buffer) const;
+
+  void prefetchLoop();
+
+  void fill(BatchBuffer& buffer, uint32_t batch_index);
+
+  IdxFile _images;
+  IdxFile _labels;
+  uint32_t _batch_size;
+  uint32_t _batch_count;
+  uint32_t _input_dimension;
+
+  BatchBuffer _buffers[2];
+
+  std::mutex _mutex;
+  std::condition_variable _condition;
+  // The batch the background thread fills next, and the batch next()
+  // returns next
+  uint32_t _fill_index = 0;
+  uint32_t _consume_index = 0;
+  // Incremented by reset(), so that a batch filled for a previous epoch is
+  // discarded
+  uint64_t _epoch = 0;
+  bool _stopping = false;
+
+  std::thread _prefetcher;
+};
+
+}  // namespace gladius::data
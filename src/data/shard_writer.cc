@@ -0,0 +1,171 @@
+#include <src/data/shard_writer.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+#if defined(GLADIUS_WITH_ZLIB)
+#include <zlib.h>
+#endif
+
+namespace gladius::data {
+
+bool isCompressionSupported(Compression compression) {
+  if (compression == Compression::None) {
+    return true;
+  }
+#if defined(GLADIUS_WITH_ZLIB)
+  return compression == Compression::Zlib;
+#else
+  return false;
+#endif
+}
+
+ShardWriter::ShardWriter(const std::string& filename,
+                         uint32_t input_dimension, Compression compression,
+                         uint32_t records_per_block)
+    : _file(filename, std::ios::binary | std::ios::trunc),
+      _input_dimension(input_dimension),
+      _compression(compression),
+      _records_per_block(records_per_block) {
+  if (!_file) {
+    throw std::runtime_error("Unable to create the shard " + filename + ".");
+  }
+  if (!isCompressionSupported(_compression)) {
+    throw std::invalid_argument(
+        "This build of gladius does not support the requested shard "
+        "compression.");
+  }
+  if (_input_dimension == 0 || _records_per_block == 0) {
+    throw std::invalid_argument(
+        "Shards require a positive input dimension and block size.");
+  }
+  _block_inputs.reserve(static_cast<uint64_t>(_records_per_block) *
+                        _input_dimension);
+  _block_labels.reserve(_records_per_block);
+}
+
+ShardWriter::~ShardWriter() {
+  if (!_closed) {
+    close();
+  }
+}
+
+void ShardWriter::write(const float* input, uint32_t label) {
+  if (_closed) {
+    throw std::runtime_error("Cannot write to a closed shard.");
+  }
+  _block_inputs.insert(_block_inputs.end(), input, input + _input_dimension);
+  _block_labels.push_back(label);
+  _record_count++;
+  if (_block_labels.size() == _records_per_block) {
+    flushBlock();
+  }
+}
+
+void ShardWriter::flushBlock() {
+  if (_block_labels.empty()) {
+    return;
+  }
+  std::vector<uint8_t> payload(_block_inputs.size() * sizeof(float) +
+                               _block_labels.size() * sizeof(uint32_t));
+  std::copy_n(reinterpret_cast<const uint8_t*>(_block_inputs.data()),
+              _block_inputs.size() * sizeof(float), payload.begin());
+  std::copy_n(reinterpret_cast<const uint8_t*>(_block_labels.data()),
+              _block_labels.size() * sizeof(uint32_t),
+              payload.begin() + _block_inputs.size() * sizeof(float));
+
+#if defined(GLADIUS_WITH_ZLIB)
+  if (_compression == Compression::Zlib) {
+    uLongf compressed_size = compressBound(payload.size());
+    std::vector<uint8_t> compressed(compressed_size);
+    if (compress2(compressed.data(), &compressed_size, payload.data(),
+                  payload.size(), Z_DEFAULT_COMPRESSION) != Z_OK) {
+      throw std::runtime_error("Failed to compress a shard block.");
+    }
+    compressed.resize(compressed_size);
+    payload = std::move(compressed);
+  }
+#endif
+
+  if (_compression == Compression::None) {
+    uint64_t padding =
+        (SHARD_BLOCK_ALIGNMENT - _offset % SHARD_BLOCK_ALIGNMENT) %
+        SHARD_BLOCK_ALIGNMENT;
+    std::vector<char> zeros(padding, 0);
+    _file.write(zeros.data(), static_cast<std::streamsize>(padding));
+    _offset += padding;
+  }
+
+  _blocks.push_back({_offset, payload.size(),
+                     static_cast<uint32_t>(_block_labels.size()), 0});
+  _file.write(reinterpret_cast<const char*>(payload.data()),
+              static_cast<std::streamsize>(payload.size()));
+  _offset += payload.size();
+
+  _block_inputs.clear();
+  _block_labels.clear();
+}
+
+void ShardWriter::close() {
+  flushBlock();
+
+  ShardHeader header = {SHARD_VERSION, _compression, _input_dimension,
+                        static_cast<uint32_t>(_blocks.size()), _record_count};
+  uint64_t footer_size =
+      sizeof(ShardHeader) + _blocks.size() * sizeof(BlockEntry);
+  _file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  _file.write(reinterpret_cast<const char*>(_blocks.data()),
+              static_cast<std::streamsize>(_blocks.size() *
+                                           sizeof(BlockEntry)));
+  _file.write(reinterpret_cast<const char*>(&footer_size),
+              sizeof(footer_size));
+  _file.write(SHARD_MAGIC, sizeof(SHARD_MAGIC));
+  _file.close();
+  _closed = true;
+  if (!_file) {
+    throw std::runtime_error("Failed to write a shard.");
+  }
+}
+
+std::vector<std::string> writeShardedDataset(
+    const std::vector<std::pair<std::vector<float>, std::vector<uint32_t>>>&
+        dataset,
+    const std::string& prefix, uint32_t records_per_shard,
+    Compression compression, uint32_t records_per_block) {
+  if (dataset.empty() || records_per_shard == 0) {
+    throw std::invalid_argument(
+        "Cannot shard an empty dataset or use empty shards.");
+  }
+  auto input_dimension = static_cast<uint32_t>(dataset.front().first.size());
+
+  std::vector<std::string> filenames;
+  for (uint64_t first = 0; first < dataset.size();
+       first += records_per_shard) {
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), "-%05zu.gshard", filenames.size());
+    filenames.push_back(prefix + suffix);
+
+    ShardWriter writer(filenames.back(), input_dimension, compression,
+                       records_per_block);
+    uint64_t last = std::min<uint64_t>(first + records_per_shard,
+                                       dataset.size());
+    for (uint64_t index = first; index < last; index++) {
+      const auto& [input, label] = dataset[index];
+      if (input.size() != input_dimension) {
+        throw std::invalid_argument(
+            "Every input of a sharded dataset must have the same dimension.");
+      }
+      auto positive = std::find(label.begin(), label.end(), 1);
+      if (positive == label.end()) {
+        throw std::runtime_error("Each label vector must be one-hot encoded.");
+      }
+      writer.write(input.data(),
+                   static_cast<uint32_t>(positive - label.begin()));
+    }
+    writer.close();
+  }
+  return filenames;
+}
+
+}  // namespace gladius::data
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace gladius::data {
+
+/**
+ * A shard stores fixed-size records, each made of input_dimension floats
+ * and a class label. Records are grouped into blocks that are stored (and
+ * optionally compressed) independently, so that the blocks of a shard can
+ * be decoded in parallel and read in any order:
+ *
+ *    | block 0 | block 1 | ... | footer | footer size (u64) | magic (8B) |
+ *
+ * Within a block, the inputs of all of its records come first, row by row,
+ * followed by their labels. Uncompressed blocks start at 64-byte aligned
+ * offsets, so a memory-mapped block can be handed out as a batch as is.
+ * The footer is a ShardHeader followed by one BlockEntry per block.
+ */
+enum class Compression : uint32_t { None = 0, Zlib = 1 };
+
+static inline constexpr char SHARD_MAGIC[8] = {'G', 'L', 'D', 'S',
+                                               'H', 'R', 'D', '1'};
+static inline constexpr uint32_t SHARD_VERSION = 1;
+static inline constexpr uint64_t SHARD_BLOCK_ALIGNMENT = 64;
+
+struct ShardHeader {
+  uint32_t version;
+  Compression compression;
+  uint32_t input_dimension;
+  uint32_t block_count;
+  uint64_t record_count;
+};
+
+struct BlockEntry {
+  uint64_t offset;
+  uint64_t stored_size;
+  uint32_t record_count;
+  uint32_t reserved;
+};
+
+/**
+ * Returns true if this build can read and write zlib-compressed shards
+ */
+bool isCompressionSupported(Compression compression);
+
+/**
+ * Writes a single shard. Records are buffered until a block is full, and
+ * the footer is written by close().
+ */
+class ShardWriter {
+ public:
+  ShardWriter(const std::string& filename, uint32_t input_dimension,
+              Compression compression = Compression::None,
+              uint32_t records_per_block = 1024);
+
+  ShardWriter(const ShardWriter&) = delete;
+  ShardWriter& operator=(const ShardWriter&) = delete;
+
+  ~ShardWriter();
+
+  void write(const float* input, uint32_t label);
+
+  void close();
+
+ private:
+  void flushBlock();
+
+  std::ofstream _file;
+  uint32_t _input_dimension;
+  Compression _compression;
+  uint32_t _records_per_block;
+
+  std::vector<float> _block_inputs;
+  std::vector<uint32_t> _block_labels;
+  std::vector<BlockEntry> _blocks;
+  uint64_t _offset = 0;
+  uint64_t _record_count = 0;
+  bool _closed = false;
+};
+
+/**
+ * Writes a dataset with the (input, one-hot label) layout returned by
+ * utils::readMNISTDataset into shards named
+ * <prefix>-00000.gshard, <prefix>-00001.gshard, ... of records_per_shard
+ * records each, and returns their filenames.
+ */
+std::vector<std::string> writeShardedDataset(
+    const std::vector<std::pair<std::vector<float>, std::vector<uint32_t>>>&
+        dataset,
+    const std::string& prefix, uint32_t records_per_shard,
+    Compression compression = Compression::None,
+    uint32_t records_per_block = 1024);
+
+}  // namespace gladius::data
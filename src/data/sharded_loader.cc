@@ -0,0 +1,362 @@
+#include <src/data/sharded_loader.hpp>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if defined(GLADIUS_WITH_ZLIB)
+#include <zlib.h>
+#endif
+
+namespace gladius::data {
+
+static constexpr uint64_t PAGE_SIZE = 4096;
+
+/**
+ * SplitMix64 finalizer, used to derive independent seeds for every epoch
+ */
+static uint64_t mixBits(uint64_t value) {
+  value += 0x9E3779B97F4A7C15ULL;
+  value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+  return value ^ (value >> 31);
+}
+
+ShardedLoader::Shard ShardedLoader::openShard(const std::string& filename) {
+  Shard shard;
+  shard.file = std::make_unique<MappedFile>(filename);
+  const uint8_t* data = shard.file->data();
+  uint64_t size = shard.file->size();
+
+  uint64_t trailer_size = sizeof(uint64_t) + sizeof(SHARD_MAGIC);
+  if (size < trailer_size ||
+      std::memcmp(data + size - sizeof(SHARD_MAGIC), SHARD_MAGIC,
+                  sizeof(SHARD_MAGIC)) != 0) {
+    throw std::invalid_argument(filename + " is not a gladius shard.");
+  }
+  uint64_t footer_size;
+  std::memcpy(&footer_size, data + size - trailer_size, sizeof(footer_size));
+  if (footer_size < sizeof(ShardHeader) ||
+      footer_size > size - trailer_size) {
+    throw std::invalid_argument(filename + ": corrupted shard footer.");
+  }
+  uint64_t footer_offset = size - trailer_size - footer_size;
+
+  std::memcpy(&shard.header, data + footer_offset, sizeof(ShardHeader));
+  if (shard.header.version != SHARD_VERSION) {
+    throw std::invalid_argument(filename + ": unsupported shard version " +
+                                std::to_string(shard.header.version) + ".");
+  }
+  if (!isCompressionSupported(shard.header.compression)) {
+    throw std::invalid_argument(
+        filename + " is compressed, but this build of gladius does not "
+                   "support its compression.");
+  }
+  if (footer_size != sizeof(ShardHeader) +
+                         shard.header.block_count * sizeof(BlockEntry)) {
+    throw std::invalid_argument(filename + ": corrupted shard footer.");
+  }
+
+  shard.blocks.resize(shard.header.block_count);
+  std::memcpy(shard.blocks.data(), data + footer_offset + sizeof(ShardHeader),
+              shard.blocks.size() * sizeof(BlockEntry));
+
+  uint64_t record_size =
+      shard.header.input_dimension * sizeof(float) + sizeof(uint32_t);
+  uint64_t record_count = 0;
+  for (const auto& block : shard.blocks) {
+    bool uncompressed = shard.header.compression == Compression::None;
+    if (block.offset + block.stored_size > footer_offset ||
+        (uncompressed &&
+         block.stored_size != block.record_count * record_size)) {
+      throw std::invalid_argument(filename + ": corrupted block index.");
+    }
+    record_count += block.record_count;
+  }
+  if (record_count != shard.header.record_count) {
+    throw std::invalid_argument(filename + ": corrupted block index.");
+  }
+  return shard;
+}
+
+ShardedLoader::ShardedLoader(const std::vector<std::string>& filenames,
+                             uint32_t batch_size, LoaderOptions options)
+    : _batch_size(batch_size), _options(options) {
+  if (filenames.empty()) {
+    throw std::invalid_argument("The loader expects at least one shard.");
+  }
+  if (_batch_size == 0 || _options.num_readers == 0 ||
+      _options.prefetch_blocks == 0) {
+    throw std::invalid_argument(
+        "The batch size, number of readers and prefetch window must be "
+        "positive.");
+  }
+  for (const auto& filename : filenames) {
+    _shards.push_back(openShard(filename));
+  }
+  _input_dimension = _shards.front().header.input_dimension;
+  for (const auto& shard : _shards) {
+    if (shard.header.input_dimension != _input_dimension) {
+      throw std::invalid_argument(
+          "Every shard of a dataset must have the same input dimension.");
+    }
+    _record_count += shard.header.record_count;
+  }
+
+  _batch_inputs.resize(static_cast<uint64_t>(_batch_size) * _input_dimension);
+  _batch_labels.resize(_batch_size);
+  if (_options.shuffle_buffer_size > 0) {
+    // Batches are drawn from the buffer, so it holds at least one batch
+    _options.shuffle_buffer_size =
+        std::max(_options.shuffle_buffer_size, _batch_size);
+    _shuffle_inputs.resize(static_cast<uint64_t>(_options.shuffle_buffer_size) *
+                           _input_dimension);
+    _shuffle_labels.resize(_options.shuffle_buffer_size);
+  }
+
+  startEpoch(0);
+  for (uint32_t reader = 0; reader < _options.num_readers; reader++) {
+    _readers.emplace_back([this] { readerLoop(); });
+  }
+}
+
+ShardedLoader::~ShardedLoader() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopping = true;
+  }
+  _condition.notify_all();
+  for (auto& reader : _readers) {
+    reader.join();
+  }
+}
+
+void ShardedLoader::startEpoch(uint64_t epoch) {
+  uint64_t epoch_seed = mixBits(_options.seed ^ mixBits(epoch));
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _generation++;
+    _block_order.clear();
+    for (uint32_t shard = 0; shard < _shards.size(); shard++) {
+      for (uint32_t block = 0; block < _shards[shard].blocks.size();
+           block++) {
+        _block_order.push_back({shard, block});
+      }
+    }
+    if (_options.shuffle_buffer_size > 0) {
+      // Fisher-Yates with our own index draws, since the distributions of
+      // the standard library are not the same on every platform
+      std::mt19937_64 generator(epoch_seed);
+      for (uint64_t index = _block_order.size(); index > 1; index--) {
+        std::swap(_block_order[index - 1],
+                  _block_order[generator() % index]);
+      }
+    }
+    _next_to_decode = 0;
+    _next_to_consume = 0;
+    _decoded.clear();
+  }
+  _condition.notify_all();
+
+  _current.reset();
+  _current_offset = 0;
+  _shuffle_size = 0;
+  _generator.seed(mixBits(epoch_seed));
+}
+
+void ShardedLoader::readerLoop() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (true) {
+    _condition.wait(lock, [this] {
+      return _stopping ||
+             (_next_to_decode < _block_order.size() &&
+              _next_to_decode < _next_to_consume + _options.prefetch_blocks);
+    });
+    if (_stopping) {
+      return;
+    }
+    uint64_t sequence = _next_to_decode++;
+    uint64_t generation = _generation;
+    auto reference = _block_order[sequence];
+    lock.unlock();
+
+    std::unique_ptr<DecodedBlock> block;
+    std::exception_ptr error;
+    try {
+      block = decode(reference);
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    lock.lock();
+    if (generation == _generation) {
+      if (error && !_reader_error) {
+        _reader_error = error;
+      }
+      _decoded[sequence] = std::move(block);
+      _condition.notify_all();
+    }
+  }
+}
+
+std::unique_ptr<ShardedLoader::DecodedBlock> ShardedLoader::decode(
+    BlockReference reference) const {
+  const auto& shard = _shards[reference.shard];
+  const auto& entry = shard.blocks[reference.block];
+  const uint8_t* stored = shard.file->data() + entry.offset;
+  uint64_t input_bytes = static_cast<uint64_t>(entry.record_count) *
+                         _input_dimension * sizeof(float);
+
+  auto block = std::make_unique<DecodedBlock>();
+  block->size = entry.record_count;
+  const uint8_t* payload = stored;
+
+  if (shard.header.compression == Compression::None) {
+    // Fault the pages in here, so that the consumer never waits on the disk
+    shard.file->prefetch(entry.offset, entry.stored_size);
+    volatile uint8_t touched;
+    for (uint64_t offset = 0; offset < entry.stored_size;
+         offset += PAGE_SIZE) {
+      touched = stored[offset];
+    }
+    (void)touched;
+  } else {
+#if defined(GLADIUS_WITH_ZLIB)
+    uint64_t payload_size =
+        input_bytes + entry.record_count * sizeof(uint32_t);
+    block->storage.resize(payload_size);
+    uLongf decompressed_size = payload_size;
+    if (uncompress(block->storage.data(), &decompressed_size, stored,
+                   entry.stored_size) != Z_OK ||
+        decompressed_size != payload_size) {
+      throw std::runtime_error("Failed to decompress a shard block.");
+    }
+    payload = block->storage.data();
+#endif
+  }
+  block->inputs = reinterpret_cast<const float*>(payload);
+  block->labels = reinterpret_cast<const uint32_t*>(payload + input_bytes);
+  return block;
+}
+
+std::unique_ptr<ShardedLoader::DecodedBlock> ShardedLoader::takeBlock() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  if (_next_to_consume == _block_order.size()) {
+    return nullptr;
+  }
+  _condition.wait(lock, [this] {
+    return _reader_error || _decoded.count(_next_to_consume) > 0;
+  });
+  if (_reader_error) {
+    std::rethrow_exception(_reader_error);
+  }
+  auto block = std::move(_decoded.extract(_next_to_consume).mapped());
+  _next_to_consume++;
+  // Opens the prefetch window for the readers
+  _condition.notify_all();
+  return block;
+}
+
+bool ShardedLoader::next(BatchView& batch) {
+  if (_options.shuffle_buffer_size > 0) {
+    return nextShuffled(batch);
+  }
+  return nextInOrder(batch);
+}
+
+bool ShardedLoader::nextInOrder(BatchView& batch) {
+  if (!_current || _current_offset == _current->size) {
+    _current = takeBlock();
+    _current_offset = 0;
+    if (!_current) {
+      return false;
+    }
+  }
+
+  // A batch within a single block is a view into the block
+  if (_current->size - _current_offset >= _batch_size) {
+    batch = {_current->inputs +
+                 static_cast<uint64_t>(_current_offset) * _input_dimension,
+             _current->labels + _current_offset, _batch_size,
+             _input_dimension};
+    _current_offset += _batch_size;
+    return true;
+  }
+
+  uint32_t size = 0;
+  while (size < _batch_size) {
+    if (_current_offset == _current->size) {
+      _current = takeBlock();
+      _current_offset = 0;
+      if (!_current) {
+        break;
+      }
+    }
+    uint32_t count =
+        std::min(_batch_size - size, _current->size - _current_offset);
+    std::copy_n(
+        _current->inputs +
+            static_cast<uint64_t>(_current_offset) * _input_dimension,
+        static_cast<uint64_t>(count) * _input_dimension,
+        _batch_inputs.begin() + static_cast<uint64_t>(size) * _input_dimension);
+    std::copy_n(_current->labels + _current_offset, count,
+                _batch_labels.begin() + size);
+    size += count;
+    _current_offset += count;
+  }
+  batch = {_batch_inputs.data(), _batch_labels.data(), size,
+           _input_dimension};
+  return true;
+}
+
+bool ShardedLoader::nextShuffled(BatchView& batch) {
+  uint32_t capacity = _options.shuffle_buffer_size;
+  while (_shuffle_size < capacity) {
+    if (!_current || _current_offset == _current->size) {
+      _current = takeBlock();
+      _current_offset = 0;
+      if (!_current) {
+        break;
+      }
+    }
+    uint32_t count =
+        std::min(capacity - _shuffle_size, _current->size - _current_offset);
+    std::copy_n(_current->inputs +
+                    static_cast<uint64_t>(_current_offset) * _input_dimension,
+                static_cast<uint64_t>(count) * _input_dimension,
+                _shuffle_inputs.begin() +
+                    static_cast<uint64_t>(_shuffle_size) * _input_dimension);
+    std::copy_n(_current->labels + _current_offset, count,
+                _shuffle_labels.begin() + _shuffle_size);
+    _shuffle_size += count;
+    _current_offset += count;
+  }
+  if (_shuffle_size == 0) {
+    return false;
+  }
+
+  uint32_t size = std::min(_batch_size, _shuffle_size);
+  for (uint32_t index = 0; index < size; index++) {
+    // Draw a random record and fill its slot with the last one
+    auto drawn = static_cast<uint32_t>(_generator() % _shuffle_size);
+    auto last = _shuffle_size - 1;
+    auto drawn_input = _shuffle_inputs.begin() +
+                       static_cast<uint64_t>(drawn) * _input_dimension;
+    std::copy_n(drawn_input, _input_dimension,
+                _batch_inputs.begin() +
+                    static_cast<uint64_t>(index) * _input_dimension);
+    _batch_labels[index] = _shuffle_labels[drawn];
+
+    std::copy_n(_shuffle_inputs.begin() +
+                    static_cast<uint64_t>(last) * _input_dimension,
+                _input_dimension, drawn_input);
+    _shuffle_labels[drawn] = _shuffle_labels[last];
+    _shuffle_size--;
+  }
+  batch = {_batch_inputs.data(), _batch_labels.data(), size,
+           _input_dimension};
+  return true;
+}
+
+}  // namespace gladius::data
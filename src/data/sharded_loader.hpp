@@ -0,0 +1,140 @@
+#pragma once
+
+#include <src/data/batch_view.hpp>
+#include <src/data/mapped_file.hpp>
+#include <src/data/shard_writer.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace gladius::data {
+
+struct LoaderOptions {
+  // Threads that read and decompress blocks
+  uint32_t num_readers = 4;
+  // Number of records the batches are drawn from uniformly at random. Zero
+  // disables shuffling, in which case the records come in file order.
+  uint32_t shuffle_buffer_size = 0;
+  uint64_t seed = 0;
+  // Maximum number of decoded blocks waiting to be consumed
+  uint32_t prefetch_blocks = 8;
+};
+
+/**
+ * Streams batches out of a set of shards written by ShardWriter.
+ *
+ * The shards are memory-mapped, and reader threads decode their blocks
+ * ahead of the consumer, up to prefetch_blocks at a time. Uncompressed
+ * blocks are not copied: the readers only fault their pages in, and a batch
+ * that lies within a single block is a view into the mapping. Memory use is
+ * therefore bounded by the prefetch window and the shuffle buffer, no
+ * matter how large the dataset is.
+ *
+ * With shuffling, every epoch visits the blocks in a random order and draws
+ * the records of each batch from a shuffle buffer. Both only depend on the
+ * seed and the epoch number, since the decoded blocks are consumed in their
+ * epoch order whatever the number of readers, so an epoch can be replayed
+ * exactly.
+ */
+class ShardedLoader {
+ public:
+  ShardedLoader(const std::vector<std::string>& filenames,
+                uint32_t batch_size, LoaderOptions options = {});
+
+  ShardedLoader(const ShardedLoader&) = delete;
+  ShardedLoader& operator=(const ShardedLoader&) = delete;
+
+  ~ShardedLoader();
+
+  /**
+   * Restarts from the beginning of the given epoch. The constructor starts
+   * epoch zero.
+   */
+  void startEpoch(uint64_t epoch);
+
+  /**
+   * Returns false once every record of the epoch has been returned. The
+   * view stays valid until the next call to next() or startEpoch().
+   */
+  bool next(BatchView& batch);
+
+  inline uint64_t getRecordCount() const { return _record_count; }
+  inline uint32_t getInputDimension() const { return _input_dimension; }
+
+ private:
+  struct Shard {
+    std::unique_ptr<MappedFile> file;
+    ShardHeader header;
+    std::vector<BlockEntry> blocks;
+  };
+
+  struct BlockReference {
+    uint32_t shard;
+    uint32_t block;
+  };
+
+  struct DecodedBlock {
+    const float* inputs;
+    const uint32_t* labels;
+    uint32_t size;
+    // Holds the decompressed payload. Empty for uncompressed blocks, which
+    // point into the mapping.
+    std::vector<uint8_t> storage;
+  };
+
+  static Shard openShard(const std::string& filename);
+
+  void readerLoop();
+
+  std::unique_ptr<DecodedBlock> decode(BlockReference reference) const;
+
+  /**
+   * Returns the next block in epoch order, waiting for a reader if needed,
+   * or nullptr at the end of the epoch.
+   */
+  std::unique_ptr<DecodedBlock> takeBlock();
+
+  bool nextInOrder(BatchView& batch);
+  bool nextShuffled(BatchView& batch);
+
+  std::vector<Shard> _shards;
+  uint32_t _batch_size;
+  LoaderOptions _options;
+  uint32_t _input_dimension;
+  uint64_t _record_count = 0;
+
+  // Shared with the readers
+  std::mutex _mutex;
+  std::condition_variable _condition;
+  std::vector<BlockReference> _block_order;
+  uint64_t _next_to_decode = 0;
+  uint64_t _next_to_consume = 0;
+  std::unordered_map<uint64_t, std::unique_ptr<DecodedBlock>> _decoded;
+  // Incremented by startEpoch(), so that blocks decoded for a previous
+  // epoch are discarded
+  uint64_t _generation = 0;
+  bool _stopping = false;
+  // First error raised by a reader, rethrown by next()
+  std::exception_ptr _reader_error;
+
+  // Consumer state
+  std::unique_ptr<DecodedBlock> _current;
+  uint32_t _current_offset = 0;
+  std::vector<float> _batch_inputs;
+  std::vector<uint32_t> _batch_labels;
+  std::vector<float> _shuffle_inputs;
+  std::vector<uint32_t> _shuffle_labels;
+  uint32_t _shuffle_size = 0;
+  std::mt19937_64 _generator;
+
+  std::vector<std::thread> _readers;
+};
+
+}  // namespace gladius::data
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace gladius::transformer {
+
+/**
+ * Key/value cache used for autoregressive (token-by-token) decoding.
+ *
+ * Without a cache, generating token t requires recomputing the key and value
+ * projections of the entire prefix, which makes each decoding step O(t^2).
+ * The cache instead stores the projected keys and values of every token that
+ * has already been decoded so that a decoding step only projects the new
+ * token and attends over the cached history.
+ *
+ * All memory is allocated once in the constructor. For every layer and every
+ * head, keys (and values) live in a ring of `max_sequence_length` slots of
+ * `head_dimension` floats each, i.e., the layout is
+ *        [layer][head][slot][head_dimension]
+ * so that the history attended to by a single head is one contiguous block.
+ * Once the ring is full, new tokens overwrite the oldest ones, which turns the
+ * cache into a sliding attention window instead of growing without bound.
+ */
+class KVCache {
+ public:
+  KVCache(uint32_t num_layers, uint32_t num_heads, uint32_t head_dimension,
+          uint32_t max_sequence_length)
+      : _num_layers(num_layers),
+        _num_heads(num_heads),
+        _head_dimension(head_dimension),
+        _max_sequence_length(max_sequence_length),
+        _tokens_appended(num_layers, 0) {
+    if (!num_layers || !num_heads || !head_dimension || !max_sequence_length) {
+      throw std::invalid_argument(
+          "KVCache dimensions must all be positive. Got (num_layers=" +
+          std::to_string(num_layers) +
+          ", num_heads=" + std::to_string(num_heads) +
+          ", head_dimension=" + std::to_string(head_dimension) +
+          ", max_sequence_length=" + std::to_string(max_sequence_length) +
+          ").");
+    }
+    uint64_t total_elements = static_cast<uint64_t>(num_layers) * num_heads *
+                              max_sequence_length * head_dimension;
+    _keys = std::vector<float>(total_elements, 0.F);
+    _values = std::vector<float>(total_elements, 0.F);
+  }
+
+  KVCache(const KVCache&) = delete;
+  KVCache& operator=(const KVCache&) = delete;
+
+  /**
+   * Appends the key and value vectors of a single token for the given layer.
+   * Both vectors are expected to be the concatenation of the per-head
+   * projections, i.e., to have size num_heads * head_dimension.
+   */
+  void append(uint32_t layer, const std::vector<float>& key,
+              const std::vector<float>& value) {
+    checkLayer(layer);
+    uint64_t model_dimension =
+        static_cast<uint64_t>(_num_heads) * _head_dimension;
+    if (key.size() != model_dimension || value.size() != model_dimension) {
+      throw std::invalid_argument(
+          "KVCache expects key and value vectors of size " +
+          std::to_string(model_dimension) + ". Got key of size " +
+          std::to_string(key.size()) + " and value of size " +
+          std::to_string(value.size()) + ".");
+    }
+    uint32_t slot = _tokens_appended[layer] % _max_sequence_length;
+
+    for (uint32_t head = 0; head < _num_heads; head++) {
+      uint64_t source_offset = static_cast<uint64_t>(head) * _head_dimension;
+      uint64_t destination_offset = slotOffset(layer, head, slot);
+
+      std::copy_n(key.begin() + source_offset, _head_dimension,
+                  _keys.begin() + destination_offset);
+      std::copy_n(value.begin() + source_offset, _head_dimension,
+                  _values.begin() + destination_offset);
+    }
+    _tokens_appended[layer]++;
+  }
+
+  /**
+   * Returns a pointer to the first cached key of the given head. The cached
+   * keys are laid out contiguously, so the key in slot i starts at offset
+   * i * head_dimension.
+   */
+  const float* getKeys(uint32_t layer, uint32_t head) const {
+    checkLayer(layer);
+    return _keys.data() + slotOffset(layer, head, /* slot = */ 0);
+  }
+
+  const float* getValues(uint32_t layer, uint32_t head) const {
+    checkLayer(layer);
+    return _values.data() + slotOffset(layer, head, /* slot = */ 0);
+  }
+
+  /**
+   * Returns the number of tokens that can currently be attended to in the
+   * given layer. This never exceeds the maximum sequence length since older
+   * tokens are evicted once the ring is full.
+   */
+  uint32_t getCachedTokenCount(uint32_t layer) const {
+    checkLayer(layer);
+    return static_cast<uint32_t>(std::min<uint64_t>(_tokens_appended[layer],
+                                                    _max_sequence_length));
+  }
+
+  /**
+   * Returns the total number of tokens appended to the given layer since the
+   * last reset, including evicted ones. This is the absolute position of the
+   * next token in the sequence.
+   */
+  uint64_t getSequencePosition(uint32_t layer) const {
+    checkLayer(layer);
+    return _tokens_appended[layer];
+  }
+
+  /**
+   * Returns the number of bytes held by the cache. Since the cache is fully
+   * preallocated, this does not depend on how many tokens have been decoded.
+   */
+  uint64_t getMemoryFootprintBytes() const {
+    return (_keys.capacity() + _values.capacity()) * sizeof(float) +
+           _tokens_appended.capacity() * sizeof(uint64_t);
+  }
+
+  /**
+   * Forgets every cached token without releasing any memory so that the
+   * cache can be reused for a new sequence.
+   */
+  void reset() {
+    std::fill(_tokens_appended.begin(), _tokens_appended.end(), 0);
+  }
+
+  uint32_t getNumLayers() const { return _num_layers; }
+  uint32_t getNumHeads() const { return _num_heads; }
+  uint32_t getHeadDimension() const { return _head_dimension; }
+  uint32_t getMaxSequenceLength() const { return _max_sequence_length; }
+
+ private:
+  inline uint64_t slotOffset(uint32_t layer, uint32_t head,
+                             uint32_t slot) const {
+    assert(head < _num_heads);
+    return ((static_cast<uint64_t>(layer) * _num_heads + head) *
+                _max_sequence_length +
+            slot) *
+           _head_dimension;
+  }
+
+  inline void checkLayer(uint32_t layer) const {
+    if (layer >= _num_layers) {
+      throw std::invalid_argument("Invalid layer index " +
+                                  std::to_string(layer) +
+                                  " for a KVCache with " +
+                                  std::to_string(_num_layers) + " layers.");
+    }
+  }
+
+  uint32_t _num_layers;
+  uint32_t _num_heads;
+  uint32_t _head_dimension;
+  uint32_t _max_sequence_length;
+
+  std::vector<float> _keys;
+  std::vector<float> _values;
+  std::vector<uint64_t> _tokens_appended;
+};
+
+}  // namespace gladius::transformer
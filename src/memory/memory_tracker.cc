@@ -0,0 +1,215 @@
+#include <src/memory/memory_tracker.hpp>
+#include <algorithm>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <utility>
+
+namespace gladius::memory {
+
+struct Counter {
+  int64_t live_bytes = 0;
+  int64_t peak_bytes = 0;
+
+  inline void add(int64_t delta) {
+    live_bytes += delta;
+    peak_bytes = std::max(peak_bytes, live_bytes);
+  }
+
+  MemoryStatistics toStatistics() const {
+    return {static_cast<uint64_t>(std::max<int64_t>(live_bytes, 0)),
+            static_cast<uint64_t>(std::max<int64_t>(peak_bytes, 0))};
+  }
+};
+
+static std::mutex tracker_mutex;
+static Counter total_counter;
+static std::array<Counter, NUM_MEMORY_CATEGORIES> category_counters;
+static std::map<std::string, Counter> owner_counters;
+static std::optional<uint64_t> budget;
+
+const char* getCategoryName(MemoryCategory category) {
+  switch (category) {
+    case MemoryCategory::Parameters:
+      return "Parameters";
+    case MemoryCategory::Gradients:
+      return "Gradients";
+    case MemoryCategory::OptimizerState:
+      return "OptimizerState";
+    case MemoryCategory::Activations:
+      return "Activations";
+    case MemoryCategory::Jacobians:
+      return "Jacobians";
+    case MemoryCategory::Workspace:
+      return "Workspace";
+  }
+  return "Unknown";
+}
+
+static std::string formatBytes(uint64_t bytes) {
+  std::ostringstream stream;
+  stream << std::fixed << std::setprecision(2)
+         << static_cast<double>(bytes) / (1 << 20) << " MiB";
+  return stream.str();
+}
+
+void MemoryTracker::enable(std::optional<uint64_t> budget_bytes) {
+  std::lock_guard<std::mutex> lock(tracker_mutex);
+  total_counter = Counter();
+  category_counters.fill(Counter());
+  owner_counters.clear();
+  budget = budget_bytes;
+  _generation.fetch_add(1, std::memory_order_acq_rel);
+  _enabled.store(true, std::memory_order_relaxed);
+}
+
+void MemoryTracker::disable() {
+  _enabled.store(false, std::memory_order_relaxed);
+}
+
+void MemoryTracker::setBudget(std::optional<uint64_t> budget_bytes) {
+  std::lock_guard<std::mutex> lock(tracker_mutex);
+  budget = budget_bytes;
+}
+
+void MemoryTracker::resetPeaks() {
+  std::lock_guard<std::mutex> lock(tracker_mutex);
+  total_counter.peak_bytes = total_counter.live_bytes;
+  for (auto& counter : category_counters) {
+    counter.peak_bytes = counter.live_bytes;
+  }
+  for (auto& [owner, counter] : owner_counters) {
+    counter.peak_bytes = counter.live_bytes;
+  }
+}
+
+void MemoryTracker::update(const std::string& owner, MemoryCategory category,
+                           int64_t delta) {
+  std::lock_guard<std::mutex> lock(tracker_mutex);
+  total_counter.add(delta);
+  category_counters[static_cast<uint32_t>(category)].add(delta);
+  owner_counters[owner].add(delta);
+}
+
+MemorySnapshot MemoryTracker::snapshot() {
+  std::lock_guard<std::mutex> lock(tracker_mutex);
+  MemorySnapshot snapshot;
+  snapshot.total = total_counter.toStatistics();
+  for (uint32_t category = 0; category < NUM_MEMORY_CATEGORIES; category++) {
+    snapshot.categories[category] =
+        category_counters[category].toStatistics();
+  }
+  for (const auto& [owner, counter] : owner_counters) {
+    snapshot.owners[owner] = counter.toStatistics();
+  }
+  snapshot.budget_bytes = budget;
+  return snapshot;
+}
+
+void MemoryTracker::printSnapshot(std::ostream& stream) {
+  snapshot().print(stream);
+}
+
+void MemoryTracker::checkBudgetImpl() {
+  {
+    std::lock_guard<std::mutex> lock(tracker_mutex);
+    if (!budget.has_value() ||
+        total_counter.live_bytes <= static_cast<int64_t>(budget.value())) {
+      return;
+    }
+  }
+  auto current = snapshot();
+
+  std::vector<std::pair<std::string, MemoryStatistics>> owners(
+      current.owners.begin(), current.owners.end());
+  std::sort(owners.begin(), owners.end(),
+            [](const auto& left, const auto& right) {
+              return left.second.live_bytes > right.second.live_bytes;
+            });
+  owners.resize(std::min<uint64_t>(owners.size(), 3));
+
+  std::string message = "Exceeded the memory budget of " +
+                        formatBytes(current.budget_bytes.value()) + " with " +
+                        formatBytes(current.total.live_bytes) +
+                        " of tracked buffers. Largest consumers:";
+  for (const auto& [owner, statistics] : owners) {
+    message += " " + owner + " (" + formatBytes(statistics.live_bytes) + ")";
+  }
+  message += ".";
+  throw MemoryBudgetExceeded(message, std::move(current));
+}
+
+void MemorySnapshot::print(std::ostream& stream) const {
+  stream << "tracked memory: " << formatBytes(total.live_bytes) << " live, "
+         << formatBytes(total.peak_bytes) << " peak";
+  if (budget_bytes.has_value()) {
+    stream << ", budget " << formatBytes(budget_bytes.value());
+  }
+  stream << "\n";
+
+  auto print_row = [&](const std::string& name,
+                       const MemoryStatistics& statistics) {
+    stream << std::left << std::setw(26) << name << std::right << std::fixed
+           << std::setprecision(2) << std::setw(14)
+           << static_cast<double>(statistics.live_bytes) / (1 << 20)
+           << std::setw(14)
+           << static_cast<double>(statistics.peak_bytes) / (1 << 20) << "\n";
+  };
+
+  stream << std::left << std::setw(26) << "category" << std::right
+         << std::setw(14) << "live (MiB)" << std::setw(14) << "peak (MiB)"
+         << "\n";
+  for (uint32_t category = 0; category < NUM_MEMORY_CATEGORIES; category++) {
+    print_row(getCategoryName(static_cast<MemoryCategory>(category)),
+              categories[category]);
+  }
+
+  std::vector<std::pair<std::string, MemoryStatistics>> rows(owners.begin(),
+                                                             owners.end());
+  std::sort(rows.begin(), rows.end(), [](const auto& left, const auto& right) {
+    return left.second.peak_bytes > right.second.peak_bytes;
+  });
+  stream << std::left << std::setw(26) << "owner" << std::right
+         << std::setw(14) << "live (MiB)" << std::setw(14) << "peak (MiB)"
+         << "\n";
+  for (const auto& [owner, statistics] : rows) {
+    print_row(owner, statistics);
+  }
+}
+
+void TrackedBytes::set(const std::string& owner, MemoryCategory category,
+                       uint64_t bytes) {
+  if (!MemoryTracker::isEnabled()) {
+    return;
+  }
+  uint64_t generation = MemoryTracker::getGeneration();
+  if (_generation != generation) {
+    // Whatever was reported before the tracker was (re-)enabled has been
+    // dropped already
+    _bytes = 0;
+    _generation = generation;
+  }
+  if (_bytes && (category != _category || owner != _owner)) {
+    MemoryTracker::update(_owner, _category, -static_cast<int64_t>(_bytes));
+    _bytes = 0;
+  }
+  if (bytes != _bytes) {
+    MemoryTracker::update(
+        owner, category,
+        static_cast<int64_t>(bytes) - static_cast<int64_t>(_bytes));
+  }
+  if (_owner != owner) {
+    _owner = owner;
+  }
+  _category = category;
+  _bytes = bytes;
+}
+
+void TrackedBytes::releaseImpl() {
+  if (_generation == MemoryTracker::getGeneration()) {
+    MemoryTracker::update(_owner, _category, -static_cast<int64_t>(_bytes));
+  }
+  _bytes = 0;
+}
+
+}  // namespace gladius::memory
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace gladius::memory {
+
+/**
+ * What a tracked buffer holds:
+ *    - Parameters:     values of the parameters, including 16-bit copies
+ *    - Gradients:      gradients of the parameters and the gradients flowing
+ *                      through the vertices during the backward pass
+ *    - OptimizerState: per-parameter state kept by the trainer
+ *    - Activations:    outputs of the vertices and the values they keep for
+ *                      the backward pass
+ *    - Jacobians:      Jacobian matrices materialized by vertices
+ *    - Workspace:      scratch buffers, e.g., quantized inputs
+ */
+enum class MemoryCategory : uint8_t {
+  Parameters,
+  Gradients,
+  OptimizerState,
+  Activations,
+  Jacobians,
+  Workspace
+};
+
+static inline constexpr uint32_t NUM_MEMORY_CATEGORIES = 6;
+
+const char* getCategoryName(MemoryCategory category);
+
+struct MemoryStatistics {
+  uint64_t live_bytes = 0;
+  uint64_t peak_bytes = 0;
+};
+
+struct MemorySnapshot {
+  MemoryStatistics total;
+  std::array<MemoryStatistics, NUM_MEMORY_CATEGORIES> categories;
+  // Keyed by the type of the owner of the buffers, e.g., the name of a
+  // vertex or "Parameter"
+  std::map<std::string, MemoryStatistics> owners;
+  std::optional<uint64_t> budget_bytes;
+
+  /**
+   * Prints the live and peak bytes in total, by category and by owner, with
+   * the owners sorted by peak bytes.
+   */
+  void print(std::ostream& stream) const;
+};
+
+/**
+ * Thrown when the tracked bytes exceed the budget given to the tracker. The
+ * message includes the largest consumers at that point.
+ */
+class MemoryBudgetExceeded : public std::runtime_error {
+ public:
+  MemoryBudgetExceeded(const std::string& message, MemorySnapshot snapshot)
+      : std::runtime_error(message), _snapshot(std::move(snapshot)) {}
+
+  const MemorySnapshot& getSnapshot() const { return _snapshot; }
+
+ private:
+  MemorySnapshot _snapshot;
+};
+
+/**
+ * Opt-in accounting of the memory held by parameters, gradients, vertex
+ * buffers and optimizer state, tagged by category and by owner type.
+ *
+ * Owners report the current size of their buffers through TrackedBytes
+ * members, and the tracker keeps the live and peak bytes of every category
+ * and owner type. Parameters report their buffers when they are created,
+ * so the tracker must be enabled before building the model. Vertices report
+ * theirs after every forward and backward pass.
+ *
+ * With a budget, checkBudget() throws MemoryBudgetExceeded once the live
+ * bytes exceed it. The check runs after every vertex forward pass run by a
+ * Graph, before every optimizer step and after adding a parameter to a
+ * model, so that the error is raised at a point where it can be handled
+ * rather than while a buffer is being released. The budget applies to the
+ * tracked buffers only, not to the whole process.
+ *
+ * While disabled, reporting a buffer costs a single relaxed atomic load.
+ */
+class MemoryTracker {
+ public:
+  /**
+   * Starts tracking from zero. Buffers reported before this call are not
+   * accounted for.
+   */
+  static void enable(std::optional<uint64_t> budget_bytes = std::nullopt);
+  static void disable();
+  static inline bool isEnabled() {
+    return _enabled.load(std::memory_order_relaxed);
+  }
+
+  static void setBudget(std::optional<uint64_t> budget_bytes);
+
+  /**
+   * Resets the peaks to the bytes that are currently live
+   */
+  static void resetPeaks();
+
+  static MemorySnapshot snapshot();
+
+  static void printSnapshot(std::ostream& stream);
+
+  /**
+   * Throws MemoryBudgetExceeded if the live bytes exceed the budget
+   */
+  static inline void checkBudget() {
+    if (isEnabled()) {
+      checkBudgetImpl();
+    }
+  }
+
+  /**
+   * Adds `delta` bytes to the given owner type and category
+   */
+  static void update(const std::string& owner, MemoryCategory category,
+                     int64_t delta);
+
+  /**
+   * Incremented by every call to enable(). Buffers reported in an earlier
+   * generation are no longer accounted for.
+   */
+  static inline uint64_t getGeneration() {
+    return _generation.load(std::memory_order_acquire);
+  }
+
+ private:
+  static void checkBudgetImpl();
+
+  static inline std::atomic<bool> _enabled = false;
+  static inline std::atomic<uint64_t> _generation = 0;
+};
+
+/**
+ * The bytes reported to the tracker for one buffer (or a group of buffers).
+ * set() reports the difference with the previous size, and the destructor
+ * releases whatever is still reported.
+ */
+class TrackedBytes {
+ public:
+  TrackedBytes() = default;
+
+  TrackedBytes(const TrackedBytes&) = delete;
+  TrackedBytes& operator=(const TrackedBytes&) = delete;
+
+  TrackedBytes(TrackedBytes&& other) noexcept
+      : _owner(std::move(other._owner)),
+        _category(other._category),
+        _bytes(other._bytes),
+        _generation(other._generation) {
+    other._bytes = 0;
+  }
+
+  TrackedBytes& operator=(TrackedBytes&& other) noexcept {
+    if (this != &other) {
+      release();
+      _owner = std::move(other._owner);
+      _category = other._category;
+      _bytes = other._bytes;
+      _generation = other._generation;
+      other._bytes = 0;
+    }
+    return *this;
+  }
+
+  ~TrackedBytes() { release(); }
+
+  void set(const std::string& owner, MemoryCategory category, uint64_t bytes);
+
+  inline uint64_t getBytes() const { return _bytes; }
+
+ private:
+  inline void release() {
+    if (_bytes && MemoryTracker::isEnabled()) {
+      releaseImpl();
+    }
+  }
+  void releaseImpl();
+
+  std::string _owner;
+  MemoryCategory _category = MemoryCategory::Workspace;
+  uint64_t _bytes = 0;
+  uint64_t _generation = 0;
+};
+
+template <typename T>
+inline uint64_t bytesOf(const std::vector<T>& buffer) {
+  return buffer.capacity() * sizeof(T);
+}
+
+template <typename T>
+inline uint64_t bytesOf(const std::vector<std::vector<T>>& buffer) {
+  uint64_t bytes = buffer.capacity() * sizeof(std::vector<T>);
+  for (const auto& row : buffer) {
+    bytes += bytesOf(row);
+  }
+  return bytes;
+}
+
+template <typename T>
+inline uint64_t bytesOf(const std::optional<T>& buffer) {
+  return buffer.has_value() ? bytesOf(buffer.value()) : 0;
+}
+
+}  // namespace gladius::memory
@@ -0,0 +1,164 @@
+#include <src/memory/numa.hpp>
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace gladius::memory {
+
+static inline constexpr const char* SYSFS_NODE_ROOT =
+    "/sys/devices/system/node";
+
+std::vector<int> parseCPUList(const std::string& list) {
+  std::vector<int> cpus;
+  std::stringstream stream(list);
+  std::string range;
+  while (std::getline(stream, range, ',')) {
+    range.erase(std::remove_if(range.begin(), range.end(),
+                               [](unsigned char c) { return std::isspace(c); }),
+                range.end());
+    if (range.empty()) {
+      continue;
+    }
+    auto dash = range.find('-');
+    int first = std::stoi(range.substr(0, dash));
+    int last = dash == std::string::npos ? first
+                                         : std::stoi(range.substr(dash + 1));
+    for (int cpu = first; cpu <= last; cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+static std::string readLine(const std::string& path) {
+  std::ifstream file(path);
+  std::string line;
+  std::getline(file, line);
+  return line;
+}
+
+const NumaTopology& NumaTopology::get() {
+  static const NumaTopology topology = load(SYSFS_NODE_ROOT);
+  return topology;
+}
+
+NumaTopology NumaTopology::load(const std::string& sysfs_root) {
+  NumaTopology topology;
+  for (int node : parseCPUList(readLine(sysfs_root + "/online"))) {
+    topology._node_ids.push_back(node);
+    topology._node_cpus.push_back(parseCPUList(readLine(
+        sysfs_root + "/node" + std::to_string(node) + "/cpulist")));
+  }
+  if (topology._node_ids.empty()) {
+    // No NUMA support: a single node whose CPUs are unknown
+    topology._node_ids.push_back(0);
+    topology._node_cpus.emplace_back();
+  }
+  return topology;
+}
+
+uint32_t NumaTopology::getNodeOfCPU(int cpu) const {
+  for (uint32_t index = 0; index < getNumNodes(); index++) {
+    const auto& cpus = _node_cpus[index];
+    if (std::find(cpus.begin(), cpus.end(), cpu) != cpus.end()) {
+      return index;
+    }
+  }
+  return 0;
+}
+
+std::vector<int> NumaTopology::spreadOverNodes(
+    const std::vector<int>& cpus) const {
+  std::vector<std::vector<int>> node_cpus(getNumNodes());
+  for (int cpu : cpus) {
+    node_cpus[getNodeOfCPU(cpu)].push_back(cpu);
+  }
+  std::vector<int> spread;
+  for (uint32_t rank = 0; spread.size() < cpus.size(); rank++) {
+    for (const auto& node : node_cpus) {
+      if (rank < node.size()) {
+        spread.push_back(node[rank]);
+      }
+    }
+  }
+  return spread;
+}
+
+#ifdef __linux__
+// Bit mask of every node of the topology, in the format of the kernel
+struct NodeMask {
+  using Word = unsigned long;
+  static inline constexpr uint32_t BITS = 8 * sizeof(Word);
+
+  explicit NodeMask(const NumaTopology& topology) {
+    for (uint32_t index = 0; index < topology.getNumNodes(); index++) {
+      uint32_t node = topology.getNodeId(index);
+      words.resize(std::max<size_t>(words.size(), node / BITS + 1), 0);
+      words[node / BITS] |= Word(1) << (node % BITS);
+    }
+  }
+
+  // The kernel reads maxnode - 1 bits
+  inline uint64_t getMaxNode() const { return words.size() * BITS + 1; }
+
+  std::vector<Word> words;
+};
+#endif
+
+void NumaPolicy::enable(NumaPlacement placement) {
+  _placement.store(placement, std::memory_order_relaxed);
+}
+
+void NumaPolicy::disable() {
+  _placement.store(NumaPlacement::FirstTouch, std::memory_order_relaxed);
+}
+
+bool NumaPolicy::place(const void* data, uint64_t bytes) {
+  const auto& topology = NumaTopology::get();
+  if (getPlacement() == NumaPlacement::FirstTouch || !topology.isMultiNode() ||
+      bytes == 0) {
+    return true;
+  }
+#ifdef __linux__
+  static const uint64_t page_size = sysconf(_SC_PAGESIZE);
+  auto start = reinterpret_cast<uintptr_t>(data);
+  uintptr_t page_start = start & ~(page_size - 1);
+  NodeMask mask(topology);
+  return syscall(SYS_mbind, page_start, start + bytes - page_start,
+                 MPOL_INTERLEAVE, mask.words.data(), mask.getMaxNode(),
+                 MPOL_MF_MOVE) == 0;
+#else
+  return false;
+#endif
+}
+
+NumaPlacementScope::NumaPlacementScope() {
+  const auto& topology = NumaTopology::get();
+  if (NumaPolicy::getPlacement() == NumaPlacement::FirstTouch ||
+      !topology.isMultiNode()) {
+    return;
+  }
+#ifdef __linux__
+  NodeMask mask(topology);
+  _active = syscall(SYS_set_mempolicy, MPOL_INTERLEAVE, mask.words.data(),
+                    mask.getMaxNode()) == 0;
+#endif
+}
+
+NumaPlacementScope::~NumaPlacementScope() {
+#ifdef __linux__
+  if (_active) {
+    // Back to the default policy of the kernel, i.e., first touch
+    syscall(SYS_set_mempolicy, MPOL_DEFAULT, nullptr, 0);
+  }
+#endif
+}
+
+}  // namespace gladius::memory
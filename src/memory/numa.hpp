@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gladius::memory {
+
+/**
+ * Where the buffers of the parameters live on a multi-socket host:
+ *    - FirstTouch: the default policy of the kernel, i.e., on the node of
+ *                  the thread that first writes them, usually the one that
+ *                  built the model
+ *    - Interleave: pages spread round-robin over every node, so that all
+ *                  memory controllers serve the threads of every node
+ */
+enum class NumaPlacement : uint8_t { FirstTouch, Interleave };
+
+/**
+ * The NUMA nodes of the host and their CPUs, read from sysfs. Hosts without
+ * NUMA support appear as a single node holding every CPU.
+ */
+class NumaTopology {
+ public:
+  /**
+   * The topology of the host, read once
+   */
+  static const NumaTopology& get();
+
+  /**
+   * Reads the topology from `sysfs_root`, the directory that holds the
+   * `online` file and one `node<N>/cpulist` per node
+   */
+  static NumaTopology load(const std::string& sysfs_root);
+
+  inline uint32_t getNumNodes() const { return _node_cpus.size(); }
+
+  inline bool isMultiNode() const { return getNumNodes() > 1; }
+
+  /**
+   * Id of the i-th node, which may differ from i on hosts whose nodes are
+   * numbered sparsely
+   */
+  inline uint32_t getNodeId(uint32_t index) const { return _node_ids[index]; }
+
+  inline const std::vector<int>& getNodeCPUs(uint32_t index) const {
+    return _node_cpus[index];
+  }
+
+  /**
+   * Index of the node that holds `cpu`, or 0 if it is unknown
+   */
+  uint32_t getNodeOfCPU(int cpu) const;
+
+  /**
+   * Orders `cpus` by taking one CPU of every node in turn, so that the
+   * first k CPUs are spread evenly over the nodes
+   */
+  std::vector<int> spreadOverNodes(const std::vector<int>& cpus) const;
+
+ private:
+  std::vector<uint32_t> _node_ids;
+  std::vector<std::vector<int>> _node_cpus;
+};
+
+/**
+ * Parses a sysfs CPU or node list such as "0-3,8,10-11"
+ */
+std::vector<int> parseCPUList(const std::string& list);
+
+/**
+ * Places the parameters of the models built after enable() according to a
+ * NumaPlacement, through the mbind and set_mempolicy system calls (no
+ * libnuma needed).
+ *
+ * With Interleave, Model::addParameter allocates under an interleaved
+ * memory policy, and every Parameter moves the pages of its values and
+ * gradient (including the ones first touched by another thread) to an
+ * interleaved placement. Pinned ThreadPool workers are spread over the
+ * nodes independently of the placement.
+ *
+ * On hosts with a single node, or without NUMA support in the kernel,
+ * placing memory does nothing.
+ */
+class NumaPolicy {
+ public:
+  static void enable(NumaPlacement placement);
+  static void disable();
+
+  static inline NumaPlacement getPlacement() {
+    return _placement.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Applies the placement to the pages spanned by [data, data + bytes).
+   * Pages shared with neighbouring buffers are placed as well. Returns false
+   * if the kernel refused the placement.
+   */
+  static bool place(const void* data, uint64_t bytes);
+
+ private:
+  static inline std::atomic<NumaPlacement> _placement =
+      NumaPlacement::FirstTouch;
+};
+
+/**
+ * Sets the memory policy of the calling thread to the placement of the
+ * NumaPolicy for its lifetime, so that the pages first touched in its scope
+ * are placed without being moved afterwards.
+ */
+class NumaPlacementScope {
+ public:
+  NumaPlacementScope();
+  ~NumaPlacementScope();
+
+  NumaPlacementScope(const NumaPlacementScope&) = delete;
+  NumaPlacementScope& operator=(const NumaPlacementScope&) = delete;
+
+ private:
+  bool _active = false;
+};
+
+}  // namespace gladius::memory
@@ -0,0 +1,117 @@
+#include <src/memory/spill_file.hpp>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+namespace gladius::memory {
+
+static inline uint64_t alignUp(uint64_t bytes) {
+  return (bytes + SPILL_ALIGNMENT - 1) / SPILL_ALIGNMENT * SPILL_ALIGNMENT;
+}
+
+SpillFile::SpillFile(const std::string& directory) {
+  std::string path = directory + "/gladius-spill-XXXXXX";
+  _descriptor = mkstemp(path.data());
+  if (_descriptor < 0) {
+    throw std::runtime_error("Unable to create a spill file in " + directory +
+                             ".");
+  }
+  // Only the descriptor refers to the file from now on
+  unlink(path.c_str());
+#ifdef O_DIRECT
+  int flags = fcntl(_descriptor, F_GETFL);
+  _direct = flags >= 0 && fcntl(_descriptor, F_SETFL, flags | O_DIRECT) == 0;
+#endif
+}
+
+SpillFile::~SpillFile() { close(_descriptor); }
+
+void SpillFile::AlignedDeleter::operator()(uint8_t* buffer) const {
+  std::free(buffer);
+}
+
+uint64_t SpillFile::allocate(uint64_t bytes) {
+  return _end.fetch_add(alignUp(bytes), std::memory_order_relaxed);
+}
+
+void SpillFile::reset() {
+  _end.store(0, std::memory_order_relaxed);
+  // Gives the blocks back to the file system
+  if (ftruncate(_descriptor, 0) != 0) {
+    throw std::runtime_error("Unable to truncate the spill file.");
+  }
+}
+
+uint8_t* SpillFile::bounceBuffer(uint64_t bytes) {
+  if (bytes > _bounce_capacity) {
+    void* buffer = std::aligned_alloc(SPILL_ALIGNMENT, bytes);
+    if (buffer == nullptr) {
+      throw std::bad_alloc();
+    }
+    _bounce_buffer.reset(static_cast<uint8_t*>(buffer));
+    _bounce_capacity = bytes;
+  }
+  return _bounce_buffer.get();
+}
+
+void SpillFile::write(uint64_t offset, const void* data, uint64_t bytes) {
+  const auto* source = static_cast<const uint8_t*>(data);
+  uint64_t length = bytes;
+  if (_direct) {
+    // O_DIRECT needs aligned addresses, offsets and lengths
+    length = alignUp(bytes);
+    uint8_t* buffer = bounceBuffer(length);
+    std::memcpy(buffer, data, bytes);
+    std::memset(buffer + bytes, 0, length - bytes);
+    source = buffer;
+  }
+  for (uint64_t written = 0; written < length;) {
+    ssize_t result = pwrite(_descriptor, source + written, length - written,
+                            offset + written);
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+    if (result <= 0) {
+      throw std::runtime_error("Unable to write " + std::to_string(bytes) +
+                               " bytes to the spill file.");
+    }
+    written += result;
+  }
+  if (!_direct) {
+    // Written back right away, so that the cached pages can be dropped
+    fdatasync(_descriptor);
+    posix_fadvise(_descriptor, offset, length, POSIX_FADV_DONTNEED);
+  }
+}
+
+void SpillFile::read(uint64_t offset, void* data, uint64_t bytes) {
+  auto* destination = static_cast<uint8_t*>(data);
+  uint64_t length = bytes;
+  if (_direct) {
+    length = alignUp(bytes);
+    destination = bounceBuffer(length);
+  }
+  for (uint64_t read_bytes = 0; read_bytes < length;) {
+    ssize_t result = pread(_descriptor, destination + read_bytes,
+                           length - read_bytes, offset + read_bytes);
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+    if (result <= 0) {
+      throw std::runtime_error("Unable to read " + std::to_string(bytes) +
+                               " bytes from the spill file.");
+    }
+    read_bytes += result;
+  }
+  if (_direct) {
+    std::memcpy(data, destination, bytes);
+  } else {
+    posix_fadvise(_descriptor, offset, length, POSIX_FADV_DONTNEED);
+  }
+}
+
+}  // namespace gladius::memory
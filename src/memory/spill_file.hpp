@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace gladius::memory {
+
+/**
+ * Alignment of the regions of a SpillFile, a multiple of the logical block
+ * size of common file systems as required by O_DIRECT
+ */
+static inline constexpr uint64_t SPILL_ALIGNMENT = 4096;
+
+/**
+ * Scratch file for buffers that do not fit in memory, e.g., activations
+ * offloaded until the backward pass. The file is created in `directory` and
+ * unlinked right away, so it goes away with the process.
+ *
+ * Regions are appended at aligned offsets, and reads and writes bypass the
+ * page cache with O_DIRECT where the file system supports it (tmpfs does
+ * not), so that spilled buffers do not take the memory they were moved out
+ * of. Otherwise, written pages are dropped from the cache after every
+ * write. Except for allocate(), the methods must be called from a single
+ * thread at a time, e.g., a dedicated I/O thread.
+ */
+class SpillFile {
+ public:
+  explicit SpillFile(const std::string& directory = "/tmp");
+
+  SpillFile(const SpillFile&) = delete;
+  SpillFile& operator=(const SpillFile&) = delete;
+
+  ~SpillFile();
+
+  /**
+   * Reserves a region of `bytes` and returns its offset. Thread-safe.
+   */
+  uint64_t allocate(uint64_t bytes);
+
+  /**
+   * Forgets every region, so that the space is reused by the next
+   * allocations
+   */
+  void reset();
+
+  void write(uint64_t offset, const void* data, uint64_t bytes);
+
+  void read(uint64_t offset, void* data, uint64_t bytes);
+
+  inline bool isDirect() const { return _direct; }
+
+  /**
+   * The bytes reserved since the last reset
+   */
+  inline uint64_t getAllocatedBytes() const {
+    return _end.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct AlignedDeleter {
+    void operator()(uint8_t* buffer) const;
+  };
+
+  // Grows the bounce buffer used for O_DIRECT to at least `bytes`
+  uint8_t* bounceBuffer(uint64_t bytes);
+
+  int _descriptor = -1;
+  bool _direct = false;
+  std::atomic<uint64_t> _end = 0;
+  std::unique_ptr<uint8_t, AlignedDeleter> _bounce_buffer;
+  uint64_t _bounce_capacity = 0;
+};
+
+}  // namespace gladius::memory
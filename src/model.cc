@@ -1,9 +1,11 @@
 #include <cereal/archives/binary.hpp>
-#include <_types/_uint32_t.h>
+#include <src/memory/memory_tracker.hpp>
+#include <src/memory/numa.hpp>
 #include <src/model.hpp>
 #include <src/params/parameters.hpp>
 #include <src/utils.hpp>
 #include <algorithm>
+#include <cstdint>
 #include <fstream>
 #include <iterator>
 #include <random>
@@ -14,6 +16,8 @@ namespace gladius {
 // TODO(blaise): Parallelize this implementation with OpenMP
 void Model::addParameter(const std::vector<uint32_t>&& dimensions) {
   assert(!dimensions.empty());
+  // The initial values are written under the placement of the NumaPolicy
+  memory::NumaPlacementScope placement_scope;
 
   std::optional<uint32_t> vector_count = std::nullopt;
   if (dimensions.size() == 2) {
@@ -26,6 +30,7 @@ void Model::addParameter(const std::vector<uint32_t>&& dimensions) {
     // Initialize the bias parameter
     std::vector<float> bias(vector_dimension, 0.F);
     _parameters.emplace_back(new Parameter({bias}));
+    memory::MemoryTracker::checkBudget();
     return;
   }
   // Initialize the weight parameter
@@ -49,6 +54,7 @@ void Model::addParameter(const std::vector<uint32_t>&& dimensions) {
   }
 
   _parameters.emplace_back(new Parameter(std::move(parameter_vectors)));
+  memory::MemoryTracker::checkBudget();
 
 }
 
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <src/parallel/thread_pool.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <omp.h>
+#include <utility>
+#include <vector>
+
+namespace gladius::parallel {
+
+/**
+ * Rough number of scalar operations below which a task costs less than
+ * handing it to another thread (waking it, stealing and joining), i.e., a
+ * few microseconds of work
+ */
+static inline constexpr uint64_t MIN_TASK_WORK = 1 << 14;
+
+// Tasks per thread, so that threads that finish early steal the rest
+static inline constexpr uint64_t TASKS_PER_THREAD = 4;
+
+/**
+ * The grain size of a loop whose iterations each perform about
+ * `work_per_iteration` scalar operations
+ */
+inline uint64_t grainSize(uint64_t work_per_iteration) {
+  return std::max<uint64_t>(
+      1, MIN_TASK_WORK / std::max<uint64_t>(work_per_iteration, 1));
+}
+
+/**
+ * Calls `body(chunk_begin, chunk_end)` on disjoint chunks covering
+ * [begin, end), concurrently on `pool`. Chunks hold at least `grain_size`
+ * iterations and there are at most TASKS_PER_THREAD of them per thread.
+ *
+ * The loop runs serially, as a single call to `body(begin, end)`, when it
+ * has at most `grain_size` iterations, when the pool has a single thread,
+ * and when the cores are already taken: from a task of a pool (e.g., a
+ * vertex run by the GraphExecutor or an enclosing parallelFor), from an
+ * OpenMP parallel region and while the pool runs the job of another thread
+ * (e.g., another data-parallel trainer).
+ */
+template <typename Body>
+void parallelFor(uint64_t begin, uint64_t end, Body&& body,
+                 uint64_t grain_size = MIN_TASK_WORK,
+                 ThreadPool& pool = ThreadPool::global()) {
+  if (begin >= end) {
+    return;
+  }
+  uint64_t iterations = end - begin;
+  grain_size = std::max<uint64_t>(grain_size, 1);
+  if (iterations > grain_size && pool.getNumThreads() > 1 &&
+      !ThreadPool::isInsideTask() && !omp_in_parallel()) {
+    uint64_t num_chunks =
+        std::min((iterations + grain_size - 1) / grain_size,
+                 pool.getNumThreads() * TASKS_PER_THREAD);
+    uint64_t chunk_size = (iterations + num_chunks - 1) / num_chunks;
+    num_chunks = (iterations + chunk_size - 1) / chunk_size;
+
+    class ChunkJob final : public Job {
+     public:
+      ChunkJob(uint64_t begin, uint64_t end, uint64_t chunk_size, Body& body)
+          : _begin(begin), _end(end), _chunk_size(chunk_size), _body(body) {}
+
+      void execute(uint32_t chunk) final {
+        uint64_t chunk_begin = _begin + chunk * _chunk_size;
+        _body(chunk_begin, std::min(chunk_begin + _chunk_size, _end));
+      }
+
+     private:
+      uint64_t _begin, _end, _chunk_size;
+      Body& _body;
+    };
+
+    ChunkJob job(begin, end, chunk_size, body);
+    std::vector<uint32_t> chunks(num_chunks);
+    for (uint32_t chunk = 0; chunk < num_chunks; chunk++) {
+      // Pushed in reverse so that the calling thread pops the first chunk
+      chunks[chunk] = num_chunks - 1 - chunk;
+    }
+    if (pool.tryRun(job, chunks)) {
+      return;
+    }
+  }
+  body(begin, end);
+}
+
+}  // namespace gladius::parallel
@@ -0,0 +1,269 @@
+#include <src/memory/numa.hpp>
+#include <src/parallel/thread_pool.hpp>
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace gladius::parallel {
+
+// Failed attempts to find a task before a worker naps
+static inline constexpr uint32_t SPIN_ATTEMPTS = 64;
+static inline constexpr std::chrono::microseconds NAP_DURATION(100);
+
+struct WorkerContext {
+  ThreadPool* pool = nullptr;
+  uint32_t index = 0;
+  bool inside_task = false;
+};
+
+static thread_local WorkerContext worker_context;
+
+struct GlobalConfiguration {
+  uint32_t num_threads;
+  bool pin_threads;
+};
+
+static std::mutex global_mutex;
+static std::optional<GlobalConfiguration> global_configuration;
+static bool global_created = false;
+
+#ifdef __linux__
+// The CPUs the process may run on, in increasing order
+static std::vector<int> allowedCPUs() {
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  std::vector<int> cpus;
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+    return cpus;
+  }
+  for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if (CPU_ISSET(cpu, &allowed)) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+#endif
+
+ThreadPool::ThreadPool(uint32_t num_threads, bool pin_threads)
+    : _num_threads(std::max<uint32_t>(num_threads, 1)),
+      _pin_threads(pin_threads) {
+  for (uint32_t index = 0; index < _num_threads; index++) {
+    _workers.push_back(std::make_unique<Worker>());
+  }
+  for (uint32_t index = 1; index < _num_threads; index++) {
+    _threads.emplace_back([this, index] { workerLoop(index); });
+  }
+#ifdef __linux__
+  if (_pin_threads) {
+    auto cpus = memory::NumaTopology::get().spreadOverNodes(allowedCPUs());
+    for (uint32_t index = 1; index < _num_threads && !cpus.empty(); index++) {
+      cpu_set_t cpu;
+      CPU_ZERO(&cpu);
+      CPU_SET(cpus[index % cpus.size()], &cpu);
+      // Pinning is an optimization, so failures are ignored
+      pthread_setaffinity_np(_threads[index - 1].native_handle(), sizeof(cpu),
+                             &cpu);
+    }
+  }
+#endif
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(_wake_mutex);
+    _stopping = true;
+  }
+  _wake.notify_all();
+  for (auto& thread : _threads) {
+    thread.join();
+  }
+}
+
+ThreadPool& ThreadPool::global() {
+  static std::unique_ptr<ThreadPool> pool = [] {
+    std::lock_guard<std::mutex> lock(global_mutex);
+    global_created = true;
+#ifdef _OPENMP
+    GlobalConfiguration configuration{
+        static_cast<uint32_t>(omp_get_max_threads()), false};
+#else
+    GlobalConfiguration configuration{std::thread::hardware_concurrency(),
+                                      false};
+#endif
+    configuration = global_configuration.value_or(configuration);
+    return std::make_unique<ThreadPool>(configuration.num_threads,
+                                        configuration.pin_threads);
+  }();
+  return *pool;
+}
+
+void ThreadPool::configureGlobal(uint32_t num_threads, bool pin_threads) {
+  std::lock_guard<std::mutex> lock(global_mutex);
+  if (global_created) {
+    throw std::logic_error(
+        "The global ThreadPool must be configured before its first use.");
+  }
+  global_configuration = GlobalConfiguration{num_threads, pin_threads};
+}
+
+bool ThreadPool::isInsideTask() { return worker_context.inside_task; }
+
+void ThreadPool::run(Job& job, const std::vector<uint32_t>& initial_tasks) {
+  if (worker_context.inside_task) {
+    throw std::logic_error(
+        "A ThreadPool job cannot be started from a task.");
+  }
+  std::lock_guard<std::mutex> run_lock(_run_mutex);
+  runLocked(job, initial_tasks);
+}
+
+bool ThreadPool::tryRun(Job& job, const std::vector<uint32_t>& initial_tasks) {
+  if (worker_context.inside_task) {
+    throw std::logic_error(
+        "A ThreadPool job cannot be started from a task.");
+  }
+  std::unique_lock<std::mutex> run_lock(_run_mutex, std::try_to_lock);
+  if (!run_lock.owns_lock()) {
+    return false;
+  }
+  runLocked(job, initial_tasks);
+  return true;
+}
+
+void ThreadPool::runLocked(Job& job,
+                           const std::vector<uint32_t>& initial_tasks) {
+  if (initial_tasks.empty()) {
+    return;
+  }
+  _job = &job;
+  _failed.store(false, std::memory_order_relaxed);
+  _error = nullptr;
+  _pending_tasks.store(initial_tasks.size(), std::memory_order_relaxed);
+  for (uint32_t task : initial_tasks) {
+    _workers[0]->deque.push(task);
+  }
+  auto previous_context = worker_context;
+  worker_context = {this, 0, false};
+  {
+    std::lock_guard<std::mutex> lock(_wake_mutex);
+    _generation++;
+    _job_active = true;
+  }
+  _wake.notify_all();
+
+  participate(0);
+
+  {
+    // No worker joins the job after this point
+    std::lock_guard<std::mutex> lock(_wake_mutex);
+    _job_active = false;
+  }
+  while (_busy_workers.load(std::memory_order_acquire) != 0) {
+    std::this_thread::yield();
+  }
+  worker_context = previous_context;
+  _job = nullptr;
+
+  if (_error) {
+    std::rethrow_exception(std::exchange(_error, nullptr));
+  }
+}
+
+void ThreadPool::schedule(uint32_t task) {
+  if (worker_context.pool != this || !worker_context.inside_task) {
+    throw std::logic_error(
+        "ThreadPool::schedule must be called from a task of the same pool.");
+  }
+  _pending_tasks.fetch_add(1, std::memory_order_relaxed);
+  _workers[worker_context.index]->deque.push(task);
+  if (_napping_workers.load(std::memory_order_relaxed) != 0) {
+    _nap.notify_one();
+  }
+}
+
+void ThreadPool::workerLoop(uint32_t index) {
+  worker_context = {this, index, false};
+  uint64_t seen_generation = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(_wake_mutex);
+      _wake.wait(lock, [&] {
+        return _stopping || (_job_active && _generation != seen_generation);
+      });
+      if (_stopping) {
+        return;
+      }
+      seen_generation = _generation;
+      _busy_workers.fetch_add(1, std::memory_order_acq_rel);
+    }
+    participate(index);
+    _busy_workers.fetch_sub(1, std::memory_order_acq_rel);
+  }
+}
+
+void ThreadPool::participate(uint32_t index) {
+  std::minstd_rand generator(index + 1);
+  uint32_t failed_attempts = 0;
+  while (_pending_tasks.load(std::memory_order_acquire) != 0) {
+    auto task = _workers[index]->deque.pop();
+    if (!task && _num_threads > 1) {
+      uint32_t first_victim = generator() % _num_threads;
+      for (uint32_t offset = 0; offset < _num_threads && !task; offset++) {
+        uint32_t victim = (first_victim + offset) % _num_threads;
+        if (victim != index) {
+          task = _workers[victim]->deque.steal();
+        }
+      }
+    }
+    if (task) {
+      failed_attempts = 0;
+      executeTask(*task);
+      continue;
+    }
+    if (++failed_attempts < SPIN_ATTEMPTS) {
+      std::this_thread::yield();
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(_nap_mutex);
+    _napping_workers.fetch_add(1, std::memory_order_relaxed);
+    _nap.wait_for(lock, NAP_DURATION);
+    _napping_workers.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+void ThreadPool::executeTask(uint32_t task) {
+  _running_tasks.fetch_add(1, std::memory_order_relaxed);
+  if (!_failed.load(std::memory_order_relaxed)) {
+    worker_context.inside_task = true;
+    try {
+      _job->execute(task);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(_error_mutex);
+      if (!_error) {
+        _error = std::current_exception();
+      }
+      _failed.store(true, std::memory_order_relaxed);
+    }
+    worker_context.inside_task = false;
+  }
+  _running_tasks.fetch_sub(1, std::memory_order_relaxed);
+  if (_pending_tasks.fetch_sub(1, std::memory_order_acq_rel) == 1 &&
+      _napping_workers.load(std::memory_order_relaxed) != 0) {
+    _nap.notify_all();
+  }
+}
+
+}  // namespace gladius::parallel
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <src/parallel/work_stealing_deque.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gladius::parallel {
+
+/**
+ * A set of tasks, identified by 32-bit ids, run by a ThreadPool. Running a
+ * task may schedule more tasks of the same job (see ThreadPool::schedule),
+ * e.g., the vertices whose inputs are all computed.
+ */
+class Job {
+ public:
+  virtual ~Job() = default;
+
+  virtual void execute(uint32_t task) = 0;
+};
+
+/**
+ * Work-stealing thread pool. Every thread owns a WorkStealingDeque: tasks
+ * scheduled by a task go to the deque of the thread running it and are
+ * popped in LIFO order, which keeps the data they share in its caches,
+ * while idle threads steal the oldest tasks of the others.
+ *
+ * The pool runs one job at a time, and the thread that calls run() works
+ * on the job as well, so a pool of N threads starts N - 1 workers. Between
+ * jobs, the workers sleep on a condition variable. During a job, a worker
+ * that finds no task spins for a short while and then naps until a task is
+ * scheduled, so that it does not take cores away from the intra-op
+ * parallelism of the running tasks.
+ *
+ * With `pin_threads`, worker i is pinned to the i-th CPU the process may
+ * run on (modulo their count), which keeps a worker's stolen tasks next to
+ * its caches. The CPUs are taken from every NUMA node in turn, so a pool
+ * smaller than the host uses the memory bandwidth of every socket. The
+ * thread that calls run() is left alone. Note that OpenMP teams forked from
+ * a pinned worker inherit its single-CPU mask, so pinning suits pools whose
+ * tasks are not OpenMP kernels themselves.
+ */
+class ThreadPool {
+ public:
+  explicit ThreadPool(uint32_t num_threads, bool pin_threads = false);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /**
+   * The pool shared by the library. Unless configureGlobal() was called, it
+   * is sized to the core budget given by omp_get_max_threads() (i.e.,
+   * OMP_NUM_THREADS if set) when first used, and its workers are not pinned.
+   */
+  static ThreadPool& global();
+
+  /**
+   * Sets the size and pinning of the global pool. Must be called before the
+   * global pool is first used, e.g., at the start of main().
+   */
+  static void configureGlobal(uint32_t num_threads, bool pin_threads);
+
+  inline uint32_t getNumThreads() const { return _num_threads; }
+
+  inline bool areThreadsPinned() const { return _pin_threads; }
+
+  /**
+   * Runs `job` on the pool and the calling thread, starting with
+   * `initial_tasks`, and returns once every task scheduled for it has run.
+   * If a task throws, the tasks that have not started are skipped and the
+   * first exception is rethrown here. Must not be called from a task.
+   */
+  void run(Job& job, const std::vector<uint32_t>& initial_tasks);
+
+  /**
+   * Like run(), but returns false without running anything if the pool is
+   * running the job of another thread, so that the caller can run its
+   * tasks on its own instead of waiting
+   */
+  bool tryRun(Job& job, const std::vector<uint32_t>& initial_tasks);
+
+  /**
+   * Schedules another task of the running job. Must be called from a task
+   * of that job.
+   */
+  void schedule(uint32_t task);
+
+  /**
+   * The number of tasks of the running job that are executing right now
+   */
+  inline uint32_t getRunningTasks() const {
+    return _running_tasks.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Returns true if the calling thread is running a task of any pool
+   */
+  static bool isInsideTask();
+
+ private:
+  struct Worker {
+    WorkStealingDeque<uint32_t> deque;
+  };
+
+  void workerLoop(uint32_t index);
+
+  // Expects _run_mutex to be held
+  void runLocked(Job& job, const std::vector<uint32_t>& initial_tasks);
+
+  // Runs and steals tasks until no task of the job is left
+  void participate(uint32_t index);
+
+  void executeTask(uint32_t task);
+
+  uint32_t _num_threads;
+  bool _pin_threads;
+  // Index 0 belongs to the thread that calls run()
+  std::vector<std::unique_ptr<Worker>> _workers;
+  std::vector<std::thread> _threads;
+
+  // Serializes the jobs
+  std::mutex _run_mutex;
+
+  std::mutex _wake_mutex;
+  std::condition_variable _wake;
+  uint64_t _generation = 0;
+  bool _job_active = false;
+  bool _stopping = false;
+
+  Job* _job = nullptr;
+  // Tasks scheduled but not finished
+  std::atomic<uint64_t> _pending_tasks = 0;
+  std::atomic<uint32_t> _running_tasks = 0;
+  // Workers that joined the current job
+  std::atomic<uint32_t> _busy_workers = 0;
+
+  std::mutex _nap_mutex;
+  std::condition_variable _nap;
+  std::atomic<uint32_t> _napping_workers = 0;
+
+  std::atomic<bool> _failed = false;
+  std::exception_ptr _error;
+  std::mutex _error_mutex;
+};
+
+}  // namespace gladius::parallel
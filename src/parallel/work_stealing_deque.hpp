@@ -0,0 +1,153 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace gladius::parallel {
+
+/**
+ * Chase-Lev work-stealing deque [1], with the memory orderings of the C11
+ * formulation in [2]. The owner thread pushes and pops at the bottom, in
+ * LIFO order, while any other thread may steal from the top. Only steals
+ * and the pop of the last item synchronize through a CAS, so the owner
+ * pays no atomic read-modify-write in the common case.
+ *
+ * The circular buffer doubles when it is full. Retired buffers are kept
+ * until the deque is destroyed since a thief may still be reading from
+ * them, which bounds the extra memory by the size of the current buffer.
+ *
+ * [1] D. Chase and Y. Lev. Dynamic circular work-stealing deque. SPAA 2005.
+ * [2] N. M. Le et al. Correct and efficient work-stealing for weak memory
+ *     models. PPoPP 2013.
+ */
+template <typename T>
+class WorkStealingDeque {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "Items of a WorkStealingDeque must be trivially copyable.");
+
+ public:
+  explicit WorkStealingDeque(uint64_t capacity = 256) {
+    uint64_t rounded_capacity = 1;
+    while (rounded_capacity < capacity) {
+      rounded_capacity <<= 1;
+    }
+    _buffers.push_back(std::make_unique<Buffer>(rounded_capacity));
+    _buffer.store(_buffers.back().get(), std::memory_order_relaxed);
+  }
+
+  WorkStealingDeque(const WorkStealingDeque&) = delete;
+  WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+  /**
+   * Owner only
+   */
+  void push(T item) {
+    int64_t bottom = _bottom.load(std::memory_order_relaxed);
+    int64_t top = _top.load(std::memory_order_acquire);
+    Buffer* buffer = _buffer.load(std::memory_order_relaxed);
+    if (bottom - top > static_cast<int64_t>(buffer->capacity) - 1) {
+      buffer = grow(buffer, top, bottom);
+    }
+    buffer->put(bottom, item);
+    std::atomic_thread_fence(std::memory_order_release);
+    _bottom.store(bottom + 1, std::memory_order_relaxed);
+  }
+
+  /**
+   * Owner only. Returns the most recently pushed item.
+   */
+  std::optional<T> pop() {
+    int64_t bottom = _bottom.load(std::memory_order_relaxed) - 1;
+    Buffer* buffer = _buffer.load(std::memory_order_relaxed);
+    _bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = _top.load(std::memory_order_relaxed);
+
+    if (top > bottom) {
+      // Empty
+      _bottom.store(bottom + 1, std::memory_order_relaxed);
+      return std::nullopt;
+    }
+    T item = buffer->get(bottom);
+    if (top == bottom) {
+      // The last item, which a thief may be taking at the same time
+      bool won = _top.compare_exchange_strong(top, top + 1,
+                                              std::memory_order_seq_cst,
+                                              std::memory_order_relaxed);
+      _bottom.store(bottom + 1, std::memory_order_relaxed);
+      if (!won) {
+        return std::nullopt;
+      }
+    }
+    return item;
+  }
+
+  /**
+   * Any thread. Returns the least recently pushed item, or nothing if the
+   * deque is empty or another thread took the item first.
+   */
+  std::optional<T> steal() {
+    int64_t top = _top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t bottom = _bottom.load(std::memory_order_acquire);
+    if (top >= bottom) {
+      return std::nullopt;
+    }
+    Buffer* buffer = _buffer.load(std::memory_order_acquire);
+    T item = buffer->get(top);
+    if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      return std::nullopt;
+    }
+    return item;
+  }
+
+  /**
+   * An estimate when other threads operate on the deque concurrently
+   */
+  inline bool empty() const {
+    return _top.load(std::memory_order_relaxed) >=
+           _bottom.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Buffer {
+    explicit Buffer(uint64_t buffer_capacity)
+        : capacity(buffer_capacity),
+          items(std::make_unique<std::atomic<T>[]>(buffer_capacity)) {}
+
+    inline T get(int64_t index) const {
+      return items[index & (capacity - 1)].load(std::memory_order_relaxed);
+    }
+    inline void put(int64_t index, T item) {
+      items[index & (capacity - 1)].store(item, std::memory_order_relaxed);
+    }
+
+    uint64_t capacity;
+    std::unique_ptr<std::atomic<T>[]> items;
+  };
+
+  Buffer* grow(Buffer* buffer, int64_t top, int64_t bottom) {
+    auto grown = std::make_unique<Buffer>(buffer->capacity * 2);
+    for (int64_t index = top; index < bottom; index++) {
+      grown->put(index, buffer->get(index));
+    }
+    _buffers.push_back(std::move(grown));
+    Buffer* new_buffer = _buffers.back().get();
+    _buffer.store(new_buffer, std::memory_order_release);
+    return new_buffer;
+  }
+
+  // Kept on separate cache lines since thieves only write the top
+  alignas(64) std::atomic<int64_t> _top = 0;
+  alignas(64) std::atomic<int64_t> _bottom = 0;
+  alignas(64) std::atomic<Buffer*> _buffer;
+  // Owner only
+  std::vector<std::unique_ptr<Buffer>> _buffers;
+};
+
+}  // namespace gladius::parallel
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__AVX2__) || defined(__F16C__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+namespace gladius::parameters {
+
+/**
+ * Storage type of a parameter. Computations always accumulate in fp32; the
+ * 16-bit types only halve the memory (and bandwidth) taken by the stored
+ * values, which are converted to fp32 on load. The F16C/AVX512-BF16 paths
+ * of the conversions and dot products are chosen at compile time and need
+ * GLADIUS_NATIVE_ARCH; otherwise the software conversions are used.
+ */
+enum class ElementType { Float32, BFloat16, Float16 };
+
+/**
+ * Brain floating point: the upper 16 bits of an IEEE fp32 value, i.e., the
+ * same exponent range as fp32 with 8 bits of precision.
+ */
+struct bfloat16 {
+  uint16_t bits;
+
+  static inline bfloat16 fromFloat(float value) {
+    uint32_t input = std::bit_cast<uint32_t>(value);
+    if ((input & 0x7FFFFFFFU) > 0x7F800000U) {
+      // Quiet NaN
+      return {static_cast<uint16_t>((input >> 16) | 0x40U)};
+    }
+    // Round to nearest, ties to even
+    uint32_t rounding_bias = 0x7FFFU + ((input >> 16) & 1U);
+    return {static_cast<uint16_t>((input + rounding_bias) >> 16)};
+  }
+
+  inline float toFloat() const {
+    return std::bit_cast<float>(static_cast<uint32_t>(bits) << 16);
+  }
+};
+
+/**
+ * IEEE 754 half precision: 5 exponent bits and 11 bits of precision. Uses
+ * the F16C instructions when available and a software conversion otherwise.
+ */
+struct float16 {
+  uint16_t bits;
+
+  static inline float16 fromFloat(float value) {
+#if defined(__F16C__)
+    return {static_cast<uint16_t>(
+        _cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC))};
+#else
+    uint32_t input = std::bit_cast<uint32_t>(value);
+    auto sign = static_cast<uint16_t>((input >> 16) & 0x8000U);
+    uint32_t magnitude = input & 0x7FFFFFFFU;
+
+    if (magnitude > 0x7F800000U) {
+      return {static_cast<uint16_t>(sign | 0x7E00U)};
+    }
+    // Values of magnitude at least 2^16 (and infinities) overflow. Smaller
+    // values that round up past the largest half are handled below by the
+    // carry into the exponent.
+    if (magnitude >= 0x47800000U) {
+      return {static_cast<uint16_t>(sign | 0x7C00U)};
+    }
+    if (magnitude < 0x38800000U) {
+      // Subnormal halves are multiples of 2^-24, and the scaling is exact
+      float scaled = std::bit_cast<float>(magnitude) * 16777216.F;
+      return {static_cast<uint16_t>(
+          sign | static_cast<uint16_t>(std::nearbyint(scaled)))};
+    }
+    uint32_t exponent = (magnitude >> 23) - 127 + 15;
+    uint32_t mantissa = magnitude & 0x7FFFFFU;
+    uint32_t half = (exponent << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1FFFU;
+    if (remainder > 0x1000U || (remainder == 0x1000U && (half & 1U))) {
+      half++;
+    }
+    return {static_cast<uint16_t>(sign | half)};
+#endif
+  }
+
+  inline float toFloat() const {
+#if defined(__F16C__)
+    return _cvtsh_ss(bits);
+#else
+    uint32_t sign = static_cast<uint32_t>(bits & 0x8000U) << 16;
+    uint32_t exponent = (bits >> 10) & 0x1FU;
+    uint32_t mantissa = bits & 0x3FFU;
+
+    if (exponent == 0) {
+      float magnitude = static_cast<float>(mantissa) * 0x1p-24F;
+      return sign ? -magnitude : magnitude;
+    }
+    if (exponent == 0x1FU) {
+      return std::bit_cast<float>(sign | 0x7F800000U | (mantissa << 13));
+    }
+    return std::bit_cast<float>(sign | ((exponent - 15 + 127) << 23) |
+                                (mantissa << 13));
+#endif
+  }
+};
+
+template <typename T>
+inline float toFloat(T value) {
+  if constexpr (std::is_same_v<T, float>) {
+    return value;
+  } else {
+    return value.toFloat();
+  }
+}
+
+template <typename T>
+inline T fromFloat(float value) {
+  if constexpr (std::is_same_v<T, float>) {
+    return value;
+  } else {
+    return T::fromFloat(value);
+  }
+}
+
+/**
+ * Converts `size` fp32 values into T. bf16 uses the AVX512-BF16 conversion
+ * when available, which rounds to nearest even like the scalar fallback.
+ */
+template <typename T>
+inline void convertFromFloat(const float* source, T* destination,
+                             uint64_t size) {
+  uint64_t index = 0;
+#if defined(__AVX512BF16__)
+  if constexpr (std::is_same_v<T, bfloat16>) {
+    for (; index + 16 <= size; index += 16) {
+      __m256bh converted =
+          _mm512_cvtneps_pbh(_mm512_loadu_ps(source + index));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + index),
+                          std::bit_cast<__m256i>(converted));
+    }
+  }
+#endif
+#if defined(__F16C__) && defined(__AVX__)
+  if constexpr (std::is_same_v<T, float16>) {
+    for (; index + 8 <= size; index += 8) {
+      __m128i converted = _mm256_cvtps_ph(_mm256_loadu_ps(source + index),
+                                          _MM_FROUND_TO_NEAREST_INT);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + index),
+                       converted);
+    }
+  }
+#endif
+  for (; index < size; index++) {
+    destination[index] = fromFloat<T>(source[index]);
+  }
+}
+
+#if defined(__AVX2__)
+/**
+ * Loads 8 values of type T starting at `source` as fp32
+ */
+template <typename T>
+inline __m256 load8AsFloat(const T* source) {
+  if constexpr (std::is_same_v<T, float>) {
+    return _mm256_loadu_ps(source);
+  } else if constexpr (std::is_same_v<T, bfloat16>) {
+    __m256i widened = _mm256_cvtepu16_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(source)));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(widened, 16));
+  } else {
+#if defined(__F16C__)
+    return _mm256_cvtph_ps(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(source)));
+#else
+    alignas(32) float values[8];
+    for (uint32_t lane = 0; lane < 8; lane++) {
+      values[lane] = source[lane].toFloat();
+    }
+    return _mm256_load_ps(values);
+#endif
+  }
+}
+#endif
+
+/**
+ * Returns <x, y> for a row x stored as T and an fp32 vector y, converting x
+ * on load and accumulating in fp32.
+ */
+template <typename T>
+inline float dotProduct(const T* x, const float* y, uint32_t size) {
+  uint32_t index = 0;
+  float result = 0.F;
+#if defined(__AVX2__) && defined(__FMA__)
+  __m256 accumulator = _mm256_setzero_ps();
+  for (; index + 8 <= size; index += 8) {
+    accumulator = _mm256_fmadd_ps(load8AsFloat(x + index),
+                                  _mm256_loadu_ps(y + index), accumulator);
+  }
+  __m128 sum = _mm_add_ps(_mm256_castps256_ps128(accumulator),
+                          _mm256_extractf128_ps(accumulator, 1));
+  sum = _mm_hadd_ps(sum, sum);
+  sum = _mm_hadd_ps(sum, sum);
+  result = _mm_cvtss_f32(sum);
+#endif
+  for (; index < size; index++) {
+    result += toFloat(x[index]) * y[index];
+  }
+  return result;
+}
+
+/**
+ * Computes y += alpha * x for a row x stored as T and an fp32 vector y
+ */
+template <typename T>
+inline void addScaled(float alpha, const T* x, float* y, uint32_t size) {
+  uint32_t index = 0;
+#if defined(__AVX2__) && defined(__FMA__)
+  __m256 scale = _mm256_set1_ps(alpha);
+  for (; index + 8 <= size; index += 8) {
+    _mm256_storeu_ps(y + index,
+                     _mm256_fmadd_ps(scale, load8AsFloat(x + index),
+                                     _mm256_loadu_ps(y + index)));
+  }
+#endif
+  for (; index < size; index++) {
+    y[index] += alpha * toFloat(x[index]);
+  }
+}
+
+}  // namespace gladius::parameters
@@ -1,8 +1,14 @@
 #pragma once
 
 #include <cereal/access.hpp>
-#include <_types/_uint32_t.h>
+#include <src/memory/memory_tracker.hpp>
+#include <src/memory/numa.hpp>
+#include <src/parallel/parallel_for.hpp>
+#include <src/params/element_types.hpp>
 #include <src/utils.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
 #include <ios>
 #include <memory>
 #include <stdexcept>
@@ -22,6 +28,8 @@ class Parameter {
     }
     auto total_parameters = getParameterCount();
     _gradient = std::vector<float>(total_parameters, 0.F);
+    trackMemory();
+    placeMemory();
   }
 
   Parameter(const Parameter&) = delete;
@@ -32,13 +40,79 @@ class Parameter {
 
   std::vector<std::vector<float>>& getValue() { return _value; }
 
+  /**
+   * Keeps a copy of the value in a 16-bit type next to the fp32 value.
+   * Vertices that support it read the compact copy in their kernels, which
+   * halves the weight bandwidth, while the optimizer keeps updating the fp32
+   * master value and re-rounds the updated entries into the compact copy.
+   * ElementType::Float32 drops the compact copy.
+   */
+  void setStorageType(ElementType storage_type) {
+    _storage_type = storage_type;
+    if (storage_type == ElementType::Float32) {
+      _compact_value.clear();
+      _compact_value.shrink_to_fit();
+      trackMemory();
+      return;
+    }
+    _compact_value.resize(getParameterCount());
+    refreshCompactValue();
+    trackMemory();
+    placeMemory();
+  }
+
+  inline ElementType getStorageType() const { return _storage_type; }
+
+  /**
+   * Returns the given row of the compact copy, where T must match the
+   * storage type.
+   */
+  template <typename T>
+  inline const T* getCompactRow(uint32_t row) const {
+    static_assert(sizeof(T) == sizeof(uint16_t));
+    assert(!_compact_value.empty());
+    return reinterpret_cast<const T*>(_compact_value.data() +
+                                      row * _value.at(0).size());
+  }
+
+  /**
+   * Re-rounds the whole fp32 value into the compact copy. This is needed
+   * after writing to getValue() directly.
+   */
+  void refreshCompactValue() {
+    for (uint32_t row = 0; row < _value.size(); row++) {
+      refreshCompactRow(row);
+    }
+  }
+
   std::vector<float>& getGradient() { return _gradient; }
 
   inline void zeroOutGradient() {
     if (!_gradients_zeroed_out) {
-      for (float& grad : _gradient) {
-        grad = 0.F;
+      auto total_rows = _value.size();
+      auto total_cols = _value.at(0).size();
+
+      // Only the rows or columns written by sparse updates can be non-zero
+      switch (_sparsity) {
+        case GradientSparsity::Rows:
+          for (uint32_t row : _touched_indices) {
+            std::fill_n(_gradient.begin() + row * total_cols, total_cols, 0.F);
+          }
+          break;
+        case GradientSparsity::Columns:
+          for (uint64_t row = 0; row < total_rows; row++) {
+            for (uint32_t col : _touched_indices) {
+              _gradient[row * total_cols + col] = 0.F;
+            }
+          }
+          break;
+        case GradientSparsity::Dense:
+          for (float& grad : _gradient) {
+            grad = 0.F;
+          }
+          break;
       }
+      clearTouchedIndices();
     }
     _gradients_zeroed_out = true;
   }
@@ -51,17 +125,80 @@ class Parameter {
   void updateGradient(std::vector<float>& gradient) {
     assert(gradient.size() == _gradient.size());
 
-    auto size = gradient.size();
-#pragma omp parallel for default(none) shared(_gradient, gradient, size)
-    for (uint64_t index = 0; index < size; index++) {
-      _gradient[index] = gradient[index];
-    }
+    // Gradients of a few thousand floats are copied by the calling thread
+    parallel::parallelFor(
+        0, gradient.size(),
+        [&](uint64_t begin, uint64_t end) {
+          std::copy(gradient.begin() + begin, gradient.begin() + end,
+                    _gradient.begin() + begin);
+        },
+        parallel::grainSize(/* work_per_iteration = */ 1));
     _gradients_zeroed_out = false;
+    // The whole gradient may now be non-zero
+    _sparsity = GradientSparsity::Dense;
+    clearTouchedIndices();
 
     // std::cout << "[parameter-finished-grad-upate]" << std::endl;
     // _gradient = gradient;
   }
 
+  /**
+   * Adds the given gradient to a single row of the parameter. This is meant
+   * for vertices whose gradient w.r.t a weight matrix is zero outside a few
+   * rows (for instance, sampled softmax or embedding lookups). As long as the
+   * gradient is only updated through this method, the parameter keeps track
+   * of the rows that were written, and both zeroing out the gradient and
+   * updating the parameter value only touch those rows.
+   */
+  void accumulateRowGradient(uint32_t row, const float* row_gradient) {
+    auto total_rows = _value.size();
+    auto total_cols = _value.at(0).size();
+    assert(row < total_rows);
+
+    if (trackSparseUpdate(GradientSparsity::Rows, total_rows)) {
+      markTouched(row);
+    }
+    float* destination = _gradient.data() + row * total_cols;
+#pragma omp simd
+    for (uint64_t col = 0; col < total_cols; col++) {
+      destination[col] += row_gradient[col];
+    }
+    _gradients_zeroed_out = false;
+  }
+
+  /**
+   * Same as above for a gradient that is zero outside a few columns of every
+   * row, which is the case of the weights multiplied by a sparse input.
+   * `columns_gradient` has shape (rows, columns.size()) and its entry (r, k)
+   * is added to the entry (r, columns[k]) of the gradient.
+   */
+  void accumulateColumnGradient(const std::vector<uint32_t>& columns,
+                                const std::vector<float>& columns_gradient) {
+    auto total_rows = _value.size();
+    auto total_cols = _value.at(0).size();
+    uint64_t num_columns = columns.size();
+    assert(columns_gradient.size() == total_rows * num_columns);
+
+    if (trackSparseUpdate(GradientSparsity::Columns, total_cols)) {
+      for (uint32_t col : columns) {
+        markTouched(col);
+      }
+    }
+    parallel::parallelFor(
+        0, total_rows,
+        [&](uint64_t begin, uint64_t end) {
+          for (uint64_t row = begin; row < end; row++) {
+            float* destination = _gradient.data() + row * total_cols;
+            const float* source = columns_gradient.data() + row * num_columns;
+            for (uint64_t index = 0; index < num_columns; index++) {
+              destination[columns[index]] += source[index];
+            }
+          }
+        },
+        parallel::grainSize(/* work_per_iteration = */ num_columns));
+    _gradients_zeroed_out = false;
+  }
+
   /**
    * Returns the total number of trainable parameters. For instance,
    * If the parameter wraps a matrix of mxn dimensions, the total
@@ -87,11 +224,32 @@ class Parameter {
     auto total_rows = _value.size();
     auto total_cols = _value.at(0).size();
 
-    for (uint64_t row = 0; row < total_rows; row++) {
-      for (uint64_t col = 0; col < total_cols; col++) {
-        uint64_t grad_index = (row * total_cols) + col;
-        _value[row][col] += (update_factor * _gradient[grad_index]);
-      }
+    if (_gradients_zeroed_out) {
+      return;
+    }
+    switch (_sparsity) {
+      case GradientSparsity::Rows:
+        for (uint32_t row : _touched_indices) {
+          updateRowValue(row, total_cols, update_factor);
+          refreshCompactRow(row);
+        }
+        break;
+      case GradientSparsity::Columns:
+        for (uint64_t row = 0; row < total_rows; row++) {
+          float* row_value = _value[row].data();
+          const float* row_gradient = _gradient.data() + row * total_cols;
+          for (uint32_t col : _touched_indices) {
+            row_value[col] += (update_factor * row_gradient[col]);
+          }
+          refreshCompactEntries(row, _touched_indices);
+        }
+        break;
+      case GradientSparsity::Dense:
+        for (uint64_t row = 0; row < total_rows; row++) {
+          updateRowValue(row, total_cols, update_factor);
+          refreshCompactRow(row);
+        }
+        break;
     }
   }
 
@@ -108,17 +266,149 @@ class Parameter {
   }
 
  private:
+  // Which entries of the gradient may be non-zero since it was last zeroed
+  // out: all of them, or only those in the rows (columns) listed in
+  // _touched_indices.
+  enum class GradientSparsity { Dense, Rows, Columns };
+
+  /**
+   * Returns true if a sparse update of the given kind should record the
+   * indices it touches. Mixing row and column updates, or sparse and dense
+   * updates, falls back to treating the gradient as dense.
+   */
+  bool trackSparseUpdate(GradientSparsity sparsity, uint64_t num_indices) {
+    if (_gradients_zeroed_out) {
+      _sparsity = sparsity;
+      if (_is_touched.size() != num_indices) {
+        _is_touched.assign(num_indices, false);
+      }
+      return true;
+    }
+    if (_sparsity == sparsity) {
+      return true;
+    }
+    _sparsity = GradientSparsity::Dense;
+    clearTouchedIndices();
+    return false;
+  }
+
+  inline void markTouched(uint32_t index) {
+    if (!_is_touched[index]) {
+      _is_touched[index] = true;
+      _touched_indices.push_back(index);
+    }
+  }
+
+  inline void clearTouchedIndices() {
+    for (uint32_t index : _touched_indices) {
+      _is_touched[index] = false;
+    }
+    _touched_indices.clear();
+  }
+
+  inline void refreshCompactRow(uint32_t row) {
+    if (_storage_type == ElementType::Float32) {
+      return;
+    }
+    auto total_cols = _value.at(0).size();
+    uint16_t* destination = _compact_value.data() + row * total_cols;
+    switch (_storage_type) {
+      case ElementType::BFloat16:
+        convertFromFloat(_value[row].data(),
+                         reinterpret_cast<bfloat16*>(destination), total_cols);
+        break;
+      case ElementType::Float16:
+        convertFromFloat(_value[row].data(),
+                         reinterpret_cast<float16*>(destination), total_cols);
+        break;
+      case ElementType::Float32:
+        break;
+    }
+  }
+
+  /**
+   * Re-rounds the given columns of a row into the compact copy, so that
+   * column-sparse updates leave the other entries alone
+   */
+  inline void refreshCompactEntries(uint32_t row,
+                                    const std::vector<uint32_t>& columns) {
+    if (_storage_type == ElementType::Float32) {
+      return;
+    }
+    const float* source = _value[row].data();
+    uint16_t* destination = _compact_value.data() + row * _value[row].size();
+    for (uint32_t col : columns) {
+      destination[col] = _storage_type == ElementType::BFloat16
+                             ? bfloat16::fromFloat(source[col]).bits
+                             : float16::fromFloat(source[col]).bits;
+    }
+  }
+
+  /**
+   * Reports the value, its compact copy and the gradient to the memory
+   * tracker. The sizes only change on construction, on a change of the
+   * storage type and on deserialization.
+   */
+  void trackMemory() {
+    _value_memory.set(
+        "Parameter", memory::MemoryCategory::Parameters,
+        memory::bytesOf(_value) + memory::bytesOf(_compact_value));
+    _gradient_memory.set("Parameter", memory::MemoryCategory::Gradients,
+                         memory::bytesOf(_gradient));
+  }
+
+  /**
+   * Moves the pages of the value, its compact copy and the gradient to the
+   * placement of the memory::NumaPolicy. Like trackMemory(), it runs
+   * whenever the buffers are reallocated.
+   */
+  void placeMemory() {
+    if (memory::NumaPolicy::getPlacement() ==
+        memory::NumaPlacement::FirstTouch) {
+      return;
+    }
+    for (const auto& row : _value) {
+      memory::NumaPolicy::place(row.data(), memory::bytesOf(row));
+    }
+    memory::NumaPolicy::place(_compact_value.data(),
+                              memory::bytesOf(_compact_value));
+    memory::NumaPolicy::place(_gradient.data(), memory::bytesOf(_gradient));
+  }
+
+  inline void updateRowValue(uint64_t row, uint64_t total_cols,
+                             float update_factor) {
+    float* row_value = _value[row].data();
+    const float* row_gradient = _gradient.data() + row * total_cols;
+#pragma omp simd
+    for (uint64_t col = 0; col < total_cols; col++) {
+      row_value[col] += (update_factor * row_gradient[col]);
+    }
+  }
+
   Parameter(){};
   std::vector<std::vector<float>> _value;
   std::vector<float> _gradient;
 
   bool _gradients_zeroed_out = true;
 
+  // Compact copy of _value laid out row-major, empty for fp32 storage
+  ElementType _storage_type = ElementType::Float32;
+  std::vector<uint16_t> _compact_value;
+
+  GradientSparsity _sparsity = GradientSparsity::Dense;
+  std::vector<uint32_t> _touched_indices;
+  std::vector<bool> _is_touched;
+
+  memory::TrackedBytes _value_memory;
+  memory::TrackedBytes _gradient_memory;
+
   friend class cereal::access;
 
   template <typename Archive>
   void serialize(Archive& archive) {
     archive(_value, _gradient, _gradients_zeroed_out);
+    trackMemory();
+    placeMemory();
   }
 };
 
@@ -0,0 +1,200 @@
+#include <src/profiling/hardware_counters.hpp>
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+namespace gladius::profiling {
+
+const char* getHardwareEventName(HardwareEvent event) {
+  switch (event) {
+    case HardwareEvent::Cycles:
+      return "cycles";
+    case HardwareEvent::Instructions:
+      return "instructions";
+    case HardwareEvent::LLCMisses:
+      return "llc_misses";
+    case HardwareEvent::FloatingPointOps:
+      return "fp_ops";
+  }
+  return "unknown";
+}
+
+HardwareCounts& HardwareCounts::operator+=(const HardwareCounts& other) {
+  for (uint32_t index = 0; index < NUM_HARDWARE_EVENTS; index++) {
+    values[index] += other.values[index];
+  }
+  return *this;
+}
+
+HardwareCounts HardwareCounts::operator-(const HardwareCounts& other) const {
+  HardwareCounts difference;
+  for (uint32_t index = 0; index < NUM_HARDWARE_EVENTS; index++) {
+    difference.values[index] =
+        values[index] > other.values[index]
+            ? values[index] - other.values[index]
+            : 0;
+  }
+  return difference;
+}
+
+#if defined(__linux__)
+
+static bool isIntelCPU() {
+#if defined(__x86_64__) || defined(__i386__)
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(0, &eax, &ebx, &ecx, &edx)) {
+    return false;
+  }
+  char vendor[13];
+  std::memcpy(vendor, &ebx, 4);
+  std::memcpy(vendor + 4, &edx, 4);
+  std::memcpy(vendor + 8, &ecx, 4);
+  vendor[12] = '\0';
+  return std::strcmp(vendor, "GenuineIntel") == 0;
+#else
+  return false;
+#endif
+}
+
+static int openEvent(uint32_t type, uint64_t config, int group_fd) {
+  perf_event_attr attributes;
+  std::memset(&attributes, 0, sizeof(attributes));
+  attributes.size = sizeof(attributes);
+  attributes.type = type;
+  attributes.config = config;
+  attributes.exclude_kernel = 1;
+  attributes.exclude_hv = 1;
+  attributes.read_format = PERF_FORMAT_GROUP |
+                           PERF_FORMAT_TOTAL_TIME_ENABLED |
+                           PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return static_cast<int>(syscall(SYS_perf_event_open, &attributes,
+                                  /* pid = */ 0, /* cpu = */ -1, group_fd,
+                                  /* flags = */ 0));
+}
+
+// Intel FP_ARITH_INST_RETIRED umasks for single precision, with the number
+// of operations per instruction. FMA instructions are counted twice.
+static inline constexpr uint64_t FP_ARITH_EVENT = 0xC7;
+static inline constexpr std::array<std::pair<uint64_t, uint64_t>, 4>
+    FP_ARITH_SINGLE_UMASKS = {{{0x02, 1}, {0x08, 4}, {0x20, 8}, {0x80, 16}}};
+
+HardwareCounters::HardwareCounters() {
+  uint64_t llc_misses = PERF_COUNT_HW_CACHE_LL |
+                        (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  openGroup({PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE},
+            {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, llc_misses},
+            {HardwareEvent::Cycles, HardwareEvent::Instructions,
+             HardwareEvent::LLCMisses},
+            {1, 1, 1});
+
+  if (!isIntelCPU()) {
+    return;
+  }
+  std::vector<uint32_t> types;
+  std::vector<uint64_t> configs;
+  std::vector<HardwareEvent> events;
+  std::vector<uint64_t> weights;
+  for (const auto& [umask, operations] : FP_ARITH_SINGLE_UMASKS) {
+    types.push_back(PERF_TYPE_RAW);
+    configs.push_back((umask << 8) | FP_ARITH_EVENT);
+    events.push_back(HardwareEvent::FloatingPointOps);
+    weights.push_back(operations);
+  }
+  auto available_mask = _available_mask;
+  openGroup(types, configs, events, weights);
+  // The operations are only meaningful if every vector width is counted
+  if (!_groups.empty() &&
+      _groups.back().events.front() == HardwareEvent::FloatingPointOps &&
+      _groups.back().fds.size() != configs.size()) {
+    for (int fd : _groups.back().fds) {
+      close(fd);
+    }
+    _groups.pop_back();
+    _available_mask = available_mask;
+  }
+}
+
+HardwareCounters::~HardwareCounters() {
+  for (const auto& group : _groups) {
+    for (int fd : group.fds) {
+      close(fd);
+    }
+  }
+}
+
+void HardwareCounters::openGroup(const std::vector<uint32_t>& types,
+                                 const std::vector<uint64_t>& configs,
+                                 const std::vector<HardwareEvent>& events,
+                                 const std::vector<uint64_t>& weights) {
+  CounterGroup group;
+  for (uint32_t index = 0; index < types.size(); index++) {
+    int fd = openEvent(types[index], configs[index], group.leader_fd);
+    if (fd < 0) {
+      continue;
+    }
+    if (group.leader_fd < 0) {
+      group.leader_fd = fd;
+    }
+    group.fds.push_back(fd);
+    group.events.push_back(events[index]);
+    group.weights.push_back(weights[index]);
+    _available_mask |= 1U << static_cast<uint32_t>(events[index]);
+  }
+  if (group.leader_fd >= 0) {
+    _groups.push_back(std::move(group));
+  }
+}
+
+HardwareCounts HardwareCounters::read() const {
+  HardwareCounts counts;
+  // nr, time_enabled, time_running and one value per member
+  uint64_t buffer[3 + FP_ARITH_SINGLE_UMASKS.size()];
+  for (const auto& group : _groups) {
+    auto bytes = ::read(group.leader_fd, buffer, sizeof(buffer));
+    if (bytes < static_cast<ssize_t>(3 * sizeof(uint64_t))) {
+      continue;
+    }
+    uint64_t members = std::min<uint64_t>(buffer[0], group.fds.size());
+    uint64_t time_enabled = buffer[1];
+    uint64_t time_running = buffer[2];
+    if (time_running == 0) {
+      continue;
+    }
+    double scale = static_cast<double>(time_enabled) /
+                   static_cast<double>(time_running);
+    for (uint64_t member = 0; member < members; member++) {
+      counts[group.events[member]] += static_cast<uint64_t>(
+          static_cast<double>(buffer[3 + member]) * scale *
+          static_cast<double>(group.weights[member]));
+    }
+  }
+  return counts;
+}
+
+#else
+
+HardwareCounters::HardwareCounters() {}
+
+HardwareCounters::~HardwareCounters() {}
+
+void HardwareCounters::openGroup(const std::vector<uint32_t>& types,
+                                 const std::vector<uint64_t>& configs,
+                                 const std::vector<HardwareEvent>& events,
+                                 const std::vector<uint64_t>& weights) {}
+
+HardwareCounts HardwareCounters::read() const { return HardwareCounts(); }
+
+#endif
+
+}  // namespace gladius::profiling
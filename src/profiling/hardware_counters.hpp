@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace gladius::profiling {
+
+/**
+ * Hardware events counted around profiled regions:
+ *    - Cycles:            core cycles spent in user space
+ *    - Instructions:      retired instructions, IPC = Instructions / Cycles
+ *    - LLCMisses:         last-level cache misses, each one a 64-byte line
+ *                         fetched from memory
+ *    - FloatingPointOps:  single-precision floating point operations
+ *                         retired, weighted by the vector width. Only
+ *                         available on Intel CPUs with the FP_ARITH events.
+ */
+enum class HardwareEvent : uint8_t {
+  Cycles,
+  Instructions,
+  LLCMisses,
+  FloatingPointOps
+};
+
+static inline constexpr uint32_t NUM_HARDWARE_EVENTS = 4;
+
+static inline constexpr uint64_t CACHE_LINE_BYTES = 64;
+
+const char* getHardwareEventName(HardwareEvent event);
+
+struct HardwareCounts {
+  std::array<uint64_t, NUM_HARDWARE_EVENTS> values{};
+
+  inline uint64_t& operator[](HardwareEvent event) {
+    return values[static_cast<uint32_t>(event)];
+  }
+  inline uint64_t operator[](HardwareEvent event) const {
+    return values[static_cast<uint32_t>(event)];
+  }
+
+  HardwareCounts& operator+=(const HardwareCounts& other);
+
+  /**
+   * Saturates at zero, since multiplexed counts are scaled estimates and
+   * the counts of a region may come out slightly below those of the
+   * regions nested in it
+   */
+  HardwareCounts operator-(const HardwareCounts& other) const;
+};
+
+/**
+ * The hardware counters of the calling thread, opened with
+ * perf_event_open(2). The counters only see the work of the thread that
+ * opened them, so the work that a region hands to OpenMP worker threads is
+ * not counted (run with OMP_NUM_THREADS=1 for complete counts).
+ *
+ * Events that cannot be opened, e.g., inside a VM without a virtual PMU,
+ * with a restrictive kernel.perf_event_paranoid or on platforms other than
+ * Linux, are reported as unavailable and read as zero. When the events of
+ * a group cannot all be scheduled at once, the kernel multiplexes them and
+ * read() scales the counts by the fraction of the time they were running.
+ */
+class HardwareCounters {
+ public:
+  HardwareCounters();
+  ~HardwareCounters();
+
+  HardwareCounters(const HardwareCounters&) = delete;
+  HardwareCounters& operator=(const HardwareCounters&) = delete;
+
+  HardwareCounters(HardwareCounters&&) = delete;
+  HardwareCounters& operator=(HardwareCounters&&) = delete;
+
+  inline bool isAvailable(HardwareEvent event) const {
+    return _available_mask & (1U << static_cast<uint32_t>(event));
+  }
+
+  // Bit i is set if the i-th HardwareEvent is available
+  inline uint8_t getAvailableMask() const { return _available_mask; }
+
+  /**
+   * Returns the counts accumulated by the calling thread since the counters
+   * were opened
+   */
+  HardwareCounts read() const;
+
+ private:
+  // A group of events read together with a single system call. The count
+  // of every member is multiplied by its weight and added to the count of
+  // the event it belongs to.
+  struct CounterGroup {
+    int leader_fd = -1;
+    std::vector<int> fds;
+    std::vector<HardwareEvent> events;
+    std::vector<uint64_t> weights;
+  };
+
+  void openGroup(const std::vector<uint32_t>& types,
+                 const std::vector<uint64_t>& configs,
+                 const std::vector<HardwareEvent>& events,
+                 const std::vector<uint64_t>& weights);
+
+  std::vector<CounterGroup> _groups;
+  uint8_t _available_mask = 0;
+};
+
+}  // namespace gladius::profiling
@@ -0,0 +1,470 @@
+#include <src/comp_graph/vertices/vertex.hpp>
+#include <src/profiling/profiler.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace gladius::profiling {
+
+struct EventRing {
+  std::vector<ProfileEvent> events;
+  uint64_t next = 0;
+};
+
+// Ticks and hardware events spent in the nested regions of an open region
+struct NestedTotals {
+  uint64_t ticks = 0;
+  HardwareCounts counts;
+};
+
+struct ThreadState {
+  std::shared_ptr<EventRing> ring;
+  uint32_t thread_id;
+  std::vector<NestedTotals> nested;
+  // Opened on the first region counted by this thread
+  std::unique_ptr<HardwareCounters> counters;
+};
+
+static std::mutex registry_mutex;
+static std::vector<std::shared_ptr<EventRing>> registered_rings;
+static uint32_t registered_threads = 0;
+
+// Timestamps and times taken when the profiler was enabled, used to convert
+// ticks into microseconds
+static uint64_t calibration_ticks = 0;
+static std::chrono::steady_clock::time_point calibration_time;
+
+static inline uint64_t readTicks() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+#endif
+}
+
+static ThreadState& threadState() {
+  thread_local ThreadState state = [] {
+    ThreadState new_state;
+    new_state.ring = std::make_shared<EventRing>();
+    new_state.ring->events.resize(Profiler::RING_CAPACITY);
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    registered_rings.push_back(new_state.ring);
+    new_state.thread_id = registered_threads++;
+    return new_state;
+  }();
+  return state;
+}
+
+static HardwareCounters& threadCounters() {
+  auto& state = threadState();
+  if (!state.counters) {
+    state.counters = std::make_unique<HardwareCounters>();
+  }
+  return *state.counters;
+}
+
+void Profiler::enable(bool hardware_counters) {
+  calibration_time = std::chrono::steady_clock::now();
+  calibration_ticks = readTicks();
+  _hardware_counters.store(hardware_counters, std::memory_order_relaxed);
+  _enabled.store(true, std::memory_order_relaxed);
+}
+
+void Profiler::disable() {
+  _enabled.store(false, std::memory_order_relaxed);
+  _hardware_counters.store(false, std::memory_order_relaxed);
+}
+
+uint8_t Profiler::getAvailableHardwareEvents() {
+  return threadCounters().getAvailableMask();
+}
+
+void Profiler::clear() {
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  for (auto& ring : registered_rings) {
+    ring->next = 0;
+  }
+}
+
+double Profiler::ticksToMicroseconds(uint64_t ticks) {
+  double elapsed_microseconds =
+      std::chrono::duration<double, std::micro>(
+          std::chrono::steady_clock::now() - calibration_time)
+          .count();
+  uint64_t elapsed_ticks = readTicks() - calibration_ticks;
+  if (elapsed_ticks == 0 || elapsed_microseconds <= 0.) {
+    return 0.;
+  }
+  return static_cast<double>(ticks) * elapsed_microseconds /
+         static_cast<double>(elapsed_ticks);
+}
+
+std::vector<ProfileEvent> Profiler::collect() {
+  std::vector<ProfileEvent> events;
+  {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (const auto& ring : registered_rings) {
+      uint64_t count = std::min<uint64_t>(ring->next, RING_CAPACITY);
+      for (uint64_t index = ring->next - count; index < ring->next; index++) {
+        events.push_back(ring->events[index % RING_CAPACITY]);
+      }
+    }
+  }
+  std::sort(events.begin(), events.end(),
+            [](const ProfileEvent& left, const ProfileEvent& right) {
+              return left.start_ticks < right.start_ticks;
+            });
+  return events;
+}
+
+static const char* passName(Pass pass) {
+  switch (pass) {
+    case Pass::Forward:
+      return "forward";
+    case Pass::Backward:
+      return "backward";
+    case Pass::Optimizer:
+      return "optimizer";
+    case Pass::Kernel:
+      return "kernel";
+  }
+  return "unknown";
+}
+
+void Profiler::writeChromeTrace(std::ostream& stream) {
+  auto events = collect();
+  uint64_t origin = events.empty() ? 0 : events.front().start_ticks;
+
+  stream << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+  for (uint64_t index = 0; index < events.size(); index++) {
+    const auto& event = events[index];
+    stream << (index == 0 ? "\n" : ",\n") << std::fixed
+           << std::setprecision(3) << "{\"name\": \"" << event.op
+           << "\", \"cat\": \"" << passName(event.pass)
+           << "\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << event.thread_id
+           << ", \"ts\": " << ticksToMicroseconds(event.start_ticks - origin)
+           << ", \"dur\": "
+           << ticksToMicroseconds(event.end_ticks - event.start_ticks)
+           << ", \"args\": {\"shape\": \"(" << event.rows << ", "
+           << event.columns << ")\", \"flops\": " << event.flops
+           << ", \"bytes_allocated\": " << event.bytes_allocated
+           << ", \"self_us\": "
+           << ticksToMicroseconds(event.end_ticks - event.start_ticks -
+                                  event.child_ticks);
+    for (uint32_t counter = 0; counter < NUM_HARDWARE_EVENTS; counter++) {
+      if (event.counter_mask & (1U << counter)) {
+        stream << ", \"self_"
+               << getHardwareEventName(static_cast<HardwareEvent>(counter))
+               << "\": " << event.counters.values[counter];
+      }
+    }
+    stream << "}}";
+  }
+  stream << "\n]}\n";
+}
+
+void Profiler::writeChromeTrace(const std::string& filename) {
+  std::ofstream file(filename);
+  if (!file) {
+    throw std::runtime_error("Unable to write the trace to " + filename +
+                             ".");
+  }
+  writeChromeTrace(file);
+}
+
+void Profiler::printSummary(std::ostream& stream, uint32_t top) {
+  struct Aggregate {
+    uint64_t calls = 0;
+    uint64_t self_ticks = 0;
+    uint64_t flops = 0;
+    uint64_t bytes_allocated = 0;
+  };
+  std::map<std::pair<std::string, Pass>, Aggregate> aggregates;
+  uint64_t total_ticks = 0;
+  for (const auto& event : Profiler::collect()) {
+    auto& aggregate = aggregates[{event.op, event.pass}];
+    uint64_t self_ticks =
+        event.end_ticks - event.start_ticks - event.child_ticks;
+    aggregate.calls++;
+    aggregate.self_ticks += self_ticks;
+    aggregate.flops += event.flops;
+    aggregate.bytes_allocated += event.bytes_allocated;
+    total_ticks += self_ticks;
+  }
+
+  std::vector<std::pair<std::pair<std::string, Pass>, Aggregate>> rows(
+      aggregates.begin(), aggregates.end());
+  std::sort(rows.begin(), rows.end(), [](const auto& left, const auto& right) {
+    return left.second.self_ticks > right.second.self_ticks;
+  });
+  rows.resize(std::min<uint64_t>(rows.size(), top));
+
+  stream << std::left << std::setw(26) << "op" << std::setw(11) << "pass"
+         << std::right << std::setw(9) << "calls" << std::setw(12)
+         << "self (ms)" << std::setw(8) << "%" << std::setw(12) << "avg (us)"
+         << std::setw(10) << "GFLOP/s" << std::setw(12) << "alloc (MB)"
+         << "\n";
+  for (const auto& [key, aggregate] : rows) {
+    double self_microseconds = ticksToMicroseconds(aggregate.self_ticks);
+    double share = total_ticks == 0
+                       ? 0.
+                       : 100. * static_cast<double>(aggregate.self_ticks) /
+                             static_cast<double>(total_ticks);
+    double gflops =
+        self_microseconds <= 0.
+            ? 0.
+            : static_cast<double>(aggregate.flops) / self_microseconds / 1e3;
+    stream << std::left << std::setw(26) << key.first << std::setw(11)
+           << passName(key.second) << std::right << std::fixed
+           << std::setw(9) << aggregate.calls << std::setprecision(3)
+           << std::setw(12) << self_microseconds / 1e3 << std::setprecision(1)
+           << std::setw(8) << share << std::setw(12)
+           << self_microseconds / static_cast<double>(aggregate.calls)
+           << std::setprecision(2) << std::setw(10) << gflops
+           << std::setw(12)
+           << static_cast<double>(aggregate.bytes_allocated) / (1 << 20)
+           << "\n";
+  }
+}
+
+RooflineLimits RooflineLimits::measure() {
+  using Clock = std::chrono::steady_clock;
+  auto seconds = [](Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+  };
+
+  // Independent multiply-add chains, enough of them to hide the latency of
+  // the FMA units once vectorized
+  constexpr uint32_t CHAINS = 64;
+  constexpr uint64_t FMA_ITERATIONS = 1 << 22;
+  float accumulators[CHAINS];
+  std::fill_n(accumulators, CHAINS, 1.F);
+  volatile float multiplier_source = 0.999999F;
+  volatile float addend_source = 1e-7F;
+  float multiplier = multiplier_source;
+  float addend = addend_source;
+  auto start = Clock::now();
+  for (uint64_t iteration = 0; iteration < FMA_ITERATIONS; iteration++) {
+#pragma omp simd
+    for (uint32_t chain = 0; chain < CHAINS; chain++) {
+      accumulators[chain] = accumulators[chain] * multiplier + addend;
+    }
+  }
+  double fma_seconds = seconds(start);
+  float sink = 0.F;
+  for (float accumulator : accumulators) {
+    sink += accumulator;
+  }
+  volatile float keep_alive = sink;
+  (void)keep_alive;
+
+  // Each buffer is larger than the last-level cache of common CPUs
+  constexpr uint64_t TRIAD_SIZE = 1 << 23;
+  constexpr uint32_t TRIAD_REPETITIONS = 3;
+  std::vector<float> target(TRIAD_SIZE, 0.F);
+  std::vector<float> left(TRIAD_SIZE, 1.F);
+  std::vector<float> right(TRIAD_SIZE, 2.F);
+  double triad_seconds = 0.;
+  for (uint32_t repetition = 0; repetition < TRIAD_REPETITIONS;
+       repetition++) {
+    start = Clock::now();
+    float* target_data = target.data();
+    const float* left_data = left.data();
+    const float* right_data = right.data();
+#pragma omp simd
+    for (uint64_t index = 0; index < TRIAD_SIZE; index++) {
+      target_data[index] = left_data[index] + addend * right_data[index];
+    }
+    double elapsed = seconds(start);
+    if (repetition == 0 || elapsed < triad_seconds) {
+      triad_seconds = elapsed;
+    }
+  }
+  volatile float triad_keep_alive = target[TRIAD_SIZE / 2];
+  (void)triad_keep_alive;
+
+  RooflineLimits limits;
+  limits.peak_gflops = 2. * CHAINS * FMA_ITERATIONS / fma_seconds / 1e9;
+  limits.peak_bandwidth_gbs =
+      3. * TRIAD_SIZE * sizeof(float) / triad_seconds / 1e9;
+  return limits;
+}
+
+void Profiler::printRoofline(std::ostream& stream,
+                             const RooflineLimits& limits, uint32_t top) {
+  struct Aggregate {
+    uint64_t calls = 0;
+    uint64_t self_ticks = 0;
+    uint64_t estimated_flops = 0;
+    HardwareCounts counters;
+    uint8_t counter_mask = 0xFF;
+  };
+  std::map<std::pair<std::string, Pass>, Aggregate> aggregates;
+  for (const auto& event : Profiler::collect()) {
+    auto& aggregate = aggregates[{event.op, event.pass}];
+    aggregate.calls++;
+    aggregate.self_ticks +=
+        event.end_ticks - event.start_ticks - event.child_ticks;
+    aggregate.estimated_flops += event.flops;
+    aggregate.counters += event.counters;
+    aggregate.counter_mask &= event.counter_mask;
+  }
+
+  std::vector<std::pair<std::pair<std::string, Pass>, Aggregate>> rows(
+      aggregates.begin(), aggregates.end());
+  std::sort(rows.begin(), rows.end(), [](const auto& left, const auto& right) {
+    return left.second.self_ticks > right.second.self_ticks;
+  });
+  rows.resize(std::min<uint64_t>(rows.size(), top));
+
+  stream << std::fixed << std::setprecision(2) << "roofline: peak "
+         << limits.peak_gflops << " GFLOP/s, bandwidth "
+         << limits.peak_bandwidth_gbs << " GB/s, ridge point "
+         << limits.ridgePoint() << " FLOP/byte\n";
+  stream << std::left << std::setw(26) << "op" << std::setw(11) << "pass"
+         << std::right << std::setw(12) << "self (ms)" << std::setw(8)
+         << "IPC" << std::setw(12) << "FLOP/byte" << std::setw(10)
+         << "GFLOP/s" << std::setw(10) << "roof" << std::setw(8) << "%roof"
+         << "  bound\n";
+
+  auto has = [](const Aggregate& aggregate, HardwareEvent event) {
+    return aggregate.counter_mask & (1U << static_cast<uint32_t>(event));
+  };
+  auto print_value = [&](bool available, double value, int width) {
+    if (available && std::isfinite(value)) {
+      stream << std::setw(width) << value;
+    } else {
+      stream << std::setw(width) << "n/a";
+    }
+  };
+
+  for (const auto& [key, aggregate] : rows) {
+    double self_microseconds = ticksToMicroseconds(aggregate.self_ticks);
+    bool has_ipc = has(aggregate, HardwareEvent::Cycles) &&
+                   has(aggregate, HardwareEvent::Instructions) &&
+                   aggregate.counters[HardwareEvent::Cycles] > 0;
+    double ipc =
+        has_ipc ? static_cast<double>(
+                      aggregate.counters[HardwareEvent::Instructions]) /
+                      static_cast<double>(
+                          aggregate.counters[HardwareEvent::Cycles])
+                : 0.;
+    double flops =
+        has(aggregate, HardwareEvent::FloatingPointOps)
+            ? static_cast<double>(
+                  aggregate.counters[HardwareEvent::FloatingPointOps])
+            : static_cast<double>(aggregate.estimated_flops);
+    double memory_bytes = static_cast<double>(
+        aggregate.counters[HardwareEvent::LLCMisses] * CACHE_LINE_BYTES);
+    // Without a single miss the data was already in the caches, so the
+    // intensity w.r.t memory is unbounded and only the compute roof applies
+    bool has_intensity = has(aggregate, HardwareEvent::LLCMisses) && flops > 0;
+    double intensity = memory_bytes > 0.
+                           ? flops / memory_bytes
+                           : std::numeric_limits<double>::infinity();
+    double gflops =
+        self_microseconds <= 0. ? 0. : flops / self_microseconds / 1e3;
+    double roof = std::min(limits.peak_gflops,
+                           intensity * limits.peak_bandwidth_gbs);
+
+    stream << std::left << std::setw(26) << key.first << std::setw(11)
+           << passName(key.second) << std::right << std::fixed
+           << std::setprecision(3) << std::setw(12) << self_microseconds / 1e3
+           << std::setprecision(2);
+    print_value(has_ipc, ipc, 8);
+    if (has_intensity && std::isinf(intensity)) {
+      stream << std::setw(12) << "inf";
+    } else {
+      print_value(has_intensity, intensity, 12);
+    }
+    print_value(flops > 0, gflops, 10);
+    print_value(has_intensity, roof, 10);
+    print_value(has_intensity && roof > 0., 100. * gflops / roof, 8);
+    if (!has_intensity) {
+      stream << "  n/a\n";
+    } else {
+      stream << (intensity < limits.ridgePoint() ? "  memory\n"
+                                                  : "  compute\n");
+    }
+  }
+}
+
+void ProfileScope::begin(comp_graph::Vertex* vertex, const char* name,
+                         Pass pass) {
+  auto& state = threadState();
+  _active = true;
+  _vertex = vertex;
+  _name = name;
+  _pass = pass;
+  _start_bytes = vertex ? vertex->getBufferBytes() : 0;
+  state.nested.emplace_back();
+  _counting = Profiler::areHardwareCountersEnabled();
+  if (_counting) {
+    _start_counts = threadCounters().read();
+  }
+  _start_ticks = readTicks();
+}
+
+void ProfileScope::end() {
+  uint64_t end_ticks = readTicks();
+  auto& state = threadState();
+  HardwareCounts counts;
+  if (_counting) {
+    counts = state.counters->read() - _start_counts;
+  }
+  NestedTotals nested = state.nested.back();
+  state.nested.pop_back();
+  if (!state.nested.empty()) {
+    state.nested.back().ticks += end_ticks - _start_ticks;
+    state.nested.back().counts += counts;
+  }
+
+  auto& ring = *state.ring;
+  auto& event = ring.events[ring.next % Profiler::RING_CAPACITY];
+  ring.next++;
+
+  std::string name = _vertex ? _vertex->getName() : std::string(_name);
+  std::strncpy(event.op, name.c_str(), sizeof(event.op) - 1);
+  event.op[sizeof(event.op) - 1] = '\0';
+  event.pass = _pass;
+  event.thread_id = state.thread_id;
+  event.depth = static_cast<uint32_t>(state.nested.size());
+  event.start_ticks = _start_ticks;
+  event.end_ticks = end_ticks;
+  event.child_ticks = nested.ticks;
+  event.counters = counts - nested.counts;
+  event.counter_mask = _counting ? state.counters->getAvailableMask() : 0;
+  if (_vertex) {
+    std::tie(event.rows, event.columns) = _vertex->getOutputShape();
+    uint64_t end_bytes = _vertex->getBufferBytes();
+    event.bytes_allocated =
+        end_bytes > _start_bytes ? end_bytes - _start_bytes : 0;
+    // Computing the gradients w.r.t the inputs and the parameters costs
+    // about twice as much as the forward pass
+    event.flops = _vertex->estimateFlops() * (_pass == Pass::Backward ? 2 : 1);
+  } else {
+    event.rows = event.columns = 0;
+    event.bytes_allocated = 0;
+    event.flops = _flops;
+  }
+}
+
+void ProfileScope::trackVertexMemory() { _vertex->trackMemory(); }
+
+}  // namespace gladius::profiling
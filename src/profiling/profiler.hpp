@@ -0,0 +1,211 @@
+#pragma once
+
+#include <src/memory/memory_tracker.hpp>
+#include <src/profiling/hardware_counters.hpp>
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace gladius::comp_graph {
+class Vertex;
+}  // namespace gladius::comp_graph
+
+namespace gladius::profiling {
+
+/**
+ * Kernel regions are nested in the forward or backward pass of a vertex and
+ * cover a single kernel, e.g., the matrix-vector product of InnerProduct.
+ */
+enum class Pass : uint8_t { Forward, Backward, Optimizer, Kernel };
+
+/**
+ * One timed region, usually the forward or backward computation of a
+ * vertex. Timestamps are in TSC ticks (or nanoseconds on platforms without
+ * a TSC) and are converted when the events are exported.
+ */
+struct ProfileEvent {
+  // Operation name, truncated to fit
+  char op[32];
+  Pass pass;
+  uint32_t thread_id;
+  uint32_t depth;
+  uint32_t rows;
+  uint32_t columns;
+  uint64_t start_ticks;
+  uint64_t end_ticks;
+  // Time spent in nested regions, e.g., the backward pass of the inputs of
+  // a vertex, which runs inside its own backward pass
+  uint64_t child_ticks;
+  // Growth of the buffers held by the vertex during the region
+  uint64_t bytes_allocated;
+  uint64_t flops;
+  // Hardware events counted in the region minus those counted in its nested
+  // regions, and which of them were available (see HardwareCounters)
+  HardwareCounts counters;
+  uint8_t counter_mask;
+};
+
+/**
+ * The peak compute throughput and memory bandwidth of the machine, i.e.,
+ * the two ceilings of the roofline model.
+ */
+struct RooflineLimits {
+  double peak_gflops;
+  double peak_bandwidth_gbs;
+
+  /**
+   * Measures both ceilings on the calling thread with a register-resident
+   * FMA loop and a streaming triad over buffers larger than the caches.
+   * This takes a fraction of a second. The numbers are single-thread
+   * ceilings, which is what the counters of a region measure too.
+   */
+  static RooflineLimits measure();
+
+  // Arithmetic intensity (FLOP/byte) above which a kernel is compute-bound
+  inline double ridgePoint() const {
+    return peak_gflops / peak_bandwidth_gbs;
+  }
+};
+
+/**
+ * Opt-in per-vertex profiler.
+ *
+ * While enabled, every forward pass run by a Graph, every vertex backward
+ * pass and every optimizer step records a ProfileEvent. Events go to a
+ * fixed-size ring buffer owned by the recording thread, so recording takes
+ * no lock, and the oldest events are overwritten once the ring is full.
+ * While disabled, a profiled region costs a single relaxed atomic load.
+ *
+ * With hardware counters enabled, every region also reads the cycles,
+ * instructions, last-level cache misses and floating point operations of
+ * the recording thread (see HardwareCounters), which costs a system call at
+ * both ends of the region. printRoofline() turns them into IPC and
+ * arithmetic intensity per operation.
+ *
+ * collect(), writeChromeTrace() and printSummary() read the rings of every
+ * thread and must not run concurrently with profiled work.
+ */
+class Profiler {
+ public:
+  static inline constexpr uint32_t RING_CAPACITY = 1 << 16;
+
+  static void enable(bool hardware_counters = false);
+  static void disable();
+  static inline bool isEnabled() {
+    return _enabled.load(std::memory_order_relaxed);
+  }
+  static inline bool areHardwareCountersEnabled() {
+    return _hardware_counters.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Returns which hardware events can be counted on the calling thread,
+   * with bit i set for the i-th HardwareEvent
+   */
+  static uint8_t getAvailableHardwareEvents();
+
+  /**
+   * Drops the events recorded so far
+   */
+  static void clear();
+
+  /**
+   * Returns the recorded events of every thread ordered by start time
+   */
+  static std::vector<ProfileEvent> collect();
+
+  /**
+   * Writes the events in the Chrome trace event format, which can be
+   * opened in chrome://tracing or https://ui.perfetto.dev. Nested regions
+   * show up as a flame graph per thread.
+   */
+  static void writeChromeTrace(std::ostream& stream);
+  static void writeChromeTrace(const std::string& filename);
+
+  /**
+   * Prints the `top` operations with the largest self time (the time not
+   * spent in nested regions) aggregated per operation and pass.
+   */
+  static void printSummary(std::ostream& stream, uint32_t top = 20);
+
+  /**
+   * Prints the `top` operations with the largest self time together with
+   * their IPC, arithmetic intensity and achieved GFLOP/s, and places each of
+   * them on the roofline given by `limits`: the attainable GFLOP/s is
+   * min(peak, intensity * bandwidth), and an operation whose intensity is
+   * below the ridge point is bandwidth-bound.
+   *
+   * The intensity divides the FLOPs by the bytes fetched from memory, i.e.,
+   * 64 bytes per last-level cache miss. The FLOPs are the counted floating
+   * point operations if available and the estimates of the vertices
+   * otherwise. Columns that need an unavailable counter show "n/a".
+   */
+  static void printRoofline(std::ostream& stream,
+                            const RooflineLimits& limits, uint32_t top = 20);
+
+  /**
+   * Converts a difference of timestamps into microseconds
+   */
+  static double ticksToMicroseconds(uint64_t ticks);
+
+ private:
+  static inline std::atomic<bool> _enabled = false;
+  static inline std::atomic<bool> _hardware_counters = false;
+};
+
+/**
+ * Records the region between its construction and destruction when the
+ * profiler is enabled. At the end of the forward or backward pass of a
+ * vertex, it also reports the buffers of the vertex to the memory tracker
+ * when that is enabled.
+ */
+class ProfileScope {
+ public:
+  ProfileScope(comp_graph::Vertex& vertex, Pass pass) : _vertex(&vertex) {
+    if (Profiler::isEnabled()) {
+      begin(&vertex, nullptr, pass);
+    }
+  }
+
+  /**
+   * `flops` is reported for regions that are not the pass of a vertex, e.g.,
+   * kernel regions
+   */
+  ProfileScope(const char* name, Pass pass, uint64_t flops = 0)
+      : _flops(flops) {
+    if (Profiler::isEnabled()) {
+      begin(nullptr, name, pass);
+    }
+  }
+
+  ProfileScope(const ProfileScope&) = delete;
+  ProfileScope& operator=(const ProfileScope&) = delete;
+
+  ~ProfileScope() {
+    if (_active) {
+      end();
+    }
+    if (_vertex && memory::MemoryTracker::isEnabled()) {
+      trackVertexMemory();
+    }
+  }
+
+ private:
+  void begin(comp_graph::Vertex* vertex, const char* name, Pass pass);
+  void end();
+  void trackVertexMemory();
+
+  bool _active = false;
+  bool _counting = false;
+  comp_graph::Vertex* _vertex = nullptr;
+  const char* _name = nullptr;
+  Pass _pass;
+  uint64_t _flops = 0;
+  uint64_t _start_ticks;
+  uint64_t _start_bytes;
+  HardwareCounts _start_counts;
+};
+
+}  // namespace gladius::profiling
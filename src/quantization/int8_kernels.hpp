@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace gladius::quantization {
+
+/**
+ * Largest quantized activation. Activations use 7 bits so that the pairwise
+ * sums computed by _mm256_maddubs_epi16 (two products of a u8 by a s8) never
+ * saturate the 16-bit lanes: 2 * 127 * 127 < 2^15. With VNNI the products
+ * are accumulated directly in 32 bits, but we keep the same range so that
+ * both paths return identical results.
+ */
+static inline constexpr int32_t MAX_QUANTIZED_ACTIVATION = 127;
+static inline constexpr int32_t MAX_QUANTIZED_WEIGHT = 127;
+
+/**
+ * Returns \sum_i a_i b_i for unsigned activations a and signed weights b,
+ * accumulated in 32 bits. Uses VNNI (vpdpbusd) when available, AVX2
+ * (vpmaddubsw + vpmaddwd) otherwise, and a scalar loop for the tail and
+ * on CPUs without AVX2. The path is chosen at compile time, so the vector
+ * ones need GLADIUS_NATIVE_ARCH (or equivalent -m flags).
+ */
+inline int32_t dotProductU8S8(const uint8_t* activations,
+                              const int8_t* weights, uint32_t size) {
+  uint32_t index = 0;
+  int32_t result = 0;
+
+#if defined(__AVX2__)
+  __m256i accumulator = _mm256_setzero_si256();
+#if !(defined(__AVX512VNNI__) && defined(__AVX512VL__))
+  const __m256i ones = _mm256_set1_epi16(1);
+#endif
+  for (; index + 32 <= size; index += 32) {
+    __m256i a = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(activations + index));
+    __m256i b =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + index));
+#if defined(__AVX512VNNI__) && defined(__AVX512VL__)
+    accumulator = _mm256_dpbusd_epi32(accumulator, a, b);
+#else
+    __m256i pairs = _mm256_maddubs_epi16(a, b);
+    accumulator =
+        _mm256_add_epi32(accumulator, _mm256_madd_epi16(pairs, ones));
+#endif
+  }
+  __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(accumulator),
+                              _mm256_extracti128_si256(accumulator, 1));
+  sum = _mm_hadd_epi32(sum, sum);
+  sum = _mm_hadd_epi32(sum, sum);
+  result = _mm_cvtsi128_si32(sum);
+#endif
+
+  for (; index < size; index++) {
+    result += static_cast<int32_t>(activations[index]) *
+              static_cast<int32_t>(weights[index]);
+  }
+  return result;
+}
+
+}  // namespace gladius::quantization
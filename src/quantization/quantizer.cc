@@ -0,0 +1,178 @@
+#include <src/comp_graph/vertices/fully_connected.hpp>
+#include <src/comp_graph/vertices/inner_product.hpp>
+#include <src/comp_graph/vertices/param_vertex.hpp>
+#include <src/parallel/parallel_for.hpp>
+#include <src/quantization/int8_kernels.hpp>
+#include <src/quantization/quantizer.hpp>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace gladius::quantization {
+
+using gladius::comp_graph::FullyConnected;
+using gladius::comp_graph::InnerProduct;
+using gladius::comp_graph::ParameterVertex;
+
+PostTrainingQuantizer::PostTrainingQuantizer(std::shared_ptr<Model> model)
+    : _model(std::move(model)) {}
+
+void PostTrainingQuantizer::observe(Graph& graph) {
+  for (uint32_t index = 0; index < graph.getVerticesCount(); index++) {
+    auto vertex = graph.getVertexAtIndex(index);
+
+    if (auto layer = std::dynamic_pointer_cast<FullyConnected>(vertex)) {
+      observeActivation(layer->getWeights()->getParameter(),
+                        layer->getInput()->getOutput());
+    } else if (auto product =
+                   std::dynamic_pointer_cast<InnerProduct>(vertex)) {
+      auto weights =
+          std::dynamic_pointer_cast<ParameterVertex>(product->getLeftInput());
+      if (weights) {
+        observeActivation(weights->getParameter(),
+                          product->getRightInput()->getOutput());
+      }
+    }
+  }
+}
+
+void PostTrainingQuantizer::observeActivation(
+    const std::shared_ptr<Parameter>& weights,
+    const std::vector<float>& activations) {
+  auto [min_iterator, max_iterator] =
+      std::minmax_element(activations.begin(), activations.end());
+  if (min_iterator == activations.end()) {
+    return;
+  }
+  auto [iterator, inserted] = _activation_ranges.try_emplace(
+      weights.get(), ActivationRange{*min_iterator, *max_iterator});
+  if (!inserted) {
+    iterator->second.min_value =
+        std::min(iterator->second.min_value, *min_iterator);
+    iterator->second.max_value =
+        std::max(iterator->second.max_value, *max_iterator);
+  }
+}
+
+void PostTrainingQuantizer::finalize() {
+  if (_activation_ranges.empty()) {
+    throw std::runtime_error(
+        "Cannot quantize the model before observing any calibration "
+        "sample.");
+  }
+  for (auto& parameter : _model->getParameters()) {
+    auto range = _activation_ranges.find(parameter.get());
+    if (range == _activation_ranges.end()) {
+      continue;
+    }
+    _quantized_weights[parameter.get()] = quantizeWeights(
+        parameter->getValue(),
+        computeActivationParameters(range->second.min_value,
+                                    range->second.max_value));
+  }
+}
+
+std::shared_ptr<const QuantizedLinear>
+PostTrainingQuantizer::getQuantizedLinear(
+    const std::shared_ptr<Parameter>& weights) const {
+  auto iterator = _quantized_weights.find(weights.get());
+  if (iterator == _quantized_weights.end()) {
+    throw std::invalid_argument(
+        "The given parameter was not quantized. Make sure that it multiplies "
+        "an activation observed during calibration and that finalize() was "
+        "called.");
+  }
+  return iterator->second;
+}
+
+QuantizationReport PostTrainingQuantizer::report(
+    const std::vector<uint32_t>& labels,
+    const std::vector<uint32_t>& fp32_predictions,
+    const std::vector<uint32_t>& int8_predictions) const {
+  if (labels.empty() || fp32_predictions.size() != labels.size() ||
+      int8_predictions.size() != labels.size()) {
+    throw std::invalid_argument(
+        "Expected one fp32 and one int8 prediction for each of the " +
+        std::to_string(labels.size()) + " labels.");
+  }
+  uint32_t fp32_correct = 0;
+  uint32_t int8_correct = 0;
+  for (uint32_t index = 0; index < labels.size(); index++) {
+    fp32_correct += fp32_predictions[index] == labels[index];
+    int8_correct += int8_predictions[index] == labels[index];
+  }
+
+  QuantizationReport report{};
+  report.fp32_accuracy = static_cast<float>(fp32_correct) / labels.size();
+  report.int8_accuracy = static_cast<float>(int8_correct) / labels.size();
+  report.accuracy_delta = report.int8_accuracy - report.fp32_accuracy;
+  for (auto& [parameter, quantized] : _quantized_weights) {
+    report.fp32_weight_bytes += quantized->rows * quantized->columns *
+                                static_cast<uint64_t>(sizeof(float));
+    report.int8_weight_bytes += quantized->getMemoryFootprintBytes();
+  }
+  return report;
+}
+
+QuantizationParameters PostTrainingQuantizer::computeActivationParameters(
+    float min_value, float max_value) {
+  // The range must contain zero so that zero is exactly representable
+  min_value = std::min(min_value, 0.F);
+  max_value = std::max(max_value, 0.F);
+
+  QuantizationParameters parameters;
+  float range = max_value - min_value;
+  if (range == 0.F) {
+    return parameters;
+  }
+  parameters.scale = range / MAX_QUANTIZED_ACTIVATION;
+  parameters.zero_point = std::clamp<int32_t>(
+      static_cast<int32_t>(std::lround(-min_value / parameters.scale)), 0,
+      MAX_QUANTIZED_ACTIVATION);
+  return parameters;
+}
+
+std::shared_ptr<QuantizedLinear> PostTrainingQuantizer::quantizeWeights(
+    const std::vector<std::vector<float>>& weights,
+    QuantizationParameters input) {
+  auto quantized = std::make_shared<QuantizedLinear>();
+  quantized->rows = weights.size();
+  quantized->columns = weights.at(0).size();
+  quantized->weights.resize(static_cast<uint64_t>(quantized->rows) *
+                            quantized->columns);
+  quantized->weight_scales.resize(quantized->rows);
+  quantized->weight_row_sums.resize(quantized->rows);
+  quantized->input = input;
+  int32_t max_weight = MAX_QUANTIZED_WEIGHT;
+
+  parallel::parallelFor(
+      0, quantized->rows,
+      [&](uint64_t begin, uint64_t end) {
+        for (uint64_t row = begin; row < end; row++) {
+          float max_magnitude = 0.F;
+          for (float weight : weights[row]) {
+            max_magnitude = std::max(max_magnitude, std::abs(weight));
+          }
+          float scale =
+              max_magnitude > 0.F ? max_magnitude / max_weight : 1.F;
+
+          int8_t* quantized_row =
+              quantized->weights.data() + row * quantized->columns;
+          int32_t row_sum = 0;
+          for (uint32_t col = 0; col < quantized->columns; col++) {
+            auto value = std::clamp<int32_t>(
+                std::lround(weights[row][col] / scale), -max_weight,
+                max_weight);
+            quantized_row[col] = static_cast<int8_t>(value);
+            row_sum += value;
+          }
+          quantized->weight_scales[row] = scale;
+          quantized->weight_row_sums[row] = row_sum;
+        }
+      },
+      parallel::grainSize(/* work_per_iteration = */ quantized->columns));
+  return quantized;
+}
+
+}  // namespace gladius::quantization
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <src/comp_graph/graph.hpp>
+#include <src/model.hpp>
+#include <src/params/parameters.hpp>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace gladius::quantization {
+
+using gladius::comp_graph::Graph;
+using gladius::parameters::Parameter;
+
+/**
+ * Affine quantization x ~ scale * (q - zero_point)
+ */
+struct QuantizationParameters {
+  float scale = 1.F;
+  int32_t zero_point = 0;
+};
+
+/**
+ * Int8 copy of a (m, n) weight matrix W together with the quantization
+ * parameters of the activations it multiplies.
+ *    - Weights are quantized symmetrically per output channel (row), i.e.,
+ *      W_r ~ weight_scales[r] * q_r with q_r in [-127, 127] and a zero point
+ *      of zero, which keeps the inner loop a plain integer dot product.
+ *    - Activations are quantized asymmetrically per tensor with a scale and
+ *      zero point derived from the range observed during calibration.
+ * The sums of every quantized row are precomputed to correct for the
+ * activation zero point in the epilogue.
+ */
+struct QuantizedLinear {
+  uint32_t rows;
+  uint32_t columns;
+  std::vector<int8_t> weights;
+  std::vector<float> weight_scales;
+  std::vector<int32_t> weight_row_sums;
+  QuantizationParameters input;
+
+  uint64_t getMemoryFootprintBytes() const {
+    return weights.size() * sizeof(int8_t) +
+           weight_scales.size() * sizeof(float) +
+           weight_row_sums.size() * sizeof(int32_t);
+  }
+};
+
+struct QuantizationReport {
+  float fp32_accuracy;
+  float int8_accuracy;
+  // int8 accuracy minus fp32 accuracy
+  float accuracy_delta;
+  uint64_t fp32_weight_bytes;
+  uint64_t int8_weight_bytes;
+};
+
+/**
+ * Post-training quantization of the weights of a trained model.
+ *
+ * Calibration runs the fp32 graph on a small set of representative samples
+ * and calls observe() after each forward pass. This records the range of
+ * the input to every FullyConnected and InnerProduct vertex, keyed by its
+ * weight parameter. finalize() then quantizes each of those weights, after
+ * which the QuantizedLinear of a parameter can be used to build an int8
+ * inference graph (see QuantizedFullyConnected).
+ */
+class PostTrainingQuantizer {
+ public:
+  explicit PostTrainingQuantizer(std::shared_ptr<Model> model);
+
+  void observe(Graph& graph);
+
+  void finalize();
+
+  std::shared_ptr<const QuantizedLinear> getQuantizedLinear(
+      const std::shared_ptr<Parameter>& weights) const;
+
+  /**
+   * Compares the predictions of the fp32 and int8 models on the same
+   * evaluation samples and reports the accuracy delta and weight sizes.
+   */
+  QuantizationReport report(
+      const std::vector<uint32_t>& labels,
+      const std::vector<uint32_t>& fp32_predictions,
+      const std::vector<uint32_t>& int8_predictions) const;
+
+  static QuantizationParameters computeActivationParameters(float min_value,
+                                                            float max_value);
+
+  static std::shared_ptr<QuantizedLinear> quantizeWeights(
+      const std::vector<std::vector<float>>& weights,
+      QuantizationParameters input);
+
+ private:
+  struct ActivationRange {
+    float min_value;
+    float max_value;
+  };
+
+  void observeActivation(const std::shared_ptr<Parameter>& weights,
+                         const std::vector<float>& activations);
+
+  std::shared_ptr<Model> _model;
+  std::unordered_map<const Parameter*, ActivationRange> _activation_ranges;
+  std::unordered_map<const Parameter*, std::shared_ptr<QuantizedLinear>>
+      _quantized_weights;
+};
+
+}  // namespace gladius::quantization
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace gladius::sampling {
+
+enum class ProposalDistribution { Uniform, LogUniform, Unigram };
+
+/**
+ * Draws candidate classes in [0, V) from a proposal distribution Q. This is
+ * used by sampled losses, which only evaluate the logits of the true class
+ * and of a few sampled negatives.
+ *    - Uniform:     Q(c) = 1 / V
+ *    - LogUniform:  Q(c) = log((c + 2) / (c + 1)) / log(V + 1), i.e., a
+ *                   Zipfian distribution which is appropriate when the class
+ *                   ids are sorted by decreasing frequency.
+ *    - Unigram:     Q(c) proportional to a given positive count of class c.
+ *                   Sampling uses Vose's alias method, which takes O(V) to
+ *                   build the tables and O(1) per sample.
+ *
+ * A sampler owns its random number generator, so it must not be shared by
+ * concurrently running vertices.
+ */
+class CandidateSampler {
+ public:
+  static CandidateSampler uniform(uint32_t num_classes, uint32_t seed = 0) {
+    return CandidateSampler(ProposalDistribution::Uniform, num_classes, seed);
+  }
+
+  static CandidateSampler logUniform(uint32_t num_classes, uint32_t seed = 0) {
+    return CandidateSampler(ProposalDistribution::LogUniform, num_classes,
+                            seed);
+  }
+
+  static CandidateSampler unigram(const std::vector<float>& class_counts,
+                                  uint32_t seed = 0) {
+    CandidateSampler sampler(ProposalDistribution::Unigram,
+                             class_counts.size(), seed);
+    sampler.buildAliasTable(class_counts);
+    return sampler;
+  }
+
+  uint32_t sample() {
+    switch (_distribution) {
+      case ProposalDistribution::Uniform:
+        return std::min<uint32_t>(_num_classes * _uniform(_generator),
+                                  _num_classes - 1);
+      case ProposalDistribution::LogUniform: {
+        // Inverse of the CDF F(c) = log(c + 1) / log(V + 1)
+        auto candidate = static_cast<uint32_t>(
+            std::exp(_uniform(_generator) * _log_range) - 1.0);
+        return std::min<uint32_t>(candidate, _num_classes - 1);
+      }
+      case ProposalDistribution::Unigram: {
+        auto bucket = std::min<uint32_t>(_num_classes * _uniform(_generator),
+                                         _num_classes - 1);
+        return _uniform(_generator) < _alias_probabilities[bucket]
+                   ? bucket
+                   : _aliases[bucket];
+      }
+    }
+    throw std::logic_error("Unknown proposal distribution.");
+  }
+
+  float probability(uint32_t class_index) const {
+    switch (_distribution) {
+      case ProposalDistribution::Uniform:
+        return 1.F / _num_classes;
+      case ProposalDistribution::LogUniform:
+        return static_cast<float>(
+            std::log((class_index + 2.0) / (class_index + 1.0)) / _log_range);
+      case ProposalDistribution::Unigram:
+        return _probabilities[class_index];
+    }
+    throw std::logic_error("Unknown proposal distribution.");
+  }
+
+  inline uint32_t getNumClasses() const { return _num_classes; }
+  inline ProposalDistribution getDistribution() const { return _distribution; }
+
+ private:
+  CandidateSampler(ProposalDistribution distribution, uint32_t num_classes,
+                   uint32_t seed)
+      : _distribution(distribution),
+        _num_classes(num_classes),
+        _log_range(std::log(num_classes + 1.0)),
+        _generator(seed),
+        _uniform(0.0, 1.0) {
+    if (!num_classes) {
+      throw std::invalid_argument(
+          "Cannot sample candidates from an empty set of classes.");
+    }
+  }
+
+  void buildAliasTable(const std::vector<float>& class_counts) {
+    double total = 0.0;
+    for (float count : class_counts) {
+      // Sampled losses subtract log Q(c) from the logit of the true class,
+      // which is -inf for a class with a zero count
+      if (!(count > 0.F)) {
+        throw std::invalid_argument(
+            "Unigram class counts must be positive. Got " +
+            std::to_string(count) + ".");
+      }
+      total += count;
+    }
+
+    _probabilities.resize(_num_classes);
+    _alias_probabilities.resize(_num_classes);
+    _aliases.resize(_num_classes);
+
+    // Buckets are scaled so that the average bucket has mass 1. Buckets with
+    // less mass than that are topped up by a single bucket with more.
+    std::vector<double> scaled(_num_classes);
+    std::vector<uint32_t> small, large;
+    for (uint32_t index = 0; index < _num_classes; index++) {
+      _probabilities[index] = static_cast<float>(class_counts[index] / total);
+      scaled[index] = class_counts[index] / total * _num_classes;
+      (scaled[index] < 1.0 ? small : large).push_back(index);
+    }
+    while (!small.empty() && !large.empty()) {
+      uint32_t less = small.back();
+      uint32_t more = large.back();
+      small.pop_back();
+
+      _alias_probabilities[less] = static_cast<float>(scaled[less]);
+      _aliases[less] = more;
+      scaled[more] -= (1.0 - scaled[less]);
+      if (scaled[more] < 1.0) {
+        large.pop_back();
+        small.push_back(more);
+      }
+    }
+    // Whatever is left has mass 1 up to rounding errors
+    for (uint32_t index : small) {
+      _alias_probabilities[index] = 1.F;
+      _aliases[index] = index;
+    }
+    for (uint32_t index : large) {
+      _alias_probabilities[index] = 1.F;
+      _aliases[index] = index;
+    }
+  }
+
+  ProposalDistribution _distribution;
+  uint32_t _num_classes;
+  double _log_range;
+
+  std::mt19937 _generator;
+  std::uniform_real_distribution<double> _uniform;
+
+  // Only used by the unigram distribution
+  std::vector<float> _probabilities;
+  std::vector<float> _alias_probabilities;
+  std::vector<uint32_t> _aliases;
+};
+
+}  // namespace gladius::sampling
@@ -0,0 +1,347 @@
+#pragma once
+
+#include <src/parallel/parallel_for.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace gladius::sampling {
+
+enum class HashFunction { SimHash, DWTA };
+
+/**
+ * Controls how often the hash tables catch up with the weights they index.
+ * Rows whose weights received a gradient are re-hashed every
+ * `initial_interval` queries at first. After each rebuild, the interval is
+ * multiplied by `growth`, since weights move less as training converges.
+ */
+struct RebuildSchedule {
+  uint32_t initial_interval = 50;
+  float growth = 1.F;
+};
+
+/**
+ * L locality sensitive hash tables over the rows of a (m, n) weight matrix as
+ * used by SLIDE (https://arxiv.org/pdf/1903.03129.pdf). Each table combines
+ * K hash functions into a bucket id. A query returns the rows that collide
+ * with the query vector in at least one table, which are likely to have a
+ * large inner product with it.
+ *    - SimHash: each hash is the sign of a sparse random projection with
+ *      entries in {-1, +1}, one bit per hash.
+ *    - DWTA: densified winner-take-all hashing. Each hash is the position of
+ *      the largest coordinate in a random bin of `bin_size` coordinates.
+ *      Bins without any non-zero coordinate (frequent for sparse inputs)
+ *      borrow the code of the next non-empty hash.
+ *
+ * Queries can run concurrently. Re-hashing takes an exclusive lock and
+ * processes the tables in parallel; only the rows marked since the last
+ * rebuild are moved between buckets.
+ */
+class LSHTables {
+ public:
+  LSHTables(HashFunction hash_function, uint32_t dimension,
+            uint32_t num_tables, uint32_t hashes_per_table,
+            RebuildSchedule schedule = RebuildSchedule(),
+            uint32_t bucket_capacity = 128, uint32_t bin_size = 8,
+            uint32_t seed = 0)
+      : _hash_function(hash_function),
+        _dimension(dimension),
+        _num_tables(num_tables),
+        _hashes_per_table(hashes_per_table),
+        _bucket_capacity(bucket_capacity),
+        _bin_size(bin_size),
+        _schedule(schedule),
+        _rebuild_interval(std::max<uint32_t>(schedule.initial_interval, 1)) {
+    uint32_t bits_per_hash =
+        hash_function == HashFunction::SimHash
+            ? 1
+            : static_cast<uint32_t>(std::ceil(std::log2(bin_size)));
+    if (!dimension || !num_tables || !hashes_per_table ||
+        (hash_function == HashFunction::DWTA && bin_size < 2)) {
+      throw std::invalid_argument(
+          "LSHTables requires a positive dimension, number of tables and "
+          "hashes per table, and DWTA bins of at least 2 coordinates.");
+    }
+    _num_buckets = 1U << std::min<uint32_t>(
+                       bits_per_hash * hashes_per_table, MAX_BUCKET_BITS);
+    _buckets.resize(static_cast<uint64_t>(_num_tables) * _num_buckets);
+    initializeHashFunctions(seed);
+  }
+
+  LSHTables(const LSHTables&) = delete;
+  LSHTables& operator=(const LSHTables&) = delete;
+
+  /**
+   * Hashes every row of the weight matrix from scratch
+   */
+  void build(const std::vector<std::vector<float>>& rows) {
+    std::unique_lock lock(_tables_mutex);
+    if (rows.at(0).size() != _dimension) {
+      throw std::invalid_argument(
+          "The rows indexed by the hash tables must have dimension " +
+          std::to_string(_dimension) + ". Got " +
+          std::to_string(rows.at(0).size()) + ".");
+    }
+    uint32_t num_rows = rows.size();
+    _row_buckets.assign(static_cast<uint64_t>(_num_tables) * num_rows, 0);
+    _pending_rows.clear();
+    _is_pending.assign(num_rows, false);
+
+    // Tables are independent, so each one is rebuilt by a single task
+    parallel::parallelFor(
+        0, _num_tables,
+        [&](uint64_t begin, uint64_t end) {
+          std::vector<uint32_t> codes(_hashes_per_table);
+          for (uint64_t table = begin; table < end; table++) {
+            for (uint32_t bucket = 0; bucket < _num_buckets; bucket++) {
+              bucketAt(table, bucket).clear();
+            }
+            for (uint32_t row = 0; row < num_rows; row++) {
+              uint32_t bucket = hash(table, rows[row].data(), codes);
+              insert(table, bucket, row);
+              _row_buckets[table * num_rows + row] = bucket;
+            }
+          }
+        },
+        parallel::grainSize(/* work_per_iteration = */ hashWork(num_rows)));
+    _num_rows = num_rows;
+  }
+
+  /**
+   * Returns the rows colliding with the input in at least one table. A row
+   * may appear several times in the result.
+   */
+  void query(const float* input, std::vector<uint32_t>& candidates) const {
+    std::shared_lock lock(_tables_mutex);
+    std::vector<uint32_t> codes(_hashes_per_table);
+    for (uint32_t table = 0; table < _num_tables; table++) {
+      auto& bucket = bucketAt(table, hash(table, input, codes));
+      candidates.insert(candidates.end(), bucket.begin(), bucket.end());
+    }
+  }
+
+  /**
+   * Records that the weights of a row changed, so that it gets re-hashed at
+   * the next scheduled rebuild.
+   */
+  void markForRehash(uint32_t row) {
+    std::lock_guard lock(_pending_mutex);
+    if (!_is_pending[row]) {
+      _is_pending[row] = true;
+      _pending_rows.push_back(row);
+    }
+  }
+
+  /**
+   * Counts one step of the rebuild schedule, and re-hashes the rows marked
+   * since the last rebuild if the current interval has elapsed.
+   */
+  void step(const std::vector<std::vector<float>>& rows) {
+    {
+      std::lock_guard lock(_pending_mutex);
+      if (++_steps_since_rebuild < _rebuild_interval) {
+        return;
+      }
+      _steps_since_rebuild = 0;
+      _rebuild_interval = std::max<uint32_t>(
+          1, static_cast<uint32_t>(_rebuild_interval * _schedule.growth));
+    }
+    rehashPendingRows(rows);
+  }
+
+  inline uint32_t getDimension() const { return _dimension; }
+  inline uint32_t getNumTables() const { return _num_tables; }
+  inline uint32_t getNumRows() const { return _num_rows; }
+
+ private:
+  // Caps the number of buckets of a table to 2^20
+  static constexpr uint32_t MAX_BUCKET_BITS = 20;
+
+  void initializeHashFunctions(uint32_t seed) {
+    std::mt19937 generator(seed);
+    uint64_t num_hashes =
+        static_cast<uint64_t>(_num_tables) * _hashes_per_table;
+
+    if (_hash_function == HashFunction::SimHash) {
+      // Sparse projections over a third of the coordinates
+      _sample_size = std::max<uint32_t>(1, _dimension / 3);
+    } else {
+      _sample_size = _bin_size;
+    }
+    _coordinates.resize(num_hashes * _sample_size);
+    _signs.resize(_hash_function == HashFunction::SimHash
+                      ? num_hashes * _sample_size
+                      : 0);
+
+    std::vector<uint32_t> permutation(_dimension);
+    std::iota(permutation.begin(), permutation.end(), 0);
+    std::bernoulli_distribution coin(0.5);
+    for (uint64_t hash = 0; hash < num_hashes; hash++) {
+      for (uint32_t index = 0; index < _sample_size; index++) {
+        // Partial Fisher-Yates shuffle. Bins may repeat coordinates when the
+        // dimension is smaller than the bin size.
+        uint32_t position = index % _dimension;
+        std::uniform_int_distribution<uint32_t> pick(position, _dimension - 1);
+        std::swap(permutation[position], permutation[pick(generator)]);
+        _coordinates[hash * _sample_size + index] = permutation[position];
+        if (!_signs.empty()) {
+          _signs[hash * _sample_size + index] = coin(generator) ? 1 : -1;
+        }
+      }
+    }
+  }
+
+  /**
+   * Computes the bucket id of a vector in the given table. `codes` is a
+   * scratch buffer with one entry per hash of the table.
+   */
+  // Scalar operations taken to hash `num_rows` rows into one table
+  inline uint64_t hashWork(uint64_t num_rows) const {
+    return num_rows * _hashes_per_table * _sample_size;
+  }
+
+  uint32_t hash(uint32_t table, const float* vector,
+                std::vector<uint32_t>& codes) const {
+    uint64_t first_hash = static_cast<uint64_t>(table) * _hashes_per_table;
+    const uint32_t* coordinates =
+        _coordinates.data() + first_hash * _sample_size;
+
+    if (_hash_function == HashFunction::SimHash) {
+      const int8_t* signs = _signs.data() + first_hash * _sample_size;
+      uint32_t bucket = 0;
+      for (uint32_t hash = 0; hash < _hashes_per_table; hash++) {
+        float projection = 0.F;
+        for (uint32_t index = 0; index < _sample_size; index++) {
+          uint32_t offset = hash * _sample_size + index;
+          projection += signs[offset] * vector[coordinates[offset]];
+        }
+        bucket = (bucket << 1) | (projection >= 0.F);
+      }
+      return bucket & (_num_buckets - 1);
+    }
+
+    constexpr uint32_t EMPTY_BIN = UINT32_MAX;
+    bool has_non_empty_bin = false;
+    for (uint32_t hash = 0; hash < _hashes_per_table; hash++) {
+      const uint32_t* bin = coordinates + hash * _sample_size;
+      float max_value = 0.F;
+      codes[hash] = EMPTY_BIN;
+      for (uint32_t index = 0; index < _sample_size; index++) {
+        float value = vector[bin[index]];
+        if (value != 0.F && (codes[hash] == EMPTY_BIN || value > max_value)) {
+          max_value = value;
+          codes[hash] = index;
+        }
+      }
+      has_non_empty_bin |= codes[hash] != EMPTY_BIN;
+    }
+    uint32_t bucket = 0;
+    for (uint32_t hash = 0; hash < _hashes_per_table; hash++) {
+      uint32_t code = 0;
+      if (has_non_empty_bin) {
+        uint32_t donor = hash;
+        while (codes[donor] == EMPTY_BIN) {
+          donor = (donor + 1) % _hashes_per_table;
+        }
+        code = codes[donor];
+      }
+      bucket = bucket * _bin_size + code;
+    }
+    return bucket & (_num_buckets - 1);
+  }
+
+  inline std::vector<uint32_t>& bucketAt(uint32_t table, uint32_t bucket) {
+    return _buckets[static_cast<uint64_t>(table) * _num_buckets + bucket];
+  }
+
+  inline const std::vector<uint32_t>& bucketAt(uint32_t table,
+                                               uint32_t bucket) const {
+    return _buckets[static_cast<uint64_t>(table) * _num_buckets + bucket];
+  }
+
+  inline void insert(uint32_t table, uint32_t bucket, uint32_t row) {
+    auto& rows = bucketAt(table, bucket);
+    // Rows hashed into a full bucket are dropped from this table
+    if (rows.size() < _bucket_capacity) {
+      rows.push_back(row);
+    }
+  }
+
+  void rehashPendingRows(const std::vector<std::vector<float>>& rows) {
+    std::vector<uint32_t> pending;
+    {
+      std::lock_guard lock(_pending_mutex);
+      pending.swap(_pending_rows);
+      for (uint32_t row : pending) {
+        _is_pending[row] = false;
+      }
+    }
+    if (pending.empty()) {
+      return;
+    }
+    std::unique_lock lock(_tables_mutex);
+
+    parallel::parallelFor(
+        0, _num_tables,
+        [&](uint64_t begin, uint64_t end) {
+          std::vector<uint32_t> codes(_hashes_per_table);
+          for (uint64_t table = begin; table < end; table++) {
+            for (uint32_t row : pending) {
+              uint32_t& current_bucket = _row_buckets[table * _num_rows + row];
+              uint32_t new_bucket = hash(table, rows[row].data(), codes);
+              if (new_bucket == current_bucket) {
+                continue;
+              }
+              auto& old_rows = bucketAt(table, current_bucket);
+              auto iterator =
+                  std::find(old_rows.begin(), old_rows.end(), row);
+              if (iterator != old_rows.end()) {
+                *iterator = old_rows.back();
+                old_rows.pop_back();
+              }
+              insert(table, new_bucket, row);
+              current_bucket = new_bucket;
+            }
+          }
+        },
+        parallel::grainSize(
+            /* work_per_iteration = */ hashWork(pending.size())));
+  }
+
+  HashFunction _hash_function;
+  uint32_t _dimension;
+  uint32_t _num_tables;
+  uint32_t _hashes_per_table;
+  uint32_t _bucket_capacity;
+  uint32_t _bin_size;
+  uint32_t _num_buckets;
+  uint32_t _num_rows = 0;
+
+  // Coordinates (and signs for SimHash) of every hash function, laid out as
+  // [table][hash][sample]
+  uint32_t _sample_size;
+  std::vector<uint32_t> _coordinates;
+  std::vector<int8_t> _signs;
+
+  // Rows of each bucket laid out as [table][bucket], and the bucket of each
+  // row laid out as [table][row]
+  std::vector<std::vector<uint32_t>> _buckets;
+  std::vector<uint32_t> _row_buckets;
+  mutable std::shared_mutex _tables_mutex;
+
+  RebuildSchedule _schedule;
+  uint32_t _rebuild_interval;
+  uint32_t _steps_since_rebuild = 0;
+  std::vector<uint32_t> _pending_rows;
+  std::vector<bool> _is_pending;
+  std::mutex _pending_mutex;
+};
+
+}  // namespace gladius::sampling
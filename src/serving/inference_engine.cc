@@ -0,0 +1,193 @@
+#include <src/comp_graph/vertices/vertex.hpp>
+#include <src/serving/inference_engine.hpp>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace gladius::serving {
+
+using gladius::comp_graph::NoGradGuard;
+
+InferenceEngine::InferenceEngine(BatchGraphBuilder builder,
+                                 uint32_t input_dimension,
+                                 BatchingPolicy policy)
+    : _builder(std::move(builder)),
+      _input_dimension(input_dimension),
+      _policy(policy) {
+  if (_policy.max_batch_size == 0) {
+    throw std::invalid_argument("The maximum batch size must be positive.");
+  }
+  _dispatcher = std::thread([this] { dispatch(); });
+}
+
+InferenceEngine::~InferenceEngine() {
+  _stopping.store(true, std::memory_order_seq_cst);
+  // A submit() that has not seen _stopping is about to enqueue its request,
+  // which must come before the shutdown request
+  auto pending = _pending_submits.load(std::memory_order_seq_cst);
+  while (pending != 0) {
+    _pending_submits.wait(pending, std::memory_order_seq_cst);
+    pending = _pending_submits.load(std::memory_order_seq_cst);
+  }
+  Request shutdown;
+  shutdown.shutdown = true;
+  enqueue(std::move(shutdown));
+  _dispatcher.join();
+}
+
+std::future<std::vector<float>> InferenceEngine::submit(
+    std::vector<float> input) {
+  if (input.size() != _input_dimension) {
+    throw std::invalid_argument(
+        "Expected an input of dimension " + std::to_string(_input_dimension) +
+        ". Got instead an input of dimension " + std::to_string(input.size()) +
+        ".");
+  }
+  // Either the destructor sees this submission pending and waits for it, or
+  // the submission sees _stopping
+  _pending_submits.fetch_add(1, std::memory_order_seq_cst);
+  if (_stopping.load(std::memory_order_seq_cst)) {
+    if (_pending_submits.fetch_sub(1, std::memory_order_seq_cst) == 1) {
+      _pending_submits.notify_all();
+    }
+    throw std::runtime_error(
+        "Cannot submit a request to an inference engine that is shutting "
+        "down.");
+  }
+  Request request;
+  request.input = std::move(input);
+  request.enqueue_time = std::chrono::steady_clock::now();
+  auto response = request.response.get_future();
+  enqueue(std::move(request));
+  if (_pending_submits.fetch_sub(1, std::memory_order_seq_cst) == 1) {
+    _pending_submits.notify_all();
+  }
+  return response;
+}
+
+void InferenceEngine::enqueue(Request request) {
+  _queue.push(std::move(request));
+  _submitted.fetch_add(1, std::memory_order_seq_cst);
+  // Either the dispatcher sees the new count before it waits, or we see it
+  // waiting and wake it up. Taking the mutex makes sure it is blocked on
+  // _wakeup, and not between its check and the wait, when we notify it.
+  if (_dispatcher_waiting.load(std::memory_order_seq_cst)) {
+    std::lock_guard<std::mutex> lock(_wakeup_mutex);
+    _wakeup.notify_one();
+  }
+}
+
+bool InferenceEngine::waitForRequest(
+    uint64_t seen,
+    std::optional<std::chrono::steady_clock::time_point> deadline) {
+  std::unique_lock<std::mutex> lock(_wakeup_mutex);
+  _dispatcher_waiting.store(true, std::memory_order_seq_cst);
+  auto pushed = [&] {
+    return _submitted.load(std::memory_order_seq_cst) != seen;
+  };
+  bool woken = true;
+  if (deadline) {
+    woken = _wakeup.wait_until(lock, *deadline, pushed);
+  } else {
+    _wakeup.wait(lock, pushed);
+  }
+  _dispatcher_waiting.store(false, std::memory_order_relaxed);
+  return woken;
+}
+
+void InferenceEngine::dispatch() {
+  bool shutdown = false;
+  std::vector<Request> batch;
+  batch.reserve(_policy.max_batch_size);
+
+  // Pops the next request if one is visible, and returns false otherwise
+  auto pop = [&]() {
+    Request request;
+    if (!_queue.tryPop(request)) {
+      return false;
+    }
+    if (request.shutdown) {
+      shutdown = true;
+    } else {
+      batch.push_back(std::move(request));
+    }
+    return true;
+  };
+
+  // The count of pushed requests is read before trying to pop, so a request
+  // pushed after a failed pop always ends the wait that follows. A failed
+  // pop with older requests in the queue means that a producer is still
+  // linking its request, and its push ends the wait.
+  while (!shutdown) {
+    auto seen = _submitted.load(std::memory_order_seq_cst);
+    if (!pop()) {
+      waitForRequest(seen, /* deadline = */ std::nullopt);
+      continue;
+    }
+    if (batch.empty()) {
+      continue;
+    }
+
+    auto deadline = batch.front().enqueue_time + _policy.max_wait;
+    while (!shutdown && batch.size() < _policy.max_batch_size) {
+      seen = _submitted.load(std::memory_order_seq_cst);
+      if (pop()) {
+        continue;
+      }
+      if (!waitForRequest(seen, deadline)) {
+        break;
+      }
+    }
+    executeBatch(batch);
+    batch.clear();
+  }
+
+  // Requests pushed before the shutdown request was popped
+  if (!batch.empty()) {
+    executeBatch(batch);
+  }
+}
+
+void InferenceEngine::executeBatch(std::vector<Request>& batch) {
+  auto batch_size = static_cast<uint32_t>(batch.size());
+  std::vector<std::vector<float>> responses;
+  try {
+    std::vector<float> inputs;
+    inputs.reserve(static_cast<uint64_t>(batch_size) * _input_dimension);
+    for (auto& request : batch) {
+      inputs.insert(inputs.end(), request.input.begin(), request.input.end());
+    }
+
+    NoGradGuard no_grad;
+    auto graph = _builder(inputs, batch_size);
+    graph->eliminateRedundantVertices();
+    graph->foldConstants(&_folded_constants);
+    auto& output = graph->launchInferencePass()->getOutput();
+    if (output.size() % batch_size != 0) {
+      throw std::runtime_error(
+          "The output of the inference graph must have one row per request "
+          "in the batch.");
+    }
+
+    auto output_dimension = output.size() / batch_size;
+    responses.reserve(batch_size);
+    for (uint32_t index = 0; index < batch_size; index++) {
+      auto row = output.begin() + index * output_dimension;
+      responses.emplace_back(row, row + output_dimension);
+    }
+  } catch (...) {
+    for (auto& request : batch) {
+      request.response.set_exception(std::current_exception());
+    }
+    responses.clear();
+  }
+
+  for (uint32_t index = 0; index < responses.size(); index++) {
+    batch[index].response.set_value(std::move(responses[index]));
+  }
+  _request_count.fetch_add(batch_size, std::memory_order_relaxed);
+  _batch_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+}  // namespace gladius::serving
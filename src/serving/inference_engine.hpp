@@ -0,0 +1,135 @@
+#pragma once
+
+#include <src/comp_graph/graph.hpp>
+#include <src/serving/mpsc_queue.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace gladius::serving {
+
+using gladius::comp_graph::FoldedConstantCache;
+using gladius::comp_graph::Graph;
+
+/**
+ * A batch is executed as soon as it holds max_batch_size requests, or once
+ * its oldest request has waited for max_wait, whichever comes first.
+ * max_batch_size = 1 executes every request on its own.
+ */
+struct BatchingPolicy {
+  uint32_t max_batch_size = 32;
+  std::chrono::microseconds max_wait = std::chrono::microseconds(500);
+};
+
+/**
+ * Builds the graph for a batch of `batch_size` inputs laid out row by row in
+ * `inputs`. The output of the last vertex before the loss (if any) must have
+ * shape (batch_size, output_dimension). The graph is always built under a
+ * NoGradGuard, so it holds no gradient state.
+ */
+using BatchGraphBuilder = std::function<std::shared_ptr<Graph>(
+    std::vector<float>& inputs, uint32_t batch_size)>;
+
+/**
+ * Serves single-sample inference requests from any number of threads.
+ *
+ * Requests are pushed onto a lock-free MPSC queue and a dispatcher thread
+ * coalesces them into batches under the given BatchingPolicy. Each batch is
+ * run through one forward-only graph, which turns per-request matrix-vector
+ * products into matrix-matrix products over the batch, and the row of the
+ * output that belongs to every request completes its future. Before it
+ * runs, duplicate and dead vertices are removed and whatever only depends on
+ * parameters is folded into constants (see Graph::foldConstants()). The
+ * constants are computed once for all batches, so the parameters must not
+ * change while the engine runs.
+ *
+ * The dispatcher sleeps on a condition variable while it waits for requests
+ * or for the deadline of a batch, so an idle engine does not take a core
+ * away from the batches. The destructor executes every request accepted by
+ * submit(), so no future is left without a value, and submit() throws once
+ * the destructor has started.
+ */
+class InferenceEngine {
+ public:
+  InferenceEngine(BatchGraphBuilder builder, uint32_t input_dimension,
+                  BatchingPolicy policy = {});
+
+  InferenceEngine(const InferenceEngine&) = delete;
+  InferenceEngine& operator=(const InferenceEngine&) = delete;
+
+  ~InferenceEngine();
+
+  /**
+   * Enqueues one input of size input_dimension. The future holds the
+   * corresponding row of the output, or the exception thrown while running
+   * its batch. Throws std::runtime_error if the engine is shutting down.
+   */
+  std::future<std::vector<float>> submit(std::vector<float> input);
+
+  uint64_t getRequestCount() const {
+    return _request_count.load(std::memory_order_relaxed);
+  }
+  uint64_t getBatchCount() const {
+    return _batch_count.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Request {
+    std::vector<float> input;
+    std::promise<std::vector<float>> response;
+    std::chrono::steady_clock::time_point enqueue_time;
+    // Pushed by the destructor after every other request
+    bool shutdown = false;
+  };
+
+  void enqueue(Request request);
+
+  /**
+   * Blocks the dispatcher until _submitted differs from `seen` or until
+   * `deadline`, if any. Returns false on timeout.
+   */
+  bool waitForRequest(
+      uint64_t seen,
+      std::optional<std::chrono::steady_clock::time_point> deadline);
+
+  void dispatch();
+
+  void executeBatch(std::vector<Request>& batch);
+
+  BatchGraphBuilder _builder;
+  uint32_t _input_dimension;
+  BatchingPolicy _policy;
+  // Only used by the dispatcher thread
+  FoldedConstantCache _folded_constants;
+
+  MPSCQueue<Request> _queue;
+  // Number of requests pushed so far. The dispatcher waits for it to change
+  // when the queue looks empty.
+  std::atomic<uint64_t> _submitted{0};
+  // Set while the dispatcher waits on _wakeup, so that producers only take
+  // _wakeup_mutex when there is someone to wake up
+  std::atomic<bool> _dispatcher_waiting{false};
+  std::mutex _wakeup_mutex;
+  std::condition_variable _wakeup;
+
+  std::atomic<bool> _stopping{false};
+  // Calls to submit() that passed the _stopping check and have not enqueued
+  // their request yet. The destructor waits for them before it enqueues the
+  // shutdown request.
+  std::atomic<uint32_t> _pending_submits{0};
+
+  std::atomic<uint64_t> _request_count{0};
+  std::atomic<uint64_t> _batch_count{0};
+
+  std::thread _dispatcher;
+};
+
+}  // namespace gladius::serving
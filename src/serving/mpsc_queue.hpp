@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+namespace gladius::serving {
+
+/**
+ * Unbounded lock-free multi-producer single-consumer queue (D. Vyukov's
+ * intrusive MPSC queue). Producers link a new node with a single atomic
+ * exchange on the head, so push() never blocks nor retries. Only one
+ * thread may call tryPop().
+ *
+ * A producer that has exchanged the head but not yet linked its node makes
+ * the queue look empty to the consumer for a moment, even if older nodes
+ * follow. tryPop() then returns false and the consumer tries again later.
+ */
+template <typename T>
+class MPSCQueue {
+ public:
+  MPSCQueue() : _head(new Node()), _tail(_head.load()) {}
+
+  MPSCQueue(const MPSCQueue&) = delete;
+  MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+  ~MPSCQueue() {
+    while (_tail != nullptr) {
+      Node* next = _tail->next.load(std::memory_order_relaxed);
+      delete _tail;
+      _tail = next;
+    }
+  }
+
+  void push(T value) {
+    auto* node = new Node();
+    node->value.emplace(std::move(value));
+    Node* previous = _head.exchange(node, std::memory_order_acq_rel);
+    previous->next.store(node, std::memory_order_release);
+  }
+
+  bool tryPop(T& value) {
+    Node* next = _tail->next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+      return false;
+    }
+    // The popped node becomes the new stub, so its value is moved out
+    value = std::move(next->value.value());
+    next->value.reset();
+    delete _tail;
+    _tail = next;
+    return true;
+  }
+
+ private:
+  struct Node {
+    std::optional<T> value;
+    std::atomic<Node*> next{nullptr};
+  };
+
+  std::atomic<Node*> _head;
+  Node* _tail;
+};
+
+}  // namespace gladius::serving
@@ -1,9 +1,11 @@
 
 #include "trainer.hpp"
-#include <_types/_uint32_t.h>
+#include <src/memory/memory_tracker.hpp>
 #include <src/params/parameters.hpp>
+#include <src/profiling/profiler.hpp>
 #include <src/trainers/trainer.hpp>
 #include <omp.h>
+#include <cstdint>
 #include <stdexcept>
 
 namespace gladius::trainers {
@@ -13,10 +15,13 @@ GradientDescentTrainer::GradientDescentTrainer(std::shared_ptr<Model> model,
     : _model(std::move(model)), _learning_rate(learning_rate) {}
 
 void GradientDescentTrainer::takeDescentStep() {
+  profiling::ProfileScope profile_scope("GradientDescentStep",
+                                        profiling::Pass::Optimizer);
+  // Plain gradient descent keeps no optimizer state, so the budget only
+  // covers the gradients accumulated by the backward pass
+  memory::MemoryTracker::checkBudget();
   for (auto& parameter : _model->getParameters()) {
-    auto computed_gradient = parameter->getGradient();
-
-    auto parameter_value = parameter->getValue();
+    auto& computed_gradient = parameter->getGradient();
 
     if (computed_gradient.empty()) {
       throw std::runtime_error(
@@ -0,0 +1,231 @@
+#include <gtest/gtest.h>
+#include <src/aot/code_generator.hpp>
+#include <src/comp_graph/graph.hpp>
+#include <src/comp_graph/vertices/activ_functions.hpp>
+#include <src/comp_graph/vertices/fully_connected.hpp>
+#include <src/comp_graph/vertices/inner_product.hpp>
+#include <src/comp_graph/vertices/input_vertex.hpp>
+#include <src/comp_graph/vertices/layer_norm.hpp>
+#include <src/comp_graph/vertices/param_vertex.hpp>
+#include <src/comp_graph/vertices/summation.hpp>
+#include <src/params/parameters.hpp>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef GLADIUS_AOT_COMPILER
+#define GLADIUS_AOT_COMPILER "c++"
+#endif
+
+namespace gladius::tests {
+
+using gladius::aot::CodeGenerationOptions;
+using gladius::aot::generateCode;
+using gladius::aot::WeightStorage;
+using gladius::comp_graph::BiasGELUActivation;
+using gladius::comp_graph::FullyConnected;
+using gladius::comp_graph::Graph;
+using gladius::comp_graph::InnerProduct;
+using gladius::comp_graph::LayerNorm;
+using gladius::comp_graph::NoGradGuard;
+using gladius::comp_graph::ParameterVertex;
+using gladius::comp_graph::ResidualAddition;
+using gladius::comp_graph::SequenceInputVertex;
+using gladius::comp_graph::SparseInputVertex;
+using gladius::comp_graph::VertexPointer;
+using gladius::parameters::Parameter;
+
+static inline constexpr uint32_t ROWS = 2;
+static inline constexpr uint32_t INPUT_DIMENSION = 24;
+static inline constexpr uint32_t HIDDEN_DIMENSION = 32;
+static inline constexpr uint32_t CLASSES = 5;
+
+static std::vector<float> randomVector(uint32_t size, std::mt19937& generator) {
+  std::normal_distribution<float> distribution(0.F, 0.5F);
+  std::vector<float> values(size);
+  std::generate(values.begin(), values.end(),
+                [&] { return distribution(generator); });
+  return values;
+}
+
+static std::shared_ptr<ParameterVertex> randomParameterVertex(
+    uint32_t rows, uint32_t columns, std::mt19937& generator) {
+  std::vector<std::vector<float>> matrix;
+  for (uint32_t row = 0; row < rows; row++) {
+    matrix.push_back(randomVector(columns, generator));
+  }
+  return std::make_shared<ParameterVertex>(
+      std::make_shared<Parameter>(std::move(matrix)));
+}
+
+/**
+ * Builds  W_o (h + FC(h))  with h = GELU(W LayerNorm(x) + b + b')  for a
+ * batch of ROWS inputs. The parameters only depend on the seed.
+ */
+static std::shared_ptr<Graph> buildResidualMLP(std::vector<float>& inputs) {
+  std::mt19937 generator(23);
+  auto input = std::make_shared<SequenceInputVertex>(
+      inputs, /* sequence_length = */ ROWS);
+  auto norm = std::make_shared<LayerNorm>(
+      input, randomParameterVertex(1, INPUT_DIMENSION, generator),
+      randomParameterVertex(1, INPUT_DIMENSION, generator));
+  auto projection = std::make_shared<FullyConnected>(
+      norm, randomParameterVertex(HIDDEN_DIMENSION, INPUT_DIMENSION, generator),
+      randomParameterVertex(1, HIDDEN_DIMENSION, generator));
+  auto hidden = std::make_shared<BiasGELUActivation>(
+      projection, randomParameterVertex(1, HIDDEN_DIMENSION, generator));
+  auto residual = std::make_shared<FullyConnected>(
+      hidden,
+      randomParameterVertex(HIDDEN_DIMENSION, HIDDEN_DIMENSION, generator),
+      randomParameterVertex(1, HIDDEN_DIMENSION, generator));
+  auto sum = std::make_shared<ResidualAddition>(hidden, residual);
+  auto logits = std::make_shared<FullyConnected>(
+      sum, randomParameterVertex(CLASSES, HIDDEN_DIMENSION, generator));
+
+  auto graph = std::make_shared<Graph>();
+  for (const VertexPointer& vertex : std::vector<VertexPointer>{
+           input, norm, projection, hidden, residual, sum, logits}) {
+    graph->addVertex(vertex);
+  }
+  return graph;
+}
+
+static void writeFloats(const std::filesystem::path& path,
+                        const std::vector<float>& values) {
+  std::ofstream file(path, std::ios::binary);
+  file.write(reinterpret_cast<const char*>(values.data()),
+             static_cast<std::streamsize>(values.size() * sizeof(float)));
+}
+
+static std::vector<float> readFloats(const std::filesystem::path& path,
+                                     uint64_t size) {
+  std::vector<float> values(size);
+  std::ifstream file(path, std::ios::binary);
+  file.read(reinterpret_cast<char*>(values.data()),
+            static_cast<std::streamsize>(size * sizeof(float)));
+  return values;
+}
+
+TEST(AotTest, GeneratesConstexprShapesAndAReusedWorkspace) {
+  NoGradGuard no_grad;
+  std::vector<float> inputs(ROWS * INPUT_DIMENSION, 1.F);
+  auto graph = buildResidualMLP(inputs);
+  auto code = generateCode(*graph);
+
+  ASSERT_NE(code.header.find("inline constexpr uint32_t INPUT_ROWS = 2;"),
+            std::string::npos);
+  ASSERT_NE(
+      code.header.find("inline constexpr uint32_t OUTPUT_DIMENSION = 5;"),
+      std::string::npos);
+  ASSERT_NE(code.source.find("fullyConnected<2, 24, 32, true>("),
+            std::string::npos);
+  ASSERT_NE(code.source.find("fullyConnected<2, 32, 5, false>(workspace"),
+            std::string::npos);
+  ASSERT_NE(code.source.find("alignas(64) const float PARAMETER_0[24]"),
+            std::string::npos);
+  ASSERT_TRUE(code.weights.empty());
+
+  // The outputs of the 5 intermediate vertices take 48 + 4 * 64 floats,
+  // but only some of them are alive at once
+  auto position = code.header.find("WORKSPACE_SIZE = ");
+  ASSERT_NE(position, std::string::npos);
+  auto workspace_size = std::stoull(code.header.substr(position + 17));
+  ASSERT_LT(workspace_size, 48 + 4 * 64);
+  ASSERT_GE(workspace_size, 3 * 64);
+}
+
+TEST(AotTest, CompiledCodeMatchesTheInterpretedGraph) {
+  NoGradGuard no_grad;
+  std::mt19937 generator(29);
+  auto inputs = randomVector(ROWS * INPUT_DIMENSION, generator);
+  auto graph_inputs = inputs;
+  auto graph = buildResidualMLP(graph_inputs);
+  auto expected = graph->launchInferencePass()->getOutput();
+
+  auto directory = std::filesystem::temp_directory_path() /
+                   ("gladius-aot-test-" + std::to_string(::getpid()));
+  std::filesystem::create_directories(directory);
+  writeFloats(directory / "input", inputs);
+
+  for (auto storage : {WeightStorage::Embedded, WeightStorage::Mapped}) {
+    bool mapped = storage == WeightStorage::Mapped;
+    CodeGenerationOptions options;
+    options.name_space = "residual_mlp";
+    options.file_stem = "residual_mlp";
+    options.weight_storage = storage;
+    auto features = inputs;
+    auto code = generateCode(*buildResidualMLP(features), options);
+    code.write(directory.string());
+    ASSERT_EQ(std::filesystem::exists(directory / "residual_mlp.weights"),
+              mapped);
+
+    std::ofstream driver(directory / "driver.cc");
+    driver << "#include \"residual_mlp.hpp\"\n"
+           << "#include <cstdio>\n#include <vector>\n"
+           << "int main(int, char** argv) {\n"
+           << "  using namespace residual_mlp;\n"
+           << "  std::vector<float> input(INPUT_ROWS * INPUT_DIMENSION);\n"
+           << "  std::vector<float> output(OUTPUT_ROWS * OUTPUT_DIMENSION);\n"
+           << "  FILE* file = std::fopen(argv[1], \"rb\");\n"
+           << "  if (std::fread(input.data(), sizeof(float), input.size(), "
+              "file) != input.size()) {\n"
+           << "    return 1;\n  }\n"
+           << "  std::fclose(file);\n"
+           << (mapped ? "  if (!loadWeights(argv[3])) {\n    return 2;\n  }\n"
+                      : "")
+           << "  run(input.data(), output.data());\n"
+           << "  file = std::fopen(argv[2], \"wb\");\n"
+           << "  std::fwrite(output.data(), sizeof(float), output.size(), "
+              "file);\n"
+           << "  std::fclose(file);\n"
+           << "  return 0;\n}\n";
+    driver.close();
+
+    auto path = [&](const char* name) { return (directory / name).string(); };
+    auto compile = std::string(GLADIUS_AOT_COMPILER) +
+                   " -std=c++17 -O2 -I" + directory.string() + " " +
+                   path("residual_mlp.cc") + " " + path("driver.cc") +
+                   " -o " + path("driver");
+    ASSERT_EQ(std::system(compile.c_str()), 0) << compile;
+    auto run = path("driver") + " " + path("input") + " " + path("output") +
+               (mapped ? " " + path("residual_mlp.weights") : "");
+    ASSERT_EQ(std::system(run.c_str()), 0) << run;
+
+    auto output = readFloats(directory / "output", ROWS * CLASSES);
+    ASSERT_EQ(expected.size(), output.size());
+    for (uint32_t index = 0; index < expected.size(); index++) {
+      ASSERT_NEAR(output[index], expected[index], 1e-4)
+          << "output " << index << (mapped ? " (mapped)" : " (embedded)");
+    }
+  }
+  std::filesystem::remove_all(directory);
+}
+
+TEST(AotTest, RejectsUnsupportedGraphs) {
+  NoGradGuard no_grad;
+  std::mt19937 generator(31);
+  std::vector<uint32_t> row_offsets = {0, 1};
+  std::vector<uint32_t> indices = {3};
+  std::vector<float> values = {1.F};
+  auto input = std::make_shared<SparseInputVertex>(row_offsets, indices,
+                                                   values, INPUT_DIMENSION);
+  auto product = std::make_shared<InnerProduct>(
+      randomParameterVertex(CLASSES, INPUT_DIMENSION, generator), input);
+  Graph graph;
+  graph.addVertex(input);
+  graph.addVertex(product);
+  ASSERT_THROW(generateCode(graph), std::invalid_argument);
+
+  Graph empty_graph;
+  ASSERT_THROW(generateCode(empty_graph), std::invalid_argument);
+}
+
+}  // namespace gladius::tests
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include <src/attention.hpp>
+#include <src/kv_cache.hpp>
+#include <src/params/parameters.hpp>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace gladius::tests {
+
+using gladius::parameters::Parameter;
+using gladius::transformer::KVCache;
+using gladius::transformer::MultiHeadAttention;
+
+static inline constexpr uint32_t MODEL_DIMENSION = 8;
+static inline constexpr uint32_t NUM_HEADS = 2;
+static inline constexpr uint32_t SEQUENCE_LENGTH = 6;
+
+static std::shared_ptr<Parameter> randomSquareParameter(
+    std::mt19937& generator) {
+  std::normal_distribution<float> distribution(0.F, 0.5F);
+  std::vector<std::vector<float>> rows(MODEL_DIMENSION,
+                                       std::vector<float>(MODEL_DIMENSION));
+  for (auto& row : rows) {
+    for (auto& value : row) {
+      value = distribution(generator);
+    }
+  }
+  return std::make_shared<Parameter>(std::move(rows));
+}
+
+static std::vector<float> multiply(std::shared_ptr<Parameter>& weights,
+                                   const std::vector<float>& input) {
+  std::vector<float> output(MODEL_DIMENSION, 0.F);
+  for (uint32_t row = 0; row < MODEL_DIMENSION; row++) {
+    for (uint32_t col = 0; col < MODEL_DIMENSION; col++) {
+      output[row] += weights->getValue()[row][col] * input[col];
+    }
+  }
+  return output;
+}
+
+/**
+ * Recomputes causal attention for the last token over the whole prefix,
+ * which is what decoding without a cache amounts to.
+ */
+static std::vector<float> attendOverPrefix(
+    std::vector<std::shared_ptr<Parameter>>& weights,
+    const std::vector<std::vector<float>>& prefix) {
+  uint32_t head_dimension = MODEL_DIMENSION / NUM_HEADS;
+  auto query = multiply(weights[0], prefix.back());
+  std::vector<std::vector<float>> keys;
+  std::vector<std::vector<float>> values;
+  for (const auto& token : prefix) {
+    keys.push_back(multiply(weights[1], token));
+    values.push_back(multiply(weights[2], token));
+  }
+
+  std::vector<float> context(MODEL_DIMENSION, 0.F);
+  for (uint32_t head = 0; head < NUM_HEADS; head++) {
+    uint32_t offset = head * head_dimension;
+    std::vector<float> scores;
+    float sum_exps = 0.F;
+    for (const auto& key : keys) {
+      float score = 0.F;
+      for (uint32_t index = 0; index < head_dimension; index++) {
+        score += query[offset + index] * key[offset + index];
+      }
+      scores.push_back(std::exp(score / std::sqrt(float(head_dimension))));
+      sum_exps += scores.back();
+    }
+    for (uint32_t token = 0; token < values.size(); token++) {
+      for (uint32_t index = 0; index < head_dimension; index++) {
+        context[offset + index] +=
+            (scores[token] / sum_exps) * values[token][offset + index];
+      }
+    }
+  }
+  return multiply(weights[3], context);
+}
+
+TEST(gladiusAttention, DecodeStepMatchesFullPrefixRecomputation) {
+  std::mt19937 generator(42);
+  std::vector<std::shared_ptr<Parameter>> weights;
+  for (uint32_t index = 0; index < 4; index++) {
+    weights.push_back(randomSquareParameter(generator));
+  }
+  MultiHeadAttention attention(NUM_HEADS, weights[0], weights[1], weights[2],
+                               weights[3]);
+  KVCache cache(/* num_layers = */ 1, NUM_HEADS,
+                /* head_dimension = */ MODEL_DIMENSION / NUM_HEADS,
+                /* max_sequence_length = */ SEQUENCE_LENGTH);
+  auto footprint = cache.getMemoryFootprintBytes();
+
+  std::normal_distribution<float> distribution(0.F, 1.F);
+  std::vector<std::vector<float>> prefix;
+  for (uint32_t step = 0; step < SEQUENCE_LENGTH; step++) {
+    std::vector<float> token(MODEL_DIMENSION);
+    for (auto& value : token) {
+      value = distribution(generator);
+    }
+    prefix.push_back(token);
+
+    auto cached_output = attention.decodeStep(token, cache, /* layer = */ 0);
+    auto expected_output = attendOverPrefix(weights, prefix);
+
+    ASSERT_EQ(cache.getCachedTokenCount(/* layer = */ 0), step + 1);
+    for (uint32_t index = 0; index < MODEL_DIMENSION; index++) {
+      ASSERT_NEAR(cached_output[index], expected_output[index], 1e-4);
+    }
+  }
+  ASSERT_EQ(cache.getMemoryFootprintBytes(), footprint);
+}
+
+TEST(gladiusAttention, KVCacheEvictsOldestTokensOnceFull) {
+  KVCache cache(/* num_layers = */ 1, /* num_heads = */ 1,
+                /* head_dimension = */ 1, /* max_sequence_length = */ 2);
+  for (float token = 0.F; token < 3.F; token += 1.F) {
+    cache.append(/* layer = */ 0, /* key = */ {token}, /* value = */ {token});
+  }
+  ASSERT_EQ(cache.getCachedTokenCount(/* layer = */ 0), 2);
+  ASSERT_EQ(cache.getSequencePosition(/* layer = */ 0), 3);
+
+  // Token 2 overwrote token 0 in the first slot of the ring.
+  ASSERT_EQ(cache.getKeys(/* layer = */ 0, /* head = */ 0)[0], 2.F);
+  ASSERT_EQ(cache.getValues(/* layer = */ 0, /* head = */ 0)[1], 1.F);
+}
+
+}  // namespace gladius::tests
@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include <src/builders/rnn_builder.hpp>
+#include <src/builders/transformer_builder.hpp>
+#include <src/comp_graph/graph.hpp>
+#include <src/comp_graph/vertices/input_vertex.hpp>
+#include <src/comp_graph/vertices/layer_norm.hpp>
+#include <src/comp_graph/vertices/param_vertex.hpp>
+#include <src/model.hpp>
+#include <src/params/parameters.hpp>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace gladius::tests {
+
+using gladius::builders::GRUBuilder;
+using gladius::builders::LSTMBuilder;
+using gladius::builders::TransformerBlockBuilder;
+using gladius::comp_graph::Graph;
+using gladius::comp_graph::LayerNorm;
+using gladius::comp_graph::ParameterVertex;
+using gladius::comp_graph::SequenceInputVertex;
+using gladius::comp_graph::VertexPointer;
+using gladius::parameters::Parameter;
+
+static inline constexpr uint32_t SEQUENCE_LENGTH = 3;
+static inline constexpr uint32_t INPUT_DIMENSION = 4;
+
+/**
+ * Builds the network on top of a fresh graph, runs the forward pass and
+ * returns <r, y> for a fixed random vector r, i.e., a scalar function whose
+ * gradient w.r.t the output y of the network is r.
+ */
+template <typename Builder>
+static float forwardProjection(const Builder& builder,
+                               const std::vector<float>& sequence,
+                               const std::vector<float>& projection,
+                               VertexPointer& output) {
+  Graph graph;
+  auto input_copy = sequence;
+  auto input =
+      std::make_shared<SequenceInputVertex>(input_copy, SEQUENCE_LENGTH);
+  graph.addVertex(input);
+  output = builder.build(graph, input);
+
+  for (uint32_t index = 0; index < graph.getVerticesCount(); index++) {
+    graph.getVertexAtIndex(index)->forward();
+  }
+  float value = 0.F;
+  for (uint32_t index = 0; index < projection.size(); index++) {
+    value += projection[index] * output->getOutput()[index];
+  }
+  return value;
+}
+
+/**
+ * Back-propagates through the network once and compares the gradient of the
+ * first few entries of every model parameter against central finite
+ * differences.
+ */
+template <typename Builder>
+static void checkGradients(const std::shared_ptr<Model>& model,
+                           const Builder& builder, uint32_t output_dimension) {
+  std::mt19937 generator(7);
+  std::normal_distribution<float> distribution(0.F, 1.F);
+
+  std::vector<float> sequence(SEQUENCE_LENGTH * INPUT_DIMENSION);
+  std::vector<float> projection(SEQUENCE_LENGTH * output_dimension);
+  std::generate(sequence.begin(), sequence.end(),
+                [&] { return distribution(generator); });
+  std::generate(projection.begin(), projection.end(),
+                [&] { return distribution(generator); });
+
+  VertexPointer output;
+  forwardProjection(builder, sequence, projection, output);
+  ASSERT_EQ(output->getOutputShape().first, SEQUENCE_LENGTH);
+  ASSERT_EQ(output->getOutputShape().second, output_dimension);
+
+  std::optional<std::vector<float>> upstream_grad = projection;
+  output->backward(upstream_grad);
+
+  // Model draws fresh weights on every run, and some draws give gradients
+  // in the hundreds whose curvature a step of 1e-2 does not resolve
+  constexpr float EPSILON = 1e-3;
+  for (auto& parameter : model->getParameters()) {
+    auto analytic_gradient = parameter->getGradient();
+    auto& rows = parameter->getValue();
+    uint32_t columns = rows.at(0).size();
+
+    for (uint32_t index = 0; index < std::min<uint32_t>(columns, 3); index++) {
+      float original = rows[0][index];
+      rows[0][index] = original + EPSILON;
+      float upper = forwardProjection(builder, sequence, projection, output);
+      rows[0][index] = original - EPSILON;
+      float lower = forwardProjection(builder, sequence, projection, output);
+      rows[0][index] = original;
+
+      float numeric_gradient = (upper - lower) / (2 * EPSILON);
+      ASSERT_NEAR(analytic_gradient[index], numeric_gradient,
+                  2e-2 * std::max(1.F, std::abs(numeric_gradient)));
+    }
+  }
+}
+
+TEST(gladiusBuilders, TransformerEncoderGradientsMatchFiniteDifferences) {
+  auto model = std::make_shared<Model>();
+  TransformerBlockBuilder encoder(
+      model, /* model_dimension = */ INPUT_DIMENSION, /* num_heads = */ 2,
+      /* feed_forward_dimension = */ 8, /* num_layers = */ 2,
+      /* causal = */ true);
+  ASSERT_EQ(model->getParameterCount(), 24);
+
+  checkGradients(model, encoder, /* output_dimension = */ INPUT_DIMENSION);
+}
+
+TEST(gladiusBuilders, LayerNormKeepsPrecisionForLargeMeans) {
+  // The entries and their deviations from the mean are exact in fp32, but
+  // E[x^2] - E[x]^2 cancels every significant bit of the variance
+  constexpr uint32_t DIMENSION = 16;
+  constexpr float OFFSET = 1e4F;
+  std::vector<float> row(DIMENSION);
+  for (uint32_t col = 0; col < DIMENSION; col++) {
+    row[col] = OFFSET + 0.25F * col;
+  }
+  auto parameter = [](float value) {
+    return std::make_shared<ParameterVertex>(std::make_shared<Parameter>(
+        std::vector<std::vector<float>>{std::vector<float>(DIMENSION, value)}));
+  };
+  auto input_copy = row;
+  auto norm = std::make_shared<LayerNorm>(
+      std::make_shared<SequenceInputVertex>(input_copy, 1),
+      /* gain = */ parameter(1.F), /* bias = */ parameter(0.F));
+  norm->forward();
+
+  double mean = 0.0, variance = 0.0;
+  for (float value : row) {
+    mean += value / DIMENSION;
+  }
+  for (float value : row) {
+    variance += (value - mean) * (value - mean) / DIMENSION;
+  }
+  for (uint32_t col = 0; col < DIMENSION; col++) {
+    double expected = (row[col] - mean) / std::sqrt(variance + 1e-5);
+    ASSERT_NEAR(norm->getOutput()[col], expected, 1e-4);
+  }
+}
+
+TEST(gladiusBuilders, LSTMGradientsMatchFiniteDifferences) {
+  auto model = std::make_shared<Model>();
+  LSTMBuilder lstm(model, INPUT_DIMENSION, /* hidden_dimension = */ 5,
+                   /* num_layers = */ 2);
+
+  checkGradients(model, lstm, /* output_dimension = */ 5);
+}
+
+TEST(gladiusBuilders, GRUGradientsMatchFiniteDifferences) {
+  auto model = std::make_shared<Model>();
+  GRUBuilder gru(model, INPUT_DIMENSION, /* hidden_dimension = */ 5,
+                 /* num_layers = */ 2);
+
+  checkGradients(model, gru, /* output_dimension = */ 5);
+}
+
+}  // namespace gladius::tests
@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+#include <src/comp_graph/checkpointing.hpp>
+#include <src/comp_graph/graph.hpp>
+#include <src/memory/memory_tracker.hpp>
+#include <tests/test_utils.hpp>
+#include <cmath>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace gladius::tests {
+
+using gladius::memory::MemoryCategory;
+using gladius::memory::MemoryTracker;
+
+TEST(CheckpointingTest, RecomputedGradientsMatchTheFullPass) {
+  for (bool residual : {false, true}) {
+    auto reference = buildDeepNetwork(/* depth = */ 16, residual);
+    auto checkpointed = buildDeepNetwork(/* depth = */ 16, residual);
+    checkpointed.graph->enableCheckpointing();
+
+    float reference_loss = runForwardAndBackward(reference);
+    float checkpointed_loss = runForwardAndBackward(checkpointed);
+    ASSERT_EQ(checkpointed_loss, reference_loss);
+
+    const auto* checkpointer = checkpointed.graph->getCheckpointer();
+    ASSERT_NE(checkpointer, nullptr);
+    uint32_t vertices = checkpointed.graph->getVerticesCount();
+    ASSERT_EQ(checkpointer->getSegmentLength(),
+              static_cast<uint32_t>(std::ceil(std::sqrt(vertices))));
+    ASSERT_GT(checkpointer->getDroppedCount(), vertices / 2);
+    // Every dropped output is recomputed once
+    ASSERT_EQ(checkpointer->getRecomputedCount(),
+              checkpointer->getDroppedCount());
+
+    for (uint32_t index = 0; index < reference.parameters.size(); index++) {
+      ASSERT_EQ(checkpointed.parameters[index]->getGradient(),
+                reference.parameters[index]->getGradient())
+          << "parameter " << index << (residual ? " (residual)" : "");
+    }
+  }
+}
+
+TEST(CheckpointingTest, DropsOutputsAfterTheForwardPass) {
+  auto network = buildDeepNetwork(/* depth = */ 8, /* residual = */ false);
+  network.graph->enableCheckpointing(/* segment_length = */ 4);
+  network.graph->launchForwardPass();
+
+  // Segments {x, W_0, GELU_0, W_1}, {GELU_1, ...}, ..., {W_o, CE}: the last
+  // vertex of every segment and the last segment are kept
+  ASSERT_FALSE(network.graph->getVertexAtIndex(0)->isOutputReleased());
+  ASSERT_TRUE(network.graph->getVertexAtIndex(1)->isOutputReleased());
+  ASSERT_TRUE(network.graph->getVertexAtIndex(2)->isOutputReleased());
+  ASSERT_FALSE(network.graph->getVertexAtIndex(3)->isOutputReleased());
+  ASSERT_FALSE(network.graph->getVertexAtIndex(17)->isOutputReleased());
+  ASSERT_FALSE(network.graph->getVertexAtIndex(18)->isOutputReleased());
+
+  std::optional<std::vector<float>> no_upstream_grad = std::nullopt;
+  network.loss->backward(no_upstream_grad);
+  ASSERT_EQ(network.graph->getCheckpointer()->getSegmentsCount(), 5);
+}
+
+TEST(CheckpointingTest, LowersThePeakActivationMemory) {
+  auto peakActivationBytes = [](bool checkpointing) {
+    MemoryTracker::enable();
+    auto network = buildDeepNetwork(/* depth = */ 32, /* residual = */ false);
+    if (checkpointing) {
+      network.graph->enableCheckpointing();
+    }
+    runForwardAndBackward(network);
+    auto snapshot = MemoryTracker::snapshot();
+    MemoryTracker::disable();
+    return snapshot
+        .categories[static_cast<uint32_t>(MemoryCategory::Activations)]
+        .peak_bytes;
+  };
+  uint64_t full_peak = peakActivationBytes(/* checkpointing = */ false);
+  uint64_t checkpointed_peak = peakActivationBytes(/* checkpointing = */ true);
+  ASSERT_GT(checkpointed_peak, 0);
+  // About 3 sqrt(N) of the N outputs are alive at once
+  ASSERT_LT(checkpointed_peak, full_peak / 2);
+}
+
+}  // namespace gladius::tests
@@ -0,0 +1,247 @@
+#include <gtest/gtest.h>
+#include <src/comp_graph/constant_folding.hpp>
+#include <src/comp_graph/graph.hpp>
+#include <src/comp_graph/vertices/activ_functions.hpp>
+#include <src/comp_graph/vertices/fully_connected.hpp>
+#include <src/comp_graph/vertices/inner_product.hpp>
+#include <src/comp_graph/vertices/input_vertex.hpp>
+#include <src/comp_graph/vertices/param_vertex.hpp>
+#include <src/comp_graph/vertices/summation.hpp>
+#include <src/params/parameters.hpp>
+#include <tests/test_utils.hpp>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace gladius::tests {
+
+using gladius::comp_graph::BiasGELUActivation;
+using gladius::comp_graph::FoldedConstantCache;
+using gladius::comp_graph::FullyConnected;
+using gladius::comp_graph::Graph;
+using gladius::comp_graph::InnerProduct;
+using gladius::comp_graph::NoGradGuard;
+using gladius::comp_graph::ParameterVertex;
+using gladius::comp_graph::ResidualAddition;
+using gladius::comp_graph::SequenceInputVertex;
+using gladius::comp_graph::SparseInputVertex;
+using gladius::comp_graph::VertexPointer;
+using gladius::parameters::Parameter;
+
+static inline constexpr uint32_t INPUT_DIMENSION = 32;
+static inline constexpr uint32_t HIDDEN_DIMENSION = 16;
+static inline constexpr uint32_t BOTTLENECK_DIMENSION = 8;
+static inline constexpr uint32_t CLASSES = 4;
+static inline constexpr uint32_t ROWS = 3;
+
+static inline constexpr float PARAMETER_STDDEV = 0.5F;
+
+static std::vector<std::shared_ptr<Parameter>> mlpParameters() {
+  std::mt19937 generator(7);
+  auto parameter = [&](uint32_t rows, uint32_t columns) {
+    return randomParameter(rows, columns, generator, PARAMETER_STDDEV);
+  };
+  return {parameter(HIDDEN_DIMENSION, INPUT_DIMENSION),
+          parameter(1, HIDDEN_DIMENSION),
+          parameter(BOTTLENECK_DIMENSION, HIDDEN_DIMENSION),
+          parameter(1, BOTTLENECK_DIMENSION),
+          parameter(1, BOTTLENECK_DIMENSION),
+          parameter(CLASSES, BOTTLENECK_DIMENSION)};
+}
+
+/**
+ * Builds  W_o GELU(W_2 (W_1 x + b_1) + b_2 + b_3)  for a batch of ROWS
+ * inputs, with no nonlinearity between the first two layers
+ */
+static std::shared_ptr<Graph> buildBottleneckMLP(
+    const std::vector<std::shared_ptr<Parameter>>& parameters,
+    std::vector<float>& inputs) {
+  auto input = std::make_shared<SequenceInputVertex>(
+      inputs, /* sequence_length = */ ROWS);
+  auto first = std::make_shared<FullyConnected>(
+      input, std::make_shared<ParameterVertex>(parameters[0]),
+      std::make_shared<ParameterVertex>(parameters[1]));
+  auto second = std::make_shared<FullyConnected>(
+      first, std::make_shared<ParameterVertex>(parameters[2]),
+      std::make_shared<ParameterVertex>(parameters[3]));
+  auto activation = std::make_shared<BiasGELUActivation>(
+      second, std::make_shared<ParameterVertex>(parameters[4]));
+  auto logits = std::make_shared<FullyConnected>(
+      activation, std::make_shared<ParameterVertex>(parameters[5]));
+
+  auto graph = std::make_shared<Graph>();
+  for (const VertexPointer& vertex :
+       std::vector<VertexPointer>{input, first, second, activation, logits}) {
+    graph->addVertex(vertex);
+  }
+  return graph;
+}
+
+static std::vector<float> randomInputs(uint32_t size) {
+  std::mt19937 generator(13);
+  std::normal_distribution<float> distribution(0.F, 1.F);
+  std::vector<float> inputs(size);
+  std::generate(inputs.begin(), inputs.end(),
+                [&] { return distribution(generator); });
+  return inputs;
+}
+
+TEST(ConstantFoldingTest, ComposesLinearLayersAndFoldsBiases) {
+  NoGradGuard no_grad;
+  auto parameters = mlpParameters();
+  auto inputs = randomInputs(ROWS * INPUT_DIMENSION);
+  auto reference_inputs = inputs;
+  auto reference = buildBottleneckMLP(parameters, reference_inputs);
+  auto expected = reference->launchInferencePass()->getOutput();
+
+  auto graph = buildBottleneckMLP(parameters, inputs);
+  auto report = graph->foldConstants();
+  ASSERT_EQ(report.folded_vertices, 1);
+  ASSERT_EQ(report.pruned_vertices, 0);
+  // {x, FC(x, W_2 W_1), GELU, FC}
+  ASSERT_EQ(graph->getVerticesCount(), 4);
+  auto projection = std::dynamic_pointer_cast<FullyConnected>(
+      graph->getVertexAtIndex(1));
+  ASSERT_NE(projection, nullptr);
+  ASSERT_EQ(projection->getWeights()->getOutputShape(),
+            std::make_pair(BOTTLENECK_DIMENSION, INPUT_DIMENSION));
+  // Added by the activation instead
+  ASSERT_EQ(projection->getBias(), nullptr);
+
+  auto& output = graph->launchInferencePass()->getOutput();
+  ASSERT_EQ(output.size(), expected.size());
+  for (uint32_t index = 0; index < expected.size(); index++) {
+    ASSERT_NEAR(output[index], expected[index], 1e-4);
+  }
+}
+
+TEST(ConstantFoldingTest, GraphsSharingACacheFoldOnce) {
+  NoGradGuard no_grad;
+  auto parameters = mlpParameters();
+  FoldedConstantCache cache;
+  auto inputs = randomInputs(ROWS * INPUT_DIMENSION);
+  auto graph = buildBottleneckMLP(parameters, inputs);
+  graph->foldConstants(&cache);
+  // The composed weights and bias, and the summed biases
+  ASSERT_EQ(cache.size(), 3);
+
+  auto other_inputs = randomInputs(ROWS * INPUT_DIMENSION);
+  auto other_graph = buildBottleneckMLP(parameters, other_inputs);
+  other_graph->foldConstants(&cache);
+  ASSERT_EQ(cache.size(), 3);
+  auto weights = [](Graph& graph) {
+    return std::dynamic_pointer_cast<FullyConnected>(graph.getVertexAtIndex(1))
+        ->getWeights()
+        ->getParameter();
+  };
+  ASSERT_EQ(weights(*graph), weights(*other_graph));
+
+  cache.clear();
+  ASSERT_EQ(cache.size(), 0);
+}
+
+TEST(ConstantFoldingTest, FoldsVerticesThatOnlyReadParameters) {
+  NoGradGuard no_grad;
+  std::mt19937 generator(17);
+  auto offset =
+      randomParameter(1, INPUT_DIMENSION, generator, PARAMETER_STDDEV);
+  auto other_offset =
+      randomParameter(1, INPUT_DIMENSION, generator, PARAMETER_STDDEV);
+  auto weights =
+      randomParameter(CLASSES, INPUT_DIMENSION, generator, PARAMETER_STDDEV);
+  auto inputs = randomInputs(INPUT_DIMENSION);
+  // Moved into the input vertex
+  auto features = inputs;
+
+  // W (x + (c + c'))
+  auto graph = std::make_shared<Graph>();
+  auto input = std::make_shared<SequenceInputVertex>(
+      inputs, /* sequence_length = */ 1);
+  auto offsets = std::make_shared<ResidualAddition>(
+      std::make_shared<ParameterVertex>(offset),
+      std::make_shared<ParameterVertex>(other_offset));
+  auto shifted = std::make_shared<ResidualAddition>(input, offsets);
+  auto logits = std::make_shared<FullyConnected>(
+      shifted, std::make_shared<ParameterVertex>(weights));
+  for (const VertexPointer& vertex :
+       std::vector<VertexPointer>{input, offsets, shifted, logits}) {
+    graph->addVertex(vertex);
+  }
+
+  auto report = graph->foldConstants();
+  ASSERT_EQ(report.folded_vertices, 1);
+  ASSERT_EQ(graph->getVerticesCount(), 3);
+  auto& output = graph->launchInferencePass()->getOutput();
+  ASSERT_EQ(output.size(), CLASSES);
+  for (uint32_t label = 0; label < CLASSES; label++) {
+    float expected = 0.F;
+    for (uint32_t col = 0; col < INPUT_DIMENSION; col++) {
+      expected += weights->getValue()[label][col] *
+                  (features[col] + offset->getValue()[0][col] +
+                   other_offset->getValue()[0][col]);
+    }
+    ASSERT_NEAR(output[label], expected, 1e-4);
+  }
+}
+
+TEST(ConstantFoldingTest, MergesConsecutiveInnerProducts) {
+  NoGradGuard no_grad;
+  std::mt19937 generator(19);
+  auto first = randomParameter(HIDDEN_DIMENSION, INPUT_DIMENSION, generator,
+                               PARAMETER_STDDEV);
+  auto second = randomParameter(CLASSES, HIDDEN_DIMENSION, generator,
+                                PARAMETER_STDDEV);
+  std::vector<uint32_t> row_offsets = {0, 2, 5, 5};
+  std::vector<uint32_t> indices = {3, 10, 0, 3, 31};
+  std::vector<float> values = {1.5F, -2.F, 0.5F, 4.F, -1.F};
+  auto batch = std::vector<std::vector<float>>(
+      ROWS, std::vector<float>(INPUT_DIMENSION, 0.F));
+  for (uint32_t row = 0; row < ROWS; row++) {
+    for (uint32_t index = row_offsets[row]; index < row_offsets[row + 1];
+         index++) {
+      batch[row][indices[index]] = values[index];
+    }
+  }
+
+  auto graph = std::make_shared<Graph>();
+  auto input = std::make_shared<SparseInputVertex>(row_offsets, indices,
+                                                   values, INPUT_DIMENSION);
+  auto hidden = std::make_shared<InnerProduct>(
+      std::make_shared<ParameterVertex>(first), input);
+  auto logits = std::make_shared<InnerProduct>(
+      std::make_shared<ParameterVertex>(second), hidden);
+  for (const VertexPointer& vertex :
+       std::vector<VertexPointer>{input, hidden, logits}) {
+    graph->addVertex(vertex);
+  }
+
+  auto report = graph->foldConstants();
+  ASSERT_EQ(report.folded_vertices, 1);
+  ASSERT_EQ(graph->getVerticesCount(), 2);
+  auto& output = graph->launchInferencePass()->getOutput();
+  ASSERT_EQ(output.size(), ROWS * CLASSES);
+  for (uint32_t row = 0; row < ROWS; row++) {
+    for (uint32_t label = 0; label < CLASSES; label++) {
+      float expected = 0.F;
+      for (uint32_t neuron = 0; neuron < HIDDEN_DIMENSION; neuron++) {
+        float activation = 0.F;
+        for (uint32_t col = 0; col < INPUT_DIMENSION; col++) {
+          activation += first->getValue()[neuron][col] * batch[row][col];
+        }
+        expected += second->getValue()[label][neuron] * activation;
+      }
+      ASSERT_NEAR(output[row * CLASSES + label], expected, 1e-4);
+    }
+  }
+}
+
+TEST(ConstantFoldingTest, RequiresAnInferenceGraph) {
+  auto parameters = mlpParameters();
+  auto inputs = randomInputs(ROWS * INPUT_DIMENSION);
+  auto graph = buildBottleneckMLP(parameters, inputs);
+  ASSERT_THROW(graph->foldConstants(), std::logic_error);
+}
+
+}  // namespace gladius::tests
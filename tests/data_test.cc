@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include <src/data/idx_file.hpp>
+#include <src/data/mnist_stream.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace gladius::tests {
+
+using gladius::data::BatchView;
+using gladius::data::IdxFile;
+using gladius::data::MNISTStream;
+
+static inline constexpr uint32_t SAMPLES = 50;
+static inline constexpr uint32_t ROWS = 4;
+static inline constexpr uint32_t COLUMNS = 5;
+
+static void writeIdxFile(const std::string& filename,
+                         const std::vector<uint32_t>& dimensions,
+                         const std::vector<uint8_t>& data) {
+  std::ofstream file(filename, std::ios::binary);
+  std::vector<uint8_t> header = {0, 0, 0x08,
+                                 static_cast<uint8_t>(dimensions.size())};
+  for (uint32_t dimension : dimensions) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+      header.push_back(static_cast<uint8_t>(dimension >> shift));
+    }
+  }
+  file.write(reinterpret_cast<const char*>(header.data()), header.size());
+  file.write(reinterpret_cast<const char*>(data.data()), data.size());
+}
+
+class MNISTStreamTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    auto directory = std::filesystem::temp_directory_path();
+    _images_filename = (directory / "gladius_test_images.idx").string();
+    _labels_filename = (directory / "gladius_test_labels.idx").string();
+
+    std::mt19937 generator(13);
+    std::uniform_int_distribution<uint32_t> distribution(0, 255);
+    _pixels.resize(SAMPLES * ROWS * COLUMNS);
+    for (auto& pixel : _pixels) {
+      pixel = static_cast<uint8_t>(distribution(generator));
+    }
+    for (uint32_t sample = 0; sample < SAMPLES; sample++) {
+      _labels.push_back(static_cast<uint8_t>(sample % 10));
+    }
+    writeIdxFile(_images_filename, {SAMPLES, ROWS, COLUMNS}, _pixels);
+    writeIdxFile(_labels_filename, {SAMPLES}, _labels);
+  }
+
+  void TearDown() override {
+    std::filesystem::remove(_images_filename);
+    std::filesystem::remove(_labels_filename);
+  }
+
+  std::string _images_filename;
+  std::string _labels_filename;
+  std::vector<uint8_t> _pixels;
+  std::vector<uint8_t> _labels;
+};
+
+TEST_F(MNISTStreamTest, IdxHeaderIsParsed) {
+  IdxFile images(_images_filename);
+  ASSERT_EQ(images.getDimensions(),
+            std::vector<uint32_t>({SAMPLES, ROWS, COLUMNS}));
+  ASSERT_EQ(images.getItemSize(), ROWS * COLUMNS);
+  ASSERT_EQ(images.getItem(3)[0], _pixels[3 * ROWS * COLUMNS]);
+
+  writeIdxFile(_labels_filename, {SAMPLES + 1}, _labels);
+  ASSERT_THROW(IdxFile truncated(_labels_filename), std::invalid_argument);
+}
+
+TEST_F(MNISTStreamTest, BatchesCoverEveryEpochInOrder) {
+  constexpr uint32_t BATCH_SIZE = 7;
+  MNISTStream stream(_images_filename, _labels_filename, BATCH_SIZE);
+  ASSERT_EQ(stream.getBatchCount(), (SAMPLES + BATCH_SIZE - 1) / BATCH_SIZE);
+
+  for (uint32_t epoch = 0; epoch < 3; epoch++) {
+    uint32_t sample = 0;
+    BatchView batch;
+    while (stream.next(batch)) {
+      ASSERT_EQ(batch.input_dimension, ROWS * COLUMNS);
+      ASSERT_EQ(batch.size, std::min(BATCH_SIZE, SAMPLES - sample));
+      for (uint32_t index = 0; index < batch.size; index++, sample++) {
+        ASSERT_EQ(batch.labels[index], _labels[sample]);
+        for (uint32_t pixel = 0; pixel < ROWS * COLUMNS; pixel++) {
+          ASSERT_FLOAT_EQ(
+              batch.inputs[index * ROWS * COLUMNS + pixel],
+              static_cast<float>(_pixels[sample * ROWS * COLUMNS + pixel]) /
+                  255.F);
+        }
+      }
+    }
+    ASSERT_EQ(sample, SAMPLES);
+    stream.reset();
+  }
+
+  // Restarting in the middle of an epoch
+  BatchView batch;
+  ASSERT_TRUE(stream.next(batch));
+  ASSERT_TRUE(stream.next(batch));
+  stream.reset();
+  ASSERT_TRUE(stream.next(batch));
+  ASSERT_EQ(batch.labels[0], _labels[0]);
+}
+
+}  // namespace gladius::tests
@@ -26,6 +26,7 @@ namespace gladius::tests {
 using gladius::comp_graph::CrossEntropyLoss;
 using gladius::comp_graph::InnerProduct;
 using gladius::comp_graph::InputVertex;
+using gladius::comp_graph::NoGradGuard;
 using gladius::comp_graph::ParameterVertex;
 using gladius::comp_graph::ReLUActivation;
 // using gladius::comp_graph::SoftMaxActivation;
@@ -191,10 +192,12 @@ static float evaluate(
   std::vector<std::vector<uint32_t>> labels;
 
   for (auto& [input, label] : dataset) {
-    labels.push_back(std::move(label));
-
+    // The loss vertex reads the one-hot label, so it is only moved once the
+    // graph is built
+    NoGradGuard no_grad;
     auto graph = buildComputationGraph(model, input, label);
-    auto [predicted_label, loss] = graph->launchForwardPass();
+    labels.push_back(std::move(label));
+    auto predicted_label = graph->predict();
 
     predictions.push_back(predicted_label);
   }
@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+#include <src/comp_graph/graph.hpp>
+#include <src/comp_graph/graph_passes.hpp>
+#include <src/comp_graph/vertices/activ_functions.hpp>
+#include <src/comp_graph/vertices/fully_connected.hpp>
+#include <src/comp_graph/vertices/input_vertex.hpp>
+#include <src/comp_graph/vertices/loss.hpp>
+#include <src/comp_graph/vertices/param_vertex.hpp>
+#include <src/comp_graph/vertices/summation.hpp>
+#include <src/params/parameters.hpp>
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <vector>
+
+namespace gladius::tests {
+
+using gladius::comp_graph::BiasGELUActivation;
+using gladius::comp_graph::CrossEntropyLoss;
+using gladius::comp_graph::FullyConnected;
+using gladius::comp_graph::Graph;
+using gladius::comp_graph::GraphPassReport;
+using gladius::comp_graph::ParameterVertex;
+using gladius::comp_graph::ResidualAddition;
+using gladius::comp_graph::SequenceInputVertex;
+using gladius::comp_graph::VertexPointer;
+using gladius::parameters::Parameter;
+
+static inline constexpr uint32_t DIMENSION = 16;
+static inline constexpr uint32_t CLASSES = 4;
+
+struct Parameters {
+  std::shared_ptr<Parameter> hidden_weights;
+  std::shared_ptr<Parameter> hidden_bias;
+  std::shared_ptr<Parameter> output_weights;
+  std::vector<float> features;
+};
+
+static Parameters randomParameters() {
+  std::mt19937 generator(3);
+  std::normal_distribution<float> distribution(0.F, 0.3F);
+  auto matrix = [&](uint32_t rows, uint32_t columns) {
+    std::vector<std::vector<float>> values(rows, std::vector<float>(columns));
+    for (auto& row : values) {
+      std::generate(row.begin(), row.end(),
+                    [&] { return distribution(generator); });
+    }
+    return std::make_shared<Parameter>(std::move(values));
+  };
+  Parameters parameters{matrix(DIMENSION, DIMENSION), matrix(1, DIMENSION),
+                        matrix(CLASSES, DIMENSION),
+                        std::vector<float>(DIMENSION)};
+  std::generate(parameters.features.begin(), parameters.features.end(),
+                [&] { return distribution(generator); });
+  return parameters;
+}
+
+/**
+ * Builds CE(W_o (h + h')) with h = GELU(W x + b). The branch h' is the same
+ * as h, built again from its own ParameterVertex objects if `duplicated`,
+ * or h itself otherwise.
+ */
+static std::pair<std::unique_ptr<Graph>, std::shared_ptr<CrossEntropyLoss>>
+buildTwoBranchGraph(Parameters& parameters, bool duplicated) {
+  auto graph = std::make_unique<Graph>();
+  VertexPointer input = std::make_shared<SequenceInputVertex>(
+      parameters.features, /* sequence_length = */ 1);
+  graph->addVertex(input);
+  auto branch = [&] {
+    auto weights = std::make_shared<ParameterVertex>(parameters.hidden_weights);
+    auto bias = std::make_shared<ParameterVertex>(parameters.hidden_bias);
+    graph->addVertex(weights);
+    graph->addVertex(bias);
+    auto projection = std::make_shared<FullyConnected>(input, weights);
+    graph->addVertex(projection);
+    auto activation = std::make_shared<BiasGELUActivation>(projection, bias);
+    graph->addVertex(activation);
+    return activation;
+  };
+  VertexPointer hidden = branch();
+  VertexPointer other_hidden = duplicated ? branch() : hidden;
+  auto sum = std::make_shared<ResidualAddition>(hidden, other_hidden);
+  graph->addVertex(sum);
+  auto logits = std::make_shared<FullyConnected>(
+      sum, std::make_shared<ParameterVertex>(parameters.output_weights));
+  auto loss = std::make_shared<CrossEntropyLoss>(logits, /* label = */ 1);
+  graph->addVertex(logits);
+  graph->addVertex(loss);
+  return {std::move(graph), loss};
+}
+
+static void runTrainingStep(Graph& graph, CrossEntropyLoss& loss) {
+  graph.launchForwardPass();
+  std::optional<std::vector<float>> no_upstream_grad = std::nullopt;
+  loss.backward(no_upstream_grad);
+}
+
+TEST(GraphPassesTest, MergedDuplicatesShareTheirGradient) {
+  auto shared = randomParameters();
+  auto [shared_graph, shared_loss] =
+      buildTwoBranchGraph(shared, /* duplicated = */ false);
+  runTrainingStep(*shared_graph, *shared_loss);
+
+  auto duplicated = randomParameters();
+  auto [graph, loss] = buildTwoBranchGraph(duplicated, /* duplicated = */ true);
+  uint32_t vertices = graph->getVerticesCount();
+  auto report = graph->eliminateRedundantVertices();
+  // The weights, bias, projection and activation of the second branch
+  ASSERT_EQ(report.merged_vertices, 4);
+  ASSERT_EQ(report.pruned_vertices, 0);
+  ASSERT_EQ(graph->getVerticesCount(), vertices - 4);
+  ASSERT_EQ(graph->getVerticesCount(), shared_graph->getVerticesCount());
+  runTrainingStep(*graph, *loss);
+
+  ASSERT_EQ(duplicated.hidden_weights->getGradient(),
+            shared.hidden_weights->getGradient());
+  ASSERT_EQ(duplicated.hidden_bias->getGradient(),
+            shared.hidden_bias->getGradient());
+  ASSERT_EQ(duplicated.output_weights->getGradient(),
+            shared.output_weights->getGradient());
+}
+
+TEST(GraphPassesTest, PrunesVerticesThatDoNotReachTheLoss) {
+  auto reference = randomParameters();
+  auto [reference_graph, reference_loss] =
+      buildTwoBranchGraph(reference, /* duplicated = */ false);
+  runTrainingStep(*reference_graph, *reference_loss);
+
+  auto parameters = randomParameters();
+  auto [graph, loss] =
+      buildTwoBranchGraph(parameters, /* duplicated = */ false);
+  // A second head on the hidden layer that nothing reads, inserted before
+  // the loss: without pruning, the hidden layer waits for its gradient
+  auto hidden = graph->getVertexAtIndex(4);
+  auto dead_head = std::make_shared<FullyConnected>(
+      hidden, std::make_shared<ParameterVertex>(parameters.output_weights));
+  std::vector<VertexPointer> vertices;
+  for (uint32_t index = 0; index < graph->getVerticesCount(); index++) {
+    vertices.push_back(graph->getVertexAtIndex(index));
+  }
+  graph->clearComputationGraph();
+  for (uint32_t index = 0; index < vertices.size(); index++) {
+    if (index == 5) {
+      graph->addVertex(dead_head);
+    }
+    graph->addVertex(vertices[index]);
+  }
+
+  auto report = graph->eliminateRedundantVertices();
+  ASSERT_EQ(report.merged_vertices, 0);
+  ASSERT_EQ(report.pruned_vertices, 1);
+  runTrainingStep(*graph, *loss);
+  ASSERT_EQ(parameters.hidden_weights->getGradient(),
+            reference.hidden_weights->getGradient());
+  ASSERT_EQ(parameters.hidden_bias->getGradient(),
+            reference.hidden_bias->getGradient());
+}
+
+TEST(GraphPassesTest, ReportsTheRemovedVertices) {
+  GraphPassReport report;
+  report.vertices_before = 20;
+  report.merged_vertices = 4;
+  report.pruned_vertices = 1;
+  report.folded_vertices = 2;
+  std::stringstream stream;
+  report.print(stream);
+  ASSERT_EQ(stream.str(),
+            "Removed 7 of 20 vertices: 4 duplicates merged, 1 dead vertices "
+            "pruned, 2 vertices folded into constants\n");
+}
+
+}  // namespace gladius::tests
@@ -0,0 +1,305 @@
+#include <gtest/gtest.h>
+#include <src/comp_graph/graph.hpp>
+#include <src/comp_graph/vertices/activ_functions.hpp>
+#include <src/comp_graph/vertices/fully_connected.hpp>
+#include <src/comp_graph/vertices/inner_product.hpp>
+#include <src/comp_graph/vertices/input_vertex.hpp>
+#include <src/comp_graph/vertices/loss.hpp>
+#include <src/comp_graph/vertices/param_vertex.hpp>
+#include <src/comp_graph/vertices/sampled_softmax.hpp>
+#include <src/comp_graph/vertices/summation.hpp>
+#include <src/params/parameters.hpp>
+#include <src/sampling/candidate_sampler.hpp>
+#include <tests/test_utils.hpp>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace gladius::tests {
+
+using gladius::comp_graph::BiasGELUActivation;
+using gladius::comp_graph::CrossEntropyLoss;
+using gladius::comp_graph::FullyConnected;
+using gladius::comp_graph::GradMode;
+using gladius::comp_graph::Graph;
+using gladius::comp_graph::InnerProduct;
+using gladius::comp_graph::InputVertex;
+using gladius::comp_graph::NoGradGuard;
+using gladius::comp_graph::ParameterVertex;
+using gladius::comp_graph::SampledSoftmaxLoss;
+using gladius::comp_graph::Summation;
+using gladius::parameters::Parameter;
+using gladius::sampling::CandidateSampler;
+using gladius::comp_graph::SequenceInputVertex;
+using gladius::comp_graph::VertexPointer;
+
+static inline constexpr uint32_t NUM_CLASSES = 1000;
+
+static std::vector<float> randomLogits() {
+  std::mt19937 generator(3);
+  // Large logits make sure the loss does not overflow exp()
+  std::normal_distribution<float> distribution(0.F, 50.F);
+  std::vector<float> logits(NUM_CLASSES);
+  for (auto& logit : logits) {
+    logit = distribution(generator);
+  }
+  return logits;
+}
+
+TEST(gladiusLoss, FusedCrossEntropyMatchesSoftmaxDefinition) {
+  auto logits = randomLogits();
+  uint32_t label = 17;
+
+  double max_logit = *std::max_element(logits.begin(), logits.end());
+  double sum_exps = 0.0;
+  for (float logit : logits) {
+    sum_exps += std::exp(logit - max_logit);
+  }
+
+  auto input_logits = logits;
+  auto input = std::make_shared<SequenceInputVertex>(input_logits,
+                                                     /* sequence_length = */ 1);
+  auto loss = std::make_shared<CrossEntropyLoss>(input, label);
+  loss->forward();
+
+  double expected_loss = std::log(sum_exps) - (logits[label] - max_logit);
+  ASSERT_NEAR(loss->getOutput().at(0), expected_loss, 1e-3);
+  ASSERT_EQ(loss->getPredictedLabel(),
+            std::max_element(logits.begin(), logits.end()) - logits.begin());
+
+  auto& gradient = loss->getGradient();
+  for (uint32_t index = 0; index < NUM_CLASSES; index++) {
+    double softmax = std::exp(logits[index] - max_logit) / sum_exps;
+    ASSERT_NEAR(gradient[index], softmax - (index == label), 1e-5);
+  }
+}
+
+TEST(gladiusLoss, OneHotAndClassIndexLabelsAgree) {
+  auto logits = randomLogits();
+  std::vector<uint32_t> one_hot(NUM_CLASSES, 0);
+  one_hot[42] = 1;
+
+  auto dense_logits = logits;
+  auto dense_loss = std::make_shared<CrossEntropyLoss>(
+      std::make_shared<SequenceInputVertex>(dense_logits, 1), one_hot);
+  auto sparse_logits = logits;
+  auto sparse_loss = std::make_shared<CrossEntropyLoss>(
+      std::make_shared<SequenceInputVertex>(sparse_logits, 1),
+      /* label = */ 42);
+  dense_loss->forward();
+  sparse_loss->forward();
+
+  ASSERT_EQ(dense_loss->getOutput().at(0), sparse_loss->getOutput().at(0));
+  ASSERT_EQ(dense_loss->getGradient(), sparse_loss->getGradient());
+
+  auto invalid_logits = logits;
+  auto invalid_input =
+      std::make_shared<SequenceInputVertex>(invalid_logits, 1);
+  ASSERT_THROW(CrossEntropyLoss(invalid_input, /* label = */ NUM_CLASSES),
+               std::invalid_argument);
+}
+
+TEST(gladiusLoss, AliasTableMatchesUnigramDistribution) {
+  std::vector<float> counts = {1.F, 1.F, 5.F, 2.F, 11.F};
+  auto sampler = CandidateSampler::unigram(counts, /* seed = */ 11);
+
+  constexpr uint32_t NUM_SAMPLES = 200000;
+  std::vector<uint32_t> frequencies(counts.size(), 0);
+  for (uint32_t sample = 0; sample < NUM_SAMPLES; sample++) {
+    frequencies[sampler.sample()]++;
+  }
+  for (uint32_t index = 0; index < counts.size(); index++) {
+    ASSERT_NEAR(sampler.probability(index), counts[index] / 20.F, 1e-6);
+    ASSERT_NEAR(static_cast<float>(frequencies[index]) / NUM_SAMPLES,
+                sampler.probability(index), 5e-3);
+  }
+}
+
+TEST(gladiusLoss, UnigramRejectsNonPositiveCounts) {
+  // log Q(c) of a class with a zero count would make the sampled logits
+  // infinite
+  ASSERT_THROW(CandidateSampler::unigram({1.F, 0.F, 5.F}),
+               std::invalid_argument);
+  ASSERT_THROW(CandidateSampler::unigram({1.F, -2.F, 5.F}),
+               std::invalid_argument);
+  ASSERT_THROW(CandidateSampler::unigram({1.F, NAN, 5.F}),
+               std::invalid_argument);
+}
+
+/**
+ * Runs the sampled softmax loss with a freshly seeded sampler, so that every
+ * call draws the same candidates.
+ */
+static std::shared_ptr<SampledSoftmaxLoss> sampledLoss(
+    const std::vector<float>& hidden,
+    const std::shared_ptr<Parameter>& weights, uint32_t label) {
+  auto input = hidden;
+  auto sampler = std::make_shared<CandidateSampler>(
+      CandidateSampler::logUniform(NUM_CLASSES, /* seed = */ 5));
+  auto loss = std::make_shared<SampledSoftmaxLoss>(
+      std::make_shared<SequenceInputVertex>(input, 1),
+      std::make_shared<ParameterVertex>(weights), label, sampler,
+      /* num_sampled = */ 8);
+  loss->forward();
+  return loss;
+}
+
+TEST(gladiusLoss, SampledSoftmaxOnlyWritesSampledRows) {
+  constexpr uint32_t DIMENSION = 6;
+  std::mt19937 generator(9);
+  std::normal_distribution<float> distribution(0.F, 1.F);
+  std::vector<std::vector<float>> rows(NUM_CLASSES,
+                                       std::vector<float>(DIMENSION));
+  for (auto& row : rows) {
+    std::generate(row.begin(), row.end(),
+                  [&] { return distribution(generator); });
+  }
+  std::vector<float> hidden(DIMENSION);
+  std::generate(hidden.begin(), hidden.end(),
+                [&] { return distribution(generator); });
+  auto weights = std::make_shared<Parameter>(std::move(rows));
+  uint32_t label = 123;
+
+  auto loss = sampledLoss(hidden, weights, label);
+  std::optional<std::vector<float>> no_upstream_grad = std::nullopt;
+  loss->backward(no_upstream_grad);
+  auto gradient = weights->getGradient();
+  const auto& candidates = loss->getCandidates();
+
+  constexpr float EPSILON = 1e-2;
+  for (uint32_t row = 0; row < NUM_CLASSES; row++) {
+    bool sampled = std::find(candidates.begin(), candidates.end(), row) !=
+                   candidates.end();
+    for (uint32_t col = 0; col < DIMENSION; col++) {
+      float analytic_gradient = gradient[row * DIMENSION + col];
+      if (!sampled) {
+        ASSERT_EQ(analytic_gradient, 0.F);
+        continue;
+      }
+      float& weight = weights->getValue()[row][col];
+      float original = weight;
+      weight = original + EPSILON;
+      float upper = sampledLoss(hidden, weights, label)->getOutput().at(0);
+      weight = original - EPSILON;
+      float lower = sampledLoss(hidden, weights, label)->getOutput().at(0);
+      weight = original;
+      ASSERT_NEAR(analytic_gradient, (upper - lower) / (2 * EPSILON), 1e-2);
+    }
+  }
+
+  weights->zeroOutGradient();
+  for (float grad : weights->getGradient()) {
+    ASSERT_EQ(grad, 0.F);
+  }
+}
+
+/**
+ * Builds the graph of a two layer classifier
+ *        CE(W_2 GELU(W_1 x + b_1) + b_2, label)
+ */
+static std::shared_ptr<Graph> buildClassifier(
+    const std::vector<std::shared_ptr<Parameter>>& parameters,
+    std::vector<float> features, uint32_t label) {
+  auto input = std::make_shared<SequenceInputVertex>(features,
+                                                     /* sequence_length = */ 1);
+  auto hidden = std::make_shared<FullyConnected>(
+      input, std::make_shared<ParameterVertex>(parameters[0]));
+  auto activation = std::make_shared<BiasGELUActivation>(
+      hidden, std::make_shared<ParameterVertex>(parameters[1]));
+  auto logits = std::make_shared<FullyConnected>(
+      activation, std::make_shared<ParameterVertex>(parameters[2]),
+      std::make_shared<ParameterVertex>(parameters[3]));
+  auto loss = std::make_shared<CrossEntropyLoss>(logits, label);
+
+  auto graph = std::make_shared<Graph>();
+  for (const VertexPointer& vertex :
+       std::vector<VertexPointer>{input, hidden, activation, logits, loss}) {
+    graph->addVertex(vertex);
+  }
+  return graph;
+}
+
+TEST(gladiusLoss, NoGradGraphPredictsAndReleasesIntermediateOutputs) {
+  constexpr uint32_t INPUT_DIMENSION = 12;
+  constexpr uint32_t HIDDEN_DIMENSION = 16;
+  constexpr uint32_t CLASSES = 5;
+  std::mt19937 generator(21);
+  std::normal_distribution<float> distribution(0.F, 1.F);
+  auto randomMatrix = [&](uint32_t rows, uint32_t columns) {
+    std::vector<std::vector<float>> matrix(rows, std::vector<float>(columns));
+    for (auto& row : matrix) {
+      std::generate(row.begin(), row.end(),
+                    [&] { return distribution(generator); });
+    }
+    return std::make_shared<Parameter>(std::move(matrix));
+  };
+  std::vector<std::shared_ptr<Parameter>> parameters = {
+      randomMatrix(HIDDEN_DIMENSION, INPUT_DIMENSION),
+      randomMatrix(1, HIDDEN_DIMENSION),
+      randomMatrix(CLASSES, HIDDEN_DIMENSION), randomMatrix(1, CLASSES)};
+
+  for (uint32_t sample = 0; sample < 10; sample++) {
+    std::vector<float> features(INPUT_DIMENSION);
+    std::generate(features.begin(), features.end(),
+                  [&] { return distribution(generator); });
+
+    auto training_graph = buildClassifier(parameters, features, 0);
+    auto [expected_label, loss] = training_graph->launchForwardPass();
+
+    NoGradGuard no_grad;
+    auto graph = buildClassifier(parameters, features, 0);
+    ASSERT_EQ(graph->predict(), expected_label);
+
+    // Only the logits are left, and the loss is never computed
+    ASSERT_TRUE(graph->getVertexAtIndex(1)->isOutputReleased());
+    ASSERT_TRUE(graph->getVertexAtIndex(2)->isOutputReleased());
+    ASSERT_FALSE(graph->getVertexAtIndex(3)->isOutputReleased());
+    ASSERT_TRUE(graph->getVertexAtIndex(4)->isOutputReleased());
+
+    auto loss_vertex = graph->getVertexAtIndex(4);
+    ASSERT_FALSE(loss_vertex->requiresGrad());
+    std::optional<std::vector<float>> no_upstream_grad = std::nullopt;
+    ASSERT_THROW(loss_vertex->backward(no_upstream_grad), std::runtime_error);
+  }
+  ASSERT_TRUE(GradMode::isEnabled());
+}
+
+TEST(gladiusLoss, NoGradInnerProductGraphPredictsLikeItsTrainingGraph) {
+  // The graph of the MNIST end-to-end test, W x + b with a one-hot label
+  constexpr uint32_t INPUT_DIMENSION = 20;
+  constexpr uint32_t CLASSES = 6;
+  std::mt19937 generator(17);
+  auto weights = randomParameter(CLASSES, INPUT_DIMENSION, generator);
+  auto bias = randomParameter(1, CLASSES, generator);
+  auto build = [&](std::vector<float> features,
+                   const std::vector<uint32_t>& label) {
+    auto input = std::make_shared<InputVertex>(features);
+    auto weight_vertex = std::make_shared<ParameterVertex>(weights);
+    auto bias_vertex = std::make_shared<ParameterVertex>(bias);
+    auto product = std::make_shared<InnerProduct>(weight_vertex, input);
+    auto sum = std::make_shared<Summation>(product, bias_vertex);
+    auto loss = std::make_shared<CrossEntropyLoss>(sum, label);
+    auto graph = std::make_shared<Graph>();
+    for (const VertexPointer& vertex : std::vector<VertexPointer>{
+             input, weight_vertex, bias_vertex, product, sum, loss}) {
+      graph->addVertex(vertex);
+    }
+    return graph;
+  };
+
+  for (uint32_t sample = 0; sample < 10; sample++) {
+    auto features = randomVector(INPUT_DIMENSION, generator);
+    std::vector<uint32_t> label(CLASSES, 0);
+    label[sample % CLASSES] = 1;
+    auto [expected_label, loss] = build(features, label)->launchForwardPass();
+
+    NoGradGuard no_grad;
+    ASSERT_EQ(build(features, label)->predict(), expected_label);
+  }
+}
+
+}  // namespace gladius::tests
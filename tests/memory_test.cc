@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+#include <src/memory/memory_tracker.hpp>
+#include <src/memory/numa.hpp>
+#include <src/params/parameters.hpp>
+#include <tests/test_utils.hpp>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace gladius::tests {
+
+using gladius::memory::MemoryBudgetExceeded;
+using gladius::memory::MemoryCategory;
+using gladius::memory::MemorySnapshot;
+using gladius::memory::MemoryTracker;
+using gladius::memory::NumaPlacement;
+using gladius::memory::NumaPolicy;
+using gladius::memory::NumaTopology;
+using gladius::memory::parseCPUList;
+using gladius::parameters::Parameter;
+
+/**
+ * Runs the forward and backward passes of the MLP of buildMLP() and returns
+ * a snapshot taken before the graph and its parameters are destroyed.
+ */
+static MemorySnapshot runTrainingStep() {
+  auto mlp = buildMLP();
+  runForwardAndBackward(mlp);
+  return MemoryTracker::snapshot();
+}
+
+static uint64_t parameterBytes(uint32_t rows, uint32_t columns) {
+  // Bytes of the value, which is stored as a vector of rows
+  return rows * (sizeof(std::vector<float>) + columns * sizeof(float));
+}
+
+static const gladius::memory::MemoryStatistics& getCategory(
+    const MemorySnapshot& snapshot, MemoryCategory category) {
+  return snapshot.categories[static_cast<uint32_t>(category)];
+}
+
+TEST(MemoryTrackerTest, TracksParametersAndVertexBuffersByCategory) {
+  MemoryTracker::enable();
+  auto snapshot = runTrainingStep();
+  MemoryTracker::disable();
+
+  uint64_t expected_parameter_bytes =
+      parameterBytes(MLP_HIDDEN_DIMENSION, MLP_INPUT_DIMENSION) +
+      parameterBytes(1, MLP_HIDDEN_DIMENSION) +
+      parameterBytes(MLP_CLASSES, MLP_HIDDEN_DIMENSION) +
+      parameterBytes(1, MLP_CLASSES);
+  ASSERT_EQ(getCategory(snapshot, MemoryCategory::Parameters).live_bytes,
+            expected_parameter_bytes);
+
+  // Every parameter has a gradient and the outputs of the vertices are
+  // kept until the graph is destroyed
+  ASSERT_GT(getCategory(snapshot, MemoryCategory::Gradients).live_bytes, 0);
+  ASSERT_GE(getCategory(snapshot, MemoryCategory::Activations).live_bytes,
+            (MLP_HIDDEN_DIMENSION * 2 + MLP_CLASSES) * sizeof(float));
+  ASSERT_EQ(getCategory(snapshot, MemoryCategory::OptimizerState).peak_bytes,
+            0);
+
+  uint64_t category_bytes = 0;
+  for (const auto& statistics : snapshot.categories) {
+    category_bytes += statistics.live_bytes;
+  }
+  ASSERT_EQ(category_bytes, snapshot.total.live_bytes);
+  ASSERT_GE(snapshot.total.peak_bytes, snapshot.total.live_bytes);
+
+  for (const std::string owner :
+       {"Parameter", "FullyConnected", "BiasGELU", "SequenceInput"}) {
+    ASSERT_TRUE(snapshot.owners.count(owner)) << owner;
+    ASSERT_GT(snapshot.owners.at(owner).peak_bytes, 0) << owner;
+  }
+
+  std::ostringstream stream;
+  snapshot.print(stream);
+  ASSERT_NE(stream.str().find("Activations"), std::string::npos);
+  ASSERT_NE(stream.str().find("FullyConnected"), std::string::npos);
+}
+
+TEST(MemoryTrackerTest, ReleasesBuffersWhenTheGraphIsDestroyed) {
+  MemoryTracker::enable();
+  auto during_step = runTrainingStep();
+  auto after_step = MemoryTracker::snapshot();
+  MemoryTracker::disable();
+
+  ASSERT_GT(during_step.total.live_bytes, 0);
+  ASSERT_EQ(after_step.total.live_bytes, 0);
+  ASSERT_EQ(after_step.total.peak_bytes, during_step.total.peak_bytes);
+  for (const auto& [owner, statistics] : after_step.owners) {
+    ASSERT_EQ(statistics.live_bytes, 0) << owner;
+  }
+}
+
+TEST(MemoryTrackerTest, ThrowsOnceTheBudgetIsExceeded) {
+  // The first weight matrix alone takes more than the budget
+  MemoryTracker::enable(/* budget_bytes = */ 512);
+  try {
+    runTrainingStep();
+    FAIL() << "Expected the memory budget to be exceeded";
+  } catch (const MemoryBudgetExceeded& error) {
+    ASSERT_NE(std::string(error.what()).find("Parameter"), std::string::npos);
+    ASSERT_GT(error.getSnapshot().total.live_bytes, 512);
+    ASSERT_EQ(error.getSnapshot().budget_bytes, 512);
+  }
+  MemoryTracker::disable();
+
+  // The buffers of the failed step were released while unwinding
+  ASSERT_EQ(MemoryTracker::snapshot().total.live_bytes, 0);
+}
+
+TEST(MemoryTrackerTest, DoesNotTrackWhileDisabled) {
+  MemoryTracker::enable();
+  MemoryTracker::disable();
+  runTrainingStep();
+  ASSERT_EQ(MemoryTracker::snapshot().total.peak_bytes, 0);
+}
+
+TEST(NumaTest, ParsesCPULists) {
+  ASSERT_EQ(parseCPUList("0-3,8,10-11\n"),
+            (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+  ASSERT_EQ(parseCPUList("5"), std::vector<int>{5});
+  ASSERT_TRUE(parseCPUList("").empty());
+}
+
+TEST(NumaTest, LoadsTheTopologyAndSpreadsCPUsOverTheNodes) {
+  auto root = std::filesystem::temp_directory_path() / "gladius_numa_test";
+  std::filesystem::remove_all(root);
+  std::filesystem::create_directories(root / "node0");
+  std::filesystem::create_directories(root / "node2");
+  std::ofstream(root / "online") << "0,2\n";
+  std::ofstream(root / "node0" / "cpulist") << "0-1\n";
+  std::ofstream(root / "node2" / "cpulist") << "2-3\n";
+
+  auto topology = NumaTopology::load(root.string());
+  ASSERT_EQ(topology.getNumNodes(), 2);
+  ASSERT_TRUE(topology.isMultiNode());
+  ASSERT_EQ(topology.getNodeId(1), 2);
+  ASSERT_EQ(topology.getNodeCPUs(1), (std::vector<int>{2, 3}));
+  ASSERT_EQ(topology.getNodeOfCPU(3), 1);
+  ASSERT_EQ(topology.spreadOverNodes({0, 1, 2, 3}),
+            (std::vector<int>{0, 2, 1, 3}));
+  ASSERT_EQ(topology.spreadOverNodes({0, 1, 3}),
+            (std::vector<int>{0, 3, 1}));
+  std::filesystem::remove_all(root);
+
+  // Without NUMA support, a single node
+  auto missing = NumaTopology::load((root / "missing").string());
+  ASSERT_EQ(missing.getNumNodes(), 1);
+  ASSERT_FALSE(missing.isMultiNode());
+  ASSERT_EQ(missing.spreadOverNodes({0, 1}), (std::vector<int>{0, 1}));
+}
+
+TEST(NumaTest, InterleavedParametersKeepTheirValues) {
+  NumaPolicy::enable(NumaPlacement::Interleave);
+  std::vector<std::vector<float>> value(64, std::vector<float>(1024));
+  for (uint32_t row = 0; row < value.size(); row++) {
+    std::fill(value[row].begin(), value[row].end(), float(row));
+  }
+  auto expected = value;
+  Parameter parameter(std::move(value));
+  const auto& gradient = parameter.getGradient();
+  ASSERT_TRUE(
+      NumaPolicy::place(gradient.data(), gradient.size() * sizeof(float)));
+  NumaPolicy::disable();
+
+  ASSERT_EQ(parameter.getValue(), expected);
+  ASSERT_EQ(NumaPolicy::getPlacement(), NumaPlacement::FirstTouch);
+}
+
+}  // namespace gladius::tests
@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+#include <src/comp_graph/graph.hpp>
+#include <src/comp_graph/offloading.hpp>
+#include <src/memory/spill_file.hpp>
+#include <tests/test_utils.hpp>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace gladius::tests {
+
+using gladius::comp_graph::ActivationOffloader;
+using gladius::comp_graph::OffloadOptions;
+using gladius::memory::SPILL_ALIGNMENT;
+using gladius::memory::SpillFile;
+
+static OffloadOptions spillEverything() {
+  OffloadOptions options;
+  options.min_bytes = 0;
+  options.prefetch_depth = 3;
+  return options;
+}
+
+static float runTrainingStep(TrainingGraph& network, bool flush = true) {
+  auto [prediction, loss] = network.graph->launchForwardPass();
+  if (auto* offloader = network.graph->getOffloader(); offloader && flush) {
+    // Every spilled output is on disk before the backward pass
+    offloader->flush();
+  }
+  std::optional<std::vector<float>> no_upstream_grad = std::nullopt;
+  network.loss->backward(no_upstream_grad);
+  return loss;
+}
+
+TEST(SpillFileTest, ReadsBackAlignedRegions) {
+  SpillFile file;
+  std::vector<std::vector<float>> buffers;
+  std::vector<uint64_t> offsets;
+  for (uint32_t size : {1, 1000, 1024, 3000}) {
+    buffers.emplace_back(size);
+    std::iota(buffers.back().begin(), buffers.back().end(),
+              static_cast<float>(size));
+    offsets.push_back(file.allocate(size * sizeof(float)));
+    ASSERT_EQ(offsets.back() % SPILL_ALIGNMENT, 0);
+    file.write(offsets.back(), buffers.back().data(),
+               buffers.back().size() * sizeof(float));
+  }
+  // Read in the reverse order, as in the backward pass
+  for (uint32_t index = buffers.size(); index-- > 0;) {
+    std::vector<float> read_back(buffers[index].size());
+    file.read(offsets[index], read_back.data(),
+              read_back.size() * sizeof(float));
+    ASSERT_EQ(read_back, buffers[index]);
+  }
+
+  file.reset();
+  ASSERT_EQ(file.getAllocatedBytes(), 0);
+  ASSERT_EQ(file.allocate(8), 0);
+}
+
+TEST(OffloadingTest, GradientsMatchTheInMemoryPass) {
+  auto reference = buildDeepNetwork(/* depth = */ 12);
+  auto offloaded = buildDeepNetwork(/* depth = */ 12);
+  offloaded.graph->enableOffloading(spillEverything());
+
+  ASSERT_EQ(runTrainingStep(offloaded), runTrainingStep(reference));
+  auto statistics = offloaded.graph->getOffloader()->getStatistics();
+  // Every output but the ones of the input and the loss
+  uint32_t spillable = offloaded.graph->getVerticesCount() - 2;
+  ASSERT_EQ(statistics.spilled_outputs, spillable);
+  ASSERT_EQ(statistics.spilled_bytes,
+            ((spillable - 1) * DEEP_NETWORK_DIMENSION + DEEP_NETWORK_CLASSES) *
+                sizeof(float));
+  // Each of them is read back once
+  ASSERT_EQ(statistics.read_bytes, statistics.spilled_bytes);
+  ASSERT_EQ(statistics.hits + statistics.stalls, spillable);
+  ASSERT_GT(statistics.prefetches, 0);
+
+  for (uint32_t index = 0; index < reference.parameters.size(); index++) {
+    ASSERT_EQ(offloaded.parameters[index]->getGradient(),
+              reference.parameters[index]->getGradient())
+        << "parameter " << index;
+  }
+}
+
+TEST(OffloadingTest, BackwardPassOverlapsThePendingWrites) {
+  auto reference = buildDeepNetwork(/* depth = */ 12);
+  auto offloaded = buildDeepNetwork(/* depth = */ 12);
+  offloaded.graph->enableOffloading(spillEverything());
+  // The backward pass cancels the writes it gets to first
+  ASSERT_EQ(runTrainingStep(offloaded, /* flush = */ false),
+            runTrainingStep(reference));
+  offloaded.graph->getOffloader()->flush();
+
+  for (uint32_t index = 0; index < reference.parameters.size(); index++) {
+    ASSERT_EQ(offloaded.parameters[index]->getGradient(),
+              reference.parameters[index]->getGradient())
+        << "parameter " << index;
+  }
+}
+
+TEST(OffloadingTest, ReleasesSpilledOutputsInTheForwardPass) {
+  auto network = buildDeepNetwork(/* depth = */ 4);
+  network.graph->enableOffloading(spillEverything());
+  network.graph->launchForwardPass();
+  network.graph->getOffloader()->flush();
+
+  // {x, W_0, GELU_0, ..., W_3, GELU_3, W_o, CE}
+  ASSERT_FALSE(network.graph->getVertexAtIndex(0)->isOutputReleased());
+  for (uint32_t index = 1; index <= 9; index++) {
+    ASSERT_TRUE(network.graph->getVertexAtIndex(index)->isOutputReleased())
+        << "vertex " << index;
+  }
+  ASSERT_FALSE(network.graph->getVertexAtIndex(10)->isOutputReleased());
+
+  std::optional<std::vector<float>> no_upstream_grad = std::nullopt;
+  network.loss->backward(no_upstream_grad);
+  // Outputs read back are released again after their backward pass
+  for (uint32_t index = 1; index <= 9; index++) {
+    ASSERT_TRUE(network.graph->getVertexAtIndex(index)->isOutputReleased())
+        << "vertex " << index;
+  }
+}
+
+TEST(OffloadingTest, CannotBeCombinedWithCheckpointing) {
+  auto network = buildDeepNetwork(/* depth = */ 2);
+  network.graph->enableOffloading();
+  ASSERT_THROW(network.graph->enableCheckpointing(), std::logic_error);
+  network.graph->disableOffloading();
+  network.graph->enableCheckpointing();
+  ASSERT_THROW(network.graph->enableOffloading(), std::logic_error);
+}
+
+}  // namespace gladius::tests
@@ -0,0 +1,334 @@
+#include <gtest/gtest.h>
+#include <src/comp_graph/graph.hpp>
+#include <src/comp_graph/graph_executor.hpp>
+#include <src/comp_graph/vertices/activ_functions.hpp>
+#include <src/comp_graph/vertices/fully_connected.hpp>
+#include <src/comp_graph/vertices/input_vertex.hpp>
+#include <src/comp_graph/vertices/loss.hpp>
+#include <src/comp_graph/vertices/param_vertex.hpp>
+#include <src/comp_graph/vertices/summation.hpp>
+#include <src/params/parameters.hpp>
+#include <src/parallel/parallel_for.hpp>
+#include <src/parallel/thread_pool.hpp>
+#include <src/parallel/work_stealing_deque.hpp>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace gladius::tests {
+
+using gladius::comp_graph::BiasGELUActivation;
+using gladius::comp_graph::CrossEntropyLoss;
+using gladius::comp_graph::FullyConnected;
+using gladius::comp_graph::Graph;
+using gladius::comp_graph::GraphExecutor;
+using gladius::comp_graph::ParameterVertex;
+using gladius::comp_graph::ResidualAddition;
+using gladius::comp_graph::SequenceInputVertex;
+using gladius::comp_graph::Vertex;
+using gladius::comp_graph::VertexPointer;
+using gladius::parallel::Job;
+using gladius::parallel::parallelFor;
+using gladius::parallel::ThreadPool;
+using gladius::parallel::WorkStealingDeque;
+using gladius::parameters::Parameter;
+
+static inline constexpr uint32_t INPUT_DIMENSION = 24;
+static inline constexpr uint32_t HIDDEN_DIMENSION = 32;
+static inline constexpr uint32_t CLASSES = 6;
+static inline constexpr uint32_t BRANCHES = 3;
+
+static std::shared_ptr<ParameterVertex> randomParameter(
+    uint32_t rows, uint32_t columns, std::mt19937& generator) {
+  std::normal_distribution<float> distribution(0.F, 0.3F);
+  std::vector<std::vector<float>> matrix(rows, std::vector<float>(columns));
+  for (auto& row : matrix) {
+    std::generate(row.begin(), row.end(),
+                  [&] { return distribution(generator); });
+  }
+  return std::make_shared<ParameterVertex>(
+      std::make_shared<Parameter>(std::move(matrix)));
+}
+
+/**
+ * Builds the vertices, in topological order, of
+ *    CE(W_o (GELU(W_1 x + b_1) + GELU(W_2 x + b_2) + GELU(W_3 x + b_3)))
+ * whose three branches are independent, like the Q/K/V projections of an
+ * attention block.
+ */
+static std::vector<VertexPointer> buildWideGraph() {
+  std::mt19937 generator(11);
+  std::vector<float> features(INPUT_DIMENSION);
+  std::normal_distribution<float> distribution(0.F, 1.F);
+  std::generate(features.begin(), features.end(),
+                [&] { return distribution(generator); });
+
+  std::vector<VertexPointer> vertices;
+  auto input = std::make_shared<SequenceInputVertex>(features,
+                                                     /* sequence_length = */ 1);
+  vertices.push_back(input);
+
+  std::vector<VertexPointer> branches;
+  for (uint32_t branch = 0; branch < BRANCHES; branch++) {
+    auto projection = std::make_shared<FullyConnected>(
+        input,
+        randomParameter(HIDDEN_DIMENSION, INPUT_DIMENSION, generator));
+    auto activation = std::make_shared<BiasGELUActivation>(
+        projection, randomParameter(1, HIDDEN_DIMENSION, generator));
+    vertices.push_back(projection);
+    vertices.push_back(activation);
+    branches.push_back(activation);
+  }
+  VertexPointer sum = branches[0];
+  for (uint32_t branch = 1; branch < BRANCHES; branch++) {
+    sum = std::make_shared<ResidualAddition>(sum, branches[branch]);
+    vertices.push_back(sum);
+  }
+  auto logits = std::make_shared<FullyConnected>(
+      sum, randomParameter(CLASSES, HIDDEN_DIMENSION, generator));
+  vertices.push_back(logits);
+  vertices.push_back(
+      std::make_shared<CrossEntropyLoss>(logits, /* label = */ 4));
+  return vertices;
+}
+
+TEST(gladiusParallel, WorkStealingDequeIsLIFOForTheOwnerAndFIFOForThieves) {
+  WorkStealingDeque<uint32_t> deque(/* capacity = */ 2);
+  ASSERT_FALSE(deque.pop().has_value());
+  ASSERT_FALSE(deque.steal().has_value());
+
+  // Grows past the initial capacity
+  for (uint32_t item = 0; item < 100; item++) {
+    deque.push(item);
+  }
+  ASSERT_EQ(deque.steal().value(), 0);
+  ASSERT_EQ(deque.pop().value(), 99);
+  ASSERT_EQ(deque.steal().value(), 1);
+  for (uint32_t item = 98; item >= 2; item--) {
+    ASSERT_EQ(deque.pop().value(), item);
+  }
+  ASSERT_TRUE(deque.empty());
+  ASSERT_FALSE(deque.pop().has_value());
+}
+
+TEST(gladiusParallel, WorkStealingDequeHandsOutEveryItemOnce) {
+  constexpr uint32_t ITEMS = 200000;
+  constexpr uint32_t THIEVES = 3;
+  WorkStealingDeque<uint32_t> deque(/* capacity = */ 64);
+  std::vector<std::atomic<uint32_t>> taken(ITEMS);
+  std::atomic<uint32_t> total_taken = 0;
+  std::atomic<bool> done_pushing = false;
+
+  std::vector<std::thread> thieves;
+  for (uint32_t thief = 0; thief < THIEVES; thief++) {
+    thieves.emplace_back([&] {
+      while (!done_pushing.load() || !deque.empty()) {
+        if (auto item = deque.steal()) {
+          taken[*item]++;
+          total_taken++;
+        }
+      }
+    });
+  }
+  for (uint32_t item = 0; item < ITEMS; item++) {
+    deque.push(item);
+    if (item % 3 == 0) {
+      if (auto popped = deque.pop()) {
+        taken[*popped]++;
+        total_taken++;
+      }
+    }
+  }
+  done_pushing = true;
+  while (auto popped = deque.pop()) {
+    taken[*popped]++;
+    total_taken++;
+  }
+  for (auto& thief : thieves) {
+    thief.join();
+  }
+
+  ASSERT_EQ(total_taken.load(), ITEMS);
+  for (uint32_t item = 0; item < ITEMS; item++) {
+    ASSERT_EQ(taken[item].load(), 1) << item;
+  }
+}
+
+/**
+ * Task t schedules tasks 2t + 1 and 2t + 2, i.e., a binary tree of tasks
+ */
+class TreeJob final : public Job {
+ public:
+  TreeJob(ThreadPool& pool, uint32_t size)
+      : _pool(pool), _executions(size), _throw_at(size) {}
+
+  void execute(uint32_t task) final {
+    _executions[task]++;
+    if (task == _throw_at) {
+      throw std::runtime_error("task failed");
+    }
+    for (uint32_t child : {2 * task + 1, 2 * task + 2}) {
+      if (child < _executions.size()) {
+        _pool.schedule(child);
+      }
+    }
+  }
+
+  void throwAt(uint32_t task) { _throw_at = task; }
+
+  inline const std::vector<std::atomic<uint32_t>>& getExecutions() const {
+    return _executions;
+  }
+
+ private:
+  ThreadPool& _pool;
+  std::vector<std::atomic<uint32_t>> _executions;
+  uint32_t _throw_at;
+};
+
+TEST(gladiusParallel, ThreadPoolRunsEveryScheduledTaskOnce) {
+  ThreadPool pool(/* num_threads = */ 4);
+  for (uint32_t repetition = 0; repetition < 3; repetition++) {
+    TreeJob job(pool, /* size = */ 5000);
+    pool.run(job, /* initial_tasks = */ {0});
+    for (const auto& executions : job.getExecutions()) {
+      ASSERT_EQ(executions.load(), 1);
+    }
+  }
+}
+
+TEST(gladiusParallel, ThreadPoolRethrowsTheExceptionOfATask) {
+  ThreadPool pool(/* num_threads = */ 3);
+  TreeJob failing_job(pool, /* size = */ 1000);
+  failing_job.throwAt(5);
+  ASSERT_THROW(pool.run(failing_job, /* initial_tasks = */ {0}),
+               std::runtime_error);
+  // The subtree of the failed task never ran
+  ASSERT_EQ(failing_job.getExecutions()[11].load(), 0);
+
+  // The pool is still usable
+  TreeJob job(pool, /* size = */ 1000);
+  pool.run(job, /* initial_tasks = */ {0});
+  ASSERT_EQ(job.getExecutions()[999].load(), 1);
+}
+
+TEST(gladiusParallel, GraphExecutorRunsBranchesInDependencyOrder) {
+  auto parallel_vertices = buildWideGraph();
+  auto sequential_vertices = buildWideGraph();
+
+  GraphExecutor executor(parallel_vertices);
+  ASSERT_EQ(executor.getMaxWidth(), BRANCHES);
+
+  std::unordered_map<Vertex*, uint32_t> indices;
+  for (uint32_t index = 0; index < parallel_vertices.size(); index++) {
+    indices[parallel_vertices[index].get()] = index;
+  }
+  std::vector<std::atomic<bool>> finished(parallel_vertices.size());
+
+  ThreadPool pool(/* num_threads = */ 4);
+  executor.run(
+      [&](uint32_t index) {
+        for (const auto& input : parallel_vertices[index]->getInputs()) {
+          if (indices.count(input.get())) {
+            ASSERT_TRUE(finished[indices.at(input.get())].load());
+          }
+        }
+        parallel_vertices[index]->forward();
+        finished[index] = true;
+      },
+      pool);
+  for (const auto& vertex : sequential_vertices) {
+    vertex->forward();
+  }
+
+  for (uint32_t index = 0; index < parallel_vertices.size(); index++) {
+    ASSERT_TRUE(finished[index].load());
+    ASSERT_EQ(parallel_vertices[index]->getOutput(),
+              sequential_vertices[index]->getOutput());
+  }
+}
+
+TEST(gladiusParallel, GraphRunsWideForwardPassesWithoutChanges) {
+  auto vertices = buildWideGraph();
+  auto reference_vertices = buildWideGraph();
+
+  Graph graph;
+  for (const auto& vertex : vertices) {
+    graph.addVertex(vertex);
+  }
+  auto [prediction, loss] = graph.launchForwardPass();
+
+  for (const auto& vertex : reference_vertices) {
+    vertex->forward();
+  }
+  ASSERT_EQ(loss, reference_vertices.back()->getOutput().at(0));
+  auto* reference_loss =
+      dynamic_cast<CrossEntropyLoss*>(reference_vertices.back().get());
+  ASSERT_EQ(prediction, reference_loss->getPredictedLabel());
+}
+
+TEST(gladiusParallel, ParallelForCoversTheRangeOnceInChunks) {
+  ThreadPool pool(/* num_threads = */ 4, /* pin_threads = */ true);
+  ASSERT_TRUE(pool.areThreadsPinned());
+  constexpr uint64_t BEGIN = 7;
+  constexpr uint64_t END = 100007;
+  std::vector<std::atomic<uint32_t>> visits(END);
+  std::atomic<uint32_t> chunks = 0;
+
+  parallelFor(
+      BEGIN, END,
+      [&](uint64_t begin, uint64_t end) {
+        // 4 chunks per thread since more chunks of 500 iterations fit
+        ASSERT_EQ(end - begin, 6250);
+        chunks++;
+        for (uint64_t index = begin; index < end; index++) {
+          visits[index]++;
+        }
+      },
+      /* grain_size = */ 500, pool);
+
+  ASSERT_EQ(chunks.load(), 16);
+  for (uint64_t index = 0; index < END; index++) {
+    ASSERT_EQ(visits[index].load(), index >= BEGIN ? 1 : 0) << index;
+  }
+}
+
+TEST(gladiusParallel, ParallelForRunsSmallAndNestedLoopsSerially) {
+  ThreadPool pool(/* num_threads = */ 4);
+  std::vector<std::pair<uint64_t, uint64_t>> calls;
+  parallelFor(
+      0, 64,
+      [&](uint64_t begin, uint64_t end) { calls.emplace_back(begin, end); },
+      /* grain_size = */ 64, pool);
+  ASSERT_EQ(calls, (std::vector<std::pair<uint64_t, uint64_t>>{{0, 64}}));
+
+  // A loop inside a chunk runs on the thread of the chunk
+  std::atomic<uint32_t> inner_calls = 0;
+  std::atomic<uint64_t> inner_iterations = 0;
+  parallelFor(
+      0, 8,
+      [&](uint64_t begin, uint64_t end) {
+        for (uint64_t outer = begin; outer < end; outer++) {
+          parallelFor(
+              0, 10000,
+              [&](uint64_t inner_begin, uint64_t inner_end) {
+                ASSERT_TRUE(ThreadPool::isInsideTask());
+                inner_calls++;
+                inner_iterations += inner_end - inner_begin;
+              },
+              /* grain_size = */ 1, pool);
+        }
+      },
+      /* grain_size = */ 1, pool);
+  ASSERT_EQ(inner_calls.load(), 8);
+  ASSERT_EQ(inner_iterations.load(), 80000);
+}
+
+}  // namespace gladius::tests
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include <src/comp_graph/vertices/fully_connected.hpp>
+#include <src/comp_graph/vertices/input_vertex.hpp>
+#include <src/comp_graph/vertices/param_vertex.hpp>
+#include <src/params/element_types.hpp>
+#include <src/params/parameters.hpp>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace gladius::tests {
+
+using gladius::comp_graph::FullyConnected;
+using gladius::comp_graph::ParameterVertex;
+using gladius::comp_graph::SequenceInputVertex;
+using gladius::parameters::bfloat16;
+using gladius::parameters::ElementType;
+using gladius::parameters::float16;
+using gladius::parameters::Parameter;
+
+TEST(gladiusPrecision, BFloat16RoundsToNearestEven) {
+  // 1 + 2^-8 is halfway between 1 and the next bf16 value 1 + 2^-7
+  ASSERT_EQ(bfloat16::fromFloat(1.F + 0x1p-8F).toFloat(), 1.F);
+  ASSERT_EQ(bfloat16::fromFloat(1.F + 0x1p-8F + 0x1p-12F).toFloat(),
+            1.F + 0x1p-7F);
+  ASSERT_EQ(bfloat16::fromFloat(1.F + 3 * 0x1p-8F).toFloat(), 1.F + 0x1p-6F);
+  ASSERT_TRUE(std::isnan(
+      bfloat16::fromFloat(std::numeric_limits<float>::quiet_NaN()).toFloat()));
+}
+
+TEST(gladiusPrecision, Float16RoundTripsEveryHalf) {
+  for (uint32_t bits = 0; bits < (1U << 16); bits++) {
+    float16 half{static_cast<uint16_t>(bits)};
+    float value = half.toFloat();
+    if (std::isnan(value)) {
+      continue;
+    }
+    ASSERT_EQ(float16::fromFloat(value).bits, bits);
+  }
+  ASSERT_EQ(float16::fromFloat(65519.F).toFloat(), 65504.F);
+  ASSERT_TRUE(std::isinf(float16::fromFloat(65520.F).toFloat()));
+  ASSERT_EQ(float16::fromFloat(0x1p-24F).bits, 1);
+  ASSERT_EQ(float16::fromFloat(0x1p-26F).bits, 0);
+}
+
+TEST(gladiusPrecision, CompactWeightsMatchFloatLayerAndFollowUpdates) {
+  constexpr uint32_t ROWS = 3, INPUT_DIMENSION = 37, OUTPUT_DIMENSION = 5;
+  std::mt19937 generator(23);
+  std::normal_distribution<float> distribution(0.F, 1.F);
+  std::vector<std::vector<float>> rows(OUTPUT_DIMENSION,
+                                       std::vector<float>(INPUT_DIMENSION));
+  for (auto& row : rows) {
+    std::generate(row.begin(), row.end(),
+                  [&] { return distribution(generator); });
+  }
+  std::vector<float> input(ROWS * INPUT_DIMENSION);
+  std::generate(input.begin(), input.end(),
+                [&] { return distribution(generator); });
+
+  auto run = [&](const std::shared_ptr<Parameter>& weights) {
+    auto input_copy = input;
+    auto layer = std::make_shared<FullyConnected>(
+        std::make_shared<SequenceInputVertex>(input_copy, ROWS),
+        std::make_shared<ParameterVertex>(weights));
+    layer->forward();
+    std::optional<std::vector<float>> upstream_grad =
+        std::vector<float>(ROWS * OUTPUT_DIMENSION, 1.F);
+    layer->backward(upstream_grad);
+    return std::make_pair(layer->getOutput(), layer->getGradient());
+  };
+
+  auto fp32_weights = std::make_shared<Parameter>(std::vector(rows));
+  auto [expected_output, expected_gradient] = run(fp32_weights);
+
+  for (auto storage_type : {ElementType::BFloat16, ElementType::Float16}) {
+    auto weights = std::make_shared<Parameter>(std::vector(rows));
+    weights->setStorageType(storage_type);
+    auto [output, gradient] = run(weights);
+    float tolerance = storage_type == ElementType::BFloat16 ? 0.1F : 0.01F;
+    for (uint32_t index = 0; index < output.size(); index++) {
+      ASSERT_NEAR(output[index], expected_output[index], tolerance);
+    }
+    for (uint32_t index = 0; index < gradient.size(); index++) {
+      ASSERT_NEAR(gradient[index], expected_gradient[index], tolerance);
+    }
+    // The weight gradient is computed against fp32 inputs only
+    ASSERT_EQ(weights->getGradient(), fp32_weights->getGradient());
+
+    // The optimizer updates the fp32 master weights and re-rounds them
+    weights->updateParameterValue(/* update_factor = */ -0.01F);
+    for (uint32_t row = 0; row < OUTPUT_DIMENSION; row++) {
+      for (uint32_t col = 0; col < INPUT_DIMENSION; col++) {
+        float master = weights->getValue()[row][col];
+        float compact =
+            storage_type == ElementType::BFloat16
+                ? weights->getCompactRow<bfloat16>(row)[col].toFloat()
+                : weights->getCompactRow<float16>(row)[col].toFloat();
+        float grad = weights->getGradient()[row * INPUT_DIMENSION + col];
+        ASSERT_EQ(master, rows[row][col] - 0.01F * grad);
+        ASSERT_NEAR(compact, master, tolerance);
+      }
+    }
+  }
+}
+
+}  // namespace gladius::tests
@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+#include <src/profiling/profiler.hpp>
+#include <tests/test_utils.hpp>
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace gladius::tests {
+
+using gladius::profiling::HardwareEvent;
+using gladius::profiling::Pass;
+using gladius::profiling::ProfileEvent;
+using gladius::profiling::Profiler;
+using gladius::profiling::RooflineLimits;
+
+static inline constexpr uint32_t ROWS = 1;
+
+/**
+ * Runs the forward and backward passes of the MLP of buildMLP()
+ */
+static void runTrainingStep() {
+  auto mlp = buildMLP();
+  runForwardAndBackward(mlp);
+}
+
+TEST(gladiusProfiler, RecordsNestedForwardAndBackwardEvents) {
+  Profiler::clear();
+  Profiler::enable();
+  runTrainingStep();
+  Profiler::disable();
+
+  auto events = Profiler::collect();
+  auto count = [&](const std::string& op, Pass pass) {
+    return std::count_if(events.begin(), events.end(), [&](const auto& e) {
+      return e.op == op && e.pass == pass;
+    });
+  };
+  ASSERT_EQ(count("FullyConnected", Pass::Forward), 2);
+  ASSERT_EQ(count("BiasGELU", Pass::Forward), 1);
+  ASSERT_EQ(count("CrossEntropyLoss", Pass::Forward), 1);
+  ASSERT_EQ(count("FullyConnected", Pass::Backward), 2);
+  ASSERT_EQ(count("Parameter", Pass::Backward), 4);
+
+  for (const ProfileEvent& event : events) {
+    ASSERT_LE(event.start_ticks, event.end_ticks);
+    ASSERT_LE(event.child_ticks, event.end_ticks - event.start_ticks);
+    if (event.pass == Pass::Forward) {
+      ASSERT_EQ(event.depth, 0);
+    }
+    if (event.pass == Pass::Backward &&
+        std::string(event.op) == "CrossEntropyLoss") {
+      // The backward pass of every other vertex runs inside this one
+      ASSERT_EQ(event.depth, 0);
+      ASSERT_GT(event.child_ticks, 0);
+    }
+    if (event.pass == Pass::Forward &&
+        std::string(event.op) == "FullyConnected" &&
+        event.columns == MLP_HIDDEN_DIMENSION) {
+      ASSERT_EQ(event.rows, ROWS);
+      ASSERT_EQ(event.flops,
+                2 * ROWS * MLP_INPUT_DIMENSION * MLP_HIDDEN_DIMENSION);
+    }
+  }
+
+  std::ostringstream trace;
+  Profiler::writeChromeTrace(trace);
+  std::string json = trace.str();
+  ASSERT_NE(json.find("\"traceEvents\""), std::string::npos);
+  const std::string complete_event = "\"ph\": \"X\"";
+  uint64_t complete_events = 0;
+  for (auto position = json.find(complete_event);
+       position != std::string::npos;
+       position = json.find(complete_event, position + 1)) {
+    complete_events++;
+  }
+  ASSERT_EQ(complete_events, events.size());
+
+  std::ostringstream summary;
+  Profiler::printSummary(summary, /* top = */ 3);
+  // A header and three operations
+  std::string table = summary.str();
+  ASSERT_EQ(std::count(table.begin(), table.end(), '\n'), 4);
+}
+
+TEST(gladiusProfiler, CountsHardwareEventsAroundVerticesAndKernels) {
+  Profiler::clear();
+  Profiler::enable(/* hardware_counters = */ true);
+  runTrainingStep();
+  Profiler::disable();
+  uint8_t available = Profiler::getAvailableHardwareEvents();
+
+  auto events = Profiler::collect();
+  uint32_t kernel_events = 0;
+  for (const ProfileEvent& event : events) {
+    // Counters that could not be opened, e.g., without a PMU, read as zero
+    ASSERT_EQ(event.counter_mask, available);
+    for (uint32_t counter = 0; counter < event.counters.values.size();
+         counter++) {
+      if (!(available & (1U << counter))) {
+        ASSERT_EQ(event.counters.values[counter], 0);
+      }
+    }
+    if (event.pass == Pass::Kernel) {
+      // Nested in the forward pass of the FullyConnected vertices
+      ASSERT_EQ(std::string(event.op), "FullyConnected::gemm");
+      ASSERT_EQ(event.depth, 1);
+      kernel_events++;
+    }
+    if (std::string(event.op) == "FullyConnected" &&
+        event.pass == Pass::Forward) {
+      ASSERT_GT(event.child_ticks, 0);
+    }
+  }
+  ASSERT_EQ(kernel_events, 2);
+
+  std::ostringstream roofline;
+  Profiler::printRoofline(roofline, RooflineLimits{100., 10.},
+                          /* top = */ 3);
+  // The limits, a header and three operations
+  std::string table = roofline.str();
+  ASSERT_EQ(std::count(table.begin(), table.end(), '\n'), 5);
+  ASSERT_NE(table.find("ridge point 10.00"), std::string::npos);
+  if (!(available & (1U << static_cast<uint32_t>(HardwareEvent::Cycles)))) {
+    ASSERT_NE(table.find("n/a"), std::string::npos);
+  }
+}
+
+TEST(gladiusProfiler, MeasuresRooflineLimits) {
+  auto limits = RooflineLimits::measure();
+  ASSERT_GT(limits.peak_gflops, 0.);
+  ASSERT_GT(limits.peak_bandwidth_gbs, 0.);
+  ASSERT_GT(limits.ridgePoint(), 0.);
+}
+
+TEST(gladiusProfiler, RecordsNothingWhileDisabled) {
+  Profiler::clear();
+  runTrainingStep();
+  ASSERT_TRUE(Profiler::collect().empty());
+}
+
+}  // namespace gladius::tests
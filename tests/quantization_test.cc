@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include <src/comp_graph/graph.hpp>
+#include <src/comp_graph/vertices/fully_connected.hpp>
+#include <src/comp_graph/vertices/input_vertex.hpp>
+#include <src/comp_graph/vertices/param_vertex.hpp>
+#include <src/comp_graph/vertices/quantized_fully_connected.hpp>
+#include <src/model.hpp>
+#include <src/quantization/int8_kernels.hpp>
+#include <src/quantization/quantizer.hpp>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace gladius::tests {
+
+using gladius::comp_graph::FullyConnected;
+using gladius::comp_graph::Graph;
+using gladius::comp_graph::ParameterVertex;
+using gladius::comp_graph::QuantizedFullyConnected;
+using gladius::comp_graph::SequenceInputVertex;
+using gladius::quantization::PostTrainingQuantizer;
+
+static inline constexpr uint32_t INPUT_DIMENSION = 100;
+static inline constexpr uint32_t OUTPUT_DIMENSION = 10;
+static inline constexpr uint32_t BATCH_SIZE = 4;
+
+TEST(gladiusQuantization, DotProductMatchesScalarAtExtremeValues) {
+  std::vector<uint8_t> activations(INPUT_DIMENSION);
+  std::vector<int8_t> weights(INPUT_DIMENSION);
+  int32_t expected = 0;
+  for (uint32_t index = 0; index < INPUT_DIMENSION; index++) {
+    activations[index] = index % 3 ? 127 : index;
+    weights[index] = index % 2 ? -127 : 127;
+    expected += activations[index] * weights[index];
+  }
+  ASSERT_EQ(quantization::dotProductU8S8(activations.data(), weights.data(),
+                                         INPUT_DIMENSION),
+            expected);
+}
+
+TEST(gladiusQuantization, Int8LayerMatchesFloatLayer) {
+  auto model = std::make_shared<Model>();
+  model->addParameter({OUTPUT_DIMENSION, INPUT_DIMENSION});
+  model->addParameter({OUTPUT_DIMENSION});
+  auto weights = model->getParameterByID(0);
+  auto bias = model->getParameterByID(1);
+  std::fill(bias->getValue()[0].begin(), bias->getValue()[0].end(), 0.25F);
+
+  std::mt19937 generator(17);
+  std::uniform_real_distribution<float> distribution(-1.F, 3.F);
+  auto randomBatch = [&] {
+    std::vector<float> batch(BATCH_SIZE * INPUT_DIMENSION);
+    std::generate(batch.begin(), batch.end(),
+                  [&] { return distribution(generator); });
+    return batch;
+  };
+
+  PostTrainingQuantizer quantizer(model);
+  std::vector<uint32_t> labels, fp32_predictions, int8_predictions;
+  for (uint32_t sample = 0; sample < 20; sample++) {
+    auto batch = randomBatch();
+    auto quantized_batch = batch;
+    Graph graph;
+    auto input = std::make_shared<SequenceInputVertex>(batch, BATCH_SIZE);
+    auto layer = std::make_shared<FullyConnected>(
+        input, std::make_shared<ParameterVertex>(weights),
+        std::make_shared<ParameterVertex>(bias));
+    graph.addVertex(input);
+    graph.addVertex(layer);
+    input->forward();
+    layer->forward();
+
+    // The first half of the samples calibrates, the second half evaluates
+    if (sample < 10) {
+      quantizer.observe(graph);
+      if (sample == 9) {
+        quantizer.finalize();
+      }
+      continue;
+    }
+    auto quantized_layer = std::make_shared<QuantizedFullyConnected>(
+        std::make_shared<SequenceInputVertex>(quantized_batch, BATCH_SIZE),
+        quantizer.getQuantizedLinear(weights),
+        std::make_shared<ParameterVertex>(bias));
+    quantized_layer->forward();
+
+    auto& expected = layer->getOutput();
+    auto& actual = quantized_layer->getOutput();
+    for (uint32_t index = 0; index < expected.size(); index++) {
+      ASSERT_NEAR(actual[index], expected[index], 0.1F);
+    }
+    for (uint32_t row = 0; row < BATCH_SIZE; row++) {
+      auto argmax = [&](const std::vector<float>& output) {
+        auto begin = output.begin() + row * OUTPUT_DIMENSION;
+        return std::max_element(begin, begin + OUTPUT_DIMENSION) - begin;
+      };
+      labels.push_back(argmax(expected));
+      fp32_predictions.push_back(argmax(expected));
+      int8_predictions.push_back(argmax(actual));
+    }
+  }
+
+  auto report = quantizer.report(labels, fp32_predictions, int8_predictions);
+  ASSERT_EQ(report.fp32_accuracy, 1.F);
+  ASSERT_GE(report.accuracy_delta, -0.1F);
+  ASSERT_GT(static_cast<float>(report.fp32_weight_bytes) /
+                report.int8_weight_bytes,
+            3.F);
+}
+
+}  // namespace gladius::tests
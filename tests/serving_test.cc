@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include <src/comp_graph/graph.hpp>
+#include <src/comp_graph/vertices/activ_functions.hpp>
+#include <src/comp_graph/vertices/fully_connected.hpp>
+#include <src/comp_graph/vertices/input_vertex.hpp>
+#include <src/comp_graph/vertices/param_vertex.hpp>
+#include <src/params/parameters.hpp>
+#include <src/serving/inference_engine.hpp>
+#include <tests/test_utils.hpp>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace gladius::tests {
+
+using gladius::comp_graph::BiasGELUActivation;
+using gladius::comp_graph::FullyConnected;
+using gladius::comp_graph::Graph;
+using gladius::comp_graph::NoGradGuard;
+using gladius::comp_graph::ParameterVertex;
+using gladius::comp_graph::SequenceInputVertex;
+using gladius::comp_graph::VertexPointer;
+using gladius::parameters::Parameter;
+using gladius::serving::BatchGraphBuilder;
+using gladius::serving::InferenceEngine;
+
+static inline constexpr uint32_t INPUT_DIMENSION = 128;
+static inline constexpr uint32_t HIDDEN_DIMENSION = 512;
+static inline constexpr uint32_t CLASSES = 10;
+
+/**
+ * Returns a builder for the MLP  W_2 GELU(W_1 x + b_1) + b_2  applied to
+ * every row of a batch
+ */
+static BatchGraphBuilder mlpBuilder() {
+  std::mt19937 generator(5);
+  std::vector<std::shared_ptr<Parameter>> parameters = {
+      randomParameter(HIDDEN_DIMENSION, INPUT_DIMENSION, generator),
+      randomParameter(1, HIDDEN_DIMENSION, generator),
+      randomParameter(CLASSES, HIDDEN_DIMENSION, generator),
+      randomParameter(1, CLASSES, generator)};
+
+  return [parameters](std::vector<float>& inputs, uint32_t batch_size) {
+    auto input = std::make_shared<SequenceInputVertex>(
+        inputs, /* sequence_length = */ batch_size);
+    auto hidden = std::make_shared<FullyConnected>(
+        input, std::make_shared<ParameterVertex>(parameters[0]));
+    auto activation = std::make_shared<BiasGELUActivation>(
+        hidden, std::make_shared<ParameterVertex>(parameters[1]));
+    auto logits = std::make_shared<FullyConnected>(
+        activation, std::make_shared<ParameterVertex>(parameters[2]),
+        std::make_shared<ParameterVertex>(parameters[3]));
+
+    auto graph = std::make_shared<Graph>();
+    for (const VertexPointer& vertex :
+         std::vector<VertexPointer>{input, hidden, activation, logits}) {
+      graph->addVertex(vertex);
+    }
+    return graph;
+  };
+}
+
+TEST(gladiusServing, BatchedResponsesMatchPerRequestInference) {
+  constexpr uint32_t CLIENTS = 4;
+  constexpr uint32_t REQUESTS_PER_CLIENT = 64;
+  auto builder = mlpBuilder();
+
+  std::mt19937 generator(11);
+  std::vector<std::vector<float>> inputs;
+  for (uint32_t index = 0; index < CLIENTS * REQUESTS_PER_CLIENT; index++) {
+    inputs.push_back(randomVector(INPUT_DIMENSION, generator));
+  }
+
+  std::vector<std::future<std::vector<float>>> responses(inputs.size());
+  {
+    InferenceEngine engine(builder, INPUT_DIMENSION,
+                           {/* max_batch_size = */ 16,
+                            /* max_wait = */ std::chrono::microseconds(200)});
+    std::vector<std::thread> clients;
+    for (uint32_t client = 0; client < CLIENTS; client++) {
+      clients.emplace_back([&, client] {
+        for (uint32_t index = client; index < inputs.size();
+             index += CLIENTS) {
+          responses[index] = engine.submit(inputs[index]);
+        }
+      });
+    }
+    for (auto& client : clients) {
+      client.join();
+    }
+    ASSERT_THROW(engine.submit(std::vector<float>(INPUT_DIMENSION + 1)),
+                 std::invalid_argument);
+  }
+
+  for (uint32_t index = 0; index < inputs.size(); index++) {
+    auto response = responses[index].get();
+
+    NoGradGuard no_grad;
+    auto input = inputs[index];
+    auto graph = builder(input, /* batch_size = */ 1);
+    auto& expected = graph->launchInferencePass()->getOutput();
+    ASSERT_EQ(response.size(), CLASSES);
+    for (uint32_t label = 0; label < CLASSES; label++) {
+      ASSERT_NEAR(response[label], expected[label], 1e-3);
+    }
+  }
+}
+
+}  // namespace gladius::tests
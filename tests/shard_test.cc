@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include <src/data/batch_view.hpp>
+#include <src/data/shard_writer.hpp>
+#include <src/data/sharded_loader.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace gladius::tests {
+
+using gladius::data::BatchView;
+using gladius::data::Compression;
+using gladius::data::LoaderOptions;
+using gladius::data::ShardedLoader;
+
+static inline constexpr uint32_t RECORDS = 1000;
+static inline constexpr uint32_t INPUT_DIMENSION = 10;
+static inline constexpr uint32_t CLASSES = 7;
+static inline constexpr uint32_t BATCH_SIZE = 48;
+
+/**
+ * Record i has input (i, i + 1, ..., i + d - 1) and label i mod CLASSES
+ */
+static std::vector<std::pair<std::vector<float>, std::vector<uint32_t>>>
+makeDataset() {
+  std::vector<std::pair<std::vector<float>, std::vector<uint32_t>>> dataset;
+  for (uint32_t record = 0; record < RECORDS; record++) {
+    std::vector<float> input(INPUT_DIMENSION);
+    for (uint32_t index = 0; index < INPUT_DIMENSION; index++) {
+      input[index] = static_cast<float>(record + index);
+    }
+    std::vector<uint32_t> label(CLASSES, 0);
+    label[record % CLASSES] = 1;
+    dataset.emplace_back(std::move(input), std::move(label));
+  }
+  return dataset;
+}
+
+/**
+ * Reads an epoch, checks every record against makeDataset() and returns
+ * the record indices in the order they were read
+ */
+static std::vector<uint32_t> readEpoch(ShardedLoader& loader) {
+  std::vector<uint32_t> order;
+  BatchView batch;
+  while (loader.next(batch)) {
+    EXPECT_EQ(batch.input_dimension, INPUT_DIMENSION);
+    EXPECT_LE(batch.size, BATCH_SIZE);
+    for (uint32_t index = 0; index < batch.size; index++) {
+      const float* input = batch.inputs + index * INPUT_DIMENSION;
+      auto record = static_cast<uint32_t>(input[0]);
+      for (uint32_t column = 0; column < INPUT_DIMENSION; column++) {
+        EXPECT_EQ(input[column], static_cast<float>(record + column));
+      }
+      EXPECT_EQ(batch.labels[index], record % CLASSES);
+      order.push_back(record);
+    }
+  }
+  return order;
+}
+
+class ShardedLoaderTest : public ::testing::TestWithParam<Compression> {
+ protected:
+  void SetUp() override {
+    if (!gladius::data::isCompressionSupported(GetParam())) {
+      GTEST_SKIP() << "Compression not supported by this build.";
+    }
+    _prefix = (std::filesystem::temp_directory_path() / "gladius_test_shard")
+                  .string();
+    _filenames = gladius::data::writeShardedDataset(
+        makeDataset(), _prefix, /* records_per_shard = */ 300, GetParam(),
+        /* records_per_block = */ 64);
+  }
+
+  void TearDown() override {
+    for (const auto& filename : _filenames) {
+      std::filesystem::remove(filename);
+    }
+  }
+
+  std::string _prefix;
+  std::vector<std::string> _filenames;
+};
+
+TEST_P(ShardedLoaderTest, UnshuffledEpochsReadRecordsInFileOrder) {
+  ASSERT_EQ(_filenames.size(), 4);
+  ShardedLoader loader(_filenames, BATCH_SIZE, {/* num_readers = */ 3});
+  ASSERT_EQ(loader.getRecordCount(), RECORDS);
+
+  std::vector<uint32_t> expected(RECORDS);
+  for (uint32_t record = 0; record < RECORDS; record++) {
+    expected[record] = record;
+  }
+  for (uint64_t epoch = 0; epoch < 2; epoch++) {
+    loader.startEpoch(epoch);
+    ASSERT_EQ(readEpoch(loader), expected);
+  }
+}
+
+TEST_P(ShardedLoaderTest, ShuffledEpochsAreDeterministicPermutations) {
+  LoaderOptions options;
+  options.shuffle_buffer_size = 200;
+  options.seed = 42;
+
+  options.num_readers = 1;
+  ShardedLoader single_reader(_filenames, BATCH_SIZE, options);
+  options.num_readers = 4;
+  ShardedLoader four_readers(_filenames, BATCH_SIZE, options);
+
+  auto first_epoch = readEpoch(single_reader);
+  ASSERT_EQ(readEpoch(four_readers), first_epoch);
+
+  auto sorted = first_epoch;
+  std::sort(sorted.begin(), sorted.end());
+  for (uint32_t record = 0; record < RECORDS; record++) {
+    ASSERT_EQ(sorted[record], record);
+  }
+  ASSERT_FALSE(std::is_sorted(first_epoch.begin(), first_epoch.end()));
+
+  four_readers.startEpoch(1);
+  auto second_epoch = readEpoch(four_readers);
+  ASSERT_NE(second_epoch, first_epoch);
+  four_readers.startEpoch(0);
+  ASSERT_EQ(readEpoch(four_readers), first_epoch);
+}
+
+INSTANTIATE_TEST_SUITE_P(Compressions, ShardedLoaderTest,
+                         ::testing::Values(Compression::None,
+                                           Compression::Zlib));
+
+TEST(gladiusShards, RejectsFilesWithoutShardFooter) {
+  auto filename =
+      (std::filesystem::temp_directory_path() / "gladius_not_a_shard")
+          .string();
+  {
+    std::ofstream file(filename, std::ios::binary);
+    file << "definitely not a shard";
+  }
+  ASSERT_THROW(ShardedLoader({filename}, BATCH_SIZE), std::invalid_argument);
+  std::filesystem::remove(filename);
+}
+
+}  // namespace gladius::tests
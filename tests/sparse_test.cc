@@ -0,0 +1,223 @@
+#include <gtest/gtest.h>
+#include <src/comp_graph/vertices/inner_product.hpp>
+#include <src/comp_graph/vertices/input_vertex.hpp>
+#include <src/comp_graph/vertices/lsh_sparse_dense.hpp>
+#include <src/comp_graph/vertices/param_vertex.hpp>
+#include <src/params/element_types.hpp>
+#include <src/params/parameters.hpp>
+#include <src/sampling/lsh_tables.hpp>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace gladius::tests {
+
+using gladius::comp_graph::InnerProduct;
+using gladius::comp_graph::LSHSparseDense;
+using gladius::comp_graph::ParameterVertex;
+using gladius::comp_graph::SequenceInputVertex;
+using gladius::comp_graph::SparseInputVertex;
+using gladius::parameters::bfloat16;
+using gladius::parameters::ElementType;
+using gladius::parameters::Parameter;
+using gladius::sampling::HashFunction;
+using gladius::sampling::LSHTables;
+using gladius::sampling::RebuildSchedule;
+
+static inline constexpr uint32_t NUM_NEURONS = 2000;
+static inline constexpr uint32_t DIMENSION = 32;
+
+static std::vector<std::vector<float>> randomRows(uint32_t num_rows,
+                                                  uint32_t seed) {
+  std::mt19937 generator(seed);
+  std::normal_distribution<float> distribution(0.F, 1.F);
+  std::vector<std::vector<float>> rows(num_rows,
+                                       std::vector<float>(DIMENSION));
+  for (auto& row : rows) {
+    std::generate(row.begin(), row.end(),
+                  [&] { return distribution(generator); });
+  }
+  return rows;
+}
+
+static bool contains(const std::vector<uint32_t>& neurons, uint32_t neuron) {
+  return std::find(neurons.begin(), neurons.end(), neuron) != neurons.end();
+}
+
+class LSHSparseDenseTest : public ::testing::TestWithParam<HashFunction> {};
+
+TEST_P(LSHSparseDenseTest, ComputesAndUpdatesOnlyRetrievedNeurons) {
+  auto weights = std::make_shared<Parameter>(randomRows(NUM_NEURONS, 1));
+  auto hash_tables = std::make_shared<LSHTables>(
+      GetParam(), DIMENSION, /* num_tables = */ 8,
+      /* hashes_per_table = */ GetParam() == HashFunction::SimHash ? 10 : 4,
+      RebuildSchedule{/* initial_interval = */ 2, /* growth = */ 1.F});
+  hash_tables->build(weights->getValue());
+
+  // A row always collides with itself, so querying with a copy of it must
+  // retrieve it
+  std::vector<float> input = weights->getValue()[77];
+  auto layer = std::make_shared<LSHSparseDense>(
+      std::make_shared<SequenceInputVertex>(input, 1),
+      std::make_shared<ParameterVertex>(weights), /* bias = */ nullptr,
+      hash_tables, /* always_active = */ std::vector<uint32_t>{5});
+  layer->forward();
+
+  auto active = layer->getActiveNeurons();
+  ASSERT_TRUE(contains(active, 77));
+  ASSERT_TRUE(contains(active, 5));
+  ASSERT_LT(active.size(), NUM_NEURONS / 2);
+
+  const auto& query = weights->getValue()[77];
+  for (uint32_t neuron = 0; neuron < NUM_NEURONS; neuron++) {
+    float expected = 0.F;
+    if (contains(active, neuron)) {
+      for (uint32_t col = 0; col < DIMENSION; col++) {
+        expected += weights->getValue()[neuron][col] * query[col];
+      }
+    }
+    ASSERT_NEAR(layer->getOutput()[neuron], expected, 1e-4);
+  }
+
+  std::optional<std::vector<float>> upstream_grad =
+      std::vector<float>(NUM_NEURONS, 1.F);
+  layer->backward(upstream_grad);
+  auto& gradient = weights->getGradient();
+  for (uint32_t neuron = 0; neuron < NUM_NEURONS; neuron++) {
+    float expected = contains(active, neuron) ? query[0] : 0.F;
+    ASSERT_EQ(gradient[neuron * DIMENSION], expected);
+  }
+
+  // Moving a retrieved neuron onto another row makes it collide with that
+  // row once the tables are rebuilt on the second step of the schedule
+  uint32_t moved_neuron = active.back() == 77 ? active.front() : active.back();
+  weights->getValue()[moved_neuron] = weights->getValue()[1234];
+  std::vector<float> other_input = weights->getValue()[1234];
+  auto other_layer = std::make_shared<LSHSparseDense>(
+      std::make_shared<SequenceInputVertex>(other_input, 1),
+      std::make_shared<ParameterVertex>(weights), /* bias = */ nullptr,
+      hash_tables);
+  other_layer->forward();
+  ASSERT_TRUE(contains(other_layer->getActiveNeurons(), 1234));
+  ASSERT_TRUE(contains(other_layer->getActiveNeurons(), moved_neuron));
+}
+
+TEST_P(LSHSparseDenseTest, ResetsStaleOutputsAndOnlyUpdatesActiveBiases) {
+  auto weights = std::make_shared<Parameter>(randomRows(NUM_NEURONS, 3));
+  auto bias = std::make_shared<Parameter>(std::vector<std::vector<float>>{
+      std::vector<float>(NUM_NEURONS, 0.5F)});
+  auto hash_tables = std::make_shared<LSHTables>(
+      GetParam(), DIMENSION, /* num_tables = */ 8,
+      /* hashes_per_table = */ GetParam() == HashFunction::SimHash ? 10 : 4);
+  hash_tables->build(weights->getValue());
+
+  std::vector<float> features = weights->getValue()[10];
+  auto input = std::make_shared<SequenceInputVertex>(features, 1);
+  auto layer = std::make_shared<LSHSparseDense>(
+      input, std::make_shared<ParameterVertex>(weights),
+      std::make_shared<ParameterVertex>(bias), hash_tables);
+  layer->forward();
+  auto first_active = layer->getActiveNeurons();
+
+  std::optional<std::vector<float>> upstream_grad =
+      std::vector<float>(NUM_NEURONS, 1.F);
+  layer->backward(upstream_grad);
+  for (uint32_t neuron = 0; neuron < NUM_NEURONS; neuron++) {
+    ASSERT_EQ(bias->getGradient()[neuron],
+              contains(first_active, neuron) ? 1.F : 0.F);
+  }
+
+  // The second pass retrieves other neurons, whose outputs must not mix
+  // with the ones of the first pass
+  input->restoreOutput(std::vector<float>(weights->getValue()[1500]));
+  layer->forward();
+  const auto& query = weights->getValue()[1500];
+  for (uint32_t neuron = 0; neuron < NUM_NEURONS; neuron++) {
+    float expected = 0.F;
+    if (contains(layer->getActiveNeurons(), neuron)) {
+      expected = 0.5F;
+      for (uint32_t col = 0; col < DIMENSION; col++) {
+        expected += weights->getValue()[neuron][col] * query[col];
+      }
+    }
+    ASSERT_NEAR(layer->getOutput()[neuron], expected, 1e-4);
+  }
+  ASSERT_TRUE(contains(layer->getActiveNeurons(), 1500));
+  ASSERT_FALSE(layer->getActiveNeurons() == first_active);
+}
+
+INSTANTIATE_TEST_SUITE_P(gladiusSparse, LSHSparseDenseTest,
+                         ::testing::Values(HashFunction::SimHash,
+                                           HashFunction::DWTA));
+
+TEST(gladiusSparse, SparseInnerProductOnlyTouchesNonZeroColumns) {
+  constexpr uint32_t NUM_ROWS = 7;
+  auto weights = std::make_shared<Parameter>(randomRows(NUM_ROWS, 2));
+  // The product reads the fp32 weights, but the update must keep the compact
+  // copy in sync
+  weights->setStorageType(ElementType::BFloat16);
+
+  // Three sparse rows. Column 3 appears twice and the last row is empty.
+  std::vector<uint32_t> row_offsets = {0, 2, 5, 5};
+  std::vector<uint32_t> indices = {3, 10, 0, 3, 31};
+  std::vector<float> values = {1.5F, -2.F, 0.5F, 4.F, -1.F};
+  auto expected_input = SparseInputVertex(row_offsets, indices, values,
+                                          DIMENSION).getOutput();
+  row_offsets = {0, 2, 5, 5};
+  indices = {3, 10, 0, 3, 31};
+  values = {1.5F, -2.F, 0.5F, 4.F, -1.F};
+
+  auto product = std::make_shared<InnerProduct>(
+      std::make_shared<ParameterVertex>(weights),
+      std::make_shared<SparseInputVertex>(row_offsets, indices, values,
+                                          DIMENSION));
+  ASSERT_EQ(product->getOutputShape(), std::make_pair(3U, NUM_ROWS));
+  product->forward();
+
+  std::vector<float> upstream(3 * NUM_ROWS);
+  for (uint32_t index = 0; index < upstream.size(); index++) {
+    upstream[index] = 0.1F * (index + 1);
+  }
+  for (uint32_t row = 0; row < 3; row++) {
+    for (uint32_t neuron = 0; neuron < NUM_ROWS; neuron++) {
+      float expected = 0.F;
+      for (uint32_t col = 0; col < DIMENSION; col++) {
+        expected += weights->getValue()[neuron][col] *
+                    expected_input[row * DIMENSION + col];
+      }
+      ASSERT_NEAR(product->getOutput()[row * NUM_ROWS + neuron], expected,
+                  1e-4);
+    }
+  }
+
+  std::optional<std::vector<float>> upstream_grad = upstream;
+  product->backward(upstream_grad);
+  auto& gradient = weights->getGradient();
+  for (uint32_t neuron = 0; neuron < NUM_ROWS; neuron++) {
+    for (uint32_t col = 0; col < DIMENSION; col++) {
+      float expected = 0.F;
+      for (uint32_t row = 0; row < 3; row++) {
+        expected += upstream[row * NUM_ROWS + neuron] *
+                    expected_input[row * DIMENSION + col];
+      }
+      ASSERT_NEAR(gradient[neuron * DIMENSION + col], expected, 1e-4);
+    }
+  }
+
+  auto original = weights->getValue();
+  weights->updateParameterValue(/* update_factor = */ -1.F);
+  weights->zeroOutGradient();
+  for (uint32_t neuron = 0; neuron < NUM_ROWS; neuron++) {
+    for (uint32_t col = 0; col < DIMENSION; col++) {
+      bool touched = col == 0 || col == 3 || col == 10 || col == 31;
+      ASSERT_EQ(weights->getValue()[neuron][col] != original[neuron][col],
+                touched);
+      ASSERT_EQ(gradient[neuron * DIMENSION + col], 0.F);
+      ASSERT_EQ(weights->getCompactRow<bfloat16>(neuron)[col].bits,
+                bfloat16::fromFloat(weights->getValue()[neuron][col]).bits);
+    }
+  }
+}
+
+}  // namespace gladius::tests
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <src/comp_graph/graph.hpp>
+#include <src/comp_graph/vertices/activ_functions.hpp>
+#include <src/comp_graph/vertices/fully_connected.hpp>
+#include <src/comp_graph/vertices/input_vertex.hpp>
+#include <src/comp_graph/vertices/loss.hpp>
+#include <src/comp_graph/vertices/param_vertex.hpp>
+#include <src/comp_graph/vertices/summation.hpp>
+#include <src/params/parameters.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <random>
+#include <vector>
+
+namespace gladius::tests {
+
+using gladius::comp_graph::BiasGELUActivation;
+using gladius::comp_graph::CrossEntropyLoss;
+using gladius::comp_graph::FullyConnected;
+using gladius::comp_graph::Graph;
+using gladius::comp_graph::ParameterVertex;
+using gladius::comp_graph::ResidualAddition;
+using gladius::comp_graph::SequenceInputVertex;
+using gladius::comp_graph::VertexPointer;
+using gladius::parameters::Parameter;
+
+/**
+ * Returns `size` values drawn from N(0, stddev^2)
+ */
+inline std::vector<float> randomVector(uint64_t size, std::mt19937& generator,
+                                       float stddev = 1.F) {
+  std::normal_distribution<float> distribution(0.F, stddev);
+  std::vector<float> values(size);
+  std::generate(values.begin(), values.end(),
+                [&] { return distribution(generator); });
+  return values;
+}
+
+/**
+ * Returns a (rows, columns) parameter with entries drawn from
+ * N(0, stddev^2)
+ */
+inline std::shared_ptr<Parameter> randomParameter(uint32_t rows,
+                                                  uint32_t columns,
+                                                  std::mt19937& generator,
+                                                  float stddev = 1.F) {
+  std::vector<std::vector<float>> matrix(rows);
+  for (auto& row : matrix) {
+    row = randomVector(columns, generator, stddev);
+  }
+  return std::make_shared<Parameter>(std::move(matrix));
+}
+
+/**
+ * A graph that ends with a cross-entropy loss, with the parameters of the
+ * model it was built from
+ */
+struct TrainingGraph {
+  std::unique_ptr<Graph> graph;
+  std::shared_ptr<CrossEntropyLoss> loss;
+  std::vector<std::shared_ptr<Parameter>> parameters;
+};
+
+static inline constexpr uint32_t MLP_INPUT_DIMENSION = 12;
+static inline constexpr uint32_t MLP_HIDDEN_DIMENSION = 16;
+static inline constexpr uint32_t MLP_CLASSES = 5;
+
+/**
+ * Builds
+ *        CE(W_2 GELU(W_1 x + b_1) + b_2, label)
+ * for a single sample. The parameters, in the order W_1, b_1, W_2, b_2,
+ * only depend on the seed.
+ */
+inline TrainingGraph buildMLP() {
+  std::mt19937 generator(3);
+  TrainingGraph mlp;
+  auto parameter = [&](uint32_t rows, uint32_t columns) {
+    mlp.parameters.push_back(randomParameter(rows, columns, generator));
+    return std::make_shared<ParameterVertex>(mlp.parameters.back());
+  };
+
+  std::vector<float> features(MLP_INPUT_DIMENSION, 0.5F);
+  auto input = std::make_shared<SequenceInputVertex>(features,
+                                                     /* sequence_length = */ 1);
+  auto hidden = std::make_shared<FullyConnected>(
+      input, parameter(MLP_HIDDEN_DIMENSION, MLP_INPUT_DIMENSION));
+  auto activation = std::make_shared<BiasGELUActivation>(
+      hidden, parameter(1, MLP_HIDDEN_DIMENSION));
+  auto logits = std::make_shared<FullyConnected>(
+      activation, parameter(MLP_CLASSES, MLP_HIDDEN_DIMENSION),
+      parameter(1, MLP_CLASSES));
+  mlp.loss = std::make_shared<CrossEntropyLoss>(logits, /* label = */ 2);
+
+  mlp.graph = std::make_unique<Graph>();
+  for (const VertexPointer& vertex : std::vector<VertexPointer>{
+           input, hidden, activation, logits, mlp.loss}) {
+    mlp.graph->addVertex(vertex);
+  }
+  return mlp;
+}
+
+static inline constexpr uint32_t DEEP_NETWORK_DIMENSION = 64;
+static inline constexpr uint32_t DEEP_NETWORK_CLASSES = 5;
+
+/**
+ * Builds CE(W_o h_depth, label) with h_0 = x and, for every block,
+ *        h_{i + 1} = GELU(W_i h_i + b_i)            without residuals
+ *        h_{i + 1} = h_i + GELU(W_i h_i + b_i)      with residuals
+ * where every h_i has DEEP_NETWORK_DIMENSION entries. The sample and the
+ * parameters only depend on the seed.
+ */
+inline TrainingGraph buildDeepNetwork(uint32_t depth, bool residual = false) {
+  std::mt19937 generator(5);
+  TrainingGraph network;
+  auto parameter = [&](uint32_t rows, uint32_t columns) {
+    network.parameters.push_back(
+        randomParameter(rows, columns, generator, /* stddev = */ 0.2F));
+    return std::make_shared<ParameterVertex>(network.parameters.back());
+  };
+
+  auto features =
+      randomVector(DEEP_NETWORK_DIMENSION, generator, /* stddev = */ 0.2F);
+  network.graph = std::make_unique<Graph>();
+  VertexPointer hidden = std::make_shared<SequenceInputVertex>(
+      features, /* sequence_length = */ 1);
+  network.graph->addVertex(hidden);
+  for (uint32_t block = 0; block < depth; block++) {
+    auto projection = std::make_shared<FullyConnected>(
+        hidden, parameter(DEEP_NETWORK_DIMENSION, DEEP_NETWORK_DIMENSION));
+    VertexPointer activation = std::make_shared<BiasGELUActivation>(
+        projection, parameter(1, DEEP_NETWORK_DIMENSION));
+    network.graph->addVertex(projection);
+    network.graph->addVertex(activation);
+    if (residual) {
+      activation = std::make_shared<ResidualAddition>(hidden, activation);
+      network.graph->addVertex(activation);
+    }
+    hidden = activation;
+  }
+  auto logits = std::make_shared<FullyConnected>(
+      hidden, parameter(DEEP_NETWORK_CLASSES, DEEP_NETWORK_DIMENSION));
+  network.loss = std::make_shared<CrossEntropyLoss>(logits, /* label = */ 3);
+  network.graph->addVertex(logits);
+  network.graph->addVertex(network.loss);
+  return network;
+}
+
+/**
+ * Runs the forward and backward passes of the graph and returns the loss
+ */
+inline float runForwardAndBackward(TrainingGraph& network) {
+  auto [prediction, loss] = network.graph->launchForwardPass();
+  std::optional<std::vector<float>> no_upstream_grad = std::nullopt;
+  network.loss->backward(no_upstream_grad);
+  return loss;
+}
+
+}  // namespace gladius::tests